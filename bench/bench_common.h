@@ -0,0 +1,246 @@
+// Scaffolding shared by the bench/ tools: command line options and the JSON
+// report. Each tool keeps its own cases and checks.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// "32,64,128" -> { 32, 64, 128 }; zeros and junk are skipped
+inline std::vector<uint32_t> ParseList(const std::string& value) {
+    std::vector<uint32_t> result;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        uint32_t number = static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10));
+        if (number > 0) {
+            result.push_back(number);
+        }
+    }
+    return result;
+}
+
+inline std::string JsonEscape(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// Puts `path` in front of LV2_PATH, or in its place with `replace`, before
+// the plugin manager first reads it. An empty path leaves it alone.
+inline void AddLv2Path(const std::string& path, bool replace = false) {
+    if (path.empty()) {
+        return;
+    }
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+    // putenv keeps the pointer, so the string has to outlive the process setup
+    static std::string lv2Path;
+    const char* existing = getenv("LV2_PATH");
+    lv2Path = "LV2_PATH=" + path;
+    if (!replace && existing && *existing) {
+        lv2Path += separator + std::string(existing);
+    }
+    putenv(const_cast<char*>(lv2Path.c_str()));
+}
+
+// The options a tool takes, bound to its own fields. The usage line is built
+// from the same table, and --help is always understood.
+class OptionParser {
+public:
+    explicit OptionParser(std::string program)
+        : program_(std::move(program)) {
+    }
+
+    void AddFlag(const std::string& name, bool& value) {
+        options_.push_back({ name, "", [&value](const std::string&) { value = true; } });
+    }
+
+    void AddOption(const std::string& name, const std::string& metavar, uint32_t& value) {
+        AddHandler(name, metavar, [&value](const std::string& text) {
+            value = static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 10));
+        });
+    }
+
+    void AddOption(const std::string& name, const std::string& metavar, int32_t& value) {
+        AddHandler(name, metavar, [&value](const std::string& text) {
+            value = static_cast<int32_t>(std::strtol(text.c_str(), nullptr, 10));
+        });
+    }
+
+    void AddOption(const std::string& name, const std::string& metavar, double& value) {
+        AddHandler(name, metavar, [&value](const std::string& text) { value = std::strtod(text.c_str(), nullptr); });
+    }
+
+    void AddOption(const std::string& name, const std::string& metavar, std::string& value) {
+        AddHandler(name, metavar, [&value](const std::string& text) { value = text; });
+    }
+
+    // Comma-separated numbers, see ParseList()
+    void AddOption(const std::string& name, const std::string& metavar, std::vector<uint32_t>& value) {
+        AddHandler(name, metavar, [&value](const std::string& text) { value = ParseList(text); });
+    }
+
+    // Anything else; the handler runs once per occurrence
+    void AddHandler(const std::string& name, const std::string& metavar,
+                    std::function<void(const std::string&)> handler) {
+        options_.push_back({ name, metavar, std::move(handler) });
+    }
+
+    // False if main() should return `exitCode` right away: after --help (0)
+    // or anything it doesn't understand (1), with the usage printed
+    bool Parse(int argc, char* argv[], int& exitCode) const {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            const Option* option = Find(arg);
+            if (arg == "--help" || arg == "-h" || !option || (!option->metavar.empty() && i + 1 >= argc)) {
+                PrintUsage();
+                exitCode = arg == "--help" || arg == "-h" ? 0 : 1;
+                return false;
+            }
+            option->handler(option->metavar.empty() ? std::string() : std::string(argv[++i]));
+        }
+        return true;
+    }
+
+    // "Usage: <program> [--flag] [--name metavar]...", wrapped under itself
+    void PrintUsage() const {
+        const size_t width = 100;
+        std::string prefix = "Usage: " + program_;
+        std::string indent(prefix.size(), ' ');
+        std::string line = prefix;
+        std::string text;
+        for (const Option& option : options_) {
+            std::string item = "[" + option.name + (option.metavar.empty() ? "" : " " + option.metavar) + "]";
+            if (line.size() + 1 + item.size() > width && line.size() > indent.size()) {
+                text += line + "\n";
+                line = indent;
+            }
+            line += " " + item;
+        }
+        std::cerr << text << line << std::endl;
+    }
+
+private:
+    struct Option {
+        std::string name;
+        std::string metavar;    // empty for flags
+        std::function<void(const std::string&)> handler;
+    };
+
+    const Option* Find(const std::string& name) const {
+        for (const Option& option : options_) {
+            if (option.name == name) {
+                return &option;
+            }
+        }
+        return nullptr;
+    }
+
+    std::string program_;
+    std::vector<Option> options_;
+};
+
+// A flat JSON object, fields in the order they were added
+class JsonObject {
+public:
+    template<typename T>
+    JsonObject& Add(const std::string& key, T value) {
+        std::ostringstream text;
+        text << value;
+        return AddRaw(key, text.str());
+    }
+
+    JsonObject& Add(const std::string& key, bool value) { return AddRaw(key, value ? "true" : "false"); }
+    JsonObject& Add(const std::string& key, const char* value) { return Add(key, std::string(value)); }
+    JsonObject& Add(const std::string& key, const std::string& value) {
+        return AddRaw(key, "\"" + JsonEscape(value) + "\"");
+    }
+
+    // `json` goes in as is: a nested object or an array
+    JsonObject& AddRaw(const std::string& key, const std::string& json) {
+        fields_.emplace_back(key, json);
+        return *this;
+    }
+
+    // {"a": 1, "b": 2} on one line
+    std::string ToString() const {
+        std::string text = "{";
+        for (size_t i = 0; i < fields_.size(); ++i) {
+            text += (i ? ", \"" : "\"") + JsonEscape(fields_[i].first) + "\": " + fields_[i].second;
+        }
+        return text + "}";
+    }
+
+protected:
+    std::vector<std::pair<std::string, std::string>> fields_;
+};
+
+// What a benchmark run prints: its settings as top-level fields, one line
+// per field, then "results" with one object per case
+class Report : public JsonObject {
+public:
+    JsonObject& AddResult() {
+        results_.emplace_back();
+        return results_.back();
+    }
+
+    bool IsEmpty() const { return results_.empty(); }
+
+    void Write(std::ostream& out) const {
+        out << "{\n";
+        for (const auto& field : fields_) {
+            out << "  \"" << JsonEscape(field.first) << "\": " << field.second << ",\n";
+        }
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            out << "    " << results_[i].ToString() << (i + 1 < results_.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n";
+        out << "}\n";
+    }
+
+    // To `path`, or stdout if it is empty
+    bool Save(const std::string& path) const {
+        if (path.empty()) {
+            Write(std::cout);
+            return true;
+        }
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Cannot write " << path << std::endl;
+            return false;
+        }
+        Write(file);
+        return true;
+    }
+
+private:
+    std::vector<JsonObject> results_;
+};
+
+} // namespace bench
@@ -0,0 +1,324 @@
+// violet-drift-bench: checks that the drift compensator holds latency
+// constant between two free-running clocks and measures what it costs
+//
+//   violet-drift-bench [options]
+//
+//   --check-only              run the checks, skip the benchmark
+//   --hours <h>               simulated length of the long-run check (default 2)
+//   --channels <n>            channels in the benchmark (default 2)
+//   --seconds <s>             time spent per benchmark case (default 0.5)
+//   --output <file.json>      write the JSON report to a file instead of stdout
+//
+// The checks simulate a capture device delivering packets off a clock a
+// few hundred ppm away from the render clock, with late wake-ups on the
+// render side. The capture signal is a ramp carrying its own sample index,
+// so every output sample tells exactly how long ago it was captured; once
+// the loop has locked that delay must stay within a few samples.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_common.h"
+#include "violet/drift_compensator.h"
+#include "violet/performance_stats.h"
+
+namespace {
+
+const double SAMPLE_RATE = 48000.0;
+const double RAMP_PERIOD = 65536.0;     // keeps 1/128 frame resolution in a float
+
+// Latency may wander this far once locked; without timestamps the loop
+// only sees the FIFO level, which moves in whole packets
+const double LATENCY_TOLERANCE = 4.0;
+const double UNTIMED_LATENCY_TOLERANCE = 24.0;
+
+// The loop gets this long to lock before latency is checked
+const double SETTLE_SECONDS = 300.0;
+
+struct BenchOptions {
+    bool checkOnly = false;
+    double hours = 2.0;
+    uint32_t channels = 2;
+    double seconds = 0.5;
+    std::string outputPath;
+};
+
+struct Scenario {
+    const char* name;
+    double ppm;                 // capture clock offset from the render clock
+    uint32_t packet;            // capture frames per packet
+    uint32_t period;            // render frames per callback
+    double jitterMs;            // render wake-ups are up to this late
+    double seconds;
+    double dropoutAt;           // capture loses 200 ms here, 0 for never
+    bool timestamps;            // pass packet and play times to the compensator
+};
+
+struct ScenarioResult {
+    double minLatency = 1e30;
+    double maxLatency = -1e30;
+    double meanPpm = 0.0;
+    uint64_t resyncs = 0;
+};
+
+struct BenchResult {
+    uint32_t period = 0;
+    double nsPerFrame = 0.0;
+};
+
+bool Fail(const std::string& what) {
+    std::cerr << "FAIL " << what << std::endl;
+    return false;
+}
+
+// Runs the two clocks against each other. Latency is in render frames:
+// the output sample's play time minus the capture time of what it carries.
+ScenarioResult Simulate(const Scenario& scenario) {
+    violet::DriftCompensator compensator;
+    uint32_t target = 2 * scenario.packet + scenario.period;
+    compensator.Configure(1, scenario.packet, scenario.period, target, SAMPLE_RATE);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<double> jitter(0.0, scenario.jitterMs * 1e-3);
+
+    double captureRate = SAMPLE_RATE * (1.0 + scenario.ppm * 1e-6);
+    uint64_t packetsDelivered = 0;
+    uint64_t captureIndex = 0;
+    std::vector<float> packet(scenario.packet);
+    std::vector<float> output(scenario.period);
+    const float* packetPtr = packet.data();
+    float* outputPtr = output.data();
+
+    uint64_t periods = static_cast<uint64_t>(scenario.seconds * SAMPLE_RATE / scenario.period);
+    uint64_t settlePeriods = static_cast<uint64_t>(SETTLE_SECONDS * SAMPLE_RATE / scenario.period);
+    double ramp = 0.0;              // unwrapped ramp value of the last output
+    int rejected = 0;               // outputs in a row that broke the ramp
+    double ppmSum = 0.0;
+    uint64_t ppmCount = 0;
+    ScenarioResult result;
+
+    for (uint64_t k = 0; k < periods; ++k) {
+        // The render thread wakes for callback k, possibly late, and drains
+        // every packet the capture clock has completed by then
+        double now = static_cast<double>(k) * scenario.period / SAMPLE_RATE + jitter(random);
+        while ((packetsDelivered + 1) * scenario.packet / captureRate <= now) {
+            double packetTime = static_cast<double>(packetsDelivered) * scenario.packet / captureRate;
+            ++packetsDelivered;
+            bool lost = scenario.dropoutAt > 0.0 && packetTime >= scenario.dropoutAt &&
+                        packetTime < scenario.dropoutAt + 0.2;
+            for (uint32_t i = 0; i < scenario.packet; ++i) {
+                packet[i] = static_cast<float>(std::fmod(static_cast<double>(captureIndex + i), RAMP_PERIOD));
+            }
+            captureIndex += scenario.packet;
+            if (!lost) {
+                compensator.Push(&packetPtr, scenario.packet, scenario.timestamps ? packetTime : -1.0);
+            }
+        }
+
+        double playTime = static_cast<double>(k) * scenario.period / SAMPLE_RATE;
+        compensator.Pull(&outputPtr, scenario.period, scenario.timestamps ? playTime : -1.0);
+
+        bool dropoutWindow = scenario.dropoutAt > 0.0 && now >= scenario.dropoutAt &&
+                             now < scenario.dropoutAt + SETTLE_SECONDS;
+        for (uint32_t i = 0; i < scenario.period; ++i) {
+            // Unwrap the ramp against the previous sample; silence and
+            // samples interpolated across the ramp's wrap are skipped
+            double value = output[i];
+            if (value < 4.0 || value > RAMP_PERIOD - 4.0) {
+                continue;
+            }
+            double unwrapped = value + RAMP_PERIOD * std::round((ramp + 1.0 - value) / RAMP_PERIOD);
+            if (std::fabs(unwrapped - ramp - 1.0) > 0.25 && ++rejected < 8) {
+                continue;
+            }
+            ramp = unwrapped;
+            rejected = 0;
+            if (k < settlePeriods || dropoutWindow) {
+                continue;
+            }
+            double played = static_cast<double>(k * scenario.period + i);
+            double latency = played - unwrapped * SAMPLE_RATE / captureRate;
+            result.minLatency = std::min(result.minLatency, latency);
+            result.maxLatency = std::max(result.maxLatency, latency);
+        }
+
+        if (k >= settlePeriods && !dropoutWindow) {
+            ppmSum += compensator.GetStatus().ratioPpm;
+            ++ppmCount;
+        }
+    }
+
+    result.meanPpm = ppmCount > 0 ? ppmSum / ppmCount : 0.0;
+    result.resyncs = compensator.GetStatus().resyncs;
+    return result;
+}
+
+bool CheckScenario(const Scenario& scenario) {
+    ScenarioResult result = Simulate(scenario);
+    double spread = result.maxLatency - result.minLatency;
+    std::cerr << scenario.name << ": latency " << result.minLatency << ".." << result.maxLatency
+              << " frames, " << result.meanPpm << " ppm, " << result.resyncs << " resyncs" << std::endl;
+
+    if (result.maxLatency < result.minLatency) {
+        return Fail(std::string(scenario.name) + ": no audio came through");
+    }
+    if (spread > (scenario.timestamps ? LATENCY_TOLERANCE : UNTIMED_LATENCY_TOLERANCE)) {
+        return Fail(std::string(scenario.name) + ": latency wandered " + std::to_string(spread) + " frames");
+    }
+    if (std::fabs(result.meanPpm - scenario.ppm) > 1.0) {
+        return Fail(std::string(scenario.name) + ": ratio settled at " + std::to_string(result.meanPpm) + " ppm");
+    }
+    uint64_t expectedResyncs = scenario.dropoutAt > 0.0 ? 1 : 0;
+    if (result.resyncs != expectedResyncs) {
+        return Fail(std::string(scenario.name) + ": " + std::to_string(result.resyncs) + " resyncs");
+    }
+    return true;
+}
+
+// A constant passes through unchanged, also while the ratio moves
+bool CheckDc() {
+    violet::DriftCompensator compensator;
+    compensator.Configure(2, 480, 441, 960, SAMPLE_RATE);
+
+    std::vector<float> input(2 * 480, 0.25f), output(2 * 441);
+    const float* inputPtrs[2] = { input.data(), input.data() + 480 };
+    float* outputPtrs[2] = { output.data(), output.data() + 441 };
+
+    int blocks = 0;
+    for (int i = 0; i < 2000; ++i) {
+        // Feed 0.45% fast so the loop swings close to its limit
+        compensator.Push(inputPtrs, 443);
+        compensator.Pull(outputPtrs, 441);
+        if (blocks == 0 && output[440] == 0.0f) {
+            continue;
+        }
+        // The first block fades in from the silent history
+        if (blocks++ == 0) {
+            continue;
+        }
+        for (float sample : output) {
+            if (std::fabs(sample - 0.25f) > 1e-6f) {
+                return Fail("dc passes through: " + std::to_string(sample));
+            }
+        }
+    }
+    if (blocks == 0 || compensator.GetStatus().resyncs != 0) {
+        return Fail("dc stream");
+    }
+    if (compensator.GetStatus().ratioPpm < 4000.0) {
+        return Fail("dc ratio follows the clock: " + std::to_string(compensator.GetStatus().ratioPpm));
+    }
+    return true;
+}
+
+bool RunChecks(const BenchOptions& options) {
+    std::vector<Scenario> scenarios = {
+        { "locked clocks", 0.0, 480, 480, 0.0, 600.0, 0.0, true },
+        { "capture fast", 120.0, 480, 441, 2.0, 600.0, 0.0, true },
+        { "capture slow", -350.0, 441, 512, 3.0, 600.0, 0.0, true },
+        { "small periods", 80.0, 480, 64, 1.0, 600.0, 0.0, true },
+        { "capture dropout", -60.0, 480, 256, 2.0, 900.0, 300.0, true },
+        { "no timestamps", 120.0, 480, 441, 2.0, 600.0, 0.0, false },
+        { "long run", 47.0, 480, 441, 2.0, options.hours * 3600.0, 0.0, true },
+    };
+
+    bool passed = CheckDc();
+    for (const Scenario& scenario : scenarios) {
+        passed &= CheckScenario(scenario);
+    }
+    std::cerr << scenarios.size() + 1 << " drift checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed;
+}
+
+// Push and pull one render period at a time, 100 ppm apart
+double RunStream(uint32_t channels, uint32_t period, uint64_t frames) {
+    violet::DriftCompensator compensator;
+    compensator.Configure(channels, period + 1, period, 2 * period, SAMPLE_RATE);
+
+    std::vector<float> input(static_cast<size_t>(channels) * (period + 1), 0.5f);
+    std::vector<float> output(static_cast<size_t>(channels) * period);
+    std::vector<const float*> inputPtrs(channels);
+    std::vector<float*> outputPtrs(channels);
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        inputPtrs[ch] = input.data() + static_cast<size_t>(ch) * (period + 1);
+        outputPtrs[ch] = output.data() + static_cast<size_t>(ch) * period;
+    }
+
+    double owed = 0.0;
+    uint64_t start = violet::MonotonicNanos();
+    for (uint64_t done = 0; done < frames; done += period) {
+        owed += period * 1.0001;
+        uint32_t push = static_cast<uint32_t>(owed);
+        owed -= push;
+        compensator.Push(inputPtrs.data(), push);
+        compensator.Pull(outputPtrs.data(), period);
+    }
+    uint64_t elapsed = violet::MonotonicNanos() - start;
+    return static_cast<double>(elapsed) / static_cast<double>(frames);
+}
+
+BenchResult RunCase(const BenchOptions& options, uint32_t period) {
+    // Calibrate the frame count on a short run, then time the stream
+    uint64_t frames = 1 << 16;
+    double nsPerFrame = RunStream(options.channels, period, frames);
+    while (nsPerFrame * frames < options.seconds * 1e9 / 4 && frames < (1ull << 36)) {
+        frames *= 4;
+        nsPerFrame = RunStream(options.channels, period, frames);
+    }
+
+    BenchResult result;
+    result.period = period;
+    result.nsPerFrame = nsPerFrame;
+    return result;
+}
+
+void AddResult(bench::Report& report, const BenchResult& r) {
+    report.AddResult()
+        .Add("period", r.period)
+        .Add("nsPerFrame", r.nsPerFrame);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-drift-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddOption("--hours", "h", options.hours);
+    parser.AddOption("--channels", "n", options.channels);
+    parser.AddOption("--seconds", "s", options.seconds);
+    parser.AddOption("--output", "file.json", options.outputPath);
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+
+    if (options.hours <= 0.0 || options.channels == 0 || options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+
+    if (!RunChecks(options)) {
+        return 1;
+    }
+    if (options.checkOnly) {
+        return 0;
+    }
+
+    bench::Report report;
+    report.Add("channels", options.channels);
+    report.Add("threads", std::thread::hardware_concurrency());
+    for (uint32_t period : { 64u, 256u, 1024u }) {
+        BenchResult result = RunCase(options, period);
+        std::cerr << "period " << period << ": " << result.nsPerFrame << " ns/frame" << std::endl;
+        AddResult(report, result);
+    }
+
+    return report.Save(options.outputPath) ? 0 : 1;
+}
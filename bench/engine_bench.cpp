@@ -0,0 +1,253 @@
+// violet-engine-bench: runs the live engine on a freewheeling null backend
+// and checks that its audio threads never touch the heap
+//
+//   violet-engine-bench [options]
+//
+//   --check-only              run every scenario briefly and fail on any
+//                             allocation on an audio thread
+//   --plugin <uri>            plugin appended to the chain (repeatable), as
+//                             for violet-bench. Default: ref:gain ref:biquad ref:delay
+//   --seconds <s>             audio rendered per scenario (default 10)
+//   --lv2-path <dir>          where to find the reference bundle
+//
+// Always built with the allocation trap (see alloc_trap.h), whatever the
+// alloc_trap option says, so every malloc on a thread running the engine,
+// the chain or a chain worker is counted. Scenarios cover the plain path,
+// the block adapter with rate conversion and a channel map, and a parallel
+// graph on worker threads.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_common.h"
+#include "violet/alloc_trap.h"
+#include "violet/audio_engine.h"
+#include "violet/audio_processing_chain.h"
+#include "violet/null_backend.h"
+
+#ifndef VIOLET_BENCH_LV2_PATH
+#define VIOLET_BENCH_LV2_PATH ""
+#endif
+
+namespace {
+
+struct BenchOptions {
+    bool checkOnly = false;
+    std::vector<std::string> plugins;
+    double seconds = 10.0;
+    std::string lv2Path = VIOLET_BENCH_LV2_PATH;
+};
+
+struct Scenario {
+    const char* name;
+    uint32_t channels;          // device channels
+    uint32_t bufferSize;
+    uint32_t processingRate;    // 0 follows the device
+    bool fixedBlock;
+    violet::ChannelMap channelMap;
+    bool parallel;              // split the plugins over two branches and a sum node
+    uint32_t workers;           // 0 keeps the chain's default
+};
+
+struct ScenarioResult {
+    uint64_t frames = 0;
+    uint64_t allocations = 0;
+    uint32_t dropouts = 0;
+    violet::TimingStats callback;
+};
+
+const uint32_t SAMPLE_RATE = 48000;
+const double CHECK_SECONDS = 2.0;
+
+std::string ResolvePluginUri(const std::string& plugin, uint32_t channels) {
+    if (plugin.compare(0, 4, "ref:") == 0) {
+        return "urn:violet:ref:" + plugin.substr(4) + "-" + std::to_string(channels) + "ch";
+    }
+    return plugin;
+}
+
+// Plugins in a row, or for the parallel scenario the first one feeding two
+// branches that take turns over the rest and meet in a sum node
+bool BuildChain(violet::AudioProcessingChain& chain, const BenchOptions& options,
+                const Scenario& scenario, uint32_t channels) {
+    std::vector<uint32_t> nodes;
+    for (const auto& plugin : options.plugins) {
+        std::string uri = ResolvePluginUri(plugin, channels);
+        uint32_t nodeId = chain.AddPlugin(uri);
+        if (nodeId == 0) {
+            std::cerr << "Cannot load " << uri << std::endl;
+            return false;
+        }
+        nodes.push_back(nodeId);
+    }
+    if (!scenario.parallel || nodes.size() < 3) {
+        return true;
+    }
+
+    uint32_t sum = chain.AddSumNode();
+    uint32_t tails[2] = { nodes[0], nodes[0] };
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        uint32_t& tail = tails[i % 2];
+        chain.SetNodeInputs(nodes[i], { tail });
+        tail = nodes[i];
+    }
+    return chain.SetNodeInputs(sum, { tails[0], tails[1] }) &&
+           chain.SetNodeInputs(violet::AudioProcessingChain::GRAPH_IO, { sum });
+}
+
+bool RunScenario(const BenchOptions& options, const Scenario& scenario, double seconds,
+                 ScenarioResult& result) {
+    auto backend = std::make_unique<violet::NullBackend>();
+    backend->SetFreewheel(true);
+    violet::NullBackend* nullBackend = backend.get();
+
+    violet::AudioEngine engine;
+    if (!engine.Initialize(std::move(backend))) {
+        return false;
+    }
+    violet::AudioFormat format;
+    format.sampleRate = SAMPLE_RATE;
+    format.channels = scenario.channels;
+    format.bufferSize = scenario.bufferSize;
+    if (!engine.SetFormat(format) || !engine.SetProcessingSampleRate(scenario.processingRate) ||
+        !engine.SetChannelMap(scenario.channelMap)) {
+        return false;
+    }
+    engine.SetFixedBlockSize(scenario.fixedBlock);
+    engine.SetInputDevice("null");
+    engine.SetOutputDevice("null");
+
+    violet::AudioProcessingChain chain(&engine);
+    violet::AudioFormat processing = engine.GetProcessingFormat();
+    chain.SetFormat(processing.sampleRate, processing.channels, processing.bufferSize);
+    if (scenario.workers > 0) {
+        chain.SetWorkerThreadCount(scenario.workers);
+    }
+    engine.SetProcessCallback([&chain](float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+        chain.Process(inputs, outputs, channels, frames);
+    });
+    engine.SetGlitchContextSource([&chain] { return chain.GetBlockContext(); });
+    engine.SetProcessingLatencySource([&chain] { return chain.GetLatency(); });
+
+    if (!engine.Start()) {
+        return false;
+    }
+    violet::AudioFormat actual = engine.GetProcessingFormat();
+    chain.SetFormat(actual.sampleRate, actual.channels, actual.bufferSize);
+    chain.SetFixedBlockLength(engine.HasFixedBlockSize());
+    chain.WaitForFormatChange();
+    if (!BuildChain(chain, options, scenario, actual.channels)) {
+        engine.Stop();
+        return false;
+    }
+
+    // Count from here: the engine is running and the graph is published
+    engine.ResetStats();
+    violet::ResetRealtimeAllocationCount();
+    uint64_t startFrames = nullBackend->GetProcessedFrames();
+    uint64_t targetFrames = startFrames + static_cast<uint64_t>(seconds * SAMPLE_RATE);
+    while (nullBackend->GetProcessedFrames() < targetFrames) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    result.allocations = violet::GetRealtimeAllocationCount();
+    result.frames = nullBackend->GetProcessedFrames() - startFrames;
+    result.dropouts = engine.GetDropouts();
+    result.callback = engine.GetCallbackStats();
+    engine.Stop();
+    return true;
+}
+
+std::vector<Scenario> MakeScenarios() {
+    std::vector<Scenario> scenarios;
+
+    Scenario plain = {};
+    plain.name = "plain";
+    plain.channels = 2;
+    plain.bufferSize = 256;
+    scenarios.push_back(plain);
+
+    // Device rate and period don't match the chain's, and the chain's two
+    // buses come from swapped device channels out of four
+    Scenario adapted = {};
+    adapted.name = "adapted";
+    adapted.channels = 4;
+    adapted.bufferSize = 256;
+    adapted.processingRate = 44100;
+    adapted.fixedBlock = true;
+    adapted.channelMap.inputs = { 1, 0 };
+    adapted.channelMap.outputs = { 1, 0, -1, 0 };
+    scenarios.push_back(adapted);
+
+    Scenario parallel = {};
+    parallel.name = "parallel";
+    parallel.channels = 2;
+    parallel.bufferSize = 128;
+    parallel.parallel = true;
+    parallel.workers = 2;
+    scenarios.push_back(parallel);
+
+    return scenarios;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-engine-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddHandler("--plugin", "uri|ref:name", [&options](const std::string& value) {
+        options.plugins.push_back(value);
+    });
+    parser.AddOption("--seconds", "s", options.seconds);
+    parser.AddOption("--lv2-path", "dir", options.lv2Path);
+
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+    if (options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+    if (options.plugins.empty()) {
+        options.plugins = { "ref:gain", "ref:biquad", "ref:delay" };
+    }
+    if (!violet::IsAllocTrapBuiltIn()) {
+        std::cerr << "Built without the allocation trap" << std::endl;
+        return 1;
+    }
+
+    bench::AddLv2Path(options.lv2Path);
+    // VIOLET_ALLOC_TRAP=abort still stops at the first one, for a debugger
+    if (violet::GetAllocTrapMode() == violet::AllocTrapMode::Off) {
+        violet::SetAllocTrapMode(violet::AllocTrapMode::Count);
+    }
+    double seconds = options.checkOnly ? CHECK_SECONDS : options.seconds;
+
+    bool passed = true;
+    for (const Scenario& scenario : MakeScenarios()) {
+        ScenarioResult result;
+        if (!RunScenario(options, scenario, seconds, result)) {
+            std::cerr << "FAIL " << scenario.name << ": cannot start" << std::endl;
+            passed = false;
+            continue;
+        }
+
+        std::cout << scenario.name << ": " << result.frames << " frames, callback mean "
+                  << result.callback.mean << " ns, p99 " << result.callback.p99 << " ns, max "
+                  << result.callback.max << " ns, " << result.allocations << " realtime allocation(s)"
+                  << std::endl;
+        if (result.allocations > 0) {
+            std::cerr << "FAIL " << scenario.name << ": " << result.allocations
+                      << " allocation(s) on an audio thread" << std::endl;
+            passed = false;
+        }
+    }
+
+    std::cerr << "Realtime allocation checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
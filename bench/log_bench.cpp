@@ -0,0 +1,302 @@
+// violet-log-bench: checks the realtime log and measures what a log call
+// costs the thread making it
+//
+//   violet-log-bench [options]
+//
+//   --check-only              run the checks, skip the benchmark
+//   --threads <n>             logging threads in the contended case (default 4)
+//   --seconds <s>             time spent per benchmark case (default 0.5)
+//
+// The checks cover argument formatting, the per-format rate limit and its
+// summary line, counting of records dropped on a full queue, and that a
+// log call allocates nothing (built with the allocation trap). The
+// benchmark times LogRealtime() in bursts the queue can hold and from
+// several threads flooding it, against formatting the same line through an
+// ostream as the audio path used to (without the console behind it).
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_common.h"
+#include "violet/alloc_trap.h"
+#include "violet/performance_stats.h"
+#include "violet/realtime_log.h"
+#include "violet/realtime_thread.h"
+
+namespace {
+
+struct BenchOptions {
+    bool checkOnly = false;
+    uint32_t threads = 4;
+    double seconds = 0.5;
+};
+
+// Lines written through the sink since the last Take()
+class CapturedLines {
+public:
+    void Add(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lines_.push_back(line);
+    }
+
+    std::vector<std::string> Take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> lines;
+        lines.swap(lines_);
+        return lines;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+};
+
+CapturedLines captured;
+
+bool Fail(const std::string& what) {
+    std::cerr << "FAIL " << what << std::endl;
+    return false;
+}
+
+template<typename... Args>
+std::string Format(const char* format, const Args&... args) {
+    violet::LogRecord record;
+    record.format = format;
+    const violet::LogArg packed[] = { violet::LogArg(args)..., violet::LogArg() };
+    record.argCount = sizeof...(Args);
+    for (uint32_t i = 0; i < record.argCount; ++i) {
+        record.args[i] = packed[i];
+    }
+    return violet::FormatLogRecord(record);
+}
+
+bool CheckFormatting() {
+    struct Case {
+        std::string actual;
+        const char* expected;
+    };
+    const Case cases[] = {
+        { Format("plain"), "plain" },
+        { Format("port {} of {}", 3u, -2), "port 3 of -2" },
+        { Format("{} Hz, {}", 44100.5, "stereo"), "44100.5 Hz, stereo" },
+        { Format("code {}", violet::LogHex(0x88890004u)), "code 0x88890004" },
+        { Format("{} and {}", 1), "1 and {}" },
+        { Format("{ {}}", 7), "{ 7}" },
+    };
+
+    bool passed = true;
+    for (const Case& c : cases) {
+        if (c.actual != c.expected) {
+            passed = Fail("formatted \"" + c.actual + "\", expected \"" + c.expected + "\"");
+        }
+    }
+    return passed;
+}
+
+// One format logged well over the limit within a second: LOG_RATE_LIMIT
+// lines get through, then one summary once the window is over
+bool CheckRateLimit() {
+    violet::FlushLog();
+    captured.Take();
+    violet::LogStats before = violet::GetLogStats();
+
+    const uint32_t count = 100;
+    for (uint32_t i = 0; i < count; ++i) {
+        violet::LogRealtime(violet::LogLevel::Warning, "rate check {}", i);
+    }
+    violet::FlushLog();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    violet::FlushLog();
+
+    std::vector<std::string> lines = captured.Take();
+    violet::LogStats after = violet::GetLogStats();
+    if (after.dropped != before.dropped) {
+        return Fail("rate check dropped records");
+    }
+    if (lines.size() != violet::LOG_RATE_LIMIT + 1) {
+        return Fail("rate check wrote " + std::to_string(lines.size()) + " lines");
+    }
+    for (uint32_t i = 0; i < violet::LOG_RATE_LIMIT; ++i) {
+        if (lines[i] != "rate check " + std::to_string(i)) {
+            return Fail("rate check line " + std::to_string(i) + " is \"" + lines[i] + "\"");
+        }
+    }
+    std::string summary = std::to_string(count - violet::LOG_RATE_LIMIT) + " more like \"rate check {}\" suppressed";
+    if (lines.back() != summary) {
+        return Fail("rate check summary is \"" + lines.back() + "\"");
+    }
+    return after.suppressed - before.suppressed == count - violet::LOG_RATE_LIMIT ||
+           Fail("rate check suppressed count");
+}
+
+// Far more records than the queue holds, from threads tagged realtime:
+// every one is either written, suppressed or counted as dropped, and none
+// of the calls allocates
+bool CheckOverflow() {
+    violet::FlushLog();
+    captured.Take();
+    violet::LogStats before = violet::GetLogStats();
+    violet::ResetRealtimeAllocationCount();
+
+    const uint32_t threads = 4;
+    const uint32_t perThread = 5000;
+    static const char* const formats[] = { "overflow {} {}", "overflow b {} {}", "overflow c {} {}", "overflow d {} {}" };
+    std::vector<std::thread> producers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        producers.emplace_back([t] {
+            violet::ScopedRealtimeTag realtimeTag;
+            for (uint32_t i = 0; i < perThread; ++i) {
+                violet::LogRealtime(violet::LogLevel::Info, formats[t], t, i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    uint64_t allocations = violet::GetRealtimeAllocationCount();
+    violet::FlushLog();
+
+    uint64_t written = 0;
+    for (const std::string& line : captured.Take()) {
+        written += line.compare(0, 9, "overflow ") == 0 ? 1 : 0;
+    }
+    violet::LogStats after = violet::GetLogStats();
+    uint64_t suppressed = after.suppressed - before.suppressed;
+    uint64_t dropped = after.dropped - before.dropped;
+    bool passed = true;
+    if (dropped == 0) {
+        passed = Fail("overflow dropped nothing");
+    }
+    if (written + suppressed + dropped != threads * perThread) {
+        passed = Fail("overflow accounted for " + std::to_string(written + suppressed + dropped) + " of " +
+                      std::to_string(threads * perThread) + " records");
+    }
+    if (violet::IsAllocTrapBuiltIn() && allocations > 0) {
+        passed = Fail(std::to_string(allocations) + " allocation(s) while logging");
+    }
+    return passed;
+}
+
+bool RunChecks() {
+    bool passed = CheckFormatting();
+    passed = CheckRateLimit() && passed;
+    passed = CheckOverflow() && passed;
+    std::cerr << "Realtime log checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed;
+}
+
+// Discards whatever is written to it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Bursts that fit the queue, drained between bursts outside the timing
+double TimeLogBursts(double seconds) {
+    uint64_t busy = 0;
+    uint64_t calls = 0;
+    uint64_t deadline = violet::MonotonicNanos() + static_cast<uint64_t>(seconds * 1e9);
+    while (violet::MonotonicNanos() < deadline) {
+        uint64_t start = violet::MonotonicNanos();
+        for (uint32_t i = 0; i < 512; ++i) {
+            violet::LogRealtime(violet::LogLevel::Error, "Error: outputPtrs_[{}] is NULL! ({})", i, 0);
+        }
+        busy += violet::MonotonicNanos() - start;
+        calls += 512;
+        violet::FlushLog();
+    }
+    return static_cast<double>(busy) / static_cast<double>(calls);
+}
+
+// Every thread logging flat out; most records then find the queue full,
+// which costs the caller as much as a call that gets through
+double TimeContendedCalls(uint32_t threads, double seconds) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> calls(0);
+    std::vector<std::thread> producers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        producers.emplace_back([&stop, &calls, t] {
+            uint64_t done = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    violet::LogRealtime(violet::LogLevel::Error, "Error: outputPtrs_[{}] is NULL! ({})", i, t);
+                }
+                done += 256;
+            }
+            calls.fetch_add(done);
+        });
+    }
+    uint64_t start = violet::MonotonicNanos();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    uint64_t elapsed = violet::MonotonicNanos() - start;
+    return static_cast<double>(elapsed) * threads / static_cast<double>(calls.load());
+}
+
+double TimeStreamCalls(double seconds) {
+    NullBuffer buffer;
+    std::ostream stream(&buffer);
+    uint64_t calls = 0;
+    uint64_t start = violet::MonotonicNanos();
+    uint64_t deadline = start + static_cast<uint64_t>(seconds * 1e9);
+    while (violet::MonotonicNanos() < deadline) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            stream << "Error: outputPtrs_[" << i << "] is NULL! (" << 0 << ")" << std::endl;
+        }
+        calls += 256;
+    }
+    return static_cast<double>(violet::MonotonicNanos() - start) / static_cast<double>(calls);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-log-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddOption("--threads", "n", options.threads);
+    parser.AddOption("--seconds", "s", options.seconds);
+
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+    if (options.threads == 0 || options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+
+    violet::StartLogThread();
+    violet::SetLogSink([](violet::LogLevel, const std::string& line) { captured.Add(line); });
+
+    if (!RunChecks()) {
+        return 1;
+    }
+    if (options.checkOnly) {
+        return 0;
+    }
+
+    // The sink keeps nothing here, so only the calls themselves are timed
+    violet::SetLogSink([](violet::LogLevel, const std::string&) {});
+    double single = TimeLogBursts(options.seconds);
+    double contended = TimeContendedCalls(options.threads, options.seconds);
+    double stream = TimeStreamCalls(options.seconds);
+    violet::FlushLog();
+
+    violet::LogStats stats = violet::GetLogStats();
+    std::cout << "LogRealtime, bursts:      " << single << " ns/call\n"
+              << "LogRealtime, " << options.threads << " threads flooding: " << contended << " ns/call\n"
+              << "ostream formatting:       " << stream << " ns/call\n"
+              << stats.dropped << " dropped, " << stats.suppressed << " suppressed" << std::endl;
+    return 0;
+}
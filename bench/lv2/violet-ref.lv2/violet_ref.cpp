@@ -0,0 +1,290 @@
+// Reference LV2 plugins for violet-bench. Each algorithm comes in 1, 2, 4
+// and 8 channel variants so channel sweeps process every chain channel
+// without depending on third-party plugins being installed.
+//
+// Port layout of a variant with N channels: N audio inputs, N audio
+// outputs, then the algorithm's control inputs.
+
+#include <lv2/lv2plug.in/ns/lv2core/lv2.h>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <string>
+
+namespace {
+
+const char* const URI_PREFIX = "urn:violet:ref:";
+
+enum class Kind {
+    Gain,
+    Biquad,
+    Delay
+};
+
+const double PI = 3.14159265358979323846;
+
+class RefPlugin {
+public:
+    RefPlugin(uint32_t channels, uint32_t controls, double sampleRate)
+        : channels_(channels)
+        , sampleRate_(sampleRate)
+        , inputs_(channels, nullptr)
+        , outputs_(channels, nullptr)
+        , controls_(controls, nullptr) {
+    }
+    virtual ~RefPlugin() = default;
+
+    void ConnectPort(uint32_t port, void* data) {
+        if (port < channels_) {
+            inputs_[port] = static_cast<const float*>(data);
+        } else if (port < channels_ * 2) {
+            outputs_[port - channels_] = static_cast<float*>(data);
+        } else if (port - channels_ * 2 < controls_.size()) {
+            controls_[port - channels_ * 2] = static_cast<const float*>(data);
+        }
+    }
+
+    float Control(uint32_t index, float fallback) const {
+        return controls_[index] ? *controls_[index] : fallback;
+    }
+
+    virtual void Activate() {}
+    virtual void Run(uint32_t frames) = 0;
+
+protected:
+    uint32_t channels_;
+    double sampleRate_;
+    std::vector<const float*> inputs_;
+    std::vector<float*> outputs_;
+    std::vector<const float*> controls_;
+};
+
+// Gain in dB with a one-pole smoother against zipper noise
+class GainPlugin : public RefPlugin {
+public:
+    GainPlugin(uint32_t channels, double sampleRate)
+        : RefPlugin(channels, 1, sampleRate)
+        , gain_(1.0f)
+        , smoothing_(static_cast<float>(1.0 - std::exp(-1.0 / (0.005 * sampleRate)))) {
+    }
+
+    void Activate() override {
+        gain_ = Target();
+    }
+
+    void Run(uint32_t frames) override {
+        float target = Target();
+        float gain = gain_;
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            const float* in = inputs_[ch];
+            float* out = outputs_[ch];
+            gain = gain_;
+            for (uint32_t i = 0; i < frames; ++i) {
+                gain += (target - gain) * smoothing_;
+                out[i] = in[i] * gain;
+            }
+        }
+        gain_ = gain;
+    }
+
+private:
+    float Target() const {
+        return std::pow(10.0f, Control(0, 0.0f) / 20.0f);
+    }
+
+    float gain_;
+    float smoothing_;
+};
+
+// RBJ low-pass biquad, transposed direct form II
+class BiquadPlugin : public RefPlugin {
+public:
+    BiquadPlugin(uint32_t channels, double sampleRate)
+        : RefPlugin(channels, 2, sampleRate)
+        , state_(channels * 2, 0.0f)
+        , frequency_(-1.0f)
+        , q_(-1.0f) {
+    }
+
+    void Activate() override {
+        std::fill(state_.begin(), state_.end(), 0.0f);
+    }
+
+    void Run(uint32_t frames) override {
+        UpdateCoefficients();
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            const float* in = inputs_[ch];
+            float* out = outputs_[ch];
+            float z1 = state_[ch * 2];
+            float z2 = state_[ch * 2 + 1];
+            for (uint32_t i = 0; i < frames; ++i) {
+                float x = in[i];
+                float y = b0_ * x + z1;
+                z1 = b1_ * x - a1_ * y + z2;
+                z2 = b2_ * x - a2_ * y;
+                out[i] = y;
+            }
+            state_[ch * 2] = z1;
+            state_[ch * 2 + 1] = z2;
+        }
+    }
+
+private:
+    void UpdateCoefficients() {
+        float frequency = std::max(10.0f, std::min(Control(0, 1000.0f), static_cast<float>(sampleRate_ * 0.45)));
+        float q = std::max(0.1f, Control(1, 0.707f));
+        if (frequency == frequency_ && q == q_) {
+            return;
+        }
+        frequency_ = frequency;
+        q_ = q;
+
+        double w0 = 2.0 * PI * frequency / sampleRate_;
+        double alpha = std::sin(w0) / (2.0 * q);
+        double cosw0 = std::cos(w0);
+        double a0 = 1.0 + alpha;
+        b0_ = static_cast<float>((1.0 - cosw0) / 2.0 / a0);
+        b1_ = static_cast<float>((1.0 - cosw0) / a0);
+        b2_ = b0_;
+        a1_ = static_cast<float>(-2.0 * cosw0 / a0);
+        a2_ = static_cast<float>((1.0 - alpha) / a0);
+    }
+
+    std::vector<float> state_;
+    float frequency_;
+    float q_;
+    float b0_ = 1.0f, b1_ = 0.0f, b2_ = 0.0f, a1_ = 0.0f, a2_ = 0.0f;
+};
+
+// Feedback delay of up to one second
+class DelayPlugin : public RefPlugin {
+public:
+    DelayPlugin(uint32_t channels, double sampleRate)
+        : RefPlugin(channels, 3, sampleRate)
+        , length_(static_cast<uint32_t>(sampleRate) + 1)
+        , lines_(static_cast<size_t>(channels) * length_, 0.0f)
+        , writeIndex_(0) {
+    }
+
+    void Activate() override {
+        std::fill(lines_.begin(), lines_.end(), 0.0f);
+        writeIndex_ = 0;
+    }
+
+    void Run(uint32_t frames) override {
+        uint32_t delay = static_cast<uint32_t>(Control(0, 250.0f) * sampleRate_ / 1000.0);
+        delay = std::max(1u, std::min(delay, length_ - 1));
+        float feedback = std::max(0.0f, std::min(Control(1, 0.4f), 0.95f));
+        float mix = std::max(0.0f, std::min(Control(2, 0.3f), 1.0f));
+
+        uint32_t writeIndex = writeIndex_;
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            const float* in = inputs_[ch];
+            float* out = outputs_[ch];
+            float* line = lines_.data() + static_cast<size_t>(ch) * length_;
+            writeIndex = writeIndex_;
+            for (uint32_t i = 0; i < frames; ++i) {
+                uint32_t readIndex = writeIndex >= delay ? writeIndex - delay : writeIndex + length_ - delay;
+                float x = in[i];
+                float delayed = line[readIndex];
+                line[writeIndex] = x + delayed * feedback;
+                out[i] = x + (delayed - x) * mix;
+                if (++writeIndex == length_) {
+                    writeIndex = 0;
+                }
+            }
+        }
+        writeIndex_ = writeIndex;
+    }
+
+private:
+    uint32_t length_;
+    std::vector<float> lines_;
+    uint32_t writeIndex_;
+};
+
+struct Variant {
+    Kind kind;
+    uint32_t channels;
+    std::string uri;
+};
+
+const uint32_t CHANNEL_VARIANTS[] = { 1, 2, 4, 8 };
+const uint32_t VARIANT_COUNT = 12;
+
+const Variant& GetVariant(uint32_t index) {
+    static const std::vector<Variant> variants = [] {
+        std::vector<Variant> result;
+        const char* names[] = { "gain", "biquad", "delay" };
+        for (uint32_t kind = 0; kind < 3; ++kind) {
+            for (uint32_t channels : CHANNEL_VARIANTS) {
+                result.push_back({ static_cast<Kind>(kind), channels,
+                                   std::string(URI_PREFIX) + names[kind] + "-" + std::to_string(channels) + "ch" });
+            }
+        }
+        return result;
+    }();
+    return variants[index];
+}
+
+LV2_Descriptor descriptors[VARIANT_COUNT];
+
+LV2_Handle Instantiate(const LV2_Descriptor* descriptor, double sampleRate,
+                       const char*, const LV2_Feature* const*) {
+    const Variant& variant = GetVariant(static_cast<uint32_t>(descriptor - descriptors));
+    switch (variant.kind) {
+        case Kind::Gain:
+            return new GainPlugin(variant.channels, sampleRate);
+        case Kind::Biquad:
+            return new BiquadPlugin(variant.channels, sampleRate);
+        case Kind::Delay:
+            return new DelayPlugin(variant.channels, sampleRate);
+    }
+    return nullptr;
+}
+
+void ConnectPort(LV2_Handle instance, uint32_t port, void* data) {
+    static_cast<RefPlugin*>(instance)->ConnectPort(port, data);
+}
+
+void Activate(LV2_Handle instance) {
+    static_cast<RefPlugin*>(instance)->Activate();
+}
+
+void Run(LV2_Handle instance, uint32_t frames) {
+    static_cast<RefPlugin*>(instance)->Run(frames);
+}
+
+void Deactivate(LV2_Handle) {
+}
+
+void Cleanup(LV2_Handle instance) {
+    delete static_cast<RefPlugin*>(instance);
+}
+
+const void* ExtensionData(const char*) {
+    return nullptr;
+}
+
+} // namespace
+
+extern "C" LV2_SYMBOL_EXPORT const LV2_Descriptor* lv2_descriptor(uint32_t index) {
+    if (index >= VARIANT_COUNT) {
+        return nullptr;
+    }
+
+    LV2_Descriptor& descriptor = descriptors[index];
+    if (!descriptor.URI) {
+        descriptor.URI = GetVariant(index).uri.c_str();
+        descriptor.instantiate = Instantiate;
+        descriptor.connect_port = ConnectPort;
+        descriptor.activate = Activate;
+        descriptor.run = Run;
+        descriptor.deactivate = Deactivate;
+        descriptor.cleanup = Cleanup;
+        descriptor.extension_data = ExtensionData;
+    }
+    return &descriptor;
+}
@@ -0,0 +1,461 @@
+// violet-pcm-bench: checks and benchmarks the PCM conversion kernels
+//
+//   violet-pcm-bench [options]
+//
+//   --check-only              run the checks, skip the benchmark
+//   --channels <list>         channel counts to benchmark (default 1,2,8)
+//   --frames <n>              frames per conversion call (default 512)
+//   --seconds <s>             time spent per benchmark case (default 0.2)
+//   --output <file.json>      write the JSON report to a file instead of stdout
+//
+// Every SIMD level the CPU supports is checked against the scalar kernels:
+// bit-identical output without dither, lossless round trips up to 24 bits,
+// silence-padding of mismatched channel counts and dither bounds, plus
+// AudioBuffer's bulk interleaved and planar transfers. A failed check fails
+// the run before anything is benchmarked.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "violet/audio_buffer.h"
+#include "violet/pcm_convert.h"
+#include "violet/performance_stats.h"
+
+namespace {
+
+using violet::PcmFormat;
+using violet::SimdLevel;
+
+const PcmFormat ALL_FORMATS[] = {
+    PcmFormat::Float32, PcmFormat::Int16, PcmFormat::Int24, PcmFormat::Int24In32, PcmFormat::Int32,
+};
+
+// Odd, so every kernel runs its scalar tail too. The channel counts cover
+// the stereo kernels and full and partial 4 and 8-wide transposes.
+const uint32_t CHECK_FRAMES = 1031;
+const uint32_t CHECK_CHANNELS[] = { 1, 2, 3, 4, 6, 8, 12 };
+
+struct BenchOptions {
+    bool checkOnly = false;
+    std::vector<uint32_t> channelCounts = { 1, 2, 8 };
+    uint32_t frames = 512;
+    double seconds = 0.2;
+    std::string outputPath;
+};
+
+struct BenchResult {
+    SimdLevel level = SimdLevel::Scalar;
+    PcmFormat format = PcmFormat::Float32;
+    uint32_t channels = 0;
+    bool encode = false;
+    bool dither = false;
+    double nsPerSample = 0.0;
+};
+
+// Planar float buffers with pointers
+struct Planar {
+    std::vector<std::vector<float>> channels;
+    std::vector<float*> ptrs;
+
+    Planar(uint32_t count, uint32_t frames)
+        : channels(count, std::vector<float>(frames)), ptrs(count) {
+        for (uint32_t ch = 0; ch < count; ++ch) {
+            ptrs[ch] = channels[ch].data();
+        }
+    }
+};
+
+std::vector<SimdLevel> GetLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+        if (level <= violet::pcm::GetMaxSimdLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+// Full-scale edge cases followed by noise slightly past full scale, so
+// clipping is exercised
+void FillSignal(Planar& planar, std::mt19937& random) {
+    static const float edges[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.99999f, -0.99999f, 1.5f, -1.5f,
+                                   0.5f / 32768.0f, -0.5f / 32768.0f, 1.5f / 32768.0f, 1e-30f };
+    std::uniform_real_distribution<float> noise(-1.1f, 1.1f);
+    for (auto& channel : planar.channels) {
+        for (size_t i = 0; i < channel.size(); ++i) {
+            channel[i] = i < sizeof(edges) / sizeof(edges[0]) ? edges[i] : noise(random);
+        }
+    }
+}
+
+// Random device bytes. 24-in-32 words are sign-extended like the kernels
+// write them; float samples stay in range so the comparison is meaningful.
+void FillDevice(std::vector<uint8_t>& bytes, PcmFormat format, std::mt19937& random) {
+    if (format == PcmFormat::Float32) {
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        for (size_t i = 0; i + 4 <= bytes.size(); i += 4) {
+            float value = noise(random);
+            memcpy(&bytes[i], &value, 4);
+        }
+        return;
+    }
+    for (uint8_t& byte : bytes) {
+        byte = static_cast<uint8_t>(random());
+    }
+    if (format == PcmFormat::Int24In32) {
+        for (size_t i = 0; i + 4 <= bytes.size(); i += 4) {
+            bytes[i + 3] = (bytes[i + 2] & 0x80) ? 0xff : 0x00;
+        }
+    }
+}
+
+bool Fail(const std::string& what, SimdLevel level, PcmFormat format, uint32_t channels) {
+    std::cerr << "FAIL " << what << ": " << violet::pcm::GetSimdLevelName(level) << " "
+              << violet::pcm::GetFormatName(format) << " " << channels << "ch" << std::endl;
+    return false;
+}
+
+bool SameBits(const Planar& a, const Planar& b) {
+    for (size_t ch = 0; ch < a.channels.size(); ++ch) {
+        if (memcmp(a.channels[ch].data(), b.channels[ch].data(), a.channels[ch].size() * sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Each level against the scalar kernels, bit for bit
+bool CheckAgainstScalar(SimdLevel level, PcmFormat format, uint32_t channels) {
+    std::mt19937 random(channels * 31 + static_cast<uint32_t>(format));
+    size_t bytes = static_cast<size_t>(CHECK_FRAMES) * channels * violet::pcm::GetSampleBytes(format);
+
+    Planar signal(channels, CHECK_FRAMES);
+    FillSignal(signal, random);
+    std::vector<uint8_t> expected(bytes), actual(bytes);
+    violet::pcm::SetSimdLevel(SimdLevel::Scalar);
+    violet::pcm::Encode(signal.ptrs.data(), channels, expected.data(), format, channels, CHECK_FRAMES);
+    violet::pcm::SetSimdLevel(level);
+    violet::pcm::Encode(signal.ptrs.data(), channels, actual.data(), format, channels, CHECK_FRAMES);
+    if (expected != actual) {
+        return Fail("encode differs from scalar", level, format, channels);
+    }
+
+    std::vector<uint8_t> device(bytes);
+    FillDevice(device, format, random);
+    Planar decodedScalar(channels, CHECK_FRAMES), decoded(channels, CHECK_FRAMES);
+    violet::pcm::SetSimdLevel(SimdLevel::Scalar);
+    violet::pcm::Decode(device.data(), format, channels, decodedScalar.ptrs.data(), channels, CHECK_FRAMES);
+    violet::pcm::SetSimdLevel(level);
+    violet::pcm::Decode(device.data(), format, channels, decoded.ptrs.data(), channels, CHECK_FRAMES);
+    if (!SameBits(decodedScalar, decoded)) {
+        return Fail("decode differs from scalar", level, format, channels);
+    }
+
+    // Up to 24 bits, samples survive decode + encode unchanged; 32-bit
+    // integers don't fit a float mantissa
+    if (format == PcmFormat::Int32) {
+        return true;
+    }
+    violet::pcm::Encode(decoded.ptrs.data(), channels, actual.data(), format, channels, CHECK_FRAMES);
+    if (actual != device) {
+        return Fail("round trip is lossy", level, format, channels);
+    }
+    return true;
+}
+
+// Mismatched channel counts: extra source channels dropped, missing ones silent
+bool CheckChannelMismatch(SimdLevel level, PcmFormat format) {
+    violet::pcm::SetSimdLevel(level);
+    std::mt19937 random(7);
+    uint32_t sampleBytes = violet::pcm::GetSampleBytes(format);
+
+    Planar wide(4, CHECK_FRAMES), narrow(2, CHECK_FRAMES);
+    FillSignal(wide, random);
+    std::vector<uint8_t> device(static_cast<size_t>(CHECK_FRAMES) * 4 * sampleBytes);
+    violet::pcm::Encode(wide.ptrs.data(), 4, device.data(), format, 4, CHECK_FRAMES);
+    violet::pcm::Decode(device.data(), format, 4, narrow.ptrs.data(), 2, CHECK_FRAMES);
+    Planar full(4, CHECK_FRAMES);
+    violet::pcm::Decode(device.data(), format, 4, full.ptrs.data(), 4, CHECK_FRAMES);
+    for (uint32_t ch = 0; ch < 2; ++ch) {
+        if (narrow.channels[ch] != full.channels[ch]) {
+            return Fail("dropping decoded channels", level, format, 4);
+        }
+    }
+
+    // Two planar channels into a four-channel device
+    std::vector<uint8_t> padded(device.size(), 0xAA);
+    violet::pcm::Encode(narrow.ptrs.data(), 2, padded.data(), format, 4, CHECK_FRAMES);
+    Planar back(4, CHECK_FRAMES);
+    violet::pcm::Decode(padded.data(), format, 4, back.ptrs.data(), 4, CHECK_FRAMES);
+    for (uint32_t i = 0; i < CHECK_FRAMES; ++i) {
+        if (back.channels[2][i] != 0.0f || back.channels[3][i] != 0.0f) {
+            return Fail("padding encoded channels", level, format, 4);
+        }
+    }
+    for (uint32_t ch = 0; ch < 2; ++ch) {
+        if (back.channels[ch] != narrow.channels[ch]) {
+            return Fail("padding encoded channels", level, format, 4);
+        }
+    }
+
+    // Decoding into more channels than the device has zeroes the rest
+    Planar more(6, CHECK_FRAMES);
+    for (auto& channel : more.channels) {
+        std::fill(channel.begin(), channel.end(), 1.0f);
+    }
+    violet::pcm::Decode(device.data(), format, 4, more.ptrs.data(), 6, CHECK_FRAMES);
+    for (uint32_t i = 0; i < CHECK_FRAMES; ++i) {
+        if (more.channels[4][i] != 0.0f || more.channels[5][i] != 0.0f) {
+            return Fail("zeroing decoded channels", level, format, 6);
+        }
+    }
+    return true;
+}
+
+// Dither stays within +/-1 LSB of the undithered value, averages out, and
+// turns digital silence into low-level noise rather than a constant
+bool CheckDither(SimdLevel level, PcmFormat format, uint32_t channels) {
+    violet::pcm::SetSimdLevel(level);
+    std::mt19937 random(11);
+    double lsb = format == PcmFormat::Int16 ? 1.0 / 32768.0 : 1.0 / 8388608.0;
+    uint32_t sampleBytes = violet::pcm::GetSampleBytes(format);
+    size_t bytes = static_cast<size_t>(CHECK_FRAMES) * channels * sampleBytes;
+
+    Planar signal(channels, CHECK_FRAMES);
+    std::uniform_real_distribution<float> noise(-0.9f, 0.9f);
+    for (auto& channel : signal.channels) {
+        for (float& sample : channel) {
+            sample = noise(random);
+        }
+    }
+
+    violet::pcm::Dither dither(1234);
+    dither.SetEnabled(true);
+    std::vector<uint8_t> plain(bytes), dithered(bytes);
+    violet::pcm::Encode(signal.ptrs.data(), channels, plain.data(), format, channels, CHECK_FRAMES);
+    violet::pcm::Encode(signal.ptrs.data(), channels, dithered.data(), format, channels, CHECK_FRAMES, &dither);
+
+    Planar a(channels, CHECK_FRAMES), b(channels, CHECK_FRAMES);
+    violet::pcm::Decode(plain.data(), format, channels, a.ptrs.data(), channels, CHECK_FRAMES);
+    violet::pcm::Decode(dithered.data(), format, channels, b.ptrs.data(), channels, CHECK_FRAMES);
+    double errorSum = 0.0;
+    uint32_t changed = 0;
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        for (uint32_t i = 0; i < CHECK_FRAMES; ++i) {
+            double difference = (b.channels[ch][i] - signal.channels[ch][i]) / lsb;
+            if (std::fabs(difference) > 1.5) {
+                return Fail("dither exceeds 1 LSB", level, format, channels);
+            }
+            errorSum += difference;
+            changed += a.channels[ch][i] != b.channels[ch][i];
+        }
+    }
+    double samples = static_cast<double>(CHECK_FRAMES) * channels;
+    if (std::fabs(errorSum / samples) > 0.1 || changed < samples / 8) {
+        return Fail("dither is biased or inactive", level, format, channels);
+    }
+
+    // Silence becomes -1/0/+1 LSB noise
+    for (auto& channel : signal.channels) {
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    }
+    violet::pcm::Encode(signal.ptrs.data(), channels, dithered.data(), format, channels, CHECK_FRAMES, &dither);
+    violet::pcm::Decode(dithered.data(), format, channels, b.ptrs.data(), channels, CHECK_FRAMES);
+    uint32_t nonZero = 0;
+    for (const auto& channel : b.channels) {
+        for (float sample : channel) {
+            if (std::fabs(sample / lsb) > 1.0) {
+                return Fail("dithered silence exceeds 1 LSB", level, format, channels);
+            }
+            nonZero += sample != 0.0f;
+        }
+    }
+    if (nonZero == 0) {
+        return Fail("dithered silence is silent", level, format, channels);
+    }
+    return true;
+}
+
+// Interleaved frames written into an AudioBuffer come back unchanged,
+// through both the interleaved and the planar API, across the wrap
+bool CheckAudioBuffer(SimdLevel level, uint32_t channels) {
+    violet::pcm::SetSimdLevel(level);
+    std::mt19937 random(channels);
+    const uint32_t capacity = 700;
+    violet::AudioBuffer buffer(channels, capacity);
+
+    Planar signal(channels, CHECK_FRAMES);
+    FillSignal(signal, random);
+    std::vector<float> interleaved(static_cast<size_t>(CHECK_FRAMES) * channels);
+    violet::pcm::Interleave(signal.ptrs.data(), channels, interleaved.data(), CHECK_FRAMES);
+
+    std::vector<float> readBack(interleaved.size());
+    Planar planar(channels, CHECK_FRAMES);
+    uint32_t written = 0;
+    uint32_t read = 0;
+    bool usePlanar = false;
+    while (read < CHECK_FRAMES) {
+        written += static_cast<uint32_t>(buffer.WriteInterleaved(interleaved.data() + static_cast<size_t>(written) * channels,
+                                                                 std::min(CHECK_FRAMES - written, 300u)));
+        if (usePlanar) {
+            std::vector<float*> ptrs(channels);
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                ptrs[ch] = planar.ptrs[ch] + read;
+            }
+            uint32_t count = static_cast<uint32_t>(buffer.Read(ptrs.data(), 250));
+            std::vector<const float*> sources(ptrs.begin(), ptrs.end());
+            violet::pcm::Interleave(sources.data(), channels, readBack.data() + static_cast<size_t>(read) * channels, count);
+            read += count;
+        } else {
+            read += static_cast<uint32_t>(buffer.ReadInterleaved(readBack.data() + static_cast<size_t>(read) * channels, 250));
+        }
+        usePlanar = !usePlanar;
+    }
+    if (memcmp(readBack.data(), interleaved.data(), interleaved.size() * sizeof(float)) != 0 || !buffer.IsEmpty()) {
+        return Fail("AudioBuffer transfer", level, PcmFormat::Float32, channels);
+    }
+    return true;
+}
+
+bool RunChecks() {
+    bool passed = true;
+    uint32_t checks = 0;
+    for (SimdLevel level : GetLevels()) {
+        for (PcmFormat format : ALL_FORMATS) {
+            for (uint32_t channels : CHECK_CHANNELS) {
+                passed &= CheckAgainstScalar(level, format, channels);
+                ++checks;
+                if (format == PcmFormat::Int16 || format == PcmFormat::Int24 || format == PcmFormat::Int24In32) {
+                    passed &= CheckDither(level, format, channels);
+                    ++checks;
+                }
+            }
+            passed &= CheckChannelMismatch(level, format);
+            ++checks;
+        }
+        for (uint32_t channels : CHECK_CHANNELS) {
+            passed &= CheckAudioBuffer(level, channels);
+            ++checks;
+        }
+    }
+    std::cerr << checks << " PCM checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed;
+}
+
+BenchResult RunCase(const BenchOptions& options, SimdLevel level, PcmFormat format, uint32_t channels,
+                    bool encode, bool useDither) {
+    violet::pcm::SetSimdLevel(level);
+    std::mt19937 random(5);
+    Planar planar(channels, options.frames);
+    FillSignal(planar, random);
+    std::vector<uint8_t> device(static_cast<size_t>(options.frames) * channels * violet::pcm::GetSampleBytes(format));
+    FillDevice(device, format, random);
+    violet::pcm::Dither dither;
+    dither.SetEnabled(useDither);
+
+    auto run = [&]() {
+        if (encode) {
+            violet::pcm::Encode(planar.ptrs.data(), channels, device.data(), format, channels, options.frames, &dither);
+        } else {
+            violet::pcm::Decode(device.data(), format, channels, planar.ptrs.data(), channels, options.frames);
+        }
+    };
+
+    // Calibrate the iteration count on a short run, then time the batch
+    uint64_t iterations = 16;
+    uint64_t elapsed = 0;
+    for (;;) {
+        uint64_t start = violet::MonotonicNanos();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            run();
+        }
+        elapsed = violet::MonotonicNanos() - start;
+        if (elapsed >= options.seconds * 1e9 / 4 || iterations >= (1ull << 40)) {
+            break;
+        }
+        iterations *= 4;
+    }
+
+    BenchResult result;
+    result.level = level;
+    result.format = format;
+    result.channels = channels;
+    result.encode = encode;
+    result.dither = useDither;
+    result.nsPerSample = static_cast<double>(elapsed) / (static_cast<double>(iterations) * options.frames * channels);
+    return result;
+}
+
+void AddResult(bench::Report& report, const BenchResult& r) {
+    report.AddResult()
+        .Add("level", violet::pcm::GetSimdLevelName(r.level))
+        .Add("format", violet::pcm::GetFormatName(r.format))
+        .Add("channels", r.channels)
+        .Add("direction", r.encode ? "encode" : "decode")
+        .Add("dither", r.dither)
+        .Add("nsPerSample", r.nsPerSample);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-pcm-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddOption("--channels", "list", options.channelCounts);
+    parser.AddOption("--frames", "n", options.frames);
+    parser.AddOption("--seconds", "s", options.seconds);
+    parser.AddOption("--output", "file.json", options.outputPath);
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+    if (options.channelCounts.empty() || options.frames == 0 || options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+
+    SimdLevel defaultLevel = violet::pcm::GetSimdLevel();
+    bool passed = RunChecks();
+    violet::pcm::SetSimdLevel(defaultLevel);
+    if (!passed) {
+        return 1;
+    }
+    if (options.checkOnly) {
+        return 0;
+    }
+
+    bench::Report report;
+    report.Add("frames", options.frames);
+    report.Add("maxSimdLevel", violet::pcm::GetSimdLevelName(violet::pcm::GetMaxSimdLevel()));
+    for (PcmFormat format : ALL_FORMATS) {
+        for (uint32_t channels : options.channelCounts) {
+            for (bool encode : { false, true }) {
+                for (SimdLevel level : GetLevels()) {
+                    BenchResult result = RunCase(options, level, format, channels, encode, false);
+                    std::cerr << violet::pcm::GetFormatName(format) << " " << channels << "ch "
+                              << (encode ? "encode" : "decode") << " " << violet::pcm::GetSimdLevelName(level)
+                              << ": " << result.nsPerSample << " ns/sample" << std::endl;
+                    AddResult(report, result);
+                }
+            }
+        }
+    }
+
+    // Dither cost, on the format it matters most for
+    for (uint32_t channels : options.channelCounts) {
+        for (SimdLevel level : GetLevels()) {
+            AddResult(report, RunCase(options, level, PcmFormat::Int16, channels, true, true));
+        }
+    }
+    violet::pcm::SetSimdLevel(defaultLevel);
+
+    return report.Save(options.outputPath) ? 0 : 1;
+}
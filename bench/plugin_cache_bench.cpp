@@ -0,0 +1,574 @@
+// violet-plugin-cache-bench: checks the plugin metadata cache and measures
+// what populating the plugin list from it costs
+//
+//   violet-plugin-cache-bench [options]
+//
+//   --check-only              run the checks, skip the benchmark
+//   --bundles <n>             synthetic bundles in the benchmark (default 500)
+//   --parameters <n>          control inputs per synthetic plugin (default 24)
+//   --lv2-path <dir>          where to find the reference bundle
+//
+// The checks cover finding and fingerprinting bundles on disk, a save/load
+// round trip of every field, rejecting damaged files, and a PluginManager
+// started on a warm cache: its list is there before the background scan
+// has loaded lilv, and the scan parses nothing; in lazy mode it loads only
+// the bundle of the plugin it instantiates. The benchmark times the
+// startup path (listing the bundles, mapping the cache and decoding the
+// list) and a rewrite of the cache over synthetic bundles.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "violet/performance_stats.h"
+#include "violet/plugin_cache.h"
+#include "violet/plugin_manager.h"
+#include "violet/utils.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifndef VIOLET_BENCH_LV2_PATH
+#define VIOLET_BENCH_LV2_PATH ""
+#endif
+
+namespace {
+
+namespace utils = violet::utils;
+using utils::JoinPath;
+
+struct BenchOptions {
+    bool checkOnly = false;
+    uint32_t bundles = 500;
+    uint32_t parameters = 24;
+    std::string lv2Path = VIOLET_BENCH_LV2_PATH;
+};
+
+// Files and directories made under the work directory, removed in reverse
+class ScratchTree {
+public:
+    explicit ScratchTree(const std::string& root) : root_(root) {
+        MakeDirectory(root_);
+    }
+
+    ~ScratchTree() {
+        for (auto it = paths_.rbegin(); it != paths_.rend(); ++it) {
+#ifdef _WIN32
+            if (!DeleteFileA(it->c_str())) {
+                RemoveDirectoryA(it->c_str());
+            }
+#else
+            std::remove(it->c_str());
+#endif
+        }
+    }
+
+    const std::string& GetRoot() const { return root_; }
+
+    std::string MakeDirectory(const std::string& path) {
+        if (utils::MakeDirectory(path) && std::find(paths_.begin(), paths_.end(), path) == paths_.end()) {
+            paths_.push_back(path);
+        }
+        return path;
+    }
+
+    bool WriteFile(const std::string& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+        if (std::find(paths_.begin(), paths_.end(), path) == paths_.end()) {
+            paths_.push_back(path);
+        }
+        return static_cast<bool>(file);
+    }
+
+    // Files something else created in the tree
+    void Track(const std::string& path) {
+        paths_.push_back(path);
+    }
+
+private:
+    std::string root_;
+    std::vector<std::string> paths_;
+};
+
+bool Fail(const std::string& what) {
+    std::cerr << "FAIL " << what << std::endl;
+    return false;
+}
+
+std::string GetTempDirectory() {
+#ifdef _WIN32
+    const char* temp = getenv("TEMP");
+    return temp && *temp ? temp : ".";
+#else
+    const char* temp = getenv("TMPDIR");
+    return temp && *temp ? temp : "/tmp";
+#endif
+}
+
+// A bundle with a manifest, plugin data and a binary, as lilv would find it
+std::string MakeBundle(ScratchTree& tree, const std::string& directory, uint32_t number) {
+    std::string bundle = tree.MakeDirectory(JoinPath(directory, "synth" + std::to_string(number) + ".lv2"));
+    tree.WriteFile(JoinPath(bundle, "manifest.ttl"), "<urn:violet:synth:" + std::to_string(number) + "> a lv2:Plugin .\n");
+    tree.WriteFile(JoinPath(bundle, "synth.ttl"), std::string(2000 + number, '#'));
+    tree.WriteFile(JoinPath(bundle, "synth.so"), std::string(4096, '\0'));
+    return violet::NormalizeBundlePath(bundle);
+}
+
+violet::CachedPlugin MakePlugin(uint32_t bundle, uint32_t plugin, uint32_t parameters) {
+    violet::CachedPlugin cached;
+    violet::PluginInfo& info = cached.info;
+    info.uri = "urn:violet:synth:" + std::to_string(bundle) + ":" + std::to_string(plugin);
+    info.name = "Synthetic " + std::to_string(bundle) + "." + std::to_string(plugin);
+    info.author = "Author " + std::to_string(bundle % 7);
+    info.category = plugin % 2 ? "Effect" : "Generator";
+    info.description = bundle % 3 ? "" : "Described";
+    info.hasUI = bundle % 2 == 0;
+    info.inPlaceBroken = plugin % 3 == 1;
+    info.audioInputs = plugin % 2 ? 2 : 0;
+    info.audioOutputs = 2;
+    info.controlInputs = parameters;
+    info.controlOutputs = 1;
+    info.midiInputs = bundle % 2;
+    info.midiOutputs = 0;
+
+    for (uint32_t i = 0; i < parameters; ++i) {
+        violet::ParameterInfo parameter;
+        parameter.index = i;
+        parameter.portIndex = i + 3;
+        parameter.symbol = "param" + std::to_string(i);
+        parameter.name = "Parameter " + std::to_string(i);
+        parameter.defaultValue = 0.25f * static_cast<float>(i);
+        parameter.minimum = -static_cast<float>(i);
+        parameter.maximum = 100.0f + static_cast<float>(bundle);
+        parameter.isToggle = i % 5 == 1;
+        parameter.isInteger = i % 4 == 2;
+        parameter.isEnum = i % 6 == 3;
+        if (parameter.isEnum) {
+            parameter.enumValues = { "Off", "Low", "High " + std::to_string(i) };
+        }
+        cached.parameters.push_back(std::move(parameter));
+    }
+    return cached;
+}
+
+bool SamePlugin(const violet::PluginInfo& a, const violet::PluginInfo& b) {
+    return a.uri == b.uri && a.name == b.name && a.author == b.author && a.category == b.category &&
+           a.description == b.description && a.hasUI == b.hasUI && a.inPlaceBroken == b.inPlaceBroken &&
+           a.audioInputs == b.audioInputs && a.audioOutputs == b.audioOutputs &&
+           a.controlInputs == b.controlInputs && a.controlOutputs == b.controlOutputs &&
+           a.midiInputs == b.midiInputs && a.midiOutputs == b.midiOutputs;
+}
+
+bool SameParameters(const std::vector<violet::ParameterInfo>& a, const std::vector<violet::ParameterInfo>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        const violet::ParameterInfo& x = a[i];
+        const violet::ParameterInfo& y = b[i];
+        if (x.index != y.index || x.portIndex != y.portIndex || x.symbol != y.symbol || x.name != y.name ||
+            x.defaultValue != y.defaultValue || x.minimum != y.minimum || x.maximum != y.maximum ||
+            x.isToggle != y.isToggle || x.isInteger != y.isInteger || x.isEnum != y.isEnum ||
+            x.enumValues != y.enumValues) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Synthetic bundles on disk and the cache entries for them
+std::vector<violet::CachedBundle> MakeBundles(ScratchTree& tree, const std::string& directory,
+                                              uint32_t count, uint32_t parameters) {
+    std::vector<violet::CachedBundle> bundles;
+    for (uint32_t b = 0; b < count; ++b) {
+        violet::CachedBundle bundle;
+        bundle.path = MakeBundle(tree, directory, b);
+        bundle.fingerprint = violet::FingerprintBundle(bundle.path);
+        for (uint32_t p = 0; p < 1 + b % 3; ++p) {
+            bundle.plugins.push_back(MakePlugin(b, p, parameters));
+        }
+        bundles.push_back(std::move(bundle));
+    }
+    return bundles;
+}
+
+bool CheckBundleDiscovery(ScratchTree& tree) {
+    std::string first = tree.MakeDirectory(JoinPath(tree.GetRoot(), "discovery-a"));
+    std::string second = tree.MakeDirectory(JoinPath(tree.GetRoot(), "discovery-b"));
+    std::string bundleA = MakeBundle(tree, first, 1);
+    std::string bundleB = MakeBundle(tree, second, 2);
+    std::string bundleC = MakeBundle(tree, second, 3);
+    // Neither of these is a bundle
+    std::string notBundle = tree.MakeDirectory(JoinPath(second, "data.lv2"));
+    tree.WriteFile(JoinPath(notBundle, "plugin.ttl"), "no manifest");
+    tree.WriteFile(JoinPath(second, "stray.ttl"), "not a directory");
+
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+    std::string searchPath = first + separator + JoinPath(tree.GetRoot(), "missing") + separator + second +
+                             separator + first;
+    std::vector<violet::BundleFingerprint> found = violet::FindBundles(searchPath);
+    std::vector<std::string> paths;
+    for (const auto& bundle : found) {
+        paths.push_back(bundle.path);
+        if (bundle.fingerprint != violet::FingerprintBundle(bundle.path)) {
+            return Fail("fingerprint of " + bundle.path + " differs between FindBundles and FingerprintBundle");
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    std::vector<std::string> expected = { bundleA, bundleB, bundleC };
+    std::sort(expected.begin(), expected.end());
+    if (paths != expected) {
+        return Fail("found " + std::to_string(paths.size()) + " bundles, expected 3");
+    }
+    if (violet::NormalizeBundlePath(bundleA + "/") != bundleA) {
+        return Fail("trailing separator not normalized");
+    }
+
+    // Editing a file or adding one changes the fingerprint, nothing else does
+    uint64_t before = violet::FingerprintBundle(bundleB);
+    uint64_t untouched = violet::FingerprintBundle(bundleC);
+    if (before == 0 || before != violet::FingerprintBundle(bundleB)) {
+        return Fail("fingerprint is not stable");
+    }
+    tree.WriteFile(JoinPath(bundleB, "synth.ttl"), "edited");
+    uint64_t edited = violet::FingerprintBundle(bundleB);
+    tree.WriteFile(JoinPath(bundleB, "presets.ttl"), "added");
+    uint64_t added = violet::FingerprintBundle(bundleB);
+    if (edited == before || added == edited) {
+        return Fail("fingerprint missed a change to the bundle");
+    }
+    if (violet::FingerprintBundle(bundleC) != untouched) {
+        return Fail("fingerprint of an untouched bundle changed");
+    }
+    if (violet::FingerprintBundle(JoinPath(tree.GetRoot(), "missing")) != 0) {
+        return Fail("fingerprint of a missing bundle is not 0");
+    }
+    return true;
+}
+
+bool CheckRoundTrip(ScratchTree& tree) {
+    std::string directory = tree.MakeDirectory(JoinPath(tree.GetRoot(), "roundtrip"));
+    std::vector<violet::CachedBundle> bundles = MakeBundles(tree, directory, 12, 9);
+    std::string path = JoinPath(tree.GetRoot(), "roundtrip.cache");
+    tree.Track(path);
+    if (!violet::PluginCache::Save(path, bundles)) {
+        return Fail("cannot write " + path);
+    }
+
+    violet::PluginCache cache;
+    if (!cache.Load(path)) {
+        return Fail("cannot load the cache just written");
+    }
+    size_t pluginCount = 0;
+    for (const auto& bundle : bundles) {
+        pluginCount += bundle.plugins.size();
+    }
+    if (cache.GetBundleCount() != bundles.size() || cache.GetPluginCount() != pluginCount) {
+        return Fail("cache holds " + std::to_string(cache.GetBundleCount()) + " bundles, " +
+                    std::to_string(cache.GetPluginCount()) + " plugins");
+    }
+
+    for (const auto& bundle : bundles) {
+        uint64_t fingerprint = 0;
+        if (!cache.FindBundle(bundle.path, fingerprint) || fingerprint != bundle.fingerprint) {
+            return Fail("bundle " + bundle.path + " not found with its fingerprint");
+        }
+        std::vector<violet::PluginInfo> plugins = cache.GetBundlePlugins(bundle.path);
+        violet::CachedBundle read;
+        if (plugins.size() != bundle.plugins.size() || !cache.ReadBundle(bundle.path, read) ||
+            read.plugins.size() != bundle.plugins.size()) {
+            return Fail("bundle " + bundle.path + " lost plugins");
+        }
+        for (size_t i = 0; i < plugins.size(); ++i) {
+            const violet::CachedPlugin& expected = bundle.plugins[i];
+            std::vector<violet::ParameterInfo> parameters;
+            if (!SamePlugin(plugins[i], expected.info) || !SamePlugin(read.plugins[i].info, expected.info)) {
+                return Fail("plugin " + expected.info.uri + " differs after the round trip");
+            }
+            if (!cache.GetParameters(expected.info.uri, parameters) ||
+                !SameParameters(parameters, expected.parameters) ||
+                !SameParameters(read.plugins[i].parameters, expected.parameters)) {
+                return Fail("parameters of " + expected.info.uri + " differ after the round trip");
+            }
+        }
+    }
+
+    uint64_t fingerprint = 0;
+    std::vector<violet::ParameterInfo> parameters;
+    if (cache.FindBundle(directory + "/nothing.lv2", fingerprint) || !cache.GetBundlePlugins("").empty() ||
+        cache.GetParameters("urn:violet:nothing", parameters)) {
+        return Fail("lookup of something not cached succeeded");
+    }
+
+    // An empty cache is a valid one
+    std::string emptyPath = JoinPath(tree.GetRoot(), "empty.cache");
+    tree.Track(emptyPath);
+    if (!violet::PluginCache::Save(emptyPath, {}) || !cache.Load(emptyPath) || cache.GetBundleCount() != 0) {
+        return Fail("empty cache round trip");
+    }
+    return true;
+}
+
+bool CheckDamagedFiles(ScratchTree& tree) {
+    std::string directory = tree.MakeDirectory(JoinPath(tree.GetRoot(), "damage"));
+    std::vector<violet::CachedBundle> bundles = MakeBundles(tree, directory, 4, 3);
+    std::string path = JoinPath(tree.GetRoot(), "damage.cache");
+    tree.Track(path);
+    if (!violet::PluginCache::Save(path, bundles)) {
+        return Fail("cannot write " + path);
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::string original((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    struct Damage {
+        const char* name;
+        std::string contents;
+    };
+    std::string flipped = original;
+    flipped[original.size() / 2] ^= 0x20;
+    std::string otherVersion = original;
+    otherVersion[8] ^= 0x01;
+    std::vector<Damage> damages = {
+        { "a flipped byte", flipped },
+        { "another version", otherVersion },
+        { "a truncated file", original.substr(0, original.size() - 5) },
+        { "a header only", original.substr(0, 40) },
+        { "an empty file", "" },
+        { "text", "this is not a plugin cache, nowhere near one\n" },
+    };
+
+    bool passed = true;
+    violet::PluginCache cache;
+    for (const Damage& damage : damages) {
+        tree.WriteFile(path, damage.contents);
+        if (cache.Load(path) || cache.IsLoaded() || cache.GetPluginCount() != 0) {
+            passed = Fail("loaded " + std::string(damage.name));
+        }
+    }
+    if (cache.Load(JoinPath(tree.GetRoot(), "missing.cache"))) {
+        passed = Fail("loaded a missing file");
+    }
+    return passed;
+}
+
+bool SameUris(std::vector<violet::PluginInfo> a, std::vector<violet::PluginInfo> b) {
+    auto byUri = [](const violet::PluginInfo& x, const violet::PluginInfo& y) { return x.uri < y.uri; };
+    std::sort(a.begin(), a.end(), byUri);
+    std::sort(b.begin(), b.end(), byUri);
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!SamePlugin(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A cold start writes the cache; a warm one lists the same plugins before
+// lilv has loaded anything, and its scan finds nothing to parse
+bool CheckPluginManager(ScratchTree& tree) {
+    std::string path = JoinPath(tree.GetRoot(), "manager.cache");
+    tree.Track(path);
+
+    std::vector<violet::PluginInfo> scanned;
+    std::string uri;
+    std::vector<violet::ParameterInfo> instanceParameters;
+    {
+        violet::PluginManager manager;
+        manager.SetCachePath(path);
+        if (!manager.Initialize()) {
+            return Fail("cold plugin manager did not initialize");
+        }
+        manager.WaitForScan();
+        scanned = manager.GetAvailablePlugins();
+        if (scanned.empty()) {
+            std::cerr << "No LV2 plugins found, skipping the plugin manager check" << std::endl;
+            return true;
+        }
+        uri = scanned.front().uri;
+        auto instance = manager.CreatePlugin(uri, 48000.0, 256);
+        if (!instance) {
+            return Fail("cannot instantiate " + uri);
+        }
+        instanceParameters = instance->GetParameters();
+    }
+    if (!utils::FileExists(path)) {
+        return Fail("cold start wrote no cache");
+    }
+
+    violet::PluginManager manager;
+    manager.SetCachePath(path);
+    std::atomic<bool> changed(false);
+    manager.SetPluginsChangedCallback([&changed] { changed = true; });
+    if (!manager.Initialize()) {
+        return Fail("warm plugin manager did not initialize");
+    }
+    std::vector<violet::PluginInfo> cached = manager.GetAvailablePlugins();
+    std::vector<violet::ParameterInfo> cachedParameters = manager.GetPluginParameters(uri);
+    manager.WaitForScan();
+
+    bool passed = true;
+    if (!SameUris(cached, scanned)) {
+        passed = Fail("warm start listed " + std::to_string(cached.size()) + " plugins before the scan, " +
+                      std::to_string(scanned.size()) + " expected");
+    }
+    if (!SameParameters(cachedParameters, instanceParameters)) {
+        passed = Fail("cached parameters of " + uri + " differ from the instance's");
+    }
+    if (changed || !SameUris(manager.GetAvailablePlugins(), scanned)) {
+        passed = Fail("warm scan changed the plugin list");
+    }
+    return passed;
+}
+
+// A lazy manager on a warm cache scans nothing up front and instantiates a
+// cached plugin from its bundle alone; an unknown URI loads everything
+bool CheckLazyLoading(ScratchTree& tree) {
+    std::string path = JoinPath(tree.GetRoot(), "lazy.cache");
+    tree.Track(path);
+
+    std::vector<violet::PluginInfo> scanned;
+    {
+        violet::PluginManager manager;
+        manager.SetCachePath(path);
+        if (!manager.Initialize()) {
+            return Fail("cold plugin manager did not initialize");
+        }
+        manager.WaitForScan();
+        scanned = manager.GetAvailablePlugins();
+    }
+    if (scanned.empty()) {
+        std::cerr << "No LV2 plugins found, skipping the lazy loading check" << std::endl;
+        return true;
+    }
+
+    violet::PluginManager manager;
+    manager.SetCachePath(path);
+    manager.SetLazyLoading(true);
+    if (!manager.Initialize()) {
+        return Fail("lazy plugin manager did not initialize");
+    }
+
+    bool passed = true;
+    if (manager.IsScanning()) {
+        passed = Fail("lazy plugin manager started a scan");
+    }
+    if (!SameUris(manager.GetAvailablePlugins(), scanned)) {
+        passed = Fail("lazy plugin manager did not list the cached plugins");
+    }
+    std::string uri = scanned.back().uri;
+    if (!manager.CreatePlugin(uri, 48000.0, 256)) {
+        passed = Fail("lazy plugin manager cannot instantiate " + uri);
+    }
+    if (manager.HasLoadedAllBundles()) {
+        passed = Fail("instantiating a cached plugin loaded every bundle");
+    }
+
+    if (manager.CreatePlugin("urn:violet:bench:no-such-plugin", 48000.0, 256)) {
+        passed = Fail("instantiated a plugin that does not exist");
+    }
+    if (!manager.HasLoadedAllBundles()) {
+        passed = Fail("an unknown URI did not load every bundle");
+    }
+    manager.WaitForScan();
+    if (!SameUris(manager.GetAvailablePlugins(), scanned)) {
+        passed = Fail("scan after the lazy start changed the plugin list");
+    }
+    return passed;
+}
+
+bool RunChecks(ScratchTree& tree) {
+    bool passed = CheckBundleDiscovery(tree);
+    passed = CheckRoundTrip(tree) && passed;
+    passed = CheckDamagedFiles(tree) && passed;
+    passed = CheckPluginManager(tree) && passed;
+    passed = CheckLazyLoading(tree) && passed;
+    std::cerr << "Plugin cache checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed;
+}
+
+double MillisecondsSince(uint64_t start) {
+    return static_cast<double>(violet::MonotonicNanos() - start) / 1e6;
+}
+
+void RunBenchmark(ScratchTree& tree, const BenchOptions& options) {
+    std::string directory = tree.MakeDirectory(JoinPath(tree.GetRoot(), "bench"));
+    std::vector<violet::CachedBundle> bundles = MakeBundles(tree, directory, options.bundles, options.parameters);
+    std::string path = JoinPath(tree.GetRoot(), "bench.cache");
+    tree.Track(path);
+
+    uint64_t start = violet::MonotonicNanos();
+    violet::PluginCache::Save(path, bundles);
+    double saveMs = MillisecondsSince(start);
+
+    // What PluginManager::Initialize() does before the browser has its list
+    start = violet::MonotonicNanos();
+    std::vector<violet::BundleFingerprint> found = violet::FindBundles(directory);
+    double findMs = MillisecondsSince(start);
+
+    start = violet::MonotonicNanos();
+    violet::PluginCache cache;
+    cache.Load(path);
+    std::vector<violet::PluginInfo> plugins;
+    for (const auto& bundle : found) {
+        uint64_t fingerprint = 0;
+        if (cache.FindBundle(bundle.path, fingerprint) && fingerprint == bundle.fingerprint) {
+            std::vector<violet::PluginInfo> bundlePlugins = cache.GetBundlePlugins(bundle.path);
+            plugins.insert(plugins.end(), bundlePlugins.begin(), bundlePlugins.end());
+        }
+    }
+    double populateMs = MillisecondsSince(start);
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::cout << options.bundles << " bundles, " << plugins.size() << " plugins, "
+              << options.parameters << " parameters each, cache " << in.tellg() / 1024 << " KiB\n"
+              << "find and fingerprint bundles: " << findMs << " ms\n"
+              << "load cache and list plugins:  " << populateMs << " ms\n"
+              << "write cache:                  " << saveMs << " ms" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-plugin-cache-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddOption("--bundles", "n", options.bundles);
+    parser.AddOption("--parameters", "n", options.parameters);
+    parser.AddOption("--lv2-path", "dir", options.lv2Path);
+
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+    if (options.bundles == 0) {
+        parser.PrintUsage();
+        return 1;
+    }
+
+    // Only the reference bundle, whatever is installed
+    bench::AddLv2Path(options.lv2Path, true);
+
+    ScratchTree tree(JoinPath(GetTempDirectory(), "violet-plugin-cache-" + std::to_string(violet::MonotonicNanos())));
+    if (!RunChecks(tree)) {
+        return 1;
+    }
+    if (!options.checkOnly) {
+        RunBenchmark(tree, options);
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+// violet-resampler-bench: checks the polyphase sample rate converter and
+// times it at every quality preset and SIMD level
+//
+//   violet-resampler-bench [options]
+//
+//   --check-only              run the checks, skip the benchmark
+//   --rates <in:out>          rate pair to benchmark (default 44100:48000)
+//   --channels <n>            channels in the benchmark (default 2)
+//   --block <frames>          input frames per call (default 256)
+//   --seconds <s>             time spent per benchmark case (default 0.5)
+//   --output <file.json>      write the JSON report to a file instead of stdout
+//
+// The checks measure passband accuracy and stopband rejection with sine
+// tones, compare every SIMD level against the scalar kernel, and make sure
+// odd block sizes produce exactly what one big call does.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_common.h"
+#include "violet/pcm_convert.h"
+#include "violet/performance_stats.h"
+#include "violet/resampler.h"
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+const violet::ResamplerQuality QUALITIES[] = {
+    violet::ResamplerQuality::Fast,
+    violet::ResamplerQuality::Balanced,
+    violet::ResamplerQuality::High,
+    violet::ResamplerQuality::Best,
+};
+
+// Per quality: worst passband SNR and stopband leakage allowed, in dB
+const double MIN_SNR[] = { 45.0, 65.0, 85.0, 100.0 };
+const double MAX_ALIAS[] = { -45.0, -65.0, -85.0, -100.0 };
+
+struct BenchOptions {
+    bool checkOnly = false;
+    uint32_t inputRate = 44100;
+    uint32_t outputRate = 48000;
+    uint32_t channels = 2;
+    uint32_t block = 256;
+    double seconds = 0.5;
+    std::string outputPath;
+};
+
+struct BenchResult {
+    violet::ResamplerQuality quality = violet::ResamplerQuality::Fast;
+    violet::SimdLevel level = violet::SimdLevel::Scalar;
+    double nsPerFrame = 0.0;        // per output frame, all channels
+};
+
+bool Fail(const std::string& what) {
+    std::cerr << "FAIL " << what << std::endl;
+    return false;
+}
+
+std::vector<violet::SimdLevel> GetLevels() {
+    std::vector<violet::SimdLevel> levels;
+    for (violet::SimdLevel level : { violet::SimdLevel::Scalar, violet::SimdLevel::Sse2, violet::SimdLevel::Avx2 }) {
+        if (level <= violet::pcm::GetMaxSimdLevel()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+// Runs a mono signal through in blocks of `block` frames
+std::vector<float> Convert(const std::vector<float>& input, uint32_t inputRate, uint32_t outputRate,
+                           violet::ResamplerQuality quality, uint32_t block) {
+    violet::Resampler resampler;
+    resampler.Configure(1, inputRate, outputRate, quality, block);
+    std::vector<float> output(resampler.GetMaxOutputFrames(static_cast<uint32_t>(input.size())) + input.size() / block + 1);
+    size_t written = 0;
+    for (size_t offset = 0; offset < input.size(); offset += block) {
+        uint32_t frames = static_cast<uint32_t>(std::min<size_t>(block, input.size() - offset));
+        const float* in = input.data() + offset;
+        float* out = output.data() + written;
+        written += resampler.Process(&in, frames, &out);
+    }
+    output.resize(written);
+    return output;
+}
+
+std::vector<float> Sine(double frequency, uint32_t rate, size_t frames) {
+    std::vector<float> signal(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        signal[i] = static_cast<float>(0.5 * std::sin(2.0 * PI * frequency * i / rate));
+    }
+    return signal;
+}
+
+// A tone well inside the passband comes out as the same tone, delayed by
+// the reported latency
+bool CheckPassband(uint32_t inputRate, uint32_t outputRate, size_t qualityIndex) {
+    violet::ResamplerQuality quality = QUALITIES[qualityIndex];
+    double frequency = 997.0;
+    std::vector<float> output = Convert(Sine(frequency, inputRate, inputRate), inputRate, outputRate, quality, 512);
+
+    violet::Resampler resampler;
+    resampler.Configure(1, inputRate, outputRate, quality, 512);
+    double latency = resampler.GetLatency();
+
+    double signal = 0.0, noise = 0.0;
+    for (size_t n = output.size() / 4; n < output.size() * 3 / 4; ++n) {
+        double expected = 0.5 * std::sin(2.0 * PI * frequency * (n - latency) / outputRate);
+        signal += expected * expected;
+        noise += (output[n] - expected) * (output[n] - expected);
+    }
+    double snr = 10.0 * std::log10(signal / std::max(noise, 1e-30));
+    if (snr < MIN_SNR[qualityIndex]) {
+        return Fail(std::to_string(inputRate) + " -> " + std::to_string(outputRate) + " " +
+                    violet::GetResamplerQualityName(quality) + ": " + std::to_string(snr) + " dB SNR");
+    }
+    return true;
+}
+
+// Downsampling: a tone above the output Nyquist frequency is removed rather
+// than folded back. Upsampling images show up as passband error instead.
+bool CheckStopband(uint32_t inputRate, uint32_t outputRate, size_t qualityIndex) {
+    violet::ResamplerQuality quality = QUALITIES[qualityIndex];
+    double frequency = outputRate * 0.5 * 1.1;
+    std::vector<float> output = Convert(Sine(frequency, inputRate, inputRate), inputRate, outputRate, quality, 512);
+
+    double energy = 0.0;
+    size_t count = 0;
+    for (size_t n = output.size() / 4; n < output.size() * 3 / 4; ++n, ++count) {
+        energy += output[n] * output[n];
+    }
+    double leakage = 10.0 * std::log10(std::max(energy / count, 1e-30) / 0.125);
+    if (leakage > MAX_ALIAS[qualityIndex]) {
+        return Fail(std::to_string(inputRate) + " -> " + std::to_string(outputRate) + " " +
+                    violet::GetResamplerQualityName(quality) + ": " + std::to_string(leakage) + " dB alias");
+    }
+    return true;
+}
+
+bool CheckTones() {
+    const uint32_t pairs[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 48000, 96000 }, { 96000, 44100 } };
+    bool passed = true;
+    for (const auto& pair : pairs) {
+        for (size_t q = 0; q < 4; ++q) {
+            passed &= CheckPassband(pair[0], pair[1], q);
+            if (pair[0] > pair[1]) {
+                passed &= CheckStopband(pair[0], pair[1], q);
+            }
+        }
+    }
+    return passed;
+}
+
+// Random block sizes give the same samples as one call, and the output
+// count tracks the ratio exactly
+bool CheckStreaming() {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> input(44100 * 3);
+    for (float& sample : input) {
+        sample = noise(random);
+    }
+    std::vector<float> reference = Convert(input, 44100, 48000, violet::ResamplerQuality::High,
+                                           static_cast<uint32_t>(input.size()));
+
+    violet::Resampler resampler;
+    resampler.Configure(1, 44100, 48000, violet::ResamplerQuality::High, 1000);
+    std::uniform_int_distribution<uint32_t> blocks(1, 1000);
+    std::vector<float> output(reference.size() + 16);
+    size_t written = 0;
+    for (size_t offset = 0; offset < input.size();) {
+        uint32_t frames = static_cast<uint32_t>(std::min<size_t>(blocks(random), input.size() - offset));
+        const float* in = input.data() + offset;
+        float* out = output.data() + written;
+        uint32_t produced = resampler.Process(&in, frames, &out);
+        if (produced > resampler.GetMaxOutputFrames(frames)) {
+            return Fail("more output than GetMaxOutputFrames()");
+        }
+        written += produced;
+        offset += frames;
+    }
+    if (written != reference.size() || written != input.size() / 147 * 160) {
+        return Fail("streamed " + std::to_string(written) + " frames, expected " + std::to_string(reference.size()));
+    }
+    for (size_t i = 0; i < written; ++i) {
+        if (output[i] != reference[i]) {
+            return Fail("streamed output differs at frame " + std::to_string(i));
+        }
+    }
+    return true;
+}
+
+// Every SIMD level agrees with the scalar kernel
+bool CheckSimdLevels() {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> input(48000);
+    for (float& sample : input) {
+        sample = noise(random);
+    }
+
+    violet::SimdLevel original = violet::pcm::GetSimdLevel();
+    bool passed = true;
+    for (violet::ResamplerQuality quality : QUALITIES) {
+        violet::pcm::SetSimdLevel(violet::SimdLevel::Scalar);
+        std::vector<float> reference = Convert(input, 48000, 44100, quality, 333);
+        for (violet::SimdLevel level : GetLevels()) {
+            violet::pcm::SetSimdLevel(level);
+            std::vector<float> output = Convert(input, 48000, 44100, quality, 333);
+            float worst = 0.0f;
+            for (size_t i = 0; i < output.size() && i < reference.size(); ++i) {
+                worst = std::max(worst, std::fabs(output[i] - reference[i]));
+            }
+            if (output.size() != reference.size() || worst > 1e-5f) {
+                passed = Fail(std::string(violet::pcm::GetSimdLevelName(level)) + " " +
+                              violet::GetResamplerQualityName(quality) + " differs by " + std::to_string(worst));
+            }
+        }
+    }
+    violet::pcm::SetSimdLevel(original);
+    return passed;
+}
+
+// Tables are built once per reduced ratio; absurd ratios are refused
+bool CheckFilterCache() {
+    auto a = violet::GetResamplerFilter(44100, 48000, violet::ResamplerQuality::High);
+    auto b = violet::GetResamplerFilter(88200, 96000, violet::ResamplerQuality::High);
+    auto c = violet::GetResamplerFilter(44100, 48000, violet::ResamplerQuality::Fast);
+    if (!a || a != b || a == c || a->upFactor != 160 || a->downFactor != 147) {
+        return Fail("filter cache");
+    }
+    if (violet::GetResamplerFilter(48000, 47999, violet::ResamplerQuality::High)) {
+        return Fail("47999 Hz needs too many phases and must be refused");
+    }
+    violet::Resampler passthrough;
+    if (!passthrough.Configure(2, 48000, 48000, violet::ResamplerQuality::High, 64) ||
+        !passthrough.IsPassthrough() || passthrough.GetLatency() != 0.0) {
+        return Fail("equal rates pass through");
+    }
+    return true;
+}
+
+bool RunChecks() {
+    bool passed = CheckFilterCache();
+    passed &= CheckStreaming();
+    passed &= CheckSimdLevels();
+    passed &= CheckTones();
+    std::cerr << "4 resampler checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed;
+}
+
+double RunStream(const BenchOptions& options, violet::ResamplerQuality quality, uint64_t blocks) {
+    violet::Resampler resampler;
+    resampler.Configure(options.channels, options.inputRate, options.outputRate, quality, options.block);
+
+    std::vector<float> input(static_cast<size_t>(options.channels) * options.block, 0.25f);
+    uint32_t maxOutput = resampler.GetMaxOutputFrames(options.block);
+    std::vector<float> output(static_cast<size_t>(options.channels) * maxOutput);
+    std::vector<const float*> inputPtrs(options.channels);
+    std::vector<float*> outputPtrs(options.channels);
+    for (uint32_t ch = 0; ch < options.channels; ++ch) {
+        inputPtrs[ch] = input.data() + static_cast<size_t>(ch) * options.block;
+        outputPtrs[ch] = output.data() + static_cast<size_t>(ch) * maxOutput;
+    }
+
+    uint64_t produced = 0;
+    uint64_t start = violet::MonotonicNanos();
+    for (uint64_t i = 0; i < blocks; ++i) {
+        produced += resampler.Process(inputPtrs.data(), options.block, outputPtrs.data());
+    }
+    uint64_t elapsed = violet::MonotonicNanos() - start;
+    return static_cast<double>(elapsed) / static_cast<double>(std::max<uint64_t>(produced, 1));
+}
+
+BenchResult RunCase(const BenchOptions& options, violet::ResamplerQuality quality, violet::SimdLevel level) {
+    violet::pcm::SetSimdLevel(level);
+
+    // Calibrate the block count on a short run, then time the stream
+    uint64_t blocks = 64;
+    double nsPerFrame = RunStream(options, quality, blocks);
+    while (nsPerFrame * blocks * options.block < options.seconds * 1e9 / 4 && blocks < (1ull << 30)) {
+        blocks *= 4;
+        nsPerFrame = RunStream(options, quality, blocks);
+    }
+
+    BenchResult result;
+    result.quality = quality;
+    result.level = level;
+    result.nsPerFrame = nsPerFrame;
+    return result;
+}
+
+void AddResult(bench::Report& report, const BenchResult& r) {
+    report.AddResult()
+        .Add("quality", violet::GetResamplerQualityName(r.quality))
+        .Add("simd", violet::pcm::GetSimdLevelName(r.level))
+        .Add("nsPerFrame", r.nsPerFrame);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-resampler-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddHandler("--rates", "in:out", [&options](const std::string& value) {
+        // Without the colon both stay 0 and the check below rejects them
+        size_t colon = value.find(':');
+        options.inputRate = colon == std::string::npos ? 0 :
+            static_cast<uint32_t>(std::strtoul(value.substr(0, colon).c_str(), nullptr, 10));
+        options.outputRate = colon == std::string::npos ? 0 :
+            static_cast<uint32_t>(std::strtoul(value.substr(colon + 1).c_str(), nullptr, 10));
+    });
+    parser.AddOption("--channels", "n", options.channels);
+    parser.AddOption("--block", "frames", options.block);
+    parser.AddOption("--seconds", "s", options.seconds);
+    parser.AddOption("--output", "file.json", options.outputPath);
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+
+    if (options.inputRate == 0 || options.outputRate == 0 || options.channels == 0 ||
+        options.block == 0 || options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+    if (!violet::GetResamplerFilter(options.inputRate, options.outputRate, violet::ResamplerQuality::Fast)) {
+        std::cerr << "No polyphase ratio for " << options.inputRate << " -> " << options.outputRate << std::endl;
+        return 1;
+    }
+
+    if (!RunChecks()) {
+        return 1;
+    }
+    if (options.checkOnly) {
+        return 0;
+    }
+
+    bench::Report report;
+    report.Add("inputRate", options.inputRate);
+    report.Add("outputRate", options.outputRate);
+    report.Add("channels", options.channels);
+    report.Add("block", options.block);
+    report.Add("threads", std::thread::hardware_concurrency());
+    for (violet::ResamplerQuality quality : QUALITIES) {
+        for (violet::SimdLevel level : GetLevels()) {
+            BenchResult result = RunCase(options, quality, level);
+            std::cerr << violet::GetResamplerQualityName(quality) << " " << violet::pcm::GetSimdLevelName(level)
+                      << ": " << result.nsPerFrame << " ns/frame" << std::endl;
+            AddResult(report, result);
+        }
+    }
+
+    return report.Save(options.outputPath) ? 0 : 1;
+}
@@ -0,0 +1,394 @@
+// violet-ring-bench: checks the SPSC ring buffer and benchmarks it against
+// the previous CircularBuffer
+//
+//   violet-ring-bench [options]
+//
+//   --check-only              run the checks, skip the benchmark
+//   --blocks <list>           elements per transfer (default 1,64,512,2048)
+//   --capacity <n>            ring capacity in elements (default 8192)
+//   --seconds <s>             time spent per benchmark case (default 0.5)
+//   --output <file.json>      write the JSON report to a file instead of stdout
+//
+// Each case streams floats from a producer thread to a consumer thread
+// and reports ns per element for the old ring, the new ring's Write/Read
+// and its in-place region API. The checks cover wrap-around, the region
+// spans, Peek/Skip/Clear and a two-thread sequence stress.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_common.h"
+#include "violet/audio_buffer.h"
+#include "violet/performance_stats.h"
+
+namespace {
+
+// The ring this one replaced: a shared seq_cst size counter updated from
+// both sides, modulo positions and all three atomics on one cache line
+template<typename T>
+class LegacyCircularBuffer {
+public:
+    explicit LegacyCircularBuffer(size_t capacity)
+        : buffer_(capacity)
+        , capacity_(capacity)
+        , readPos_(0)
+        , writePos_(0)
+        , size_(0) {
+    }
+
+    size_t Write(const T* data, size_t count) {
+        size_t available = capacity_ - size_.load();
+        size_t toWrite = std::min(count, available);
+        if (toWrite == 0) {
+            return 0;
+        }
+        size_t writePos = writePos_.load();
+        if (writePos + toWrite <= capacity_) {
+            std::memcpy(&buffer_[writePos], data, toWrite * sizeof(T));
+        } else {
+            size_t firstPart = capacity_ - writePos;
+            std::memcpy(&buffer_[writePos], data, firstPart * sizeof(T));
+            std::memcpy(&buffer_[0], data + firstPart, (toWrite - firstPart) * sizeof(T));
+        }
+        writePos_.store((writePos + toWrite) % capacity_);
+        size_.fetch_add(toWrite);
+        return toWrite;
+    }
+
+    size_t Read(T* data, size_t count) {
+        size_t available = size_.load();
+        size_t toRead = std::min(count, available);
+        if (toRead == 0) {
+            return 0;
+        }
+        size_t readPos = readPos_.load();
+        if (readPos + toRead <= capacity_) {
+            std::memcpy(data, &buffer_[readPos], toRead * sizeof(T));
+        } else {
+            size_t firstPart = capacity_ - readPos;
+            std::memcpy(data, &buffer_[readPos], firstPart * sizeof(T));
+            std::memcpy(data + firstPart, &buffer_[0], (toRead - firstPart) * sizeof(T));
+        }
+        readPos_.store((readPos + toRead) % capacity_);
+        size_.fetch_sub(toRead);
+        return toRead;
+    }
+
+private:
+    std::vector<T> buffer_;
+    const size_t capacity_;
+    std::atomic<size_t> readPos_;
+    std::atomic<size_t> writePos_;
+    std::atomic<size_t> size_;
+};
+
+enum class RingKind {
+    Legacy,
+    Copy,
+    Regions,
+};
+
+const char* GetKindName(RingKind kind) {
+    switch (kind) {
+    case RingKind::Legacy:
+        return "legacy";
+    case RingKind::Copy:
+        return "spsc";
+    case RingKind::Regions:
+        return "spsc-regions";
+    }
+    return "unknown";
+}
+
+struct BenchOptions {
+    bool checkOnly = false;
+    std::vector<uint32_t> blocks = { 1, 64, 512, 2048 };
+    uint32_t capacity = 8192;
+    double seconds = 0.5;
+    std::string outputPath;
+};
+
+struct BenchResult {
+    RingKind kind = RingKind::Legacy;
+    uint32_t block = 0;
+    double nsPerElement = 0.0;
+};
+
+bool Fail(const std::string& what) {
+    std::cerr << "FAIL " << what << std::endl;
+    return false;
+}
+
+// Single-threaded: fill levels, wrap-around and the region spans
+bool CheckSequential() {
+    violet::CircularBuffer<uint32_t> ring(100);     // storage rounds to 128
+    if (ring.Capacity() != 100 || !ring.IsEmpty() || ring.AvailableWrite() != 100) {
+        return Fail("initial state");
+    }
+
+    std::vector<uint32_t> in(250), out(250);
+    for (uint32_t i = 0; i < in.size(); ++i) {
+        in[i] = i;
+    }
+    if (ring.Write(in.data(), 250) != 100 || !ring.IsFull() || ring.Write(in.data(), 1) != 0) {
+        return Fail("write stops at capacity");
+    }
+    if (ring.Peek(out.data(), 10) != 10 || out[9] != 9 || ring.Size() != 100) {
+        return Fail("peek");
+    }
+    if (ring.Skip(40) != 40 || ring.Read(out.data(), 20) != 20 || out[0] != 40 || out[19] != 59) {
+        return Fail("skip and read");
+    }
+
+    // 40 queued at index 60; 60 more wrap past the end of the storage
+    if (ring.Write(in.data() + 100, 60) != 60) {
+        return Fail("write across the wrap");
+    }
+    violet::RingRegions<const uint32_t> regions = ring.GetReadRegions(1000);
+    if (regions.Size() != 100 || regions.firstCount != 68 || regions.secondCount != 32 ||
+        regions.first[0] != 60 || regions.second[0] != 128) {
+        return Fail("read regions across the wrap");
+    }
+    ring.CommitRead(regions.Size());
+
+    // Render in place through the write regions, committing part of it
+    violet::RingRegions<uint32_t> space = ring.GetWriteRegions(70);
+    if (space.Size() != 70) {
+        return Fail("write regions");
+    }
+    for (size_t i = 0; i < space.firstCount; ++i) {
+        space.first[i] = 1000 + static_cast<uint32_t>(i);
+    }
+    for (size_t i = 0; i < space.secondCount; ++i) {
+        space.second[i] = 1000 + static_cast<uint32_t>(space.firstCount + i);
+    }
+    ring.CommitWrite(40);
+    if (ring.Read(out.data(), 100) != 40 || out[0] != 1000 || out[39] != 1039) {
+        return Fail("commit part of the write regions");
+    }
+
+    ring.Write(in.data(), 17);
+    ring.Clear();
+    if (!ring.IsEmpty() || ring.Read(out.data(), 1) != 0 || ring.AvailableWrite() != 100) {
+        return Fail("clear");
+    }
+    return true;
+}
+
+// Two threads, odd block sizes on each side: the consumer must see every
+// value exactly once and in order
+bool CheckThreaded() {
+    const uint32_t total = 500000;
+    violet::CircularBuffer<uint32_t> ring(1000);
+    std::atomic<bool> failed(false);
+
+    std::thread producer([&]() {
+        std::vector<uint32_t> block(37);
+        uint32_t next = 0;
+        bool useRegions = false;
+        while (next < total) {
+            uint32_t count = std::min<uint32_t>(static_cast<uint32_t>(block.size()), total - next);
+            if (useRegions) {
+                violet::RingRegions<uint32_t> regions = ring.GetWriteRegions(count);
+                for (size_t i = 0; i < regions.firstCount; ++i) {
+                    regions.first[i] = next + static_cast<uint32_t>(i);
+                }
+                for (size_t i = 0; i < regions.secondCount; ++i) {
+                    regions.second[i] = next + static_cast<uint32_t>(regions.firstCount + i);
+                }
+                ring.CommitWrite(regions.Size());
+                next += static_cast<uint32_t>(regions.Size());
+            } else {
+                for (uint32_t i = 0; i < count; ++i) {
+                    block[i] = next + i;
+                }
+                next += static_cast<uint32_t>(ring.Write(block.data(), count));
+            }
+            useRegions = !useRegions;
+            if (failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    });
+
+    std::vector<uint32_t> block(53);
+    uint32_t expected = 0;
+    while (expected < total && !failed.load()) {
+        size_t count = ring.Read(block.data(), block.size());
+        for (size_t i = 0; i < count; ++i) {
+            if (block[i] != expected++) {
+                failed.store(true);
+                break;
+            }
+        }
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    if (failed.load() || !ring.IsEmpty()) {
+        return Fail("threaded sequence");
+    }
+    return true;
+}
+
+bool RunChecks() {
+    bool passed = CheckSequential();
+    passed &= CheckThreaded();
+    std::cerr << "2 ring checks " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed;
+}
+
+template<typename Ring>
+double StreamCopy(Ring& ring, uint32_t block, uint64_t elements) {
+    std::thread producer([&]() {
+        std::vector<float> data(block);
+        for (uint64_t sent = 0; sent < elements;) {
+            size_t count = std::min<uint64_t>(block, elements - sent);
+            std::fill_n(data.data(), count, 0.5f);
+            count = ring.Write(data.data(), count);
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+            sent += count;
+        }
+    });
+
+    std::vector<float> data(block);
+    uint64_t start = violet::MonotonicNanos();
+    for (uint64_t received = 0; received < elements;) {
+        size_t count = ring.Read(data.data(), std::min<uint64_t>(block, elements - received));
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        received += count;
+    }
+    uint64_t elapsed = violet::MonotonicNanos() - start;
+    producer.join();
+    return static_cast<double>(elapsed) / static_cast<double>(elements);
+}
+
+// The producer renders straight into the ring, the consumer copies out of
+// it in place; the same work as StreamCopy minus the producer's block
+double StreamRegions(violet::CircularBuffer<float>& ring, uint32_t block, uint64_t elements) {
+    std::thread producer([&]() {
+        for (uint64_t sent = 0; sent < elements;) {
+            violet::RingRegions<float> regions = ring.GetWriteRegions(std::min<uint64_t>(block, elements - sent));
+            std::fill_n(regions.first, regions.firstCount, 0.5f);
+            std::fill_n(regions.second, regions.secondCount, 0.5f);
+            ring.CommitWrite(regions.Size());
+            if (regions.Size() == 0) {
+                std::this_thread::yield();
+            }
+            sent += regions.Size();
+        }
+    });
+
+    std::vector<float> data(block);
+    uint64_t start = violet::MonotonicNanos();
+    for (uint64_t received = 0; received < elements;) {
+        violet::RingRegions<const float> regions = ring.GetReadRegions(std::min<uint64_t>(block, elements - received));
+        std::copy_n(regions.first, regions.firstCount, data.data());
+        std::copy_n(regions.second, regions.secondCount, data.data() + regions.firstCount);
+        ring.CommitRead(regions.Size());
+        if (regions.Size() == 0) {
+            std::this_thread::yield();
+        }
+        received += regions.Size();
+    }
+    uint64_t elapsed = violet::MonotonicNanos() - start;
+    producer.join();
+    return static_cast<double>(elapsed) / static_cast<double>(elements);
+}
+
+double RunStream(RingKind kind, uint32_t capacity, uint32_t block, uint64_t elements) {
+    switch (kind) {
+    case RingKind::Legacy: {
+        LegacyCircularBuffer<float> ring(capacity);
+        return StreamCopy(ring, block, elements);
+    }
+    case RingKind::Copy: {
+        violet::CircularBuffer<float> ring(capacity);
+        return StreamCopy(ring, block, elements);
+    }
+    case RingKind::Regions: {
+        violet::CircularBuffer<float> ring(capacity);
+        return StreamRegions(ring, block, elements);
+    }
+    }
+    return 0.0;
+}
+
+BenchResult RunCase(const BenchOptions& options, RingKind kind, uint32_t block) {
+    // Calibrate the element count on a short run, then time the stream
+    uint64_t elements = 1 << 16;
+    double nsPerElement = RunStream(kind, options.capacity, block, elements);
+    while (nsPerElement * elements < options.seconds * 1e9 / 4 && elements < (1ull << 36)) {
+        elements *= 4;
+        nsPerElement = RunStream(kind, options.capacity, block, elements);
+    }
+
+    BenchResult result;
+    result.kind = kind;
+    result.block = block;
+    result.nsPerElement = nsPerElement;
+    return result;
+}
+
+void AddResult(bench::Report& report, const BenchResult& r) {
+    report.AddResult()
+        .Add("ring", GetKindName(r.kind))
+        .Add("block", r.block)
+        .Add("nsPerElement", r.nsPerElement);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-ring-bench");
+    parser.AddFlag("--check-only", options.checkOnly);
+    parser.AddOption("--blocks", "list", options.blocks);
+    parser.AddOption("--capacity", "n", options.capacity);
+    parser.AddOption("--seconds", "s", options.seconds);
+    parser.AddOption("--output", "file.json", options.outputPath);
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+
+    if (options.blocks.empty() || options.capacity == 0 || options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+
+    if (!RunChecks()) {
+        return 1;
+    }
+    if (options.checkOnly) {
+        return 0;
+    }
+
+    bench::Report report;
+    report.Add("capacity", options.capacity);
+    report.Add("threads", std::thread::hardware_concurrency());
+    for (uint32_t block : options.blocks) {
+        if (block > options.capacity) {
+            continue;
+        }
+        for (RingKind kind : { RingKind::Legacy, RingKind::Copy, RingKind::Regions }) {
+            BenchResult result = RunCase(options, kind, block);
+            std::cerr << GetKindName(kind) << " block " << block << ": " << result.nsPerElement
+                      << " ns/element" << std::endl;
+            AddResult(report, result);
+        }
+    }
+
+    return report.Save(options.outputPath) ? 0 : 1;
+}
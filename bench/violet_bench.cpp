@@ -0,0 +1,277 @@
+// violet-bench: headless throughput and latency benchmark for the audio core
+//
+//   violet-bench [options]
+//
+//   --plugin <uri>            plugin appended to the chain (repeatable). "ref:<name>"
+//                             picks the bundled reference plugin matching the
+//                             channel count (ref:gain, ref:biquad, ref:delay).
+//                             Default: ref:gain ref:biquad ref:delay
+//   --depth <n>               repeat the plugin list n times (default 1)
+//   --blocks <list>           block sizes to sweep (default 32,64,...,2048)
+//   --channels <list>         channel counts to sweep (default 1,2,4,8)
+//   --rate <hz>               sample rate (default 48000)
+//   --seconds <s>             audio rendered per configuration (default 10)
+//   --workers <n>             chain worker threads (default: chain default)
+//   --lv2-path <dir>          where to find the reference bundle
+//   --output <file.json>      write the JSON report to a file instead of stdout
+//
+// Chain and plugin logging goes to stderr so stdout carries only the report.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "violet/audio_processing_chain.h"
+#include "violet/performance_stats.h"
+#include "violet/realtime_thread.h"
+
+#ifndef VIOLET_BENCH_LV2_PATH
+#define VIOLET_BENCH_LV2_PATH ""
+#endif
+
+// Allocation counting. Every operator new in the process goes through here;
+// the counters are sampled around the timed loop so anything the audio path
+// allocates shows up in the report. Plain malloc calls (e.g. inside lilv or
+// the plugins themselves) are not counted.
+namespace {
+
+std::atomic<uint64_t> allocationCount(0);
+std::atomic<uint64_t> allocatedBytes(0);
+
+void* CountedAllocate(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return CountedAllocate(size); }
+void* operator new[](size_t size) { return CountedAllocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+
+namespace {
+
+struct BenchOptions {
+    std::vector<std::string> plugins;
+    uint32_t depth = 1;
+    std::vector<uint32_t> blockSizes = { 32, 64, 128, 256, 512, 1024, 2048 };
+    std::vector<uint32_t> channelCounts = { 1, 2, 4, 8 };
+    uint32_t sampleRate = 48000;
+    double seconds = 10.0;
+    int32_t workers = -1;
+    std::string lv2Path = VIOLET_BENCH_LV2_PATH;
+    std::string outputPath;
+};
+
+struct BenchResult {
+    uint32_t channels = 0;
+    uint32_t blockSize = 0;
+    uint32_t nodes = 0;
+    uint64_t blocks = 0;
+    uint64_t frames = 0;
+    double wallSeconds = 0.0;
+    double nsPerSample = 0.0;       // per frame per channel
+    double nsPerFrame = 0.0;
+    double realtimeFactor = 0.0;
+    violet::TimingStats callback;
+    uint64_t xruns = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+const double WARMUP_SECONDS = 0.5;
+
+std::string ResolvePluginUri(const std::string& plugin, uint32_t channels) {
+    if (plugin.compare(0, 4, "ref:") == 0) {
+        return "urn:violet:ref:" + plugin.substr(4) + "-" + std::to_string(channels) + "ch";
+    }
+    return plugin;
+}
+
+bool RunConfiguration(violet::AudioProcessingChain& chain, const BenchOptions& options,
+                      uint32_t channels, uint32_t blockSize, BenchResult& result) {
+    chain.ClearChain();
+    chain.CollectRetired();
+    chain.SetFormat(options.sampleRate, channels, blockSize);
+
+    // Plugins are instantiated at the configuration's format
+    for (uint32_t repeat = 0; repeat < options.depth; ++repeat) {
+        for (const auto& plugin : options.plugins) {
+            std::string uri = ResolvePluginUri(plugin, channels);
+            if (chain.AddPlugin(uri) == 0) {
+                std::cerr << "Skipping " << channels << "ch / " << blockSize
+                          << ": cannot load " << uri << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // White noise, so filters and delays do real work
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    std::vector<std::vector<float>> input(channels, std::vector<float>(blockSize));
+    std::vector<std::vector<float>> output(channels, std::vector<float>(blockSize));
+    std::vector<float*> inputPtrs(channels);
+    std::vector<float*> outputPtrs(channels);
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        for (float& sample : input[ch]) {
+            sample = noise(random);
+        }
+        inputPtrs[ch] = input[ch].data();
+        outputPtrs[ch] = output[ch].data();
+    }
+
+    // Same FPU mode as the live audio threads
+    violet::ScopedDenormalFlush denormalFlush;
+    uint64_t warmupBlocks = static_cast<uint64_t>(WARMUP_SECONDS * options.sampleRate / blockSize) + 1;
+    for (uint64_t i = 0; i < warmupBlocks; ++i) {
+        chain.Process(inputPtrs.data(), outputPtrs.data(), channels, blockSize);
+    }
+    chain.ResetPerformanceCounters();
+
+    uint64_t blocks = static_cast<uint64_t>(options.seconds * options.sampleRate / blockSize) + 1;
+    uint64_t allocationsBefore = allocationCount.load();
+    uint64_t bytesBefore = allocatedBytes.load();
+    uint64_t startTime = violet::MonotonicNanos();
+
+    for (uint64_t i = 0; i < blocks; ++i) {
+        chain.Process(inputPtrs.data(), outputPtrs.data(), channels, blockSize);
+    }
+
+    uint64_t elapsed = violet::MonotonicNanos() - startTime;
+    result.allocations = allocationCount.load() - allocationsBefore;
+    result.allocatedBytes = allocatedBytes.load() - bytesBefore;
+
+    violet::AudioProcessingChain::ChainStats stats = chain.GetStats();
+    result.channels = channels;
+    result.blockSize = blockSize;
+    result.nodes = chain.GetNodeCount();
+    result.blocks = blocks;
+    result.frames = blocks * blockSize;
+    result.wallSeconds = elapsed / 1e9;
+    result.nsPerFrame = static_cast<double>(elapsed) / result.frames;
+    result.nsPerSample = result.nsPerFrame / channels;
+    result.realtimeFactor = result.wallSeconds > 0.0
+        ? (static_cast<double>(result.frames) / options.sampleRate) / result.wallSeconds : 0.0;
+    result.callback = stats.callback;
+    result.xruns = stats.xruns;
+    return true;
+}
+
+std::string TimingJson(const violet::TimingStats& stats) {
+    return bench::JsonObject()
+        .Add("mean", stats.mean).Add("p50", stats.p50).Add("p99", stats.p99)
+        .Add("p999", stats.p999).Add("max", stats.max)
+        .ToString();
+}
+
+void AddResult(bench::Report& report, const BenchResult& r) {
+    report.AddResult()
+        .Add("channels", r.channels)
+        .Add("blockSize", r.blockSize)
+        .Add("nodes", r.nodes)
+        .Add("blocks", r.blocks)
+        .Add("frames", r.frames)
+        .Add("wallSeconds", r.wallSeconds)
+        .Add("nsPerSample", r.nsPerSample)
+        .Add("nsPerFrame", r.nsPerFrame)
+        .Add("realtimeFactor", r.realtimeFactor)
+        .AddRaw("callbackNs", TimingJson(r.callback))
+        .Add("xruns", r.xruns)
+        .Add("allocations", r.allocations)
+        .Add("allocatedBytes", r.allocatedBytes);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bench::OptionParser parser("violet-bench");
+    parser.AddHandler("--plugin", "uri|ref:name", [&options](const std::string& value) {
+        options.plugins.push_back(value);
+    });
+    parser.AddOption("--depth", "n", options.depth);
+    parser.AddOption("--blocks", "list", options.blockSizes);
+    parser.AddOption("--channels", "list", options.channelCounts);
+    parser.AddOption("--rate", "hz", options.sampleRate);
+    parser.AddOption("--seconds", "s", options.seconds);
+    parser.AddOption("--workers", "n", options.workers);
+    parser.AddOption("--lv2-path", "dir", options.lv2Path);
+    parser.AddOption("--output", "file.json", options.outputPath);
+    int exitCode = 0;
+    if (!parser.Parse(argc, argv, exitCode)) {
+        return exitCode;
+    }
+
+    if (options.plugins.empty()) {
+        options.plugins = { "ref:gain", "ref:biquad", "ref:delay" };
+    }
+    options.depth = std::max(1u, options.depth);
+    if (options.blockSizes.empty() || options.channelCounts.empty() || options.sampleRate == 0 ||
+        options.seconds <= 0.0) {
+        parser.PrintUsage();
+        return 1;
+    }
+
+    // Keep stdout for the report
+    std::streambuf* reportBuffer = std::cout.rdbuf();
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    bench::AddLv2Path(options.lv2Path);
+
+    bench::Report report;
+    report.Add("sampleRate", options.sampleRate);
+    report.Add("seconds", options.seconds);
+    {
+        violet::AudioProcessingChain chain(nullptr);
+        if (options.workers >= 0) {
+            chain.SetWorkerThreadCount(static_cast<uint32_t>(options.workers));
+        }
+        report.Add("workers", chain.GetWorkerThreadCount());
+        report.Add("depth", options.depth);
+        std::string plugins = "[";
+        for (size_t i = 0; i < options.plugins.size(); ++i) {
+            plugins += (i ? ", \"" : "\"") + bench::JsonEscape(options.plugins[i]) + "\"";
+        }
+        report.AddRaw("plugins", plugins + "]");
+
+        for (uint32_t channels : options.channelCounts) {
+            for (uint32_t blockSize : options.blockSizes) {
+                BenchResult result;
+                if (!RunConfiguration(chain, options, channels, blockSize, result)) {
+                    continue;
+                }
+                std::cerr << channels << "ch x " << blockSize << ": " << result.nsPerSample
+                          << " ns/sample, callback " << violet::FormatTimingStats(result.callback)
+                          << ", " << result.allocations << " allocations" << std::endl;
+                AddResult(report, result);
+            }
+        }
+    }
+
+    std::cout.rdbuf(reportBuffer);
+
+    if (!report.Save(options.outputPath)) {
+        return 1;
+    }
+    return report.IsEmpty() ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace violet {
+
+// Debug trap for heap allocations on realtime threads (IsRealtimeThread()).
+// Built in with `meson configure -Dalloc_trap=true`, which replaces malloc
+// (glibc) or operator new (elsewhere) for the whole program. Without it the
+// functions below do nothing and never count an allocation.
+enum class AllocTrapMode {
+    Off,
+    Count,      // count them, see GetRealtimeAllocationCount()
+    Abort       // report the first one on stderr and abort(), for a debugger
+};
+
+bool IsAllocTrapBuiltIn();
+
+// Starts out as VIOLET_ALLOC_TRAP says ("off", "count" or "abort"), Count
+// when unset
+void SetAllocTrapMode(AllocTrapMode mode);
+AllocTrapMode GetAllocTrapMode();
+
+uint64_t GetRealtimeAllocationCount();
+void ResetRealtimeAllocationCount();
+
+// Exempts a scope on a realtime thread, for allocations that are known and
+// accepted (device restarts, recording to a file)
+class ScopedAllocationAllowed {
+public:
+    ScopedAllocationAllowed();
+    ~ScopedAllocationAllowed();
+
+    ScopedAllocationAllowed(const ScopedAllocationAllowed&) = delete;
+    ScopedAllocationAllowed& operator=(const ScopedAllocationAllowed&) = delete;
+};
+
+} // namespace violet
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <alsa/asoundlib.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include "violet/audio_backend.h"
+#include "violet/pcm_convert.h"
+
+namespace violet {
+
+// ALSA PCM backend. Playback and capture run as a linked pair paced by
+// playback periods, transferring through the mmap areas where the device
+// supports it and falling back to interleaved read/write otherwise. Raw hw:
+// devices get the first of float, S32, S24_3 and S16 they take, converted
+// by the pcm kernels.
+class AlsaBackend : public AudioBackend {
+public:
+    AlsaBackend();
+    ~AlsaBackend() override;
+    
+    const char* GetName() const override { return "alsa"; }
+    bool Initialize() override { return true; }
+    
+    std::vector<AudioDevice> EnumerateDevices() override;
+    
+    bool Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+              const AudioFormat& requested, AudioFormat& actual) override;
+    void Close() override;
+    std::string GetOpenInputDevice() const override { return capture_.pcm ? inputDeviceId_ : std::string(); }
+    std::string GetOpenOutputDevice() const override { return playback_.pcm ? outputDeviceId_ : std::string(); }
+    uint32_t GetMaxFrames() const override { return periodFrames_; }
+    bool HasFixedBlockSize() const override { return true; }
+    
+    bool Start(AudioProcessCallback callback) override;
+    void Stop() override;
+    
+    double GetLatency() const override;
+    
+    void SetOutputDither(bool enabled) override { ditherEnabled_ = enabled; }
+
+private:
+    struct Stream {
+        snd_pcm_t* pcm = nullptr;
+        bool capture = false;
+        bool mmap = false;
+        PcmFormat format = PcmFormat::Float32;
+        uint32_t channels = 0;
+        snd_pcm_uframes_t periodFrames = 0;
+        snd_pcm_uframes_t bufferFrames = 0;
+        std::vector<uint8_t> interleaved;   // read/write fallback only
+    };
+    
+    bool OpenStream(Stream& stream, const std::string& deviceId, uint32_t& sampleRate,
+                    uint32_t channels, snd_pcm_uframes_t periodFrames);
+    void CloseStream(Stream& stream);
+    
+    // Moves `frames` frames between the planar buffers and the device.
+    // Playback from null buffers writes silence. Returns a negative errno
+    // on xruns and other stream errors.
+    int Transfer(Stream& stream, float** buffers, uint32_t channels, uint32_t frames);
+    bool StartStreams();
+    // Restarts both streams; an -EPIPE is reported as `xrun`
+    bool RecoverStreams(int error, GlitchType xrun);
+    void AudioThreadProc();
+    
+    Stream playback_;
+    Stream capture_;
+    bool linked_;
+    std::string inputDeviceId_;
+    std::string outputDeviceId_;
+    uint32_t sampleRate_;
+    uint32_t channels_;
+    uint32_t periodFrames_;
+    
+    std::vector<float> inputBuffer_;
+    std::vector<float> outputBuffer_;
+    std::vector<float*> inputPtrs_;
+    std::vector<float*> outputPtrs_;
+    std::vector<float*> windowPtrs_;    // planar buffers offset to an mmap window
+    bool ditherEnabled_;
+    pcm::Dither outputDither_;
+    
+    std::thread audioThread_;
+    std::atomic<bool> shouldStop_;
+    AudioProcessCallback callback_;
+    
+    static constexpr unsigned int PERIODS = 2;
+    static constexpr int WAIT_TIMEOUT_MS = 1000;
+};
+
+} // namespace violet
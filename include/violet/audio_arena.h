@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace violet {
+
+// Storage for everything an audio thread touches, carved out of one
+// preallocated block while a stream is configured so the thread itself
+// never allocates. Allocate() only runs on the configuring thread; the
+// pointers it returns stay valid until the next Reset().
+//
+// Layouts that outgrow the block spill into extra blocks; Reset() then
+// replaces them with a single block big enough for the whole layout, so a
+// stream that is reconfigured the same way ends up in one allocation.
+class AudioArena {
+public:
+    static constexpr size_t ALIGNMENT = 64;     // cache line, and enough for any SIMD load
+
+    AudioArena() = default;
+    AudioArena(const AudioArena&) = delete;
+    AudioArena& operator=(const AudioArena&) = delete;
+
+    // Forgets every allocation
+    void Reset();
+
+    // `count` zeroed elements, aligned to ALIGNMENT. Zeroing also faults
+    // the pages in before the audio thread gets to them.
+    template<typename T>
+    T* Allocate(size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                      "the arena never runs constructors or destructors");
+        return static_cast<T*>(AllocateBytes(count * sizeof(T)));
+    }
+
+    size_t GetBytesUsed() const { return used_; }
+    size_t GetCapacity() const;
+
+private:
+    void* AllocateBytes(size_t bytes);
+
+    struct Block {
+        std::unique_ptr<uint8_t[]> storage;
+        uint8_t* begin = nullptr;   // storage aligned to ALIGNMENT
+        size_t size = 0;
+        size_t offset = 0;
+    };
+
+    static Block NewBlock(size_t size);
+
+    std::vector<Block> blocks_;
+    size_t used_ = 0;               // bytes handed out since Reset(), with padding
+
+    static constexpr size_t MIN_BLOCK = 64 * 1024;
+};
+
+} // namespace violet
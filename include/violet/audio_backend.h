@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include "violet/drift_compensator.h"
+#include "violet/glitch_log.h"
+
+namespace violet {
+
+// Audio device information
+struct AudioDevice {
+    std::string id;
+    std::string name;
+    bool isDefault;
+    bool isInput;
+    bool isOutput;
+};
+
+// Audio format specification
+struct AudioFormat {
+    uint32_t sampleRate;      // 44100, 48000, 88200, 96000, 192000
+    uint32_t channels;        // 1 (mono), 2 (stereo), etc.
+    uint32_t bitsPerSample;   // 16, 24, 32
+    uint32_t bufferSize;      // 64, 128, 256, 512, 1024, 2048 samples
+
+    AudioFormat() : sampleRate(44100), channels(2), bitsPerSample(32), bufferSize(256) {}
+};
+
+// Planar process callback, run on the backend's audio thread. Inputs and
+// outputs both carry `channels` buffers of `frames` samples. Input channels
+// the device doesn't have are silent; output channels it doesn't have are
+// dropped.
+using AudioProcessCallback = std::function<void(float** inputs, float** outputs, uint32_t channels, uint32_t frames)>;
+
+using XrunHandler = std::function<void(GlitchType type, uint32_t frames)>;
+
+// One audio device API. A backend opens an input/output device pair, runs
+// its own audio thread and converts between the device's sample layout and
+// planar float buffers it allocates in Open().
+class AudioBackend {
+public:
+    virtual ~AudioBackend() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // Called once before anything else
+    virtual bool Initialize() = 0;
+
+    virtual std::vector<AudioDevice> EnumerateDevices() = 0;
+
+    // Opens the devices, an empty id meaning the system default. A missing
+    // input is not an error; the callback then sees silence. `actual` is the
+    // format the callback will run at.
+    virtual bool Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+                      const AudioFormat& requested, AudioFormat& actual) = 0;
+    virtual void Close() = 0;
+
+    // Device ids Open() resolved to; empty if that side isn't open
+    virtual std::string GetOpenInputDevice() const = 0;
+    virtual std::string GetOpenOutputDevice() const = 0;
+
+    // Largest frame count the callback can be called with, valid after Open()
+    virtual uint32_t GetMaxFrames() const = 0;
+
+    // True if every callback gets exactly the bufferSize Open() reported
+    virtual bool HasFixedBlockSize() const { return false; }
+
+    virtual bool Start(AudioProcessCallback callback) = 0;
+    virtual void Stop() = 0;
+
+    // Output latency in milliseconds
+    virtual double GetLatency() const { return 0.0; }
+
+    // Stream volume, where the device API has one
+    virtual bool SetMasterVolume(float) { return false; }
+    virtual float GetMasterVolume() const { return 1.0f; }
+    virtual bool SetMuted(bool) { return false; }
+    virtual bool IsMuted() const { return false; }
+
+    // TPDF dither for 16 and 24-bit output devices, applied from the next
+    // Open()
+    virtual void SetOutputDither(bool) {}
+
+    // Capture-to-render clock drift compensation, for backends that bridge
+    // two devices; inactive otherwise
+    virtual DriftStatus GetDriftStatus() const { return DriftStatus(); }
+
+    // Called on the audio thread for every device-side xrun (underruns,
+    // capture discontinuities) with the period it affected. Set before
+    // Start().
+    void SetXrunHandler(XrunHandler handler) { xrunHandler_ = std::move(handler); }
+
+protected:
+    void ReportXrun(GlitchType type, uint32_t frames) {
+        if (xrunHandler_) {
+            xrunHandler_(type, frames);
+        }
+    }
+
+private:
+    XrunHandler xrunHandler_;
+};
+
+// Backends compiled into this build, platform default first
+std::vector<std::string> GetAudioBackendNames();
+
+// Creates a backend by name ("wasapi", "alsa", "null"). An empty name uses
+// $VIOLET_AUDIO_BACKEND if set, otherwise the platform default. Returns
+// nullptr for unknown or unavailable backends.
+std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& name = "");
+
+} // namespace violet
@@ -4,134 +4,129 @@
 #include <atomic>
 #include <memory>
 #include <cstring>
+#include <algorithm>
+#include <type_traits>
 
 namespace violet {
 
-// Thread-safe circular buffer for audio data
+// Up to two contiguous spans of a ring, the second one after the wrap
+template<typename T>
+struct RingRegions {
+    T* first = nullptr;
+    size_t firstCount = 0;
+    T* second = nullptr;
+    size_t secondCount = 0;
+    
+    size_t Size() const { return firstCount + secondCount; }
+};
+
+// Lock-free single-producer, single-consumer ring buffer. One thread
+// writes and one thread reads; neither ever blocks. Storage is a power of
+// two so positions run free and wrap with a mask, and the producer's and
+// consumer's positions live on separate cache lines, each side caching
+// the other's position so it only touches the shared line when it looks
+// full or empty.
+//
+// Producers can render straight into the ring with GetWriteRegions() and
+// CommitWrite(), consumers read in place with GetReadRegions() and
+// CommitRead(); Write() and Read() copy through the same calls.
 template<typename T>
 class CircularBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "ring elements are moved with memcpy");
+    
 public:
+    // Holds exactly `capacity` elements; storage rounds up to a power of two
     explicit CircularBuffer(size_t capacity)
-        : buffer_(capacity)
+        : buffer_(RoundUpToPowerOfTwo(capacity))
         , capacity_(capacity)
+        , mask_(buffer_.size() - 1)
         , readPos_(0)
+        , cachedWritePos_(0)
         , writePos_(0)
-        , size_(0) {
+        , cachedReadPos_(0) {
+    }
+    
+    CircularBuffer(const CircularBuffer&) = delete;
+    CircularBuffer& operator=(const CircularBuffer&) = delete;
+    
+    // Producer: free space for up to `count` elements. Fill it, then
+    // CommitWrite() as many elements as were written.
+    RingRegions<T> GetWriteRegions(size_t count) {
+        size_t writePos = writePos_.load(std::memory_order_relaxed);
+        if (capacity_ - (writePos - cachedReadPos_) < count) {
+            cachedReadPos_ = readPos_.load(std::memory_order_acquire);
+        }
+        size_t free = capacity_ - (writePos - cachedReadPos_);
+        return MakeRegions<T>(buffer_.data(), writePos, std::min(count, free));
+    }
+    
+    void CommitWrite(size_t count) {
+        writePos_.store(writePos_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+    
+    // Consumer: up to `count` readable elements, released by CommitRead()
+    RingRegions<const T> GetReadRegions(size_t count) const {
+        size_t readPos = readPos_.load(std::memory_order_relaxed);
+        if (cachedWritePos_ - readPos < count) {
+            cachedWritePos_ = writePos_.load(std::memory_order_acquire);
+        }
+        size_t available = cachedWritePos_ - readPos;
+        return MakeRegions<const T>(buffer_.data(), readPos, std::min(count, available));
+    }
+    
+    void CommitRead(size_t count) {
+        readPos_.store(readPos_.load(std::memory_order_relaxed) + count, std::memory_order_release);
     }
     
     // Write data to buffer (returns number of elements actually written)
     size_t Write(const T* data, size_t count) {
-        size_t available = capacity_ - size_.load();
-        size_t toWrite = std::min(count, available);
-        
-        if (toWrite == 0) {
-            return 0;
+        RingRegions<T> regions = GetWriteRegions(count);
+        if (regions.firstCount > 0) {
+            std::memcpy(regions.first, data, regions.firstCount * sizeof(T));
         }
-        
-        size_t writePos = writePos_.load();
-        
-        // Handle wrap-around
-        if (writePos + toWrite <= capacity_) {
-            // No wrap-around needed
-            std::memcpy(&buffer_[writePos], data, toWrite * sizeof(T));
-        } else {
-            // Wrap-around needed
-            size_t firstPart = capacity_ - writePos;
-            size_t secondPart = toWrite - firstPart;
-            
-            std::memcpy(&buffer_[writePos], data, firstPart * sizeof(T));
-            std::memcpy(&buffer_[0], data + firstPart, secondPart * sizeof(T));
+        if (regions.secondCount > 0) {
+            std::memcpy(regions.second, data + regions.firstCount, regions.secondCount * sizeof(T));
         }
-        
-        writePos_.store((writePos + toWrite) % capacity_);
-        size_.fetch_add(toWrite);
-        
-        return toWrite;
+        CommitWrite(regions.Size());
+        return regions.Size();
     }
     
     // Read data from buffer (returns number of elements actually read)
     size_t Read(T* data, size_t count) {
-        size_t available = size_.load();
-        size_t toRead = std::min(count, available);
-        
-        if (toRead == 0) {
-            return 0;
-        }
-        
-        size_t readPos = readPos_.load();
-        
-        // Handle wrap-around
-        if (readPos + toRead <= capacity_) {
-            // No wrap-around needed
-            std::memcpy(data, &buffer_[readPos], toRead * sizeof(T));
-        } else {
-            // Wrap-around needed
-            size_t firstPart = capacity_ - readPos;
-            size_t secondPart = toRead - firstPart;
-            
-            std::memcpy(data, &buffer_[readPos], firstPart * sizeof(T));
-            std::memcpy(data + firstPart, &buffer_[0], secondPart * sizeof(T));
-        }
-        
-        readPos_.store((readPos + toRead) % capacity_);
-        size_.fetch_sub(toRead);
-        
-        return toRead;
+        size_t read = Peek(data, count);
+        CommitRead(read);
+        return read;
     }
     
-    // Peek at data without removing it
+    // Peek at data without removing it (consumer only)
     size_t Peek(T* data, size_t count) const {
-        size_t available = size_.load();
-        size_t toPeek = std::min(count, available);
-        
-        if (toPeek == 0) {
-            return 0;
+        RingRegions<const T> regions = GetReadRegions(count);
+        if (regions.firstCount > 0) {
+            std::memcpy(data, regions.first, regions.firstCount * sizeof(T));
         }
-        
-        size_t readPos = readPos_.load();
-        
-        // Handle wrap-around
-        if (readPos + toPeek <= capacity_) {
-            // No wrap-around needed
-            std::memcpy(data, &buffer_[readPos], toPeek * sizeof(T));
-        } else {
-            // Wrap-around needed
-            size_t firstPart = capacity_ - readPos;
-            size_t secondPart = toPeek - firstPart;
-            
-            std::memcpy(data, &buffer_[readPos], firstPart * sizeof(T));
-            std::memcpy(data + firstPart, &buffer_[0], secondPart * sizeof(T));
+        if (regions.secondCount > 0) {
+            std::memcpy(data + regions.firstCount, regions.second, regions.secondCount * sizeof(T));
         }
-        
-        return toPeek;
+        return regions.Size();
     }
     
-    // Skip data without reading it
+    // Skip data without reading it (consumer only)
     size_t Skip(size_t count) {
-        size_t available = size_.load();
-        size_t toSkip = std::min(count, available);
-        
-        if (toSkip == 0) {
-            return 0;
-        }
-        
-        size_t readPos = readPos_.load();
-        readPos_.store((readPos + toSkip) % capacity_);
-        size_.fetch_sub(toSkip);
-        
-        return toSkip;
+        size_t skipped = GetReadRegions(count).Size();
+        CommitRead(skipped);
+        return skipped;
     }
     
-    // Clear the buffer
+    // Drop everything written so far (consumer only)
     void Clear() {
-        readPos_.store(0);
-        writePos_.store(0);
-        size_.store(0);
+        cachedWritePos_ = writePos_.load(std::memory_order_acquire);
+        readPos_.store(cachedWritePos_, std::memory_order_release);
     }
     
     // Get current size
     size_t Size() const {
-        return size_.load();
+        size_t readPos = readPos_.load(std::memory_order_acquire);
+        return writePos_.load(std::memory_order_acquire) - readPos;
     }
     
     // Get capacity
@@ -141,33 +136,59 @@ public:
     
     // Check if buffer is empty
     bool IsEmpty() const {
-        return size_.load() == 0;
+        return Size() == 0;
     }
     
     // Check if buffer is full
     bool IsFull() const {
-        return size_.load() == capacity_;
+        return Size() >= capacity_;
     }
     
     // Get available space for writing
     size_t AvailableWrite() const {
-        return capacity_ - size_.load();
+        return capacity_ - Size();
     }
     
     // Get available data for reading
     size_t AvailableRead() const {
-        return size_.load();
+        return Size();
     }
 
 private:
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t size = 1;
+        while (size < value) {
+            size <<= 1;
+        }
+        return size;
+    }
+    
+    template<typename U, typename Storage>
+    RingRegions<U> MakeRegions(Storage* data, size_t position, size_t count) const {
+        RingRegions<U> regions;
+        size_t index = position & mask_;
+        regions.first = data + index;
+        regions.firstCount = std::min(count, buffer_.size() - index);
+        regions.second = data;
+        regions.secondCount = count - regions.firstCount;
+        return regions;
+    }
+    
     std::vector<T> buffer_;
     const size_t capacity_;
-    std::atomic<size_t> readPos_;
-    std::atomic<size_t> writePos_;
-    std::atomic<size_t> size_;
+    const size_t mask_;
+    
+    // Consumer side: its position and its last look at the producer's
+    alignas(64) std::atomic<size_t> readPos_;
+    mutable size_t cachedWritePos_;
+    
+    // Producer side
+    alignas(64) std::atomic<size_t> writePos_;
+    size_t cachedReadPos_;
 };
 
-// Audio buffer manager for handling multiple channels and formats
+// Audio buffer manager for handling multiple channels and formats. One ring
+// per channel, so like CircularBuffer it takes one writer and one reader.
 class AudioBuffer {
 public:
     AudioBuffer(uint32_t channels, uint32_t capacity);
@@ -182,6 +203,11 @@ public:
     // Read interleaved audio data
     size_t ReadInterleaved(float* data, uint32_t frames);
     
+    // Write/read all channels from planar buffers, one span per channel.
+    // Moves as many frames as every channel has room/data for.
+    size_t Write(const float* const* data, uint32_t frames);
+    size_t Read(float* const* data, uint32_t frames);
+    
     // Write/read specific channel
     size_t WriteChannel(uint32_t channel, const float* data, uint32_t frames);
     size_t ReadChannel(uint32_t channel, float* data, uint32_t frames);
@@ -200,10 +226,15 @@ public:
     CircularBuffer<float>* GetChannelBuffer(uint32_t channel);
     
 private:
+    size_t GetWritableFrames() const;
+    
     uint32_t channels_;
     uint32_t capacity_;
     std::vector<std::unique_ptr<CircularBuffer<float>>> channelBuffers_;
-    std::vector<float> tempBuffer_; // For interleaved conversions
+    
+    // Per-channel ring regions for interleaved transfers
+    std::vector<float*> writePtrs_;
+    std::vector<const float*> readPtrs_;
 };
 
 // Ring buffer specifically for MIDI events
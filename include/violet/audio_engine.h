@@ -1,52 +1,51 @@
 #pragma once
 
-#include <windows.h>
-#include <mmdeviceapi.h>
-#include <audioclient.h>
-#include <audiopolicy.h>
-#include <endpointvolume.h>
-#include <functiondiscoverykeys_devpkey.h>
 #include <memory>
 #include <vector>
 #include <string>
 #include <atomic>
-#include <thread>
 #include <functional>
 #include <mutex>
+#include "violet/audio_arena.h"
+#include "violet/audio_backend.h"
+#include "violet/audio_buffer.h"
+#include "violet/glitch_log.h"
+#include "violet/performance_stats.h"
+#include "violet/resampler.h"
 
 namespace violet {
 
-// Audio device information
-struct AudioDevice {
-    std::string id;
-    std::string name;
-    bool isDefault;
-    bool isInput;
-    bool isOutput;
-};
-
-// Audio format specification
-struct AudioFormat {
-    uint32_t sampleRate;      // 44100, 48000, 88200, 96000, 192000
-    uint32_t channels;        // 1 (mono), 2 (stereo), etc.
-    uint32_t bitsPerSample;   // 16, 24, 32
-    uint32_t bufferSize;      // 64, 128, 256, 512, 1024, 2048 samples
-    
-    AudioFormat() : sampleRate(44100), channels(2), bitsPerSample(32), bufferSize(256) {}
-};
-
 // Audio callback function type
 // Parameters: input buffer, output buffer, frame count, user data
 using AudioCallback = std::function<void(float* input, float* output, uint32_t frames, void* userData)>;
 
+// Routing between device channels and the callback's buses. The bus count
+// is the input list's length, or the device's channel count when it is
+// empty. Channels out of range are silent.
+struct ChannelMap {
+    std::vector<int32_t> inputs;    // per bus: the device input channel feeding it, -1 = silent
+    std::vector<int32_t> outputs;   // per device output channel: the bus it plays, -1 = silent
+    
+    bool IsIdentity() const { return inputs.empty() && outputs.empty(); }
+};
+
+// Parses a comma-separated channel list such as "0,1,-1"; "" is empty
+bool ParseChannelList(const std::string& text, std::vector<int32_t>& channels);
+
+// Device-independent front end over an AudioBackend. Keeps the device and
+// format selection, times every callback and adapts the backend's planar
+// buffers to the interleaved AudioCallback.
 class AudioEngine {
 public:
     AudioEngine();
     ~AudioEngine();
     
-    // Initialization and cleanup
-    bool Initialize();
+    // Initialization and cleanup. An empty name picks the default backend,
+    // see CreateAudioBackend().
+    bool Initialize(const std::string& backendName = "");
+    bool Initialize(std::unique_ptr<AudioBackend> backend);
     void Shutdown();
+    std::string GetBackendName() const;
     
     // Device management
     std::vector<AudioDevice> EnumerateDevices();
@@ -61,18 +60,69 @@ public:
     std::vector<uint32_t> GetSupportedSampleRates() const;
     std::vector<uint32_t> GetSupportedBufferSizes() const;
     
+    // Run the callback at a fixed rate whatever rate the devices open with
+    // (0, the default, follows the devices). Input and output are then
+    // resampled, and the callback always gets bufferSize frames. Both
+    // apply on Start().
+    bool SetProcessingSampleRate(uint32_t sampleRate);
+    uint32_t GetProcessingSampleRate() const { return processingSampleRate_; }
+    void SetResamplerQuality(ResamplerQuality quality) { resamplerQuality_ = quality; }
+    ResamplerQuality GetResamplerQuality() const { return resamplerQuality_; }
+    
+    // The format the callback runs at: the device format, with the
+    // processing rate in place of the device rate while converting and the
+    // channel map's bus count in place of the device channels
+    AudioFormat GetProcessingFormat() const;
+    
+    // Device channel routing (identity by default); applies on Start().
+    // Returns false for maps wider than MAX_CHANNELS buses.
+    bool SetChannelMap(const ChannelMap& map);
+    ChannelMap GetChannelMap() const;
+    
+    // Always call the callback with exactly bufferSize frames. Backends
+    // whose periods vary (WASAPI) then go through a FIFO that adds one
+    // block of latency, included in GetLatency(). Applies on Start().
+    void SetFixedBlockSize(bool enabled) { fixedBlockSize_ = enabled; }
+    bool IsFixedBlockSizeEnabled() const { return fixedBlockSize_; }
+    
+    // While running: whether every callback gets exactly bufferSize frames,
+    // because the backend works that way or the FIFO makes it so
+    bool HasFixedBlockSize() const;
+    
     // Audio processing
     bool Start();
     bool Stop();
     bool IsRunning() const;
     
-    // Callback management
+    // Callback management. A process callback gets the backend's planar
+    // buffers directly and takes precedence over the interleaved one.
     void SetAudioCallback(AudioCallback callback, void* userData = nullptr);
+    void SetProcessCallback(AudioProcessCallback callback);
     
-    // Performance monitoring
+    // Performance monitoring. The callback is timed on every period. A
+    // callback that overruns frames / sampleRate and every xrun the backend
+    // reports count as a dropout, and are logged with their timing.
     double GetCpuUsage() const;
     double GetLatency() const;
     uint32_t GetDropouts() const;
+    TimingStats GetCallbackStats() const { return callbackTiming_.GetStats(); }
+    DriftStatus GetDriftStatus() const;
+    void ResetStats();
+    
+    // The latest `count` dropouts, oldest first, and as text with times
+    // since the stream started
+    std::vector<GlitchEvent> GetRecentGlitches(uint32_t count) const;
+    std::string DumpGlitches(uint32_t count = GlitchLog::CAPACITY) const;
+    
+    // Asked on the audio thread, when a dropout is logged, what the chain
+    // was doing (see AudioProcessingChain::GetBlockContext()). Set before
+    // Start().
+    void SetGlitchContextSource(std::function<GlitchContext()> source) { glitchContextSource_ = std::move(source); }
+    
+    // Latency the callback itself adds, in frames at the processing rate
+    // (see AudioProcessingChain::GetLatency()), included in GetLatency().
+    // Asked from whichever thread calls GetLatency().
+    void SetProcessingLatencySource(std::function<uint32_t()> source) { processingLatencySource_ = std::move(source); }
     
     // Volume control
     bool SetMasterVolume(float volume); // 0.0 to 1.0
@@ -80,59 +130,86 @@ public:
     bool SetMuted(bool muted);
     bool IsMuted() const;
     
+    // Dither integer output devices (off by default); applies on Start()
+    void SetOutputDither(bool enabled);
+    bool IsOutputDitherEnabled() const { return outputDither_; }
+    
 private:
-    // WASAPI implementation
-    bool InitializeWASAPI();
-    void ShutdownWASAPI();
-    bool CreateAudioClient(bool isInput, AudioFormat* actualFormat = nullptr);
-    void AudioThreadProc();
-    
-    // Device helpers
-    bool SelectDevice(const std::string& deviceId, bool isInput);
-    std::string GetDeviceName(IMMDevice* device);
-    std::string GetDeviceId(IMMDevice* device);
-    
-    // Format helpers
-    bool SetupFormat(IAudioClient* client, const AudioFormat& format);
-    WAVEFORMATEX* CreateWaveFormat(const AudioFormat& format);
-    
-    // COM interfaces
-    IMMDeviceEnumerator* deviceEnumerator_;
-    IMMDevice* inputDevice_;
-    IMMDevice* outputDevice_;
-    IAudioClient* inputClient_;
-    IAudioClient* outputClient_;
-    IAudioRenderClient* renderClient_;
-    IAudioCaptureClient* captureClient_;
-    ISimpleAudioVolume* volumeControl_;
-    
-    // Audio thread management
-    std::thread audioThread_;
+    // Runs on the backend's audio thread
+    void ProcessBlock(float** inputs, float** outputs, uint32_t channels, uint32_t frames);
+    void RecordGlitch(GlitchType type, uint32_t frames, uint64_t callbackNanos);
+    void RunCallback(float** inputs, float** outputs, uint32_t channels, uint32_t frames);
+    void AdaptBlock(float** inputs, float** outputs, uint32_t channels, uint32_t frames);
+    bool ConfigureAdapter(const AudioFormat& device);
+    void ConfigureChannelMap(const AudioFormat& device);
+    uint32_t GetBusCount(uint32_t deviceChannels) const;
+    
+    std::unique_ptr<AudioBackend> backend_;
     std::atomic<bool> isRunning_;
-    std::atomic<bool> shouldStop_;
-    HANDLE audioEvent_;
-    bool inputEventCallbackMode_;
-    bool outputEventCallbackMode_;
     
     // Configuration
-    AudioFormat currentFormat_;        // Requested format
-    AudioFormat actualInputFormat_;    // Actual input device format
-    AudioFormat actualOutputFormat_;   // Actual output device format
+    AudioFormat currentFormat_;
     std::string currentInputDeviceId_;
     std::string currentOutputDeviceId_;
+    bool outputDither_;
     
     // Callback
+    AudioProcessCallback processCallback_;
     AudioCallback audioCallback_;
     void* callbackUserData_;
     
     // Performance monitoring
     std::atomic<double> cpuUsage_;
     std::atomic<uint32_t> dropoutCount_;
-    std::chrono::high_resolution_clock::time_point lastCpuMeasurement_;
-    
-    // Internal buffers
-    std::vector<float> inputBuffer_;
-    std::vector<float> outputBuffer_;
+    TimingHistogram callbackTiming_;
+    uint32_t streamSampleRate_;     // audio thread only while running
+    uint64_t intervalStart_;
+    uint64_t busyNanos_;
+    uint64_t lastCallbackNanos_;    // audio thread only
+    std::atomic<uint64_t> streamStart_;
+    GlitchLog glitchLog_;
+    std::function<GlitchContext()> glitchContextSource_;
+    std::function<uint32_t()> processingLatencySource_;
+    
+    // Everything below that the audio thread touches is carved out of
+    // arena_ in Start(), once the devices have settled on a format
+    AudioArena arena_;
+    
+    // Interleaved buffers for AudioCallback
+    float* inputBuffer_;
+    float* outputBuffer_;
+    size_t interleavedSize_;
+    
+    // Channel routing. Bus inputs point straight at device channels (or a
+    // silent row); bus outputs render into rows of their own and are copied
+    // out to the device channels.
+    ChannelMap channelMap_;                 // as set, guarded by formatMutex_
+    bool mapping_;
+    uint32_t busCount_;
+    uint32_t deviceChannels_;
+    int32_t* busInputMap_;                  // per bus, resolved for the open devices, -1 = silent
+    int32_t* busOutputMap_;                 // per device channel
+    float* silentRow_;
+    float** busInputPtrs_;
+    float** busOutputPtrs_;
+    
+    // Block adapter around the callback, for rate conversion or fixed
+    // blocks. Device input is resampled (or copied) into captureFifo_; the
+    // callback runs a full block at the processing rate whenever renderFifo_
+    // can't cover the device period, and its output is resampled (or
+    // copied) into renderFifo_.
+    uint32_t processingSampleRate_;
+    ResamplerQuality resamplerQuality_;
+    bool fixedBlockSize_;
+    bool adapting_;
+    uint32_t processingBlock_;
+    Resampler captureResampler_;
+    Resampler renderResampler_;
+    AudioBuffer captureFifo_;
+    AudioBuffer renderFifo_;
+    float** resampledPtrs_;
+    float** blockInputPtrs_;
+    float** blockOutputPtrs_;
     
     // Thread safety
     mutable std::mutex deviceMutex_;
@@ -145,4 +222,4 @@ private:
     static constexpr double CPU_MEASUREMENT_INTERVAL = 1.0; // seconds
 };
 
-} // namespace violet
\ No newline at end of file
+} // namespace violet
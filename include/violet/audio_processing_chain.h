@@ -3,11 +3,19 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <atomic>
 #include <functional>
+#include <algorithm>
+#include <climits>
 #include "violet/plugin_manager.h"
 #include "violet/audio_buffer.h"
+#include "violet/glitch_log.h"
 #include "violet/midi_handler.h"
+#include "violet/processing_thread_pool.h"
+#include "violet/parameter_queue.h"
+#include "violet/performance_stats.h"
 
 namespace violet {
 
@@ -42,26 +50,102 @@ public:
     void SetOutputChannels(const std::vector<uint32_t>& channels);
     std::vector<uint32_t> GetInputChannels() const { return inputChannels_; }
     std::vector<uint32_t> GetOutputChannels() const { return outputChannels_; }
-    
-    // Parameter control
-    void SetParameter(uint32_t parameterIndex, float value);
-    float GetParameter(uint32_t parameterIndex) const;
-    
-    // Parameter automation
+    uint32_t GetChannelCount() const { return channels_; }
+    
+    // Zero-copy port connection. When the routing allows it, plugin audio
+    // ports are connected straight to the buffers passed to Process() instead
+    // of being copied through private buffers.
+    bool IsDirectConnected() const { return routingDirect_ && inPlaceSafe_; }
+    uint64_t GetBytesCopied() const { return bytesCopied_; }  // by the last Process() call
+    
+    // Frames the node delays its audio by: the plugin's reported latency
+    // (lv2:reportsLatency) as of its last run, 0 while bypassed
+    uint32_t GetLatency() const;
+    uint32_t GetReportedLatency() const { return latency_.load(); }
+    
+    // Time spent in this node per block, recorded by the chain
+    TimingHistogram& GetTiming() { return timing_; }
+    const TimingHistogram& GetTiming() const { return timing_; }
+    
+    // Subnormal samples found in this node's output while the chain's
+    // denormal check is on
+    void RecordSubnormals(uint32_t samples);
+    uint64_t GetSubnormalSamples() const { return subnormalSamples_.load(std::memory_order_relaxed); }
+    uint64_t GetSubnormalBlocks() const { return subnormalBlocks_.load(std::memory_order_relaxed); }
+    void ResetSubnormals();
+    
+    // Parameter control. Values only change on the audio thread: other
+    // threads go through AudioProcessingChain::SetParameter, which resolves
+    // the change with NormalizeParameter() and queues it for ApplyParameter().
+    bool NormalizeParameter(uint32_t& parameterIndex, float& value) const;
+    void ApplyParameter(uint32_t parameterIndex, float value);   // audio thread
+    // Audio thread: applies the change sampleOffset frames into the block
+    // the next Process() calls render, splitting it there like an automation
+    // point. Applied right away if too many changes are already waiting.
+    void ApplyParameterAt(uint32_t sampleOffset, uint32_t parameterIndex, float value);
+    float GetParameter(uint32_t parameterIndex) const;          // any thread
+    uint32_t GetParameterCount() const { return static_cast<uint32_t>(controlValues_.size()); }
+    
+    // Carries parameters, bypass, automation and (when the channel count is
+    // unchanged) routing over from the node this one replaces after a format
+    // change. Automation times are rescaled by rateRatio. previous may still
+    // be running on the audio thread; this node must not be yet, and keeps
+    // previous alive until CompleteTransfer() has run.
+    void TransferFrom(std::shared_ptr<ProcessingNode> previous, double rateRatio);
+    // Audio thread, before the node's first block: picks up what previous
+    // applied after it was copied (queued and timed parameter changes, its
+    // sample position)
+    bool IsTransferPending() const { return transferPending_.load(); }
+    void CompleteTransfer();
+    // Editing thread: lets go of previous once the transfer is complete
+    void ReleaseTransferSource();
+    
+    // Parameter automation. Points are timed in frames processed by this
+    // node (see GetSamplePosition()) and kept in an immutable sorted
+    // timeline that the audio thread reads without locking. Process() splits
+    // its block at each point, but never into sub-blocks shorter than the
+    // automation granularity; points closer than that are applied early.
     struct AutomationPoint {
-        uint32_t sampleTime;
+        uint64_t sampleTime;
         uint32_t parameterIndex;
         float value;
     };
     
+    // Each call copies the timeline once, so a whole lane or recorded pass
+    // should go through AddAutomationPoints() or SetAutomation() rather than
+    // point by point.
     void AddAutomationPoint(const AutomationPoint& point);
+    void AddAutomationPoints(std::vector<AutomationPoint> points);
+    // Replaces every point of one parameter
+    void SetAutomation(uint32_t parameterIndex, std::vector<AutomationPoint> points);
     void ClearAutomation();
-    void ProcessAutomation(uint32_t currentSample, uint32_t frames);
+    std::vector<AutomationPoint> GetAutomation() const;
+    void SetAutomationGranularity(uint32_t frames) { automationGranularity_.store(std::max(frames, 1u)); }
+    uint32_t GetAutomationGranularity() const { return automationGranularity_.load(); }
+    uint64_t GetSamplePosition() const { return samplePosition_.load(); }
     
 private:
     void AllocateBuffers();
     void ConnectPorts();
-    void ProcessParameterChanges();
+    void UpdateConnectionMode();
+    void ConnectAudioPorts(float** inputBuffers, float** outputBuffers, uint32_t offset);
+    void ConnectPrivateBuffers();
+    void CopyUnroutedChannels(float** inputBuffers, float** outputBuffers, uint32_t frames);
+    void ReadLatency();
+    void ProbeLatency();
+    
+    // Automation playback (audio thread)
+    struct AutomationTimeline {
+        uint64_t version = 0;
+        std::vector<AutomationPoint> points;    // sorted by sampleTime
+    };
+    const AutomationTimeline* AcquireAutomation();
+    void ReleaseAutomation();
+    uint32_t ApplyAutomation(const AutomationTimeline* timeline, uint64_t position, uint32_t maxFrames);
+    uint32_t ApplyTimedChanges(uint64_t position, uint32_t maxFrames);
+    // Both of the above; returns the frames until the next change
+    uint32_t ApplyScheduledChanges(const AutomationTimeline* timeline, uint64_t position, uint32_t maxFrames);
+    void PublishAutomation(std::unique_ptr<AutomationTimeline> timeline);
     
     std::unique_ptr<PluginInstance> plugin_;
     uint32_t channels_;
@@ -73,10 +157,23 @@ private:
     std::vector<float*> inputPtrs_;
     std::vector<float*> outputPtrs_;
     
-    // Control parameters
+    // Buffers the plugin's audio ports are currently connected to
+    std::vector<float*> connectedInputs_;
+    std::vector<float*> connectedOutputs_;
+    bool routingDirect_;    // every port maps to its own chain channel
+    bool inPlaceSafe_;      // ports may share buffers with the opposite direction
+    std::vector<uint8_t> channelWritten_;
+    uint64_t bytesCopied_;
+    TimingHistogram timing_;
+    std::atomic<uint64_t> subnormalSamples_;
+    std::atomic<uint64_t> subnormalBlocks_;
+    
+    // Control parameters. controlValues_ is connected to the plugin and owned
+    // by the audio thread; parameterShadow_ mirrors it for other threads.
     std::vector<float> controlValues_;
-    std::vector<bool> parameterChanged_;
-    std::vector<float> controlOutputDummy_;  // Dummy buffers for control output ports
+    std::unique_ptr<std::atomic<float>[]> parameterShadow_;
+    std::vector<float> controlOutputValues_;    // control output ports (meters, latency)
+    std::atomic<uint32_t> latency_;
     
     // Channel routing
     std::vector<uint32_t> inputChannels_;
@@ -85,14 +182,125 @@ private:
     // State
     std::atomic<bool> bypassed_;
     
-    // Automation
-    std::vector<AutomationPoint> automationPoints_;
-    std::mutex automationMutex_;
+    // Automation. automation_ is swapped by editors under automationMutex_;
+    // the audio thread announces the timeline it is reading in
+    // automationHazard_ so replaced timelines are only freed once unused.
+    std::atomic<const AutomationTimeline*> automation_;
+    std::atomic<const AutomationTimeline*> automationHazard_;
+    std::vector<std::unique_ptr<const AutomationTimeline>> retiredAutomation_;
+    mutable std::mutex automationMutex_;
+    uint64_t automationVersion_;
+    std::atomic<uint32_t> automationGranularity_;
+    std::atomic<uint64_t> samplePosition_;
+    uint64_t cursorVersion_;                    // audio thread only
+    size_t automationCursor_;                   // next point to apply
+    std::vector<AutomationPoint> timedChanges_; // from ApplyParameterAt(), sorted by sampleTime
+    
+    // Node replaced after a format change, see TransferFrom()
+    std::shared_ptr<ProcessingNode> transferSource_;
+    double transferRatio_;
+    std::atomic<bool> transferPending_;
+    
+    static constexpr uint32_t DEFAULT_AUTOMATION_GRANULARITY = 16;  // frames
+    static constexpr size_t MAX_TIMED_CHANGES = 64;
     
     // MIDI buffers (for future MIDI support)
     std::vector<uint8_t> midiBuffer_;
 };
 
+// Immutable view of the chain that the audio thread processes. Snapshots are
+// built by the editing thread, published with a single atomic store and only
+// freed once the audio thread can no longer be reading them.
+//
+// The chain is a directed acyclic graph: each node sums the outputs of its
+// sources, and the chain output sums outputSources. Nodes are stored in
+// topological order together with everything needed to run them - buffer
+// assignments, dependency counts and the ready queue used by the parallel
+// scheduler - so the audio thread never allocates.
+//
+// Plugin latency is compensated where paths meet: every source of a mix goes
+// through a delay line that holds it back by however much less latency its
+// path has than the mix's slowest source.
+struct ChainSnapshot {
+    static constexpr uint32_t GRAPH_INPUT = UINT32_MAX;  // source index of the chain input
+    static constexpr uint32_t NO_BUFFER = UINT32_MAX;
+    static constexpr uint32_t NO_DELAY = UINT32_MAX;
+    
+    struct GraphNode {
+        std::vector<uint32_t> sources;      // node indices or GRAPH_INPUT
+        std::vector<uint32_t> consumers;    // node indices
+        uint32_t dependencyCount = 0;       // sources that are nodes
+        uint32_t buffer = 0;                // buffer set the node renders into
+        bool inheritsBuffer = false;        // runs in place on its only source's buffer
+        uint32_t firstDelay = NO_DELAY;     // delay line of sources[0], the others follow
+    };
+    
+    // Ring buffer of channels * mask + 1 samples
+    struct DelayLine {
+        std::vector<float> storage;
+        uint32_t mask = 0;
+        uint32_t writePosition = 0;         // audio thread only
+    };
+    
+    uint64_t id = 0;
+    uint32_t sampleRate = 0;
+    std::vector<uint32_t> nodeIds;          // topological order
+    std::vector<ProcessingNode*> nodes;
+    std::vector<GraphNode> graph;
+    std::vector<uint32_t> outputSources;    // node indices or GRAPH_INPUT
+    std::vector<uint32_t> roots;            // nodes that only depend on the chain input
+    
+    // Delay compensation. arrival holds each node's output latency from the
+    // chain input in the current block, and latency the chain output's.
+    // Written by the audio thread (and workers) once published.
+    std::vector<uint32_t> arrival;
+    uint32_t latency = 0;
+    std::vector<DelayLine> delayLines;
+    uint32_t outputFirstDelay = NO_DELAY;   // delay line of outputSources[0]
+    uint32_t maxDelay = 0;                  // longest delay the lines can hold
+    
+    // Parallel execution
+    ProcessingThreadPool* threadPool = nullptr;
+    bool parallel = false;
+    
+    // Buffer sets, channels * maxFrames each
+    uint32_t channels = 0;
+    uint32_t maxFrames = 0;
+    uint32_t outputBoundBuffer = NO_BUFFER; // rendered straight into the caller's output
+    bool inputAliasSafe = false;            // only the output-bound set's first node reads the input
+    std::vector<float> bufferStorage;
+    std::vector<float*> bufferPtrs;
+    std::vector<float**> bufferSets;        // last set stages the chain input
+    std::vector<float*> inputSlice;         // caller buffers offset to the current slice
+    std::vector<float*> outputSlice;
+    
+    // Per-block scheduling state (audio thread and workers only)
+    std::unique_ptr<std::atomic<uint32_t>[]> pending;
+    std::unique_ptr<std::atomic<uint32_t>[]> readyQueue;
+    std::atomic<uint32_t> readyHead{0};
+    std::atomic<uint32_t> readyTail{0};
+    std::atomic<uint32_t> completed{0};
+    std::atomic<uint64_t> mixBytesCopied{0};
+    std::atomic<uint64_t> slowestNode{0};   // (nanos << 16) | node index, max over the block
+    float** graphInput = nullptr;
+    const std::atomic<bool>* denormalCheck = nullptr;  // scan node outputs for subnormals
+    
+    // Crossfade from the graph this snapshot replaced when every node was
+    // re-instantiated for a new format. The old snapshot and its nodes live
+    // on in here, so they are reclaimed together with this snapshot.
+    std::unique_ptr<ChainSnapshot> fadeFrom;
+    std::vector<std::shared_ptr<void>> fadeNodes;
+    uint32_t fadeFrames = 0;
+    uint32_t fadePosition = 0;              // audio thread only
+    std::vector<float> fadeStorage;         // old graph output, fadeFrames + its maxFrames per channel
+    std::vector<float*> fadeBuffers;
+    std::vector<float*> fadeInputs;         // per-slice views for rendering the old graph
+    std::vector<float*> fadeOutputs;
+    
+    // Some node still has to CompleteTransfer(); cleared by the audio thread
+    bool transferPending = false;
+};
+
 // Audio processing chain manager
 class AudioProcessingChain {
 public:
@@ -101,10 +309,27 @@ public:
     
     // Chain management
     uint32_t AddPlugin(const std::string& pluginUri, uint32_t position = UINT_MAX);
+    uint32_t AddSumNode(uint32_t position = UINT_MAX);  // plugin-less node that mixes its inputs
     bool RemovePlugin(uint32_t nodeId);
     bool MovePlugin(uint32_t nodeId, uint32_t newPosition);
     void ClearChain();
     
+    // Graph topology. Node id GRAPH_IO (0) is the chain input when used as a
+    // source and the chain output when used as a destination. Until the
+    // topology is edited the chain stays linear and follows node positions.
+    static constexpr uint32_t GRAPH_IO = 0;
+    bool ConnectNodes(uint32_t sourceId, uint32_t destinationId);
+    bool DisconnectNodes(uint32_t sourceId, uint32_t destinationId);
+    bool SetNodeInputs(uint32_t nodeId, const std::vector<uint32_t>& sourceIds);
+    std::vector<uint32_t> GetNodeInputs(uint32_t nodeId) const;
+    bool IsLinear() const;
+    
+    // Parallel processing on pre-spawned realtime workers
+    void SetWorkerThreadCount(uint32_t count);
+    uint32_t GetWorkerThreadCount() const;
+    
+    PluginManager* GetPluginManager() const { return pluginManager_; }
+    
     // Node access
     ProcessingNode* GetNode(uint32_t nodeId);
     const ProcessingNode* GetNode(uint32_t nodeId) const;
@@ -121,38 +346,112 @@ public:
     void SetEnabled(bool enabled) { enabled_.store(enabled); }
     bool IsEnabled() const { return enabled_.load(); }
     
-    // Parameter control
-    bool SetParameter(uint32_t nodeId, uint32_t parameterIndex, float value);
+    // Parameter control. SetParameter queues the change for the audio thread
+    // and returns false if the node or parameter doesn't exist or the queue
+    // is full. Safe to call from any non-realtime thread.
+    // sampleOffset places the change that many frames into the next block;
+    // past its end, or while the chain is bypassed, it lands at the start.
+    bool SetParameter(uint32_t nodeId, uint32_t parameterIndex, float value, uint32_t sampleOffset = 0);
     float GetParameter(uint32_t nodeId, uint32_t parameterIndex) const;
     
+    // Automation lanes, see ProcessingNode. SetAutomation replaces one
+    // parameter's points with a single timeline update and returns false if
+    // the node or parameter doesn't exist; values are clamped like
+    // SetParameter's.
+    bool SetAutomation(uint32_t nodeId, uint32_t parameterIndex,
+                       std::vector<ProcessingNode::AutomationPoint> points);
+    std::vector<ProcessingNode::AutomationPoint> GetAutomation(uint32_t nodeId) const;
+    
     // MIDI parameter mapping
     void SetMidiParameterMapper(std::shared_ptr<MidiParameterMapper> mapper);
     void ProcessMidiParameterControl(const MidiMessage& message);
     
-    // Performance monitoring
+    // Reclaim snapshots and nodes the audio thread has moved past.
+    // Must be called from a non-realtime thread (the UI timer does this).
+    void CollectRetired();
+    
+    // Performance monitoring. Every block and every node is timed; a block
+    // that takes longer than frames / sampleRate counts as an xrun. All of
+    // this can be read from any thread without blocking the audio thread.
+    struct NodeStats {
+        uint32_t nodeId;
+        std::string name;
+        TimingStats timing;
+        uint64_t subnormalSamples;
+        uint64_t subnormalBlocks;
+        uint32_t latency;           // frames
+    };
+    
+    struct ChainStats {
+        TimingStats callback;
+        uint64_t blocks;
+        uint64_t xruns;
+        double cpuUsage;            // smoothed percentage of the block deadline
+        uint32_t latency;           // frames, see GetLatency()
+        std::vector<NodeStats> nodes;
+    };
+    
     double GetCpuUsage() const { return cpuUsage_.load(); }
     uint32_t GetProcessedFrames() const { return processedFrames_.load(); }
+    uint64_t GetBytesCopiedPerBlock() const { return bytesCopiedPerBlock_.load(); }
+    uint64_t GetXrunCount() const { return xrunCount_.load(); }
+    
+    // Frames from the chain input to its output at the chain's sample rate:
+    // the plugin latencies along the slowest path, as of the latest block.
+    // Shorter parallel and dry paths are delayed to match before mixing.
+    uint32_t GetLatency() const { return latency_.load(); }
+    
+    // The graph and slowest node of the latest block, for the engine's
+    // glitch log (AudioEngine::SetGlitchContextSource())
+    GlitchContext GetBlockContext() const;
+    ChainStats GetStats() const;
+    std::string DumpStats() const;
     void ResetPerformanceCounters();
     
-    // Audio format
+    // Denormal diagnostics: scans every node's output for subnormal samples
+    // and counts them per node (see NodeStats and DumpStats()). Audio
+    // threads flush denormals to zero, which hides most of them, so run
+    // with SetDenormalFlushEnabled(false) to find the plugins producing them.
+    void SetDenormalCheck(bool enabled) { denormalCheck_.store(enabled); }
+    bool IsDenormalCheckEnabled() const { return denormalCheck_.load(); }
+    
+    // Audio format. SetFormat() applies to nodes added from then on and
+    // returns straight away; existing nodes are re-instantiated at the new
+    // format on a background thread, their parameters and LV2 state carried
+    // over, and swapped in at a block boundary with a short crossfade.
+    // Until then the audio thread keeps running the old nodes.
     bool SetFormat(uint32_t sampleRate, uint32_t channels, uint32_t blockSize);
     void GetFormat(uint32_t& sampleRate, uint32_t& channels, uint32_t& blockSize) const;
-    
-    // Session management
+    void WaitForFormatChange();     // blocks until every node runs at the current format
+    
+    // Promise that Process() always gets exactly blockSize frames (the
+    // engine's fixed block adapter, or offline rendering). Plugins are then
+    // told the block length is fixed, and automation moves to block starts
+    // so runs are never split. Re-instantiates existing nodes like SetFormat().
+    void SetFixedBlockLength(bool fixed);
+    bool IsFixedBlockLength() const;
+    
+    // Session management. The state carries the graph: node ids are the
+    // saved ones, and LoadState maps them onto the nodes it creates. A
+    // plugin that fails to load is stood in for by a sum node so its edges
+    // survive, and LoadState returns false.
     struct ChainState {
         struct NodeState {
             uint32_t nodeId;
-            std::string pluginUri;
+            std::string pluginUri;              // empty for sum nodes
             uint32_t position;
             bool bypassed;
             std::map<std::string, std::string> pluginState;
             std::vector<uint32_t> inputChannels;
             std::vector<uint32_t> outputChannels;
+            std::vector<uint32_t> inputs;       // source node ids, GRAPH_IO = chain input
         };
         
         std::vector<NodeState> nodes;
-        bool bypassed;
-        bool enabled;
+        bool linearGraph = true;
+        std::vector<uint32_t> outputs;          // node ids summed into the chain output
+        bool bypassed = false;
+        bool enabled = true;
     };
     
     ChainState SaveState() const;
@@ -161,8 +460,32 @@ public:
 private:
     void ReorderChain();
     void UpdateAudioFormat();
+    void FormatThreadProc();
     uint32_t GetNextNodeId();
     
+    uint32_t InsertNode(std::unique_ptr<ProcessingNode> node, uint32_t position, uint64_t formatGeneration);
+    
+    // Graph editing (called with nodesMutex_ held)
+    void RebuildLinearGraph();
+    bool IsReachable(uint32_t fromId, uint32_t toId) const;
+    std::vector<uint32_t>* FindInputs(uint32_t nodeId);
+    
+    // Snapshot publication (editing side, called with nodesMutex_ held)
+    std::unique_ptr<ChainSnapshot> BuildSnapshot() const;
+    void PublishSnapshot(std::vector<std::shared_ptr<void>> fadeNodes = {});
+    void Retire(std::shared_ptr<void> object);
+    void CollectRetiredLocked();
+    
+    // Snapshot access (audio thread side)
+    ChainSnapshot* AcquireSnapshot();
+    void ReleaseSnapshot();
+    uint64_t RenderSnapshot(ChainSnapshot* snapshot, float** inputBuffers, float** outputBuffers,
+                            uint32_t channels, uint32_t frames);
+    void ProcessGraph(ChainSnapshot* snapshot, float** inputBuffers, float** outputBuffers,
+                      uint32_t channels, uint32_t frames);
+    void ApplyParameterChanges(ChainSnapshot* snapshot, uint32_t frames);
+    void RecordBlockTime(uint64_t nanos, uint32_t frames, uint32_t sampleRate);
+    
     AudioEngine* audioEngine_;
     PluginManager* pluginManager_;
     
@@ -171,17 +494,52 @@ private:
         uint32_t nodeId;
         uint32_t position;
         std::unique_ptr<ProcessingNode> node;
+        std::vector<uint32_t> inputs;   // source node ids, GRAPH_IO = chain input
+        uint64_t formatGeneration = 0;  // format the node was instantiated for
     };
     
+    // Editing-side view of the chain. nodesMutex_ is only ever taken by
+    // non-realtime threads; the audio thread reads snapshot_ instead.
     std::vector<NodeInfo> nodes_;
+    std::vector<uint32_t> outputSources_;
+    bool linearGraph_;
     mutable std::mutex nodesMutex_;
     
+    // Worker threads, swapped and retired like any other snapshot resource
+    std::shared_ptr<ProcessingThreadPool> threadPool_;
+    
+    // Published snapshot and epoch-based reclamation state. Anything the
+    // audio thread might still reference (snapshots, removed nodes, old
+    // thread pools) is retired here and freed by CollectRetired().
+    struct RetiredItem {
+        uint64_t epoch;
+        std::shared_ptr<void> object;
+    };
+    
+    std::atomic<ChainSnapshot*> snapshot_;
+    std::atomic<uint64_t> globalEpoch_;
+    std::atomic<uint64_t> readerEpoch_;
+    std::vector<std::shared_ptr<void>> pendingRetired_;
+    std::vector<RetiredItem> retired_;
+    
     // Audio format
     uint32_t sampleRate_;
     uint32_t channels_;
     uint32_t blockSize_;
+    bool fixedBlockLength_;
     mutable std::mutex formatMutex_;
     
+    // Background re-instantiation after a format change. The generation is
+    // bumped by every SetFormat(); formatThread_ rebuilds nodes whose
+    // generation is behind and exits once there are none. All guarded by
+    // formatMutex_.
+    uint64_t formatGeneration_;
+    bool formatBusy_;
+    bool formatStop_;
+    std::thread formatThread_;
+    std::condition_variable formatIdle_;
+    std::mutex instantiateMutex_;       // serializes plugin instantiation
+    
     // Chain state
     std::atomic<bool> bypassed_;
     std::atomic<bool> enabled_;
@@ -189,20 +547,32 @@ private:
     // Performance monitoring
     std::atomic<double> cpuUsage_;
     std::atomic<uint32_t> processedFrames_;
-    std::chrono::high_resolution_clock::time_point lastCpuMeasurement_;
+    std::atomic<uint64_t> bytesCopiedPerBlock_;
+    TimingHistogram callbackTiming_;
+    std::atomic<uint64_t> blockCount_;
+    std::atomic<uint64_t> xrunCount_;
+    std::atomic<bool> denormalCheck_;
+    std::atomic<uint64_t> lastSnapshotId_;
+    std::atomic<uint32_t> lastSlowestNodeId_;
+    std::atomic<uint64_t> lastSlowestNodeNanos_;
+    std::atomic<uint32_t> latency_;
+    
+    // Parameter changes on their way to the audio thread
+    ParameterQueue parameterQueue_;
     
     // MIDI parameter mapping
     std::shared_ptr<MidiParameterMapper> midiMapper_;
     
-    // Internal buffers for chain processing
-    std::vector<std::vector<float>> chainBuffers_;
-    std::vector<float*> chainBufferPtrs_;
-    
     // ID generation
     std::atomic<uint32_t> nextNodeId_;
     
     // Constants
-    static constexpr double CPU_MEASUREMENT_INTERVAL = 1.0; // seconds
+    static constexpr double CPU_SMOOTHING = 0.05;       // per-block weight of the DSP load average
+    static constexpr uint64_t READER_IDLE = UINT64_MAX;
+    static constexpr uint32_t MIN_GRAPH_BLOCK = 1024;   // frames per buffer set
+    static constexpr uint32_t MAX_IO_CHANNELS = 32;     // caller channels routed through the graph
+    static constexpr uint32_t FORMAT_FADE_MS = 10;      // crossfade after a format change
+    static constexpr uint32_t MIN_COMPENSATION = 8192;  // frames of delay every delay line can hold
 };
 
 // Preset management for processing chains
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "violet/audio_buffer.h"
+
+namespace violet {
+
+// What a DriftCompensator is doing, for status lines and logs
+struct DriftStatus {
+    bool active = false;
+    double ratioPpm = 0.0;          // capture clock relative to render, parts per million
+    double latencyFrames = 0.0;     // smoothed capture-to-play delay the loop holds
+    uint32_t targetFrames = 0;
+    uint64_t resyncs = 0;           // FIFO under/overruns that restarted the stream
+};
+
+// Bridges a capture stream onto a render stream running off a different
+// device clock. Captured frames go into a FIFO; the render side pulls
+// exactly the frames it needs through a variable-ratio cubic resampler. A
+// delay-locked loop (PI controller on the smoothed delay) steers the
+// resampling ratio until it matches the clock ratio, so the delay, and with
+// it the round-trip latency, stays where it started instead of creeping
+// until the FIFO runs dry or overflows.
+//
+// The delay is the FIFO level, corrected by timestamps when the caller has
+// them: packets arrive in bursts, so the bare level is a sawtooth whose
+// average shifts as the two clocks slide past each other, while
+// "play time of the next pulled frame minus its capture time" is smooth.
+//
+// Push() and Pull() run on the same audio thread; GetStatus() may be
+// called from anywhere.
+class DriftCompensator {
+public:
+    DriftCompensator();
+
+    DriftCompensator(const DriftCompensator&) = delete;
+    DriftCompensator& operator=(const DriftCompensator&) = delete;
+
+    // Pushes and pulls are at most `maxPush` and `maxPull` frames. Pulls
+    // start once `targetFill` frames are queued; that has to cover one
+    // capture packet, one render period and the scheduling jitter.
+    void Configure(uint32_t channels, uint32_t maxPush, uint32_t maxPull, uint32_t targetFill,
+                   double sampleRate);
+
+    // Drops buffered audio and the clock estimate
+    void Reset();
+
+    // Capture side. `captureTime` is when the first frame was recorded, in
+    // seconds on the clock Pull() uses, or negative if unknown. Frames that
+    // don't fit count as an overrun and restart the stream.
+    void Push(const float* const* inputs, uint32_t frames, double captureTime = -1.0);
+
+    // Render side: fills `frames` frames of every channel, silence while
+    // the FIFO is priming after a start or an underrun. `playTime` is when
+    // the first of them reaches the device output, or negative if unknown.
+    void Pull(float* const* outputs, uint32_t frames, double playTime = -1.0);
+
+    DriftStatus GetStatus() const;
+
+private:
+    double MeasureDelay(double playTime) const;
+    void UpdateLoop(uint32_t frames, double delay);
+    void Resync();
+
+    uint32_t channels_;
+    uint32_t maxPull_;
+    uint32_t targetFill_;
+    double sampleRate_;
+    AudioBuffer fifo_;
+    bool priming_;
+    double captureEnd_;                 // capture time just past the last pushed frame
+
+    // Resampler state: the last HISTORY input frames per channel and the
+    // fractional read position between history[1] and history[2]
+    static constexpr uint32_t HISTORY = 3;
+    std::vector<float> history_;
+    double phase_;
+    std::vector<float> work_;           // history + peeked input, one channel
+    std::vector<uint32_t> indices_;     // per output frame
+    std::vector<float> fractions_;
+
+    // Loop state
+    double targetDelay_;                // latched when a stream (re)starts
+    double filteredError_;
+    double integral_;
+    double ratio_;                      // input frames per output frame
+
+    std::atomic<double> statusRatio_;
+    std::atomic<double> statusDelay_;
+    std::atomic<uint64_t> resyncs_;
+};
+
+} // namespace violet
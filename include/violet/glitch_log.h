@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace violet {
+
+enum class GlitchType : uint32_t {
+    CallbackOverrun,    // the callback took longer than its period
+    RenderUnderrun,     // the output device ran out of audio
+    CaptureOverrun,     // the input device dropped audio (discontinuity)
+    CaptureUnderrun     // the input device had no audio for the period
+};
+
+const char* GetGlitchTypeName(GlitchType type);
+
+// What the chain was doing in its most recent block, so a glitch can be
+// pinned on a plugin. Node ids match AudioProcessingChain::DumpStats().
+struct GlitchContext {
+    uint64_t snapshotId = 0;        // 0 = no chain
+    uint32_t slowestNodeId = 0;     // 0 = no node ran
+    uint64_t slowestNodeNanos = 0;
+};
+
+struct GlitchEvent {
+    uint64_t timeNanos = 0;         // MonotonicNanos() when detected
+    GlitchType type = GlitchType::CallbackOverrun;
+    uint32_t frames = 0;            // device period
+    uint64_t callbackNanos = 0;     // the callback's run time (the previous one for device xruns)
+    uint64_t deadlineNanos = 0;     // the period's length
+    GlitchContext context;
+};
+
+// Fixed-size ring of the most recent glitches. Record() is wait-free and
+// allocation free for the audio thread; GetRecent() may run on any thread at
+// the same time and skips slots that are being overwritten.
+class GlitchLog {
+public:
+    static constexpr uint32_t CAPACITY = 256;   // power of two
+
+    GlitchLog();
+
+    GlitchLog(const GlitchLog&) = delete;
+    GlitchLog& operator=(const GlitchLog&) = delete;
+
+    void Record(const GlitchEvent& event);
+
+    // Up to `count` of the latest events, oldest first
+    std::vector<GlitchEvent> GetRecent(uint32_t count) const;
+    uint64_t GetTotalCount() const;
+
+    // Forgets earlier events; safe while Record() runs
+    void Reset();
+
+private:
+    static constexpr size_t EVENT_WORDS = (sizeof(GlitchEvent) + 7) / 8;
+
+    // The sequence is odd while the slot is written and 2 * (index + 1)
+    // once event `index` is in it. The payload is stored as atomic words so
+    // a reader racing a writer sees torn data, never undefined behaviour,
+    // and the sequence check throws torn data away.
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[EVENT_WORDS];
+    };
+
+    Slot slots_[CAPACITY];
+    std::atomic<uint64_t> writeIndex_;
+    std::atomic<uint64_t> resetIndex_;      // events before this one are forgotten
+};
+
+// One line per event: time since `originNanos` (e.g. the stream start), type,
+// timing and the slowest node
+std::string FormatGlitches(const std::vector<GlitchEvent>& events, uint64_t originNanos);
+
+} // namespace violet
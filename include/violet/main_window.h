@@ -98,12 +98,6 @@ private:
     std::unique_ptr<AudioProcessingChain> processingChain_;
     std::unique_ptr<SessionManager> sessionManager_;
     
-    // Audio buffers for de-interleaving (used in audio callback)
-    std::vector<float> audioBufferLeft_;
-    std::vector<float> audioBufferRight_;
-    std::vector<float> audioBufferLeftOut_;
-    std::vector<float> audioBufferRightOut_;
-    
     // Window properties
     static const wchar_t* CLASS_NAME;
     static const int DEFAULT_WIDTH = 1000;
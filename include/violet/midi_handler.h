@@ -1,7 +1,9 @@
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
 #include <mmeapi.h>
+#endif
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -61,7 +63,8 @@ struct MidiMessage {
 // MIDI callback function type
 using MidiCallback = std::function<void(const MidiMessage& message, void* userData)>;
 
-// MIDI input handler
+#ifdef _WIN32
+// MIDI input handler (Windows multimedia API)
 class MidiHandler {
 public:
     MidiHandler();
@@ -159,6 +162,7 @@ private:
     static constexpr size_t DEFAULT_BUFFER_SIZE = 1024;
     static constexpr uint32_t SYSEX_BUFFER_SIZE = 1024;
 };
+#endif // _WIN32
 
 // MIDI parameter mapping for plugin control
 class MidiParameterMapper {
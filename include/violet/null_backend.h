@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include "violet/audio_backend.h"
+#include "violet/wav_file.h"
+
+namespace violet {
+
+// Device-less backend for headless runs. Callbacks are paced by a
+// high-resolution timer, one buffer per period, or run back to back in
+// freewheel mode. Device "null" is silence in and discard out; a device id
+// of "file:<path>" reads a WAV file as input (looped) or writes the output
+// to one when the stream is closed.
+class NullBackend : public AudioBackend {
+public:
+    NullBackend();
+    ~NullBackend() override;
+    
+    const char* GetName() const override { return "null"; }
+    bool Initialize() override { return true; }
+    
+    std::vector<AudioDevice> EnumerateDevices() override;
+    
+    bool Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+              const AudioFormat& requested, AudioFormat& actual) override;
+    void Close() override;
+    std::string GetOpenInputDevice() const override { return inputDeviceId_; }
+    std::string GetOpenOutputDevice() const override { return outputDeviceId_; }
+    uint32_t GetMaxFrames() const override { return format_.bufferSize; }
+    bool HasFixedBlockSize() const override { return true; }
+    
+    bool Start(AudioProcessCallback callback) override;
+    void Stop() override;
+    
+    double GetLatency() const override;
+    
+    // Run callbacks as fast as they complete instead of in real time
+    void SetFreewheel(bool freewheel) { freewheel_ = freewheel; }
+    
+    // Frames processed since Open()
+    uint64_t GetProcessedFrames() const { return processedFrames_.load(); }
+
+private:
+    void AudioThreadProc();
+    
+    std::string inputDeviceId_;
+    std::string outputDeviceId_;
+    AudioFormat format_;
+    bool freewheel_;
+    
+    AudioFileData inputFile_;
+    uint64_t inputPosition_;
+    std::string outputPath_;
+    AudioFileData outputFile_;
+    
+    std::vector<float> inputBuffer_;
+    std::vector<float> outputBuffer_;
+    std::vector<float*> inputPtrs_;
+    std::vector<float*> outputPtrs_;
+    
+    std::thread audioThread_;
+    std::atomic<bool> shouldStop_;
+    std::atomic<uint64_t> processedFrames_;
+    AudioProcessCallback callback_;
+    
+    static constexpr double OUTPUT_RESERVE_SECONDS = 60.0;
+};
+
+} // namespace violet
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "violet/resampler.h"
+#include "violet/wav_file.h"
+
+namespace violet {
+
+// Forward declarations
+class AudioProcessingChain;
+
+struct OfflineRenderOptions {
+    uint32_t sampleRate = 0;        // 0 = the input's rate; other rates resample the input
+    uint32_t outputSampleRate = 0;  // 0 = the render rate
+    ResamplerQuality quality = ResamplerQuality::Best;
+    uint32_t channels = 0;          // 0 = the input's channel count
+    uint32_t blockSize = 256;
+    double tailSeconds = 0.0;       // silence rendered after the input, for reverb tails
+};
+
+struct OfflineRenderResult {
+    uint64_t frames = 0;
+    uint64_t blocks = 0;
+    uint32_t latencyFrames = 0;     // plugin latency removed from the front
+    double audioSeconds = 0.0;
+    double wallSeconds = 0.0;
+    double realtimeFactor = 0.0;    // seconds of audio per wall-clock second
+};
+
+// Drives an AudioProcessingChain without an audio device, one block after
+// another as fast as the CPU allows. The chain is switched to the requested
+// format with a fixed block length first (the last block is padded);
+// plugins should be added after that so they are instantiated at the render
+// rate. Input at another rate is resampled on the way in, and
+// the output can be resampled on the way out; both conversions and the
+// chain's plugin latency are compensated so the output lines up with the
+// input.
+class OfflineRenderer {
+public:
+    explicit OfflineRenderer(AudioProcessingChain* chain);
+
+    // Sets the chain format for a render of the given input
+    bool Prepare(const AudioFileData& input, const OfflineRenderOptions& options);
+
+    bool Render(const AudioFileData& input, AudioFileData& output,
+                const OfflineRenderOptions& options, OfflineRenderResult& result);
+
+    const std::string& GetLastError() const { return lastError_; }
+
+private:
+    AudioProcessingChain* chain_;
+    std::string lastError_;
+};
+
+} // namespace violet
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace violet {
+
+// A parameter change on its way to the audio thread
+struct ParameterChange {
+    uint32_t nodeId;
+    uint32_t parameterIndex;
+    float value;
+    uint32_t sampleOffset;  // frames into the next block
+};
+
+// Bounded lock-free multi-producer, single-consumer queue of parameter
+// changes. Any non-realtime thread (UI, MIDI, session loading) may push;
+// only the audio thread pops. Each slot carries a sequence number, so
+// producers claim slots with a single CAS and the consumer never blocks.
+class ParameterQueue {
+public:
+    explicit ParameterQueue(uint32_t capacity = DEFAULT_CAPACITY);
+    ~ParameterQueue();
+    
+    ParameterQueue(const ParameterQueue&) = delete;
+    ParameterQueue& operator=(const ParameterQueue&) = delete;
+    
+    // Returns false when the queue is full; the change is dropped
+    bool Push(const ParameterChange& change);
+    
+    // Audio thread only
+    bool Pop(ParameterChange& change);
+    
+    uint32_t GetCapacity() const { return capacity_; }
+    uint64_t GetDroppedCount() const { return dropped_.load(); }
+    
+    static constexpr uint32_t DEFAULT_CAPACITY = 1024;
+    
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        ParameterChange change;
+    };
+    
+    std::unique_ptr<Slot[]> slots_;
+    uint32_t capacity_;     // power of two
+    uint64_t mask_;
+    
+    // Producers and the consumer each get their own cache line
+    alignas(64) std::atomic<uint64_t> enqueuePos_;
+    alignas(64) std::atomic<uint64_t> dequeuePos_;
+    std::atomic<uint64_t> dropped_;
+};
+
+} // namespace violet
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace violet {
+
+// Device sample formats, all little-endian and interleaved
+enum class PcmFormat {
+    Float32,
+    Int16,
+    Int24,          // packed, 3 bytes per sample
+    Int24In32,      // 24 bits in the low 3 bytes of a 32-bit word
+    Int32,
+};
+
+// Instruction sets the PCM kernels are built for
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+namespace pcm {
+
+uint32_t GetSampleBytes(PcmFormat format);
+const char* GetFormatName(PcmFormat format);
+
+// TPDF dither for one output stream. Adds the difference of two uniform
+// random values, +/-1 LSB peak, before rounding to 16 or 24 bits; float and
+// 32-bit integer output are never dithered.
+class Dither {
+public:
+    explicit Dither(uint32_t seed = 1);
+
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool IsEnabled() const { return enabled_; }
+
+    // Per-lane generator state for the kernels, nullptr when disabled
+    uint32_t* GetState() { return enabled_ ? state_ : nullptr; }
+
+private:
+    alignas(32) uint32_t state_[8];
+    bool enabled_;
+};
+
+// Device buffer -> planar float. `sourceChannels` interleaved channels of
+// `frames` frames are converted to [-1, 1) floats. Source channels beyond
+// `destChannels` are dropped, destination channels beyond `sourceChannels`
+// are zeroed.
+void Decode(const void* source, PcmFormat format, uint32_t sourceChannels,
+            float* const* dest, uint32_t destChannels, uint32_t frames);
+
+// Planar float -> device buffer, saturating integer formats. Device channels
+// beyond `sourceChannels` are written silent, as is everything when
+// `source` is null.
+void Encode(const float* const* source, uint32_t sourceChannels,
+            void* dest, PcmFormat format, uint32_t destChannels, uint32_t frames,
+            Dither* dither = nullptr);
+
+// Plain float (de)interleave between an interleaved buffer and `channels`
+// planar buffers, vectorized for any channel count
+void Deinterleave(const float* source, uint32_t channels, float* const* dest, uint32_t frames);
+void Interleave(const float* const* source, uint32_t channels, float* dest, uint32_t frames);
+
+// The kernels are picked once from what the CPU supports, capped by
+// $VIOLET_SIMD (scalar, sse2, avx2). SetSimdLevel() switches them for
+// tests and benchmarks; it must not race with running streams.
+SimdLevel GetSimdLevel();
+SimdLevel GetMaxSimdLevel();
+bool SetSimdLevel(SimdLevel level);
+const char* GetSimdLevelName(SimdLevel level);
+bool ParseSimdLevel(const std::string& name, SimdLevel& level);
+
+} // namespace pcm
+} // namespace violet
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "violet/plugin_manager.h"
+
+namespace violet {
+
+// A plugin as the cache keeps it
+struct CachedPlugin {
+    PluginInfo info;
+    std::vector<ParameterInfo> parameters;
+};
+
+// One LV2 bundle and the plugins lilv found in it, as of the fingerprint
+struct CachedBundle {
+    std::string path;           // see NormalizeBundlePath()
+    uint64_t fingerprint = 0;
+    std::vector<CachedPlugin> plugins;
+};
+
+struct BundleFingerprint {
+    std::string path;
+    uint64_t fingerprint = 0;
+};
+
+// Plugin metadata kept between runs, so the plugin list is there before
+// lilv has parsed a single plugin. Entries are keyed by bundle directory and
+// a fingerprint of the files in it; a bundle whose fingerprint changed has
+// to be parsed again.
+//
+// The file is a header, fixed-size records for bundles, plugins and
+// parameters, and a string table, all addressed by offset and sorted for
+// binary search. It is used straight from a read-only mapping (one read on
+// Windows, where a mapped file can't be replaced by the next Save()): Load()
+// only validates it, and nothing is decoded until asked for. The layout is
+// the host's byte order; a file from another version is ignored.
+class PluginCache {
+public:
+    PluginCache();
+    ~PluginCache();
+
+    PluginCache(const PluginCache&) = delete;
+    PluginCache& operator=(const PluginCache&) = delete;
+
+    // False, leaving the cache empty, if the file is missing, from another
+    // version or damaged
+    bool Load(const std::string& path);
+    void Clear();
+    bool IsLoaded() const { return header_ != nullptr; }
+
+    // Writes through a temporary file, so a reader never sees half a cache
+    static bool Save(const std::string& path, const std::vector<CachedBundle>& bundles);
+
+    size_t GetBundleCount() const;
+    size_t GetPluginCount() const;
+
+    // The fingerprint the bundle was cached with; false if it isn't cached
+    bool FindBundle(const std::string& bundlePath, uint64_t& fingerprint) const;
+    std::vector<PluginInfo> GetBundlePlugins(const std::string& bundlePath) const;
+    bool ReadBundle(const std::string& bundlePath, CachedBundle& bundle) const;
+    bool GetParameters(const std::string& uri, std::vector<ParameterInfo>& parameters) const;
+    // The bundle the plugin was in when cached, "" if it isn't cached
+    std::string FindPluginBundle(const std::string& uri) const;
+
+private:
+    struct FileHeader;
+    struct BundleRecord;
+    struct PluginRecord;
+    struct ParameterRecord;
+
+    const BundleRecord* FindBundleRecord(const std::string& bundlePath) const;
+    const PluginRecord* FindPluginRecord(const std::string& uri) const;
+    const char* GetString(uint32_t offset) const;
+    PluginInfo DecodePlugin(const PluginRecord& record) const;
+    std::vector<ParameterInfo> DecodeParameters(const PluginRecord& record) const;
+
+    const uint8_t* data_;
+    size_t size_;
+    std::vector<uint8_t> buffer_;   // the file where it isn't mapped
+
+    const FileHeader* header_;
+    const BundleRecord* bundles_;
+    const PluginRecord* plugins_;
+    const uint32_t* uriIndex_;  // plugin records sorted by URI
+    const ParameterRecord* parameters_;
+    const uint32_t* enumValues_;
+    const char* strings_;
+};
+
+// Bundle directories as lilv reports them and as FindBundles() lists them
+// compare equal after this: '/' separators, no trailing separator
+std::string NormalizeBundlePath(const std::string& path);
+
+// Every LV2 bundle (a directory holding manifest.ttl) in the directories of
+// an LV2_PATH-style list, the way lilv finds them, fingerprinted
+std::vector<BundleFingerprint> FindBundles(const std::string& searchPath);
+
+// Hash of the name, size and modification time of every file in the
+// bundle; 0 if it can't be read
+uint64_t FingerprintBundle(const std::string& bundlePath);
+
+// $VIOLET_PLUGIN_CACHE if set ("off" disables the cache: ""), otherwise a
+// file in the user's cache directory
+std::string GetDefaultPluginCachePath();
+
+} // namespace violet
@@ -6,17 +6,25 @@
 #include <lv2/lv2plug.in/ns/ext/atom/atom.h>
 #include <lv2/lv2plug.in/ns/ext/midi/midi.h>
 #include <lv2/lv2plug.in/ns/ext/state/state.h>
+#include <lv2/lv2plug.in/ns/ext/options/options.h>
+#include <lv2/lv2plug.in/ns/ext/buf-size/buf-size.h>
 
 #include <string>
 #include <vector>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include <functional>
-#include <windows.h>
 #include "violet/audio_buffer.h"
 
 namespace violet {
 
+class PluginCache;
+struct CachedBundle;
+
 // Plugin information
 struct PluginInfo {
     std::string uri;
@@ -25,6 +33,7 @@ struct PluginInfo {
     std::string category;
     std::string description;
     bool hasUI;
+    bool inPlaceBroken;       // lv2:inPlaceBroken - inputs and outputs must not share buffers
     uint32_t audioInputs;
     uint32_t audioOutputs;
     uint32_t controlInputs;
@@ -51,7 +60,11 @@ struct ParameterInfo {
 // Plugin instance
 class PluginInstance {
 public:
-    PluginInstance(const LilvPlugin* plugin, LilvWorld* world, double sampleRate, uint32_t blockSize);
+    // With fixedBlockLength the host promises Process() always gets exactly
+    // blockSize frames, and tells the plugin so through buf-size. worldMutex
+    // is the manager's lock on the world, taken for state save/restore.
+    PluginInstance(const LilvPlugin* plugin, LilvWorld* world, std::mutex* worldMutex, double sampleRate,
+                   uint32_t blockSize, bool fixedBlockLength = false);
     ~PluginInstance();
     
     // Plugin control
@@ -79,9 +92,25 @@ public:
     bool SaveState(std::map<std::string, std::string>& state);
     bool LoadState(const std::map<std::string, std::string>& state);
     
+    // Plugin-internal state through the LV2 state extension, serialized as
+    // Turtle so it can be restored into another instance of the same plugin.
+    // Both return false if the plugin has no state interface, and take the
+    // manager's world lock. Saving may run alongside Process(); restoring
+    // must not.
+    bool SaveLv2State(std::string& state);
+    bool RestoreLv2State(const std::string& state);
+    
     // Plugin info
     const PluginInfo& GetInfo() const { return info_; }
     const LilvPlugin* GetLilvPlugin() const { return plugin_; }
+    double GetSampleRate() const { return sampleRate_; }
+    uint32_t GetBlockSize() const { return blockSize_; }
+    bool HasFixedBlockLength() const { return fixedBlockLength_; }
+    
+    // Ordinal (as in ConnectControlOutput()) of the control output the plugin
+    // reports its latency in frames through, or -1. The value is only valid
+    // once the plugin has run.
+    int32_t GetLatencyOutput() const { return latencyOutput_; }
     
 private:
     void InitializePorts();
@@ -90,11 +119,13 @@ private:
     
     const LilvPlugin* plugin_;
     LilvWorld* world_;
+    std::mutex* worldMutex_;
     LilvInstance* instance_;
     PluginInfo info_;
     
     double sampleRate_;
     uint32_t blockSize_;
+    bool fixedBlockLength_;
     bool isActive_;
     
     // Port information
@@ -102,6 +133,7 @@ private:
     std::vector<uint32_t> audioOutputPorts_;
     std::vector<uint32_t> controlInputPorts_;
     std::vector<uint32_t> controlOutputPorts_;
+    int32_t latencyOutput_;
     std::vector<uint32_t> midiInputPorts_;
     std::vector<uint32_t> midiOutputPorts_;
     
@@ -113,8 +145,22 @@ private:
     std::vector<const LV2_Feature*> features_;
     LV2_URID_Map uridMap_;
     LV2_URID_Unmap uridUnmap_;
+    LV2_Feature uridMapFeature_;
+    LV2_Feature uridUnmapFeature_;
+    
+    // buf-size: block length bounds passed as options, plus the
+    // fixed/power-of-two promises when the host can keep them
+    int32_t minBlockLength_;
+    int32_t maxBlockLength_;
+    int32_t nominalBlockLength_;
+    LV2_Options_Option blockOptions_[4];
+    LV2_Feature optionsFeature_;
+    LV2_Feature boundedBlockFeature_;
+    LV2_Feature fixedBlockFeature_;
+    LV2_Feature powerOf2BlockFeature_;
     
-    // URID mappings
+    // URID mappings. The plugin may map from any of its threads.
+    std::mutex uridMutex_;
     std::map<std::string, LV2_URID> uridMappings_;
     std::map<LV2_URID, std::string> uridReverseMappings_;
     LV2_URID nextUrid_;
@@ -130,11 +176,36 @@ public:
     PluginManager();
     ~PluginManager();
     
-    // Initialization
+    // Initialization. The plugin list comes from the metadata cache at
+    // once; lilv loads the world and parses new or changed bundles on a
+    // background thread, and CreatePlugin() waits for it where it has to.
     bool Initialize();
     void Shutdown();
     
-    // Plugin discovery
+    // Metadata cache file (see plugin_cache.h), "" for none. Set before
+    // Initialize(); defaults to GetDefaultPluginCachePath().
+    void SetCachePath(const std::string& path);
+    const std::string& GetCachePath() const { return cachePath_; }
+    
+    // Lazy mode, set before Initialize(): nothing is scanned at start-up.
+    // CreatePlugin() looks the URI up in the cache and has lilv load just
+    // that bundle; a URI the cache doesn't know loads every bundle. The full
+    // scan waits for StartBackgroundScan().
+    void SetLazyLoading(bool lazy);
+    bool IsLazyLoading() const { return lazyLoading_; }
+    bool HasLoadedAllBundles() const;
+    
+    // Starts the background scan unless it has run; Initialize() does
+    // this unless lazy, a lazy manager once the whole list is wanted
+    void StartBackgroundScan();
+    
+    // Called on the scan thread when the background scan changed the list
+    void SetPluginsChangedCallback(std::function<void()> callback);
+    bool IsScanning() const;
+    void WaitForScan();
+    
+    // Plugin discovery. ScanPlugins() parses every plugin again and
+    // rewrites the cache.
     void ScanPlugins();
     void ScanDirectory(const std::string& directory);
     std::vector<PluginInfo> GetAvailablePlugins() const;
@@ -142,11 +213,15 @@ public:
     std::vector<std::string> GetCategories() const;
     
     // Plugin instantiation
-    std::unique_ptr<PluginInstance> CreatePlugin(const std::string& uri, double sampleRate, uint32_t blockSize);
+    std::unique_ptr<PluginInstance> CreatePlugin(const std::string& uri, double sampleRate, uint32_t blockSize,
+                                                 bool fixedBlockLength = false);
     
     // Plugin information
     PluginInfo GetPluginInfo(const std::string& uri) const;
     bool IsPluginAvailable(const std::string& uri) const;
+    // Control inputs as PluginInstance::GetParameters() would list them,
+    // without instantiating the plugin
+    std::vector<ParameterInfo> GetPluginParameters(const std::string& uri);
     
     // Utility
     std::vector<std::string> GetDefaultScanPaths() const;
@@ -156,16 +231,49 @@ public:
 private:
     void InitializeLilv();
     void ShutdownLilv();
-    PluginInfo ExtractPluginInfo(const LilvPlugin* plugin);
-    std::string GetPluginCategory(const LilvPlugin* plugin);
+    void LoadCachedPlugins();
+    void ScanThreadProc();
+    // These expect worldMutex_ held
+    void LoadWorld();
+    void LoadBundle(const std::string& bundlePath);
+    void MapPlugins();
+    const LilvPlugin* FindPlugin(const std::string& uri);
+    void WaitForWorld();
+    void ScanBundles(bool useCache);
+    void SetPlugins(const std::vector<PluginInfo>& plugins);
+    std::string GetSearchPath() const;
+    PluginInfo ExtractPluginInfo(const LilvPlugin* plugin, std::vector<ParameterInfo>* parameters = nullptr);
+    std::string GetPluginCategory(const PluginInfo& info) const;
     
+    // Once the scan thread runs, lilv is only used under worldMutex_;
+    // instances take it for their state save/restore
+    mutable std::mutex worldMutex_;
     LilvWorld* world_;
     const LilvPlugins* plugins_;
+    std::map<std::string, const LilvPlugin*> pluginMap_;
+    bool lazyLoading_;
+    bool allBundlesLoaded_;
     
+    // The published list, and where parameters come from without lilv
+    mutable std::mutex pluginsMutex_;
     std::vector<PluginInfo> availablePlugins_;
-    std::map<std::string, const LilvPlugin*> pluginMap_;
-    std::vector<std::string> scanPaths_;
     std::vector<std::string> categories_;
+    std::unique_ptr<PluginCache> cache_;
+    std::map<std::string, std::vector<ParameterInfo>> scannedParameters_;
+    
+    std::string cachePath_;
+    std::map<std::string, uint64_t> bundleFingerprints_;   // as Initialize() found them
+    std::function<void()> pluginsChanged_;
+    
+    std::thread scanThread_;
+    mutable std::mutex scanMutex_;
+    std::condition_variable scanCondition_;
+    bool scanStarted_;
+    bool worldLoaded_;
+    bool scanning_;
+    std::atomic<bool> stopScan_;
+    
+    std::vector<std::string> scanPaths_;
     
     bool isInitialized_;
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <semaphore.h>
+#endif
+
+namespace violet {
+
+// Spin-wait hint for busy loops on realtime threads
+void CpuRelax();
+
+// Counting semaphore used to wake realtime workers. Post() never blocks,
+// so it is safe to call from the audio thread.
+class Semaphore {
+public:
+    Semaphore();
+    ~Semaphore();
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    void Post(uint32_t count = 1);
+    void Wait();
+
+private:
+#ifdef _WIN32
+    HANDLE handle_;
+#else
+    sem_t semaphore_;
+#endif
+};
+
+// Work executed by every thread taking part in a parallel region
+class ParallelTask {
+public:
+    virtual ~ParallelTask() = default;
+    virtual void Work() = 0;
+};
+
+// Pool of pre-spawned realtime worker threads for processing graph nodes.
+// RunParallel() wakes the workers, runs the task on the calling thread as
+// well and returns once every thread that joined has left Work(). Workers
+// that wake up after the task is finished skip it, so a slow wakeup never
+// stalls the caller.
+class ProcessingThreadPool {
+public:
+    explicit ProcessingThreadPool(uint32_t workerCount);
+    ~ProcessingThreadPool();
+
+    ProcessingThreadPool(const ProcessingThreadPool&) = delete;
+    ProcessingThreadPool& operator=(const ProcessingThreadPool&) = delete;
+
+    uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+    // Called from the audio thread
+    void RunParallel(ParallelTask* task);
+
+    // One worker per core besides the audio thread
+    static uint32_t GetDefaultWorkerCount();
+
+private:
+    void WorkerThreadProc();
+    static void SetRealtimePriority();
+
+    std::vector<std::thread> workers_;
+    Semaphore wakeSemaphore_;
+    std::atomic<ParallelTask*> task_;
+    std::atomic<bool> taskOpen_;
+    std::atomic<uint32_t> activeWorkers_;
+    std::atomic<bool> shouldStop_;
+
+    static constexpr uint32_t MAX_WORKERS = 31;
+};
+
+} // namespace violet
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+namespace violet {
+
+enum class LogLevel : uint8_t {
+    Info,       // stdout
+    Warning,    // stderr
+    Error       // stderr
+};
+
+// One argument of a log record, kept by value. Strings are kept as
+// pointers, so they have to outlive the record: literals, snd_strerror()
+// and the like.
+struct LogArg {
+    enum class Type : uint8_t { None, Signed, Unsigned, Hex, Float, String };
+
+    Type type = Type::None;
+    union {
+        int64_t i = 0;
+        uint64_t u;
+        double d;
+        const char* s;
+    };
+
+    LogArg() = default;
+
+    template<typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    LogArg(T value) {
+        if (std::is_signed<T>::value) {
+            type = Type::Signed;
+            i = static_cast<int64_t>(value);
+        } else {
+            type = Type::Unsigned;
+            u = static_cast<uint64_t>(value);
+        }
+    }
+
+    LogArg(double value) : type(Type::Float) { d = value; }
+    LogArg(const char* value) : type(Type::String) { s = value; }
+};
+
+// Prints as 0x... (error codes such as HRESULTs)
+inline LogArg LogHex(uint64_t value) {
+    LogArg arg(value);
+    arg.type = LogArg::Type::Hex;
+    return arg;
+}
+
+constexpr uint32_t MAX_LOG_ARGS = 6;
+constexpr uint32_t LOG_RATE_LIMIT = 10;     // lines a second per format string
+
+// No timestamp: reading the clock would cost the caller more than the rest
+// of the call, so lines are timed when the log thread picks them up, at
+// most a drain interval (20 ms) late
+struct LogRecord {
+    const char* format = nullptr;   // a literal, "{}" for each argument
+    LogLevel level = LogLevel::Info;
+    uint32_t argCount = 0;
+    LogArg args[MAX_LOG_ARGS];
+};
+
+// Logging for the audio path. LogRealtime() copies the format pointer and
+// arguments into a fixed-size record on a lock-free queue: a few
+// nanoseconds, never blocking or allocating, from any number of threads.
+// The log thread formats and writes the records; each format string gets
+// at most LOG_RATE_LIMIT lines a second. Records that find the queue full
+// are counted and dropped, and so are records logged before
+// StartLogThread(), without being counted.
+void PushLogRecord(LogLevel level, const char* format, const LogArg* args, uint32_t argCount);
+
+template<typename... Args>
+void LogRealtime(LogLevel level, const char* format, const Args&... args) {
+    static_assert(sizeof...(Args) <= MAX_LOG_ARGS, "too many log arguments");
+    const LogArg packed[] = { LogArg(args)..., LogArg() };
+    PushLogRecord(level, format, packed, sizeof...(Args));
+}
+
+// Starts the log thread, once per process; the engine and the chain call
+// it. Whatever is still queued at exit is written out.
+void StartLogThread();
+
+// Writes out everything queued so far, from the calling thread
+void FlushLog();
+
+// Where lines go instead of stdout/stderr; an empty sink restores them.
+// Called on the log thread.
+using LogSink = std::function<void(LogLevel level, const std::string& line)>;
+void SetLogSink(LogSink sink);
+
+// Also appends every line, with the time since start-up, to a file; ""
+// stops. Returns false when the file can't be opened.
+bool SetLogFile(const std::string& path);
+
+struct LogStats {
+    uint64_t written = 0;
+    uint64_t dropped = 0;       // the queue was full
+    uint64_t suppressed = 0;    // over the rate limit
+};
+
+LogStats GetLogStats();
+
+// A record as the log thread writes it, without the newline
+std::string FormatLogRecord(const LogRecord& record);
+
+} // namespace violet
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace violet {
+
+// Setup shared by every thread that runs DSP: the backends' audio threads
+// and the chain's worker pool.
+//
+// Denormal (subnormal) floats take a slow path in the FPU that can cost
+// 10-100x per operation; reverb and filter tails decaying towards silence
+// produce them by the million. Flush-to-zero and denormals-are-zero make
+// the FPU treat them as 0 instead. Both are per-thread FPU state, so each
+// audio thread has to set them itself.
+
+// Process-wide choice for threads prepared from now on (on by default).
+// Turned off to find the plugins that produce denormals, see
+// AudioProcessingChain::SetDenormalCheck().
+void SetDenormalFlushEnabled(bool enabled);
+bool IsDenormalFlushEnabled();
+
+// Sets FTZ/DAZ (x86) or FZ (ARM) on the calling thread. Returns false on
+// CPUs without either.
+bool EnableDenormalFlush();
+
+// Flushes denormals on the calling thread for a scope (unless `enabled` is
+// false) and restores the previous FPU mode after, for DSP run on a thread
+// the caller owns
+class ScopedDenormalFlush {
+public:
+    explicit ScopedDenormalFlush(bool enabled = true);
+    ~ScopedDenormalFlush();
+
+    ScopedDenormalFlush(const ScopedDenormalFlush&) = delete;
+    ScopedDenormalFlush& operator=(const ScopedDenormalFlush&) = delete;
+
+private:
+    uint64_t savedMode_;
+};
+
+// Touches `bytes` of stack below the caller so the first deep callback
+// doesn't page fault
+constexpr size_t DEFAULT_STACK_PREFAULT = 128 * 1024;
+void PrefaultStack(size_t bytes = DEFAULT_STACK_PREFAULT);
+
+// Denormal flush (unless disabled), stack prefault and the realtime tag,
+// once at the top of an audio or DSP worker thread
+void PrepareRealtimeThread();
+
+// Whether the calling thread runs the audio path and so must not allocate
+// or block; the debug allocation trap checks this (see alloc_trap.h).
+// PrepareRealtimeThread() tags a thread for the rest of its life;
+// ScopedRealtimeTag tags a scope on a thread the caller owns, such as the
+// offline renderer's.
+bool IsRealtimeThread();
+
+class ScopedRealtimeTag {
+public:
+    ScopedRealtimeTag();
+    ~ScopedRealtimeTag();
+
+    ScopedRealtimeTag(const ScopedRealtimeTag&) = delete;
+    ScopedRealtimeTag& operator=(const ScopedRealtimeTag&) = delete;
+
+private:
+    bool previous_;
+};
+
+// Locks the process's current and future pages in RAM (mlockall) so the
+// audio thread never waits on a page-in. Needs CAP_IPC_LOCK or a large
+// enough memlock limit; not available on Windows.
+bool LockProcessMemory(std::string& error);
+
+// Subnormal samples in a buffer, for the chain's denormal diagnostics
+uint32_t CountSubnormals(const float* samples, uint32_t count);
+
+} // namespace violet
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace violet {
+
+// Filter length against CPU. Every preset puts the stopband edge at the
+// lower rate's Nyquist frequency; more taps buy a narrower transition band
+// and a deeper stopband.
+enum class ResamplerQuality {
+    Fast,           // 16 taps, ~55 dB
+    Balanced,       // 32 taps, ~75 dB
+    High,           // 64 taps, ~95 dB
+    Best,           // 128 taps, ~115 dB
+};
+
+const char* GetResamplerQualityName(ResamplerQuality quality);
+bool ParseResamplerQuality(const std::string& name, ResamplerQuality& quality);
+
+// Windowed-sinc polyphase bank for one rate pair, reduced to upFactor /
+// downFactor. Immutable once built and shared by every Resampler with the
+// same ratio and quality.
+struct ResamplerFilter {
+    uint32_t upFactor = 1;          // phases
+    uint32_t downFactor = 1;
+    uint32_t taps = 0;              // per phase, a multiple of 8
+    double cutoff = 0.0;            // passband edge, fraction of the lower rate
+    std::vector<float> coefficients;    // phase-major, each phase time-reversed
+};
+
+// Builds the bank for a rate pair on first use and hands out the cached
+// copy after that. Returns null for rates without a small enough common
+// ratio (more than 4096 phases).
+std::shared_ptr<const ResamplerFilter> GetResamplerFilter(uint32_t inputRate, uint32_t outputRate,
+                                                          ResamplerQuality quality);
+
+// Streaming rate converter for planar audio. Every input frame is consumed;
+// the number of output frames per call follows the ratio and varies by one
+// from call to call. Equal rates pass straight through. The dot products use
+// the SIMD level the PCM converters run at (see pcm::GetSimdLevel()).
+//
+// Configure() allocates; Process() and Reset() don't and are safe on the
+// audio thread.
+class Resampler {
+public:
+    Resampler();
+
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    bool Configure(uint32_t channels, uint32_t inputRate, uint32_t outputRate,
+                   ResamplerQuality quality, uint32_t maxInputFrames);
+
+    // Forgets the filter history
+    void Reset();
+
+    // Converts `frames` input frames (at most the configured maximum) and
+    // returns how many output frames were written
+    uint32_t Process(const float* const* inputs, uint32_t frames, float* const* outputs);
+
+    // Most output frames Process() can return for `frames` input frames
+    uint32_t GetMaxOutputFrames(uint32_t frames) const;
+
+    // Group delay in output frames
+    double GetLatency() const;
+
+    bool IsPassthrough() const { return !filter_; }
+    uint32_t GetInputRate() const { return inputRate_; }
+    uint32_t GetOutputRate() const { return outputRate_; }
+
+private:
+    uint32_t channels_;
+    uint32_t inputRate_;
+    uint32_t outputRate_;
+    uint32_t maxInputFrames_;
+    std::shared_ptr<const ResamplerFilter> filter_;
+
+    // Per channel, the last taps - 1 input frames
+    std::vector<float> history_;
+    std::vector<float> work_;           // history + input, one channel
+
+    // Next output's window start in work_ coordinates, and its phase
+    uint32_t index_;
+    uint32_t phase_;
+    std::vector<uint32_t> starts_;
+    std::vector<uint32_t> phases_;
+};
+
+} // namespace violet
@@ -25,9 +25,15 @@ struct SessionData {
         uint32_t position;
         bool bypassed;
         std::map<uint32_t, float> parameters;  // paramIndex -> value
+        std::vector<uint32_t> inputs;          // source node ids, 0 = chain input
+        std::map<uint32_t, std::vector<std::pair<uint64_t, float>>> automation;  // paramIndex -> (frame, value)
     };
     
-    std::vector<PluginNode> plugins;
+    std::vector<PluginNode> plugins;           // an empty URI is a sum node
+    
+    // Graph topology, only stored when the chain isn't a plain series chain
+    bool linearGraph = true;
+    std::vector<uint32_t> outputs;             // node ids summed into the chain output
     
     struct AudioSettings {
         uint32_t sampleRate;
@@ -36,6 +42,10 @@ struct SessionData {
     };
     
     AudioSettings audioSettings;
+    
+    // Rate the automation frames were written at; automation is rescaled
+    // when audioSettings is changed before applying. 0 = audioSettings'.
+    uint32_t automationSampleRate = 0;
 };
 
 // Session manager for save/load functionality
@@ -61,12 +71,20 @@ public:
     std::vector<std::string> GetRecentSessions() const;
     void AddRecentSession(const std::string& filePath);
     
+    // Lower-level load steps, for tools that adjust the session before
+    // applying it (e.g. rendering at a different format)
+    bool DeserializeSession(const std::string& filePath, SessionData& data);
+    bool ApplySessionToChain(const SessionData& data, AudioProcessingChain* chain, PluginManager* pluginManager);
+    
+    // URIs of the session's plugins that failed to load on the last apply.
+    // Each one is stood in for by a pass-through node, so its connections
+    // survive, and is written back as it was when the session is saved.
+    std::vector<std::string> GetMissingPlugins() const;
+    
 private:
     bool SerializeSession(const SessionData& data, const std::string& filePath);
-    bool DeserializeSession(const std::string& filePath, SessionData& data);
     
     SessionData CreateSessionFromChain(AudioProcessingChain* chain);
-    bool ApplySessionToChain(const SessionData& data, AudioProcessingChain* chain, PluginManager* pluginManager);
     
     void SaveRecentSessions();
     void LoadRecentSessions();
@@ -74,6 +92,7 @@ private:
     std::string currentSessionPath_;
     bool hasUnsavedChanges_;
     std::vector<std::string> recentSessions_;
+    std::map<uint32_t, SessionData::PluginNode> missingPlugins_;  // stand-in node id -> saved plugin
     
     static const int MAX_RECENT_SESSIONS = 10;
     static const char* SESSION_VERSION;
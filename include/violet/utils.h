@@ -20,6 +20,7 @@ std::string GetExecutableDirectory();
 std::string JoinPath(const std::string& path1, const std::string& path2);
 bool FileExists(const std::string& path);
 bool DirectoryExists(const std::string& path);
+bool MakeDirectory(const std::string& path);   // true if it exists afterwards
 
 // Windows utilities
 std::wstring StringToWString(const std::string& str);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <audiopolicy.h>
+#include <endpointvolume.h>
+#include <functiondiscoverykeys_devpkey.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include "violet/audio_backend.h"
+#include "violet/drift_compensator.h"
+#include "violet/pcm_convert.h"
+#include "violet/resampler.h"
+
+namespace violet {
+
+// Shared-mode WASAPI, event driven with a polling fallback
+class WasapiBackend : public AudioBackend {
+public:
+    WasapiBackend();
+    ~WasapiBackend() override;
+
+    const char* GetName() const override { return "wasapi"; }
+    bool Initialize() override;
+
+    std::vector<AudioDevice> EnumerateDevices() override;
+
+    bool Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+              const AudioFormat& requested, AudioFormat& actual) override;
+    void Close() override;
+    std::string GetOpenInputDevice() const override;
+    std::string GetOpenOutputDevice() const override;
+    uint32_t GetMaxFrames() const override { return maxFrames_; }
+
+    bool Start(AudioProcessCallback callback) override;
+    void Stop() override;
+
+    double GetLatency() const override;
+    bool SetMasterVolume(float volume) override; // 0.0 to 1.0
+    float GetMasterVolume() const override;
+    bool SetMuted(bool muted) override;
+    bool IsMuted() const override;
+    void SetOutputDither(bool enabled) override { ditherEnabled_ = enabled; }
+    DriftStatus GetDriftStatus() const override {
+        return captureFrames_ > 0 ? driftCompensator_.GetStatus() : DriftStatus();
+    }
+
+private:
+    bool InitializeWASAPI();
+    void ShutdownWASAPI();
+    void ReleaseClients();
+    bool CreateAudioClient(bool isInput, AudioFormat* actualFormat = nullptr);
+    void AudioThreadProc();
+    void DrainCapture();
+    static double GetQpcSeconds();
+
+    // Device helpers
+    bool SelectDevice(const std::string& deviceId, bool isInput);
+    std::string GetDeviceName(IMMDevice* device);
+    std::string GetDeviceId(IMMDevice* device);
+
+    // Format helpers
+    bool SetupFormat(IAudioClient* client, const AudioFormat& format);
+    WAVEFORMATEX* CreateWaveFormat(const AudioFormat& format);
+
+    // COM interfaces
+    IMMDeviceEnumerator* deviceEnumerator_;
+    IMMDevice* inputDevice_;
+    IMMDevice* outputDevice_;
+    IAudioClient* inputClient_;
+    IAudioClient* outputClient_;
+    IAudioRenderClient* renderClient_;
+    IAudioCaptureClient* captureClient_;
+    ISimpleAudioVolume* volumeControl_;
+
+    // Audio thread management
+    std::thread audioThread_;
+    std::atomic<bool> shouldStop_;
+    HANDLE audioEvent_;
+    bool inputEventCallbackMode_;
+    bool outputEventCallbackMode_;
+    AudioProcessCallback callback_;
+
+    // Configuration
+    AudioFormat requestedFormat_;
+    AudioFormat actualInputFormat_;    // Actual input device format
+    AudioFormat actualOutputFormat_;   // Actual output device format
+    std::string currentInputDeviceId_;
+    std::string currentOutputDeviceId_;
+
+    // Device sample layouts, converted to and from the planar buffers
+    PcmFormat inputPcmFormat_;
+    PcmFormat outputPcmFormat_;
+    bool ditherEnabled_;
+    pcm::Dither outputDither_;
+
+    // Planar buffers handed to the callback, sized for the device buffer
+    uint32_t maxFrames_;
+    std::vector<float> inputBuffer_;
+    std::vector<float> outputBuffer_;
+    std::vector<float*> inputPtrs_;
+    std::vector<float*> outputPtrs_;
+
+    // Capture packets in planar form on their way into the drift FIFO,
+    // converted to the output rate first if the input runs at another one
+    uint32_t captureChannels_;
+    uint32_t captureFrames_;
+    std::vector<float> captureBuffer_;
+    std::vector<float*> capturePtrs_;
+    std::vector<float*> resampledPtrs_;
+    Resampler captureResampler_;
+    DriftCompensator driftCompensator_;
+    bool captureStarted_;   // audio thread only; a packet arrived since Start()
+
+    mutable std::mutex deviceMutex_;
+};
+
+} // namespace violet
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace violet {
+
+// Planar float audio loaded from or written to a WAV file
+struct AudioFileData {
+    uint32_t sampleRate = 0;
+    std::vector<std::vector<float>> channels;   // one vector per channel
+
+    uint32_t GetChannelCount() const { return static_cast<uint32_t>(channels.size()); }
+    uint64_t GetFrameCount() const { return channels.empty() ? 0 : channels[0].size(); }
+    void Resize(uint32_t channelCount, uint64_t frames);
+};
+
+// Minimal RIFF/WAVE reader and writer for offline rendering. Reads 8, 16, 24
+// and 32-bit integer PCM and 32/64-bit float, including WAVE_FORMAT_EXTENSIBLE
+// files. Writes 16 or 24-bit PCM or 32-bit float.
+class WavFile {
+public:
+    enum class SampleFormat {
+        Int16,
+        Int24,
+        Float32
+    };
+
+    static bool Read(const std::string& filePath, AudioFileData& data, std::string& error);
+    static bool Write(const std::string& filePath, const AudioFileData& data,
+                      SampleFormat format, std::string& error);
+};
+
+} // namespace violet
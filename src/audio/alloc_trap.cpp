@@ -0,0 +1,184 @@
+#include "violet/alloc_trap.h"
+#include "violet/realtime_thread.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// glibc lets a program replace malloc, which also catches operator new
+// (libstdc++ builds it on malloc) and C allocations in plugins. Elsewhere
+// only operator new is replaced.
+#if defined(VIOLET_ALLOC_TRAP) && defined(__GLIBC__)
+#define VIOLET_TRAP_MALLOC 1
+#endif
+
+namespace violet {
+
+namespace {
+
+AllocTrapMode InitialMode() {
+    const char* mode = std::getenv("VIOLET_ALLOC_TRAP");
+    if (mode && strcmp(mode, "off") == 0) {
+        return AllocTrapMode::Off;
+    }
+    if (mode && strcmp(mode, "abort") == 0) {
+        return AllocTrapMode::Abort;
+    }
+    return AllocTrapMode::Count;
+}
+
+// Zero (Off) until initialized, so allocations during static
+// initialization are never trapped
+std::atomic<AllocTrapMode> trapMode(InitialMode());
+std::atomic<uint64_t> allocationCount(0);
+thread_local uint32_t allowedDepth = 0;
+thread_local bool reporting = false;
+
+} // namespace
+
+#ifdef VIOLET_ALLOC_TRAP
+void CheckAllocation(size_t bytes) {
+    if (!IsRealtimeThread() || allowedDepth > 0 || reporting) {
+        return;
+    }
+    AllocTrapMode mode = trapMode.load(std::memory_order_relaxed);
+    if (mode == AllocTrapMode::Off) {
+        return;
+    }
+
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (mode == AllocTrapMode::Abort) {
+        reporting = true;
+        fprintf(stderr, "violet: %zu byte allocation on a realtime thread\n", bytes);
+        std::abort();
+    }
+}
+#endif
+
+bool IsAllocTrapBuiltIn() {
+#ifdef VIOLET_ALLOC_TRAP
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SetAllocTrapMode(AllocTrapMode mode) {
+    trapMode.store(mode);
+}
+
+AllocTrapMode GetAllocTrapMode() {
+    return trapMode.load();
+}
+
+uint64_t GetRealtimeAllocationCount() {
+    return allocationCount.load();
+}
+
+void ResetRealtimeAllocationCount() {
+    allocationCount.store(0);
+}
+
+ScopedAllocationAllowed::ScopedAllocationAllowed() {
+    ++allowedDepth;
+}
+
+ScopedAllocationAllowed::~ScopedAllocationAllowed() {
+    --allowedDepth;
+}
+
+} // namespace violet
+
+#if defined(VIOLET_TRAP_MALLOC)
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+
+// A program that replaces malloc has to replace free, calloc and realloc
+// too; the aligned variants are what C++17 aligned new uses
+void* malloc(size_t size) __THROW {
+    violet::CheckAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW {
+    violet::CheckAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) __THROW {
+    violet::CheckAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) __THROW {
+    violet::CheckAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size) __THROW {
+    violet::CheckAllocation(size);
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* result = __libc_memalign(alignment, size);
+    if (!result) {
+        return ENOMEM;
+    }
+    *pointer = result;
+    return 0;
+}
+
+void free(void* pointer) __THROW {
+    __libc_free(pointer);
+}
+
+} // extern "C"
+
+#elif defined(VIOLET_ALLOC_TRAP)
+
+void* operator new(std::size_t size) {
+    violet::CheckAllocation(size);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    violet::CheckAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+#endif
@@ -0,0 +1,490 @@
+#include "violet/alsa_backend.h"
+#include "violet/alloc_trap.h"
+#include "violet/pcm_convert.h"
+#include "violet/realtime_log.h"
+#include "violet/realtime_thread.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace violet {
+
+namespace {
+
+// Sample formats to try, best first; raw hw: devices often take only integers
+struct AlsaFormat {
+    snd_pcm_format_t alsa;
+    PcmFormat pcm;
+};
+
+const AlsaFormat DEVICE_FORMATS[] = {
+    { SND_PCM_FORMAT_FLOAT_LE, PcmFormat::Float32 },
+    { SND_PCM_FORMAT_S32_LE, PcmFormat::Int32 },
+    { SND_PCM_FORMAT_S24_3LE, PcmFormat::Int24 },
+    { SND_PCM_FORMAT_S16_LE, PcmFormat::Int16 },
+};
+
+} // namespace
+
+AlsaBackend::AlsaBackend()
+    : linked_(false)
+    , sampleRate_(0)
+    , channels_(0)
+    , periodFrames_(0)
+    , ditherEnabled_(false)
+    , shouldStop_(false) {
+    capture_.capture = true;
+}
+
+AlsaBackend::~AlsaBackend() {
+    Close();
+}
+
+std::vector<AudioDevice> AlsaBackend::EnumerateDevices() {
+    std::vector<AudioDevice> devices;
+    
+    void** hints = nullptr;
+    if (snd_device_name_hint(-1, "pcm", &hints) < 0) {
+        return devices;
+    }
+    
+    for (void** hint = hints; *hint; ++hint) {
+        char* name = snd_device_name_get_hint(*hint, "NAME");
+        char* description = snd_device_name_get_hint(*hint, "DESC");
+        char* direction = snd_device_name_get_hint(*hint, "IOID"); // null means both
+        
+        if (name && strcmp(name, "null") != 0) {
+            AudioDevice device;
+            device.id = name;
+            device.name = description ? description : name;
+            std::replace(device.name.begin(), device.name.end(), '\n', ' ');
+            device.isDefault = device.id == "default";
+            device.isInput = !direction || strcmp(direction, "Input") == 0;
+            device.isOutput = !direction || strcmp(direction, "Output") == 0;
+            devices.push_back(device);
+        }
+        
+        free(name);
+        free(description);
+        free(direction);
+    }
+    
+    snd_device_name_free_hint(hints);
+    return devices;
+}
+
+bool AlsaBackend::OpenStream(Stream& stream, const std::string& deviceId, uint32_t& sampleRate,
+                             uint32_t channels, snd_pcm_uframes_t periodFrames) {
+    const char* kind = stream.capture ? "capture" : "playback";
+    int err = snd_pcm_open(&stream.pcm, deviceId.c_str(),
+                           stream.capture ? SND_PCM_STREAM_CAPTURE : SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) {
+        std::cerr << "Failed to open ALSA " << kind << " device '" << deviceId << "': " << snd_strerror(err) << std::endl;
+        stream.pcm = nullptr;
+        return false;
+    }
+    
+    snd_pcm_hw_params_t* hwParams;
+    snd_pcm_hw_params_alloca(&hwParams);
+    snd_pcm_hw_params_any(stream.pcm, hwParams);
+    
+    // mmap lets the callback's buffers go straight into the device ring
+    stream.mmap = snd_pcm_hw_params_set_access(stream.pcm, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0 ||
+                  snd_pcm_hw_params_set_access(stream.pcm, hwParams, SND_PCM_ACCESS_MMAP_NONINTERLEAVED) == 0;
+    if (!stream.mmap) {
+        err = snd_pcm_hw_params_set_access(stream.pcm, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+        if (err < 0) {
+            std::cerr << "ALSA " << kind << " device supports neither mmap nor interleaved access" << std::endl;
+            CloseStream(stream);
+            return false;
+        }
+        std::cout << "ALSA " << kind << " device has no mmap access, using read/write" << std::endl;
+    }
+    
+    err = -EINVAL;
+    for (const AlsaFormat& format : DEVICE_FORMATS) {
+        if (snd_pcm_hw_params_test_format(stream.pcm, hwParams, format.alsa) == 0) {
+            err = snd_pcm_hw_params_set_format(stream.pcm, hwParams, format.alsa);
+            if (err == 0) {
+                stream.format = format.pcm;
+                break;
+            }
+        }
+    }
+    if (err < 0) {
+        std::cerr << "ALSA " << kind << " device takes none of float, S32, S24_3 or S16, try a plughw: device" << std::endl;
+        CloseStream(stream);
+        return false;
+    }
+    
+    unsigned int deviceChannels = channels;
+    unsigned int rate = sampleRate;
+    unsigned int periods = PERIODS;
+    int dir = 0;
+    if (snd_pcm_hw_params_set_channels_near(stream.pcm, hwParams, &deviceChannels) < 0 ||
+        snd_pcm_hw_params_set_rate_near(stream.pcm, hwParams, &rate, &dir) < 0 ||
+        snd_pcm_hw_params_set_period_size_near(stream.pcm, hwParams, &periodFrames, &dir) < 0 ||
+        snd_pcm_hw_params_set_periods_near(stream.pcm, hwParams, &periods, &dir) < 0) {
+        std::cerr << "ALSA " << kind << " device rejected the stream configuration" << std::endl;
+        CloseStream(stream);
+        return false;
+    }
+    
+    err = snd_pcm_hw_params(stream.pcm, hwParams);
+    if (err < 0) {
+        std::cerr << "Failed to configure ALSA " << kind << " device: " << snd_strerror(err) << std::endl;
+        CloseStream(stream);
+        return false;
+    }
+    snd_pcm_hw_params_get_period_size(hwParams, &stream.periodFrames, &dir);
+    snd_pcm_hw_params_get_buffer_size(hwParams, &stream.bufferFrames);
+    stream.channels = deviceChannels;
+    sampleRate = rate;
+    
+    // Started explicitly once playback is primed, woken once per period
+    snd_pcm_sw_params_t* swParams;
+    snd_pcm_sw_params_alloca(&swParams);
+    snd_pcm_sw_params_current(stream.pcm, swParams);
+    snd_pcm_uframes_t boundary = 0;
+    snd_pcm_sw_params_get_boundary(swParams, &boundary);
+    snd_pcm_sw_params_set_start_threshold(stream.pcm, swParams, boundary);
+    snd_pcm_sw_params_set_avail_min(stream.pcm, swParams, stream.periodFrames);
+    err = snd_pcm_sw_params(stream.pcm, swParams);
+    if (err < 0) {
+        std::cerr << "Failed to set ALSA " << kind << " software parameters: " << snd_strerror(err) << std::endl;
+        CloseStream(stream);
+        return false;
+    }
+    
+    if (!stream.mmap) {
+        stream.interleaved.assign(static_cast<size_t>(stream.periodFrames) * stream.channels *
+                                  pcm::GetSampleBytes(stream.format), 0);
+    }
+    
+    std::cout << "ALSA " << kind << " '" << deviceId << "': " << rate << " Hz, " << stream.channels << " ch, "
+              << pcm::GetFormatName(stream.format) << ", "
+              << stream.periodFrames << " x " << (stream.bufferFrames / std::max<snd_pcm_uframes_t>(stream.periodFrames, 1))
+              << " frame periods" << (stream.mmap ? " (mmap)" : "") << std::endl;
+    return true;
+}
+
+void AlsaBackend::CloseStream(Stream& stream) {
+    if (stream.pcm) {
+        snd_pcm_close(stream.pcm);
+        stream.pcm = nullptr;
+    }
+    stream.interleaved.clear();
+    stream.format = PcmFormat::Float32;
+    stream.channels = 0;
+}
+
+bool AlsaBackend::Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+                       const AudioFormat& requested, AudioFormat& actual) {
+    Close();
+    
+    outputDeviceId_ = outputDeviceId.empty() ? "default" : outputDeviceId;
+    inputDeviceId_ = inputDeviceId.empty() ? "default" : inputDeviceId;
+    
+    uint32_t sampleRate = requested.sampleRate;
+    if (!OpenStream(playback_, outputDeviceId_, sampleRate, requested.channels, requested.bufferSize)) {
+        return false;
+    }
+    sampleRate_ = sampleRate;
+    channels_ = playback_.channels;
+    periodFrames_ = static_cast<uint32_t>(playback_.periodFrames);
+    
+    // Capture has to run in lockstep with playback, there is no resampler here
+    uint32_t captureRate = sampleRate_;
+    if (OpenStream(capture_, inputDeviceId_, captureRate, channels_, playback_.periodFrames)) {
+        if (captureRate != sampleRate_ || capture_.periodFrames != playback_.periodFrames) {
+            std::cerr << "Warning: capture runs at " << captureRate << " Hz / " << capture_.periodFrames
+                      << " frames, playback at " << sampleRate_ << " Hz / " << periodFrames_
+                      << "; continuing without audio input" << std::endl;
+            CloseStream(capture_);
+        } else {
+            linked_ = snd_pcm_link(capture_.pcm, playback_.pcm) == 0;
+        }
+    } else {
+        std::cerr << "Warning: continuing without audio input" << std::endl;
+    }
+    
+    size_t bufferSize = static_cast<size_t>(periodFrames_) * channels_;
+    inputBuffer_.assign(bufferSize, 0.0f);
+    outputBuffer_.assign(bufferSize, 0.0f);
+    inputPtrs_.resize(channels_);
+    outputPtrs_.resize(channels_);
+    windowPtrs_.resize(channels_);
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+        inputPtrs_[ch] = inputBuffer_.data() + static_cast<size_t>(ch) * periodFrames_;
+        outputPtrs_[ch] = outputBuffer_.data() + static_cast<size_t>(ch) * periodFrames_;
+    }
+    
+    actual.sampleRate = sampleRate_;
+    actual.channels = channels_;
+    actual.bitsPerSample = pcm::GetSampleBytes(playback_.format) * 8;
+    actual.bufferSize = periodFrames_;
+    
+    outputDither_ = pcm::Dither();
+    outputDither_.SetEnabled(ditherEnabled_);
+    return true;
+}
+
+void AlsaBackend::Close() {
+    Stop();
+    
+    if (linked_) {
+        snd_pcm_unlink(capture_.pcm);
+        linked_ = false;
+    }
+    CloseStream(capture_);
+    CloseStream(playback_);
+    periodFrames_ = 0;
+}
+
+bool AlsaBackend::Start(AudioProcessCallback callback) {
+    if (!playback_.pcm || audioThread_.joinable()) {
+        return false;
+    }
+    
+    callback_ = std::move(callback);
+    shouldStop_.store(false);
+    audioThread_ = std::thread(&AlsaBackend::AudioThreadProc, this);
+    return true;
+}
+
+void AlsaBackend::Stop() {
+    if (!audioThread_.joinable()) {
+        return;
+    }
+    
+    // snd_pcm_wait() times out, so the thread notices within a second
+    shouldStop_.store(true);
+    audioThread_.join();
+}
+
+double AlsaBackend::GetLatency() const {
+    // Playback runs a full buffer ahead of the callback
+    return sampleRate_ ? playback_.bufferFrames * 1000.0 / sampleRate_ : 0.0;
+}
+
+int AlsaBackend::Transfer(Stream& stream, float** buffers, uint32_t channels, uint32_t frames) {
+    uint32_t shared = std::min(channels, stream.channels);
+    uint32_t sampleBytes = pcm::GetSampleBytes(stream.format);
+    pcm::Dither* dither = stream.capture ? nullptr : &outputDither_;
+    
+    if (!stream.mmap) {
+        uint8_t* interleaved = stream.interleaved.data();
+        uint32_t stride = stream.channels;
+        size_t frameBytes = static_cast<size_t>(stride) * sampleBytes;
+        if (!stream.capture) {
+            pcm::Encode(buffers, shared, interleaved, stream.format, stride, frames, dither);
+        }
+        for (uint32_t done = 0; done < frames;) {
+            snd_pcm_sframes_t count = stream.capture
+                ? snd_pcm_readi(stream.pcm, interleaved + done * frameBytes, frames - done)
+                : snd_pcm_writei(stream.pcm, interleaved + done * frameBytes, frames - done);
+            if (count < 0) {
+                return static_cast<int>(count);
+            }
+            done += static_cast<uint32_t>(count);
+        }
+        if (stream.capture) {
+            pcm::Decode(interleaved, stream.format, stride, buffers, shared, frames);
+        }
+    } else {
+        uint32_t sampleBits = sampleBytes * 8;
+        
+        // The ring may wrap, so one period can take two mmap windows
+        for (uint32_t done = 0; done < frames;) {
+            const snd_pcm_channel_area_t* areas = nullptr;
+            snd_pcm_uframes_t offset = 0;
+            snd_pcm_uframes_t count = frames - done;
+            int err = snd_pcm_mmap_begin(stream.pcm, &areas, &offset, &count);
+            if (err < 0) {
+                return err;
+            }
+            
+            float** windows = nullptr;
+            if (buffers) {
+                for (uint32_t ch = 0; ch < shared; ++ch) {
+                    windowPtrs_[ch] = buffers[ch] + done;
+                }
+                windows = windowPtrs_.data();
+            }
+            
+            // Interleaved rings convert all channels in one pass, any other
+            // layout a channel at a time
+            bool interleaved = true;
+            for (uint32_t ch = 0; ch < stream.channels; ++ch) {
+                interleaved = interleaved && areas[ch].addr == areas[0].addr && areas[ch].first == ch * sampleBits &&
+                              areas[ch].step == stream.channels * sampleBits;
+            }
+            if (interleaved) {
+                uint8_t* samples = static_cast<uint8_t*>(areas[0].addr) + offset * stream.channels * sampleBytes;
+                if (stream.capture) {
+                    pcm::Decode(samples, stream.format, stream.channels, windows, shared, count);
+                } else {
+                    pcm::Encode(windows, shared, samples, stream.format, stream.channels, count, dither);
+                }
+            } else {
+                for (uint32_t ch = 0; ch < stream.channels; ++ch) {
+                    if (stream.capture && ch >= shared) {
+                        continue;
+                    }
+                    // first and step are in bits
+                    uint8_t* samples = static_cast<uint8_t*>(areas[ch].addr) + areas[ch].first / 8;
+                    size_t stepBytes = areas[ch].step / 8;
+                    samples += offset * stepBytes;
+                    float* channel = windows && ch < shared ? windows[ch] : nullptr;
+                    
+                    // A contiguous channel converts in one call, a strided
+                    // one sample by sample so its neighbours stay untouched
+                    uint32_t run = stepBytes == sampleBytes ? static_cast<uint32_t>(count) : 1;
+                    for (snd_pcm_uframes_t i = 0; i < count; i += run) {
+                        float* window = channel ? channel + i : nullptr;
+                        if (stream.capture) {
+                            pcm::Decode(samples + i * stepBytes, stream.format, 1, &window, 1, run);
+                        } else {
+                            pcm::Encode(window ? &window : nullptr, 1, samples + i * stepBytes, stream.format, 1, run,
+                                        dither);
+                        }
+                    }
+                }
+            }
+            
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(stream.pcm, offset, count);
+            if (committed < 0) {
+                return static_cast<int>(committed);
+            }
+            if (static_cast<snd_pcm_uframes_t>(committed) != count) {
+                return -EPIPE;
+            }
+            done += static_cast<uint32_t>(count);
+        }
+    }
+    
+    // Device channels the stream lacks read as silence
+    if (stream.capture) {
+        for (uint32_t ch = shared; ch < channels; ++ch) {
+            memset(buffers[ch], 0, frames * sizeof(float));
+        }
+    }
+    return 0;
+}
+
+bool AlsaBackend::StartStreams() {
+    // Restarting is a dropout anyway; alsa-lib may allocate in here
+    ScopedAllocationAllowed allowed;
+    for (Stream* stream : { &playback_, &capture_ }) {
+        if (stream->pcm && snd_pcm_state(stream->pcm) != SND_PCM_STATE_PREPARED) {
+            int err = snd_pcm_prepare(stream->pcm);
+            if (err < 0) {
+                LogRealtime(LogLevel::Error, "Failed to prepare ALSA stream: {}", snd_strerror(err));
+                return false;
+            }
+        }
+    }
+    
+    // Prime playback with a full buffer of silence; that is the output latency
+    uint32_t primeFrames = static_cast<uint32_t>(playback_.bufferFrames);
+    for (uint32_t done = 0; done < primeFrames; done += periodFrames_) {
+        if (Transfer(playback_, nullptr, channels_, std::min(periodFrames_, primeFrames - done)) < 0) {
+            return false;
+        }
+    }
+    
+    // Starting playback starts a linked capture stream too
+    int err = snd_pcm_start(playback_.pcm);
+    if (err >= 0 && capture_.pcm && !linked_) {
+        err = snd_pcm_start(capture_.pcm);
+    }
+    if (err < 0) {
+        LogRealtime(LogLevel::Error, "Failed to start ALSA streams: {}", snd_strerror(err));
+        return false;
+    }
+    return true;
+}
+
+bool AlsaBackend::RecoverStreams(int error, GlitchType xrun) {
+    ScopedAllocationAllowed allowed;
+    if (error == -EPIPE) {
+        ReportXrun(xrun, periodFrames_);
+        LogRealtime(LogLevel::Warning, "ALSA xrun, restarting streams");
+    } else if (error == -ESTRPIPE) {
+        LogRealtime(LogLevel::Warning, "ALSA stream suspended, resuming");
+    } else {
+        LogRealtime(LogLevel::Error, "ALSA stream error: {}", snd_strerror(error));
+    }
+    
+    // Both sides restart together so capture stays aligned with playback
+    snd_pcm_drop(playback_.pcm);
+    if (capture_.pcm && !linked_) {
+        snd_pcm_drop(capture_.pcm);
+    }
+    return StartStreams();
+}
+
+void AlsaBackend::AudioThreadProc() {
+    PrepareRealtimeThread();
+    if (!StartStreams()) {
+        return;
+    }
+    
+    while (!shouldStop_.load()) {
+        int err = snd_pcm_wait(playback_.pcm, WAIT_TIMEOUT_MS);
+        if (err == 0) {
+            continue; // timed out
+        }
+        
+        snd_pcm_sframes_t available = err < 0 ? err : snd_pcm_avail_update(playback_.pcm);
+        if (available < 0) {
+            if (!RecoverStreams(static_cast<int>(available), GlitchType::RenderUnderrun)) {
+                break;
+            }
+            continue;
+        }
+        if (static_cast<uint32_t>(available) < periodFrames_) {
+            continue;
+        }
+        
+        // Linked capture delivers a period alongside each playback period
+        bool captured = false;
+        if (capture_.pcm) {
+            snd_pcm_sframes_t captureAvailable = snd_pcm_avail_update(capture_.pcm);
+            if (captureAvailable < 0) {
+                err = static_cast<int>(captureAvailable);
+            } else if (static_cast<uint32_t>(captureAvailable) >= periodFrames_) {
+                err = Transfer(capture_, inputPtrs_.data(), channels_, periodFrames_);
+                captured = err == 0;
+            }
+            if (err < 0) {
+                if (!RecoverStreams(err, GlitchType::CaptureOverrun)) {
+                    break;
+                }
+                continue;
+            }
+        }
+        if (capture_.pcm && !captured) {
+            // Capture fell behind playback: this period's input is silence
+            ReportXrun(GlitchType::CaptureUnderrun, periodFrames_);
+        }
+        if (!captured) {
+            std::fill(inputBuffer_.begin(), inputBuffer_.end(), 0.0f);
+        }
+        
+        callback_(inputPtrs_.data(), outputPtrs_.data(), channels_, periodFrames_);
+        
+        err = Transfer(playback_, outputPtrs_.data(), channels_, periodFrames_);
+        if (err < 0 && !RecoverStreams(err, GlitchType::RenderUnderrun)) {
+            break;
+        }
+    }
+    
+    snd_pcm_drop(playback_.pcm);
+    if (capture_.pcm && !linked_) {
+        snd_pcm_drop(capture_.pcm);
+    }
+}
+
+} // namespace violet
@@ -0,0 +1,64 @@
+#include "violet/audio_arena.h"
+#include <algorithm>
+#include <cstring>
+
+namespace violet {
+
+namespace {
+
+size_t AlignUp(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void AudioArena::Reset() {
+    // A layout that spilled over gets one block for all of it next time
+    if (blocks_.size() > 1) {
+        size_t size = std::max(used_, GetCapacity());
+        blocks_.clear();
+        blocks_.push_back(NewBlock(size));
+    }
+    for (Block& block : blocks_) {
+        block.offset = 0;
+    }
+    used_ = 0;
+}
+
+AudioArena::Block AudioArena::NewBlock(size_t size) {
+    Block block;
+    block.storage.reset(new uint8_t[size + ALIGNMENT]);
+    block.begin = reinterpret_cast<uint8_t*>(AlignUp(reinterpret_cast<uintptr_t>(block.storage.get()), ALIGNMENT));
+    block.size = size;
+    return block;
+}
+
+size_t AudioArena::GetCapacity() const {
+    size_t capacity = 0;
+    for (const Block& block : blocks_) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void* AudioArena::AllocateBytes(size_t bytes) {
+    bytes = AlignUp(std::max<size_t>(bytes, 1), ALIGNMENT);
+    used_ += bytes;
+
+    for (Block& block : blocks_) {
+        if (block.size - block.offset >= bytes) {
+            uint8_t* data = block.begin + block.offset;
+            block.offset += bytes;
+            memset(data, 0, bytes);
+            return data;
+        }
+    }
+
+    Block block = NewBlock(std::max(bytes, MIN_BLOCK));
+    block.offset = bytes;
+    memset(block.begin, 0, bytes);
+    blocks_.push_back(std::move(block));
+    return blocks_.back().begin;
+}
+
+} // namespace violet
@@ -0,0 +1,50 @@
+#include "violet/audio_backend.h"
+#include "violet/null_backend.h"
+#include <cstdlib>
+
+#ifdef _WIN32
+#include "violet/wasapi_backend.h"
+#endif
+
+#ifdef VIOLET_HAVE_ALSA
+#include "violet/alsa_backend.h"
+#endif
+
+namespace violet {
+
+std::vector<std::string> GetAudioBackendNames() {
+    std::vector<std::string> names;
+#ifdef _WIN32
+    names.push_back("wasapi");
+#endif
+#ifdef VIOLET_HAVE_ALSA
+    names.push_back("alsa");
+#endif
+    names.push_back("null");
+    return names;
+}
+
+std::unique_ptr<AudioBackend> CreateAudioBackend(const std::string& name) {
+    std::string backendName = name;
+    if (backendName.empty()) {
+        const char* env = std::getenv("VIOLET_AUDIO_BACKEND");
+        backendName = env && *env ? env : GetAudioBackendNames().front();
+    }
+
+#ifdef _WIN32
+    if (backendName == "wasapi") {
+        return std::make_unique<WasapiBackend>();
+    }
+#endif
+#ifdef VIOLET_HAVE_ALSA
+    if (backendName == "alsa") {
+        return std::make_unique<AlsaBackend>();
+    }
+#endif
+    if (backendName == "null") {
+        return std::make_unique<NullBackend>();
+    }
+    return nullptr;
+}
+
+} // namespace violet
@@ -1,4 +1,5 @@
 #include "violet/audio_buffer.h"
+#include "violet/pcm_convert.h"
 #include <algorithm>
 
 namespace violet {
@@ -21,62 +22,93 @@ void AudioBuffer::Resize(uint32_t channels, uint32_t capacity) {
         channelBuffers_.emplace_back(std::make_unique<CircularBuffer<float>>(capacity));
     }
     
-    // Resize temp buffer to handle the largest possible interleaved frame
-    tempBuffer_.resize(channels * capacity);
+    writePtrs_.resize(channels);
+    readPtrs_.resize(channels);
 }
 
-size_t AudioBuffer::WriteInterleaved(const float* data, uint32_t frames) {
-    if (channelBuffers_.empty() || !data) {
+size_t AudioBuffer::GetWritableFrames() const {
+    if (channelBuffers_.empty()) {
         return 0;
     }
     
-    // Find the minimum available space across all channels
+    // The minimum available space across all channels
     size_t minAvailable = channelBuffers_[0]->AvailableWrite();
     for (uint32_t ch = 1; ch < channels_; ++ch) {
         minAvailable = std::min(minAvailable, channelBuffers_[ch]->AvailableWrite());
     }
-    
-    size_t framesToWrite = std::min(static_cast<size_t>(frames), minAvailable);
-    if (framesToWrite == 0) {
+    return minAvailable;
+}
+
+size_t AudioBuffer::Write(const float* const* data, uint32_t frames) {
+    if (channelBuffers_.empty() || !data) {
         return 0;
     }
     
-    // De-interleave and write to channel buffers
-    for (uint32_t frame = 0; frame < framesToWrite; ++frame) {
-        for (uint32_t ch = 0; ch < channels_; ++ch) {
-            float sample = data[frame * channels_ + ch];
-            channelBuffers_[ch]->Write(&sample, 1);
-        }
+    size_t framesToWrite = std::min(static_cast<size_t>(frames), GetWritableFrames());
+    for (uint32_t ch = 0; ch < channels_ && framesToWrite > 0; ++ch) {
+        channelBuffers_[ch]->Write(data[ch], framesToWrite);
     }
-    
     return framesToWrite;
 }
 
-size_t AudioBuffer::ReadInterleaved(float* data, uint32_t frames) {
+size_t AudioBuffer::Read(float* const* data, uint32_t frames) {
     if (channelBuffers_.empty() || !data) {
         return 0;
     }
     
-    // Find the minimum available data across all channels
-    size_t minAvailable = channelBuffers_[0]->AvailableRead();
-    for (uint32_t ch = 1; ch < channels_; ++ch) {
-        minAvailable = std::min(minAvailable, channelBuffers_[ch]->AvailableRead());
+    size_t framesToRead = std::min(frames, GetAvailableFrames());
+    for (uint32_t ch = 0; ch < channels_ && framesToRead > 0; ++ch) {
+        channelBuffers_[ch]->Read(data[ch], framesToRead);
     }
-    
-    size_t framesToRead = std::min(static_cast<size_t>(frames), minAvailable);
-    if (framesToRead == 0) {
+    return framesToRead;
+}
+
+size_t AudioBuffer::WriteInterleaved(const float* data, uint32_t frames) {
+    if (channelBuffers_.empty() || !data) {
         return 0;
     }
     
-    // Read from channel buffers and interleave
-    for (uint32_t frame = 0; frame < framesToRead; ++frame) {
+    // De-interleave straight into the rings, one contiguous stretch (the
+    // shortest first region across channels) at a time
+    size_t framesToWrite = std::min(static_cast<size_t>(frames), GetWritableFrames());
+    size_t written = 0;
+    while (written < framesToWrite) {
+        size_t count = framesToWrite - written;
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            RingRegions<float> regions = channelBuffers_[ch]->GetWriteRegions(count);
+            writePtrs_[ch] = regions.first;
+            count = std::min(count, regions.firstCount);
+        }
+        pcm::Deinterleave(data + written * channels_, channels_, writePtrs_.data(), static_cast<uint32_t>(count));
         for (uint32_t ch = 0; ch < channels_; ++ch) {
-            float sample = 0.0f;
-            channelBuffers_[ch]->Read(&sample, 1);
-            data[frame * channels_ + ch] = sample;
+            channelBuffers_[ch]->CommitWrite(count);
         }
+        written += count;
+    }
+    return framesToWrite;
+}
+
+size_t AudioBuffer::ReadInterleaved(float* data, uint32_t frames) {
+    if (channelBuffers_.empty() || !data) {
+        return 0;
     }
     
+    // Interleave straight out of the rings
+    size_t framesToRead = std::min(frames, GetAvailableFrames());
+    size_t read = 0;
+    while (read < framesToRead) {
+        size_t count = framesToRead - read;
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            RingRegions<const float> regions = channelBuffers_[ch]->GetReadRegions(count);
+            readPtrs_[ch] = regions.first;
+            count = std::min(count, regions.firstCount);
+        }
+        pcm::Interleave(readPtrs_.data(), channels_, data + read * channels_, static_cast<uint32_t>(count));
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            channelBuffers_[ch]->CommitRead(count);
+        }
+        read += count;
+    }
     return framesToRead;
 }
 
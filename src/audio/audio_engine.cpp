@@ -1,16 +1,12 @@
-#include <windows.h>
-#include <initguid.h>
-#include <mmdeviceapi.h>
-#include <audioclient.h>
-#include <ks.h>
-#include <ksmedia.h>
-
 #include "violet/audio_engine.h"
+#include "violet/pcm_convert.h"
+#include "violet/realtime_log.h"
 #include "violet/utils.h"
 #include <iostream>
-#include <chrono>
 #include <algorithm>
-#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 
 namespace violet {
 
@@ -19,309 +15,108 @@ const uint32_t AudioEngine::SUPPORTED_SAMPLE_RATES[] = {44100, 48000, 88200, 960
 const uint32_t AudioEngine::SUPPORTED_BUFFER_SIZES[] = {64, 128, 256, 512, 1024, 2048};
 
 AudioEngine::AudioEngine()
-    : deviceEnumerator_(nullptr)
-    , inputDevice_(nullptr)
-    , outputDevice_(nullptr)
-    , inputClient_(nullptr)
-    , outputClient_(nullptr)
-    , renderClient_(nullptr)
-    , captureClient_(nullptr)
-    , volumeControl_(nullptr)
-    , isRunning_(false)
-    , shouldStop_(false)
-    , audioEvent_(nullptr)
-    , inputEventCallbackMode_(false)
-    , outputEventCallbackMode_(false)
+    : isRunning_(false)
+    , outputDither_(false)
     , audioCallback_(nullptr)
     , callbackUserData_(nullptr)
     , cpuUsage_(0.0)
-    , dropoutCount_(0) {
+    , dropoutCount_(0)
+    , streamSampleRate_(0)
+    , intervalStart_(0)
+    , busyNanos_(0)
+    , lastCallbackNanos_(0)
+    , streamStart_(0)
+    , inputBuffer_(nullptr)
+    , outputBuffer_(nullptr)
+    , interleavedSize_(0)
+    , mapping_(false)
+    , busCount_(0)
+    , deviceChannels_(0)
+    , busInputMap_(nullptr)
+    , busOutputMap_(nullptr)
+    , silentRow_(nullptr)
+    , busInputPtrs_(nullptr)
+    , busOutputPtrs_(nullptr)
+    , processingSampleRate_(0)
+    , resamplerQuality_(ResamplerQuality::High)
+    , fixedBlockSize_(false)
+    , adapting_(false)
+    , processingBlock_(0)
+    , captureFifo_(0, 0)
+    , renderFifo_(0, 0)
+    , resampledPtrs_(nullptr)
+    , blockInputPtrs_(nullptr)
+    , blockOutputPtrs_(nullptr) {
 }
 
 AudioEngine::~AudioEngine() {
     Shutdown();
 }
 
-bool AudioEngine::Initialize() {
-    std::cout << "Initializing audio engine..." << std::endl;
-    
-    if (!InitializeWASAPI()) {
-        std::cerr << "Failed to initialize WASAPI" << std::endl;
+bool AudioEngine::Initialize(const std::string& backendName) {
+    std::unique_ptr<AudioBackend> backend = CreateAudioBackend(backendName);
+    if (!backend) {
+        std::cerr << "Audio backend not available: "
+                  << (backendName.empty() ? "default" : backendName) << std::endl;
         return false;
     }
+    return Initialize(std::move(backend));
+}
+
+bool AudioEngine::Initialize(std::unique_ptr<AudioBackend> backend) {
+    Shutdown();
+    
+    std::cout << "Initializing audio engine (" << backend->GetName() << ")..." << std::endl;
     
-    // Create audio processing event
-    audioEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    if (!audioEvent_) {
-        std::cerr << "Failed to create audio event: " << GetLastError() << std::endl;
-        Shutdown();
+    if (!backend->Initialize()) {
+        std::cerr << "Failed to initialize " << backend->GetName() << " backend" << std::endl;
         return false;
     }
     
+    backend_ = std::move(backend);
+    
+    // Backends log from their audio threads through the realtime log
+    StartLogThread();
     std::cout << "Audio engine initialized successfully" << std::endl;
     return true;
 }
 
 void AudioEngine::Shutdown() {
     Stop();
-    ShutdownWASAPI();
-    
-    if (audioEvent_) {
-        CloseHandle(audioEvent_);
-        audioEvent_ = nullptr;
-    }
+    backend_.reset();
 }
 
-bool AudioEngine::InitializeWASAPI() {
-    // Initialize COM for this thread if not already initialized
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-    if (FAILED(hr) && hr != RPC_E_CHANGED_MODE) {
-        std::cerr << "Failed to initialize COM: 0x" << std::hex << hr << std::endl;
-        // Continue anyway as COM might already be initialized
-    }
-    
-    hr = CoCreateInstance(
-        __uuidof(MMDeviceEnumerator),
-        nullptr, CLSCTX_ALL,
-        __uuidof(IMMDeviceEnumerator),
-        (void**)&deviceEnumerator_
-    );
-    
-    if (FAILED(hr)) {
-        std::cerr << "Failed to create device enumerator: 0x" << std::hex << hr << std::endl;
-        if (hr == REGDB_E_CLASSNOTREG) {
-            std::cerr << "MMDeviceEnumerator class not registered (Wine may need winepulse)" << std::endl;
-        } else if (hr == CLASS_E_NOAGGREGATION) {
-            std::cerr << "Class cannot be aggregated" << std::endl;
-        } else if (hr == E_NOINTERFACE) {
-            std::cerr << "Interface not supported" << std::endl;
-        } else if (hr == CO_E_NOTINITIALIZED) {
-            std::cerr << "COM not initialized" << std::endl;
-        }
-        return false;
-    }
-    
-    std::cout << "WASAPI device enumerator created successfully" << std::endl;
-    return true;
-}
-
-void AudioEngine::ShutdownWASAPI() {
-    if (renderClient_) {
-        renderClient_->Release();
-        renderClient_ = nullptr;
-    }
-    
-    if (captureClient_) {
-        captureClient_->Release();
-        captureClient_ = nullptr;
-    }
-    
-    if (volumeControl_) {
-        volumeControl_->Release();
-        volumeControl_ = nullptr;
-    }
-    
-    if (inputClient_) {
-        inputClient_->Release();
-        inputClient_ = nullptr;
-        inputEventCallbackMode_ = false;
-    }
-    
-    if (outputClient_) {
-        outputClient_->Release();
-        outputClient_ = nullptr;
-        outputEventCallbackMode_ = false;
-    }
-    
-    if (inputDevice_) {
-        inputDevice_->Release();
-        inputDevice_ = nullptr;
-    }
-    
-    if (outputDevice_) {
-        outputDevice_->Release();
-        outputDevice_ = nullptr;
-    }
-    
-    if (deviceEnumerator_) {
-        deviceEnumerator_->Release();
-        deviceEnumerator_ = nullptr;
-    }
+std::string AudioEngine::GetBackendName() const {
+    return backend_ ? backend_->GetName() : "";
 }
 
 std::vector<AudioDevice> AudioEngine::EnumerateDevices() {
-    std::vector<AudioDevice> devices;
-    
-    if (!deviceEnumerator_) {
-        return devices;
+    if (!backend_) {
+        return {};
     }
-    
-    // Enumerate output devices
-    IMMDeviceCollection* outputCollection = nullptr;
-    HRESULT hr = deviceEnumerator_->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &outputCollection);
-    if (SUCCEEDED(hr)) {
-        UINT count = 0;
-        outputCollection->GetCount(&count);
-        
-        for (UINT i = 0; i < count; ++i) {
-            IMMDevice* device = nullptr;
-            if (SUCCEEDED(outputCollection->Item(i, &device))) {
-                AudioDevice audioDevice;
-                audioDevice.id = GetDeviceId(device);
-                audioDevice.name = GetDeviceName(device);
-                audioDevice.isInput = false;
-                audioDevice.isOutput = true;
-                audioDevice.isDefault = false; // Will be set later
-                
-                devices.push_back(audioDevice);
-                device->Release();
-            }
-        }
-        outputCollection->Release();
-    }
-    
-    // Enumerate input devices
-    IMMDeviceCollection* inputCollection = nullptr;
-    hr = deviceEnumerator_->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, &inputCollection);
-    if (SUCCEEDED(hr)) {
-        UINT count = 0;
-        inputCollection->GetCount(&count);
-        
-        for (UINT i = 0; i < count; ++i) {
-            IMMDevice* device = nullptr;
-            if (SUCCEEDED(inputCollection->Item(i, &device))) {
-                AudioDevice audioDevice;
-                audioDevice.id = GetDeviceId(device);
-                audioDevice.name = GetDeviceName(device);
-                audioDevice.isInput = true;
-                audioDevice.isOutput = false;
-                audioDevice.isDefault = false; // Will be set later
-                
-                devices.push_back(audioDevice);
-                device->Release();
-            }
-        }
-        inputCollection->Release();
-    }
-    
-    // Mark default devices
-    IMMDevice* defaultOutput = nullptr;
-    if (SUCCEEDED(deviceEnumerator_->GetDefaultAudioEndpoint(eRender, eConsole, &defaultOutput))) {
-        std::string defaultOutputId = GetDeviceId(defaultOutput);
-        for (auto& device : devices) {
-            if (device.id == defaultOutputId && device.isOutput) {
-                device.isDefault = true;
-                break;
-            }
-        }
-        defaultOutput->Release();
-    }
-    
-    IMMDevice* defaultInput = nullptr;
-    if (SUCCEEDED(deviceEnumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &defaultInput))) {
-        std::string defaultInputId = GetDeviceId(defaultInput);
-        for (auto& device : devices) {
-            if (device.id == defaultInputId && device.isInput) {
-                device.isDefault = true;
-                break;
-            }
-        }
-        defaultInput->Release();
-    }
-    
-    return devices;
-}
-
-std::string AudioEngine::GetDeviceId(IMMDevice* device) {
-    LPWSTR deviceId = nullptr;
-    if (SUCCEEDED(device->GetId(&deviceId))) {
-        std::string result = utils::WStringToString(deviceId);
-        CoTaskMemFree(deviceId);
-        return result;
-    }
-    return "";
-}
-
-std::string AudioEngine::GetDeviceName(IMMDevice* device) {
-    IPropertyStore* props = nullptr;
-    if (SUCCEEDED(device->OpenPropertyStore(STGM_READ, &props))) {
-        PROPVARIANT varName;
-        PropVariantInit(&varName);
-        
-        if (SUCCEEDED(props->GetValue(PKEY_Device_FriendlyName, &varName))) {
-            std::string result = utils::WStringToString(varName.pwszVal);
-            PropVariantClear(&varName);
-            props->Release();
-            return result;
-        }
-        
-        PropVariantClear(&varName);
-        props->Release();
-    }
-    return "Unknown Device";
+    return backend_->EnumerateDevices();
 }
 
 bool AudioEngine::SetInputDevice(const std::string& deviceId) {
-    return SelectDevice(deviceId, true);
+    if (!backend_) {
+        std::cerr << "Audio backend not initialized" << std::endl;
+        return false;
+    }
+    
+    // Opened, and checked, on the next Start()
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    currentInputDeviceId_ = deviceId;
+    return true;
 }
 
 bool AudioEngine::SetOutputDevice(const std::string& deviceId) {
-    return SelectDevice(deviceId, false);
-}
-
-bool AudioEngine::SelectDevice(const std::string& deviceId, bool isInput) {
-    if (!deviceEnumerator_) {
-        std::cerr << "Device enumerator not initialized" << std::endl;
+    if (!backend_) {
+        std::cerr << "Audio backend not initialized" << std::endl;
         return false;
     }
     
     std::lock_guard<std::mutex> lock(deviceMutex_);
-    
-    IMMDevice** targetDevice = isInput ? &inputDevice_ : &outputDevice_;
-    std::string* targetDeviceId = isInput ? &currentInputDeviceId_ : &currentOutputDeviceId_;
-    
-    // Release current device
-    if (*targetDevice) {
-        (*targetDevice)->Release();
-        *targetDevice = nullptr;
-    }
-    
-    // Get new device
-    if (deviceId.empty()) {
-        // Use default device
-        EDataFlow flow = isInput ? eCapture : eRender;
-        HRESULT hr = deviceEnumerator_->GetDefaultAudioEndpoint(flow, eConsole, targetDevice);
-        if (FAILED(hr)) {
-            std::cerr << "Failed to get default " << (isInput ? "input" : "output") 
-                      << " device: 0x" << std::hex << hr << std::endl;
-            if (hr == E_NOTFOUND) {
-                std::cerr << "No " << (isInput ? "input" : "output") << " devices found" << std::endl;
-            } else if (hr == E_OUTOFMEMORY) {
-                std::cerr << "Out of memory" << std::endl;
-            }
-            return false;
-        }
-        *targetDeviceId = GetDeviceId(*targetDevice);
-        std::cout << "Selected default " << (isInput ? "input" : "output") 
-                  << " device: " << *targetDeviceId << std::endl;
-    } else {
-        // Use specific device
-        std::wstring wDeviceId = utils::StringToWString(deviceId);
-        HRESULT hr = deviceEnumerator_->GetDevice(wDeviceId.c_str(), targetDevice);
-        if (FAILED(hr)) {
-            std::cerr << "Failed to get device '" << deviceId << "': 0x" << std::hex << hr << std::endl;
-            if (hr == E_NOTFOUND) {
-                std::cerr << "Device not found" << std::endl;
-            } else if (hr == E_INVALIDARG) {
-                std::cerr << "Invalid device ID" << std::endl;
-            }
-            return false;
-        }
-        *targetDeviceId = deviceId;
-        std::cout << "Selected " << (isInput ? "input" : "output") 
-                  << " device: " << deviceId << std::endl;
-    }
-    
+    currentOutputDeviceId_ = deviceId;
     return true;
 }
 
@@ -374,697 +169,422 @@ std::vector<uint32_t> AudioEngine::GetSupportedBufferSizes() const {
     return std::vector<uint32_t>(std::begin(SUPPORTED_BUFFER_SIZES), std::end(SUPPORTED_BUFFER_SIZES));
 }
 
-bool AudioEngine::Start() {
-    if (isRunning_.load()) {
-        return true;
+bool AudioEngine::SetProcessingSampleRate(uint32_t sampleRate) {
+    if (sampleRate != 0 && std::find(std::begin(SUPPORTED_SAMPLE_RATES), std::end(SUPPORTED_SAMPLE_RATES),
+                                     sampleRate) == std::end(SUPPORTED_SAMPLE_RATES)) {
+        return false;
     }
-    
-    // Ensure we have devices selected
-    if (currentOutputDeviceId_.empty()) {
-        std::cout << "Selecting default output device..." << std::endl;
-        if (!SetOutputDevice("")) { // Use default
-            std::cerr << "Failed to select default output device" << std::endl;
-            return false;
-        }
+    processingSampleRate_ = sampleRate;
+    return true;
+}
+
+AudioFormat AudioEngine::GetProcessingFormat() const {
+    AudioFormat format = GetFormat();
+    if (processingSampleRate_ != 0) {
+        format.sampleRate = processingSampleRate_;
     }
-    
-    // Select default input device for microphone capture
-    if (currentInputDeviceId_.empty()) {
-        std::cout << "Selecting default input device..." << std::endl;
-        if (!SetInputDevice("")) { // Use default
-            std::cerr << "Warning: Failed to select default input device, audio input will be silent" << std::endl;
-            // Don't fail - we can still output audio even without input
-        }
+    format.channels = GetBusCount(format.channels);
+    return format;
+}
+
+bool ParseChannelList(const std::string& text, std::vector<int32_t>& channels) {
+    channels.clear();
+    if (text.empty()) {
+        return true;
     }
-    
-    // Create input client first to get its native format
-    if (!currentInputDeviceId_.empty()) {
-        std::cout << "Creating audio client for input device: " << currentInputDeviceId_ << std::endl;
-        if (CreateAudioClient(true, &actualInputFormat_)) { // Input
-            std::cout << "Input initialized: " << actualInputFormat_.sampleRate << " Hz, "
-                      << actualInputFormat_.channels << " channels, "
-                      << actualInputFormat_.bitsPerSample << " bits" << std::endl;
-            
-            // Use input device's format for processing chain, but check compatibility with output
-            currentFormat_ = actualInputFormat_;
-            std::cout << "Input format will be used for processing chain" << std::endl;
-        } else {
-            std::cerr << "Warning: Failed to create input audio client, continuing without audio input" << std::endl;
+    for (const std::string& item : utils::Split(text, ',')) {
+        char* end = nullptr;
+        long long channel = std::strtoll(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || channel < -1 || channel > INT32_MAX) {
+            return false;
         }
+        channels.push_back(static_cast<int32_t>(channel));
     }
-    
-    // Create audio client for output device using same format as input
-    std::cout << "Creating audio client for output device: " << currentOutputDeviceId_ << std::endl;
-    if (!CreateAudioClient(false, &actualOutputFormat_)) { // Output
-        std::cerr << "Failed to create audio client. Cannot start audio engine." << std::endl;
+    return true;
+}
+
+bool AudioEngine::SetChannelMap(const ChannelMap& map) {
+    if (map.inputs.size() > MAX_CHANNELS) {
         return false;
     }
-    
-    std::cout << "Output initialized: " << actualOutputFormat_.sampleRate << " Hz, "
-              << actualOutputFormat_.channels << " channels, "
-              << actualOutputFormat_.bitsPerSample << " bits" << std::endl;
-    
-    std::cout << "Audio engine starting with:" << std::endl;
-    if (actualInputFormat_.sampleRate > 0) {
-        std::cout << "  Input:  " << actualInputFormat_.sampleRate << " Hz, "
-                  << actualInputFormat_.channels << " ch, "
-                  << actualInputFormat_.bitsPerSample << " bits" << std::endl;
-    }
-    std::cout << "  Output: " << actualOutputFormat_.sampleRate << " Hz, "
-              << actualOutputFormat_.channels << " ch, "
-              << actualOutputFormat_.bitsPerSample << " bits" << std::endl;
-    std::cout << "  Buffer size: " << currentFormat_.bufferSize << " samples" << std::endl;
-    
-    // Handle sample rate mismatch by using output format as the common format
-    if (actualInputFormat_.sampleRate != actualOutputFormat_.sampleRate) {
-        std::cout << "Sample rate mismatch detected. Using output format (" 
-                  << actualOutputFormat_.sampleRate << " Hz) for processing" << std::endl;
-        currentFormat_ = actualOutputFormat_;
-    }
-    
-    // Start audio thread
-    shouldStop_.store(false);
-    audioThread_ = std::thread(&AudioEngine::AudioThreadProc, this);
-    
-    isRunning_.store(true);
+    std::lock_guard<std::mutex> lock(formatMutex_);
+    channelMap_ = map;
     return true;
 }
 
-bool AudioEngine::Stop() {
-    if (!isRunning_.load()) {
-        return true;
+ChannelMap AudioEngine::GetChannelMap() const {
+    std::lock_guard<std::mutex> lock(formatMutex_);
+    return channelMap_;
+}
+
+uint32_t AudioEngine::GetBusCount(uint32_t deviceChannels) const {
+    std::lock_guard<std::mutex> lock(formatMutex_);
+    return channelMap_.inputs.empty() ? deviceChannels : static_cast<uint32_t>(channelMap_.inputs.size());
+}
+
+void AudioEngine::ConfigureChannelMap(const AudioFormat& device) {
+    ChannelMap map = GetChannelMap();
+    mapping_ = !map.IsIdentity();
+    busCount_ = GetBusCount(device.channels);
+    deviceChannels_ = device.channels;
+    if (!mapping_) {
+        return;
     }
     
-    shouldStop_.store(true);
-    
-    // Signal audio thread to stop
-    if (audioEvent_) {
-        SetEvent(audioEvent_);
+    // Identity for whichever side the map leaves out; anything out of
+    // range becomes -1 so the audio thread needs a single check
+    busInputMap_ = arena_.Allocate<int32_t>(busCount_);
+    for (uint32_t bus = 0; bus < busCount_; ++bus) {
+        int32_t source = map.inputs.empty() ? static_cast<int32_t>(bus) : map.inputs[bus];
+        busInputMap_[bus] = source >= 0 && static_cast<uint32_t>(source) < device.channels ? source : -1;
+    }
+    busOutputMap_ = arena_.Allocate<int32_t>(device.channels);
+    for (uint32_t ch = 0; ch < device.channels; ++ch) {
+        int32_t bus = map.outputs.empty() ? static_cast<int32_t>(ch)
+                    : ch < map.outputs.size() ? map.outputs[ch] : -1;
+        busOutputMap_[ch] = bus >= 0 && static_cast<uint32_t>(bus) < busCount_ ? bus : -1;
     }
     
-    // Wait for audio thread to finish
-    if (audioThread_.joinable()) {
-        audioThread_.join();
+    // busCount_ output rows, then one silent row
+    size_t rowFrames = std::max(backend_->GetMaxFrames(), device.bufferSize);
+    float* rows = arena_.Allocate<float>(rowFrames * (busCount_ + 1));
+    silentRow_ = rows + rowFrames * busCount_;
+    busInputPtrs_ = arena_.Allocate<float*>(busCount_);
+    busOutputPtrs_ = arena_.Allocate<float*>(busCount_);
+    for (uint32_t bus = 0; bus < busCount_; ++bus) {
+        busInputPtrs_[bus] = silentRow_;
+        busOutputPtrs_[bus] = rows + rowFrames * bus;
     }
     
-    isRunning_.store(false);
-    return true;
+    std::cout << "Routing " << device.channels << " device channel(s) through " << busCount_ << " bus(es)" << std::endl;
 }
 
-bool AudioEngine::IsRunning() const {
-    return isRunning_.load();
+bool AudioEngine::HasFixedBlockSize() const {
+    return isRunning_.load() && (adapting_ || backend_->HasFixedBlockSize());
 }
 
-bool AudioEngine::CreateAudioClient(bool isInput, AudioFormat* actualFormat) {
-    IMMDevice* device = isInput ? inputDevice_ : outputDevice_;
-    IAudioClient** client = isInput ? &inputClient_ : &outputClient_;
-    
-    if (!device) {
-        std::cerr << "No " << (isInput ? "input" : "output") << " device selected" << std::endl;
-        return false;
-    }
-    
-    // Release existing client
-    if (*client) {
-        (*client)->Release();
-        *client = nullptr;
-    }
-    
-    // Create new audio client
-    HRESULT hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)client);
-    if (FAILED(hr)) {
-        std::cerr << "Failed to activate audio client for " << (isInput ? "input" : "output") 
-                  << ": 0x" << std::hex << hr << std::endl;
-        return false;
+bool AudioEngine::ConfigureAdapter(const AudioFormat& device) {
+    bool converting = processingSampleRate_ != 0 && processingSampleRate_ != device.sampleRate;
+    adapting_ = converting || (fixedBlockSize_ && !backend_->HasFixedBlockSize());
+    if (!adapting_) {
+        return true;
     }
     
-    // Get the device's native mix format (for both input and output)
-    WAVEFORMATEX* mixFormat = nullptr;
-    hr = (*client)->GetMixFormat(&mixFormat);
-    if (FAILED(hr)) {
-        std::cerr << "Failed to get mix format for " << (isInput ? "input" : "output") << " device: 0x" << std::hex << hr << std::endl;
-        (*client)->Release();
-        *client = nullptr;
+    // Equal rates make both resamplers plain copies
+    uint32_t channels = device.channels;
+    uint32_t maxFrames = backend_->GetMaxFrames();
+    uint32_t processingRate = converting ? processingSampleRate_ : device.sampleRate;
+    processingBlock_ = device.bufferSize;
+    if (!captureResampler_.Configure(channels, device.sampleRate, processingRate, resamplerQuality_, maxFrames) ||
+        !renderResampler_.Configure(channels, processingRate, device.sampleRate, resamplerQuality_, processingBlock_)) {
+        std::cerr << "Cannot resample between " << device.sampleRate << " Hz and "
+                  << processingRate << " Hz" << std::endl;
+        adapting_ = false;
         return false;
     }
     
-    std::cout << (isInput ? "Input" : "Output") << " device native format: "
-              << mixFormat->nSamplesPerSec << " Hz, "
-              << mixFormat->nChannels << " channels, "
-              << mixFormat->wBitsPerSample << " bits" << std::endl;
-    
-    // For output: if input format is already set, try to use matching format
-    // Otherwise use device's native format
-    if (!isInput && actualInputFormat_.sampleRate > 0) {
-        std::cout << "Attempting to match output format to input: "
-                  << actualInputFormat_.sampleRate << " Hz" << std::endl;
-        
-        // Create format matching input
-        WAVEFORMATEXTENSIBLE* desiredFormat = (WAVEFORMATEXTENSIBLE*)CoTaskMemAlloc(sizeof(WAVEFORMATEXTENSIBLE));
-        memcpy(desiredFormat, mixFormat, sizeof(WAVEFORMATEXTENSIBLE));
-        desiredFormat->Format.nSamplesPerSec = actualInputFormat_.sampleRate;
-        desiredFormat->Format.nAvgBytesPerSec = actualInputFormat_.sampleRate * desiredFormat->Format.nBlockAlign;
-        
-        // Check if this format is supported
-        WAVEFORMATEX* closestMatch = nullptr;
-        hr = (*client)->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, (WAVEFORMATEX*)desiredFormat, &closestMatch);
-        
-        if (hr == S_OK) {
-            // Exact match supported - use it
-            CoTaskMemFree(mixFormat);
-            mixFormat = (WAVEFORMATEX*)desiredFormat;
-            std::cout << "Output device supports input sample rate" << std::endl;
-        } else if (hr == S_FALSE && closestMatch) {
-            // Close match available
-            std::cout << "Using closest match: " << closestMatch->nSamplesPerSec << " Hz" << std::endl;
-            CoTaskMemFree(mixFormat);
-            CoTaskMemFree(desiredFormat);
-            mixFormat = closestMatch;
-        } else {
-            // Not supported, use device default
-            std::cout << "Output device doesn't support input sample rate, using native format" << std::endl;
-            CoTaskMemFree(desiredFormat);
-        }
+    // Per channel: resampled frames, then the callback's input and output block
+    uint32_t captureFrames = captureResampler_.GetMaxOutputFrames(maxFrames);
+    uint32_t renderFrames = renderResampler_.GetMaxOutputFrames(processingBlock_);
+    size_t stride = std::max(captureFrames, renderFrames) + 2 * static_cast<size_t>(processingBlock_);
+    float* scratch = arena_.Allocate<float>(stride * channels);
+    resampledPtrs_ = arena_.Allocate<float*>(channels);
+    blockInputPtrs_ = arena_.Allocate<float*>(channels);
+    blockOutputPtrs_ = arena_.Allocate<float*>(channels);
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        float* base = scratch + stride * ch;
+        resampledPtrs_[ch] = base;
+        blockInputPtrs_[ch] = base + std::max(captureFrames, renderFrames);
+        blockOutputPtrs_[ch] = blockInputPtrs_[ch] + processingBlock_;
+    }
+    
+    captureFifo_.Resize(channels, 2 * (captureFrames + processingBlock_) + 8);
+    renderFifo_.Resize(channels, 2 * (renderFrames + maxFrames));
+    captureFifo_.Clear();
+    renderFifo_.Clear();
+    
+    // The callback takes whole blocks while capture trickles in per device
+    // period, so it can run up to a block ahead of what has been captured
+    captureFifo_.Write(blockInputPtrs_, processingBlock_);
+    
+    if (converting) {
+        std::cout << "Resampling " << device.sampleRate << " Hz <-> " << processingSampleRate_ << " Hz ("
+                  << GetResamplerQualityName(resamplerQuality_) << " quality)" << std::endl;
+    } else {
+        std::cout << "Buffering device periods into fixed " << processingBlock_ << " frame blocks" << std::endl;
     }
-    
-    // Store the actual format being used
-    if (actualFormat) {
-        actualFormat->sampleRate = mixFormat->nSamplesPerSec;
-        actualFormat->channels = mixFormat->nChannels;
-        actualFormat->bitsPerSample = mixFormat->wBitsPerSample;
-        actualFormat->bufferSize = currentFormat_.bufferSize; // Keep requested buffer size
+    return true;
+}
+
+bool AudioEngine::Start() {
+    if (isRunning_.load()) {
+        return true;
     }
     
-    // Calculate buffer duration - use 10ms for low latency
-    REFERENCE_TIME bufferDuration = 100000;  // 10ms
-    
-    // Try event callback mode first (for Windows), fall back to polling if it fails
-    hr = (*client)->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-        bufferDuration,
-        0,
-        mixFormat,
-        nullptr
-    );
-    
-    bool useEventCallback = SUCCEEDED(hr);
-    
-    if (FAILED(hr)) {
-        std::cout << "Event callback mode failed for " << (isInput ? "input" : "output") << ", trying polling mode" << std::endl;
-        // Release and recreate client
-        (*client)->Release();
-        hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)client);
-        if (FAILED(hr)) {
-            std::cerr << "Failed to reactivate audio client: 0x" << std::hex << hr << std::endl;
-            CoTaskMemFree(mixFormat);
-            *client = nullptr;
-            return false;
-        }
-        
-        // Get mix format again
-        WAVEFORMATEX* mixFormat2 = nullptr;
-        hr = (*client)->GetMixFormat(&mixFormat2);
-        if (SUCCEEDED(hr)) {
-            CoTaskMemFree(mixFormat);
-            mixFormat = mixFormat2;
-        }
-        
-        // Try without event callback (polling mode)
-        hr = (*client)->Initialize(
-            AUDCLNT_SHAREMODE_SHARED,
-            0,  // No event callback
-            bufferDuration,
-            0,
-            mixFormat,
-            nullptr
-        );
+    if (!backend_) {
+        std::cerr << "Audio backend not initialized. Cannot start audio engine." << std::endl;
+        return false;
     }
     
-    CoTaskMemFree(mixFormat);
+    std::string inputId = GetCurrentInputDevice();
+    std::string outputId = GetCurrentOutputDevice();
+    AudioFormat requested = GetFormat();
+    AudioFormat actual;
     
-    if (FAILED(hr)) {
-        std::cerr << "Failed to initialize " << (isInput ? "input" : "output") << " audio client: 0x" << std::hex << hr << std::endl;
-        if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
-            std::cerr << "  Format not supported" << std::endl;
-        } else if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
-            std::cerr << "  Buffer size not aligned" << std::endl;
-        } else if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-            std::cerr << "  Device already in use" << std::endl;
-        }
-        (*client)->Release();
-        *client = nullptr;
+    backend_->SetOutputDither(outputDither_);
+    if (!backend_->Open(inputId, outputId, requested, actual)) {
+        std::cerr << "Failed to open audio devices. Cannot start audio engine." << std::endl;
         return false;
     }
     
-    if (isInput) {
-        // Get the device's preferred format
-        WAVEFORMATEX* mixFormat = nullptr;
-        hr = (*client)->GetMixFormat(&mixFormat);
-        if (FAILED(hr)) {
-            std::cerr << "Failed to get mix format for input device: 0x" << std::hex << hr << std::endl;
-            (*client)->Release();
-            *client = nullptr;
-            return false;
+    // Remember what the defaults resolved to, so settings show the real device
+    {
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        if (currentInputDeviceId_.empty()) {
+            currentInputDeviceId_ = backend_->GetOpenInputDevice();
         }
-        
-        std::cout << "Input device native format: "
-                  << mixFormat->nSamplesPerSec << " Hz, "
-                  << mixFormat->nChannels << " channels, "
-                  << mixFormat->wBitsPerSample << " bits" << std::endl;
-        
-        // Calculate buffer duration - use same duration as output for better sync
-        // Default to 10ms (100000 hundred-nanosecond units)
-        REFERENCE_TIME bufferDuration = 100000;  // 10ms
-        
-        // Try event callback mode first (for Windows), fall back to polling if it fails
-        hr = (*client)->Initialize(
-            AUDCLNT_SHAREMODE_SHARED,
-            AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-            bufferDuration,
-            0,
-            mixFormat,
-            nullptr
-        );
-        
-        bool useEventCallback = SUCCEEDED(hr);
-        
-        if (FAILED(hr)) {
-            std::cout << "Event callback mode failed, trying polling mode for input" << std::endl;
-            // Release and recreate client
-            (*client)->Release();
-            hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)client);
-            if (FAILED(hr)) {
-                std::cerr << "Failed to reactivate audio client for input: 0x" << std::hex << hr << std::endl;
-                CoTaskMemFree(mixFormat);
-                *client = nullptr;
-                return false;
-            }
-            
-            // Get mix format again
-            WAVEFORMATEX* mixFormat2 = nullptr;
-            hr = (*client)->GetMixFormat(&mixFormat2);
-            if (SUCCEEDED(hr)) {
-                CoTaskMemFree(mixFormat);
-                mixFormat = mixFormat2;
-            }
-            
-            // Try without event callback (polling mode)
-            hr = (*client)->Initialize(
-                AUDCLNT_SHAREMODE_SHARED,
-                0,  // No event callback
-                bufferDuration,
-                0,
-                mixFormat,
-                nullptr
-            );
-        }
-        
-        CoTaskMemFree(mixFormat);
-        
-        if (FAILED(hr)) {
-            std::cerr << "Failed to initialize input audio client: 0x" << std::hex << hr << std::endl;
-            if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
-                std::cerr << "  Format not supported" << std::endl;
-            } else if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
-                std::cerr << "  Buffer size not aligned" << std::endl;
-            } else if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-                std::cerr << "  Device already in use" << std::endl;
-            }
-            (*client)->Release();
-            *client = nullptr;
-            return false;
-        }
-        
-        // Get capture client
-        hr = (*client)->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
-        if (FAILED(hr)) {
-            std::cerr << "Failed to get capture client: 0x" << std::hex << hr << std::endl;
-            (*client)->Release();
-            *client = nullptr;
-            return false;
-        }
-        
-        // Set event handle if using event callback mode
-        if (useEventCallback) {
-            hr = (*client)->SetEventHandle(audioEvent_);
-            if (FAILED(hr)) {
-                std::cerr << "Failed to set event handle for input: 0x" << std::hex << hr << std::endl;
-                (*client)->Release();
-                *client = nullptr;
-                return false;
-            }
-            inputEventCallbackMode_ = true;
-            std::cout << "Input audio client initialized (event callback mode)" << std::endl;
-        } else {
-            inputEventCallbackMode_ = false;
-            std::cout << "Input audio client initialized (polling mode)" << std::endl;
-        }
-    } else {
-        // Output device
-        hr = (*client)->GetService(__uuidof(IAudioRenderClient), (void**)&renderClient_);
-        if (FAILED(hr)) {
-            std::cerr << "Failed to get render client: 0x" << std::hex << hr << std::endl;
-            (*client)->Release();
-            *client = nullptr;
-            return false;
-        }
-        
-        // Get volume control (optional)
-        hr = (*client)->GetService(__uuidof(ISimpleAudioVolume), (void**)&volumeControl_);
-        // Volume control is optional, don't fail if not available
-        
-        // Set event handle if using event callback mode
-        if (useEventCallback) {
-            hr = (*client)->SetEventHandle(audioEvent_);
-            if (FAILED(hr)) {
-                std::cerr << "Failed to set event handle for output: 0x" << std::hex << hr << std::endl;
-                (*client)->Release();
-                *client = nullptr;
-                return false;
-            }
-            outputEventCallbackMode_ = true;
-            std::cout << "Output audio client initialized (event callback mode)" << std::endl;
-        } else {
-            outputEventCallbackMode_ = false;
-            std::cout << "Output audio client initialized (polling mode)" << std::endl;
+        if (currentOutputDeviceId_.empty()) {
+            currentOutputDeviceId_ = backend_->GetOpenOutputDevice();
         }
     }
     
-    return true;
-}
-
-bool AudioEngine::SetupFormat(IAudioClient* client, const AudioFormat& format) {
-    WAVEFORMATEX* waveFormat = CreateWaveFormat(format);
-    if (!waveFormat) {
-        std::cerr << "Failed to create wave format" << std::endl;
-        return false;
+    // The chain runs at whatever the devices actually opened with
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        currentFormat_ = actual;
     }
     
-    // Calculate buffer duration in 100-nanosecond units
-    REFERENCE_TIME bufferDuration = (REFERENCE_TIME)((double)format.bufferSize / format.sampleRate * 10000000.0);
-    
-    HRESULT hr = client->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-        bufferDuration,
-        0,
-        waveFormat,
-        nullptr
-    );
+    std::cout << "Audio engine starting with " << backend_->GetName() << ": " << actual.sampleRate << " Hz, "
+              << actual.channels << " ch, " << actual.bitsPerSample << " bits, "
+              << actual.bufferSize << " sample buffer (up to " << backend_->GetMaxFrames() << " per callback)" << std::endl;
     
-    CoTaskMemFree(waveFormat);
-    
-    if (FAILED(hr)) {
-        std::cerr << "Failed to initialize audio client: 0x" << std::hex << hr << std::endl;
-        if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
-            std::cerr << "Format not supported by device" << std::endl;
-        } else if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-            std::cerr << "Device is already in use" << std::endl;
-        } else if (hr == E_INVALIDARG) {
-            std::cerr << "Invalid argument in Initialize" << std::endl;
-        }
+    // Buses stand in for device channels from here on
+    arena_.Reset();
+    ConfigureChannelMap(actual);
+    AudioFormat buses = actual;
+    buses.channels = busCount_;
+    if (!ConfigureAdapter(buses)) {
+        backend_->Close();
         return false;
     }
     
-    // Set event handle
-    hr = client->SetEventHandle(audioEvent_);
-    if (FAILED(hr)) {
-        std::cerr << "Failed to set event handle: 0x" << std::hex << hr << std::endl;
+    interleavedSize_ = static_cast<size_t>(std::max(backend_->GetMaxFrames(), actual.bufferSize)) * busCount_;
+    inputBuffer_ = arena_.Allocate<float>(interleavedSize_);
+    outputBuffer_ = arena_.Allocate<float>(interleavedSize_);
+    std::cout << "Preallocated " << (arena_.GetBytesUsed() + 1023) / 1024 << " KB for the audio thread" << std::endl;
+    
+    streamSampleRate_ = actual.sampleRate;
+    intervalStart_ = MonotonicNanos();
+    busyNanos_ = 0;
+    lastCallbackNanos_ = 0;
+    streamStart_.store(intervalStart_);
+    
+    backend_->SetXrunHandler([this](GlitchType type, uint32_t frames) {
+        RecordGlitch(type, frames, lastCallbackNanos_);
+    });
+    if (!backend_->Start([this](float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+            ProcessBlock(inputs, outputs, channels, frames);
+        })) {
+        std::cerr << "Failed to start audio stream" << std::endl;
+        backend_->Close();
         return false;
     }
     
+    isRunning_.store(true);
     return true;
 }
 
-WAVEFORMATEX* AudioEngine::CreateWaveFormat(const AudioFormat& format) {
-    // Use WAVEFORMATEXTENSIBLE for proper float format support
-    WAVEFORMATEXTENSIBLE* waveFormatEx = (WAVEFORMATEXTENSIBLE*)CoTaskMemAlloc(sizeof(WAVEFORMATEXTENSIBLE));
-    if (!waveFormatEx) {
-        return nullptr;
+bool AudioEngine::Stop() {
+    if (!isRunning_.load()) {
+        return true;
     }
     
-    memset(waveFormatEx, 0, sizeof(WAVEFORMATEXTENSIBLE));
-    
-    waveFormatEx->Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
-    waveFormatEx->Format.nChannels = format.channels;
-    waveFormatEx->Format.nSamplesPerSec = format.sampleRate;
-    waveFormatEx->Format.wBitsPerSample = format.bitsPerSample;
-    waveFormatEx->Format.nBlockAlign = (format.channels * format.bitsPerSample) / 8;
-    waveFormatEx->Format.nAvgBytesPerSec = format.sampleRate * waveFormatEx->Format.nBlockAlign;
-    waveFormatEx->Format.cbSize = 22; // Size of the extension
+    backend_->Stop();
+    backend_->Close();
     
-    waveFormatEx->Samples.wValidBitsPerSample = format.bitsPerSample;
-    
-    // Set channel mask for stereo (front left + front right)
-    waveFormatEx->dwChannelMask = (format.channels == 2) ? (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT) : 0;
-    
-    // Use IEEE float format for 32-bit, PCM for others
-    if (format.bitsPerSample == 32) {
-        waveFormatEx->SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    isRunning_.store(false);
+    return true;
+}
+
+bool AudioEngine::IsRunning() const {
+    return isRunning_.load();
+}
+
+void AudioEngine::RunCallback(float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+    if (processCallback_) {
+        processCallback_(inputs, outputs, channels, frames);
+    } else if (audioCallback_ && static_cast<size_t>(frames) * channels <= interleavedSize_) {
+        // Interleave for the legacy callback and back
+        pcm::Interleave(inputs, channels, inputBuffer_, frames);
+        audioCallback_(inputBuffer_, outputBuffer_, frames, callbackUserData_);
+        pcm::Deinterleave(outputBuffer_, channels, outputs, frames);
     } else {
-        waveFormatEx->SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            memset(outputs[ch], 0, frames * sizeof(float));
+        }
     }
-    
-    return (WAVEFORMATEX*)waveFormatEx;
 }
 
-void AudioEngine::AudioThreadProc() {
-    // Initialize COM for this thread (required for WASAPI)
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-    bool comInitialized = SUCCEEDED(hr);
+void AudioEngine::AdaptBlock(float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+    uint32_t captured = captureResampler_.Process(inputs, frames, resampledPtrs_);
+    captureFifo_.Write(resampledPtrs_, captured);
     
-    // Start the audio clients
-    if (outputClient_) {
-        hr = outputClient_->Start();
-        if (FAILED(hr)) {
-            std::cerr << "Failed to start output client: 0x" << std::hex << hr << std::endl;
-            if (comInitialized) CoUninitialize();
-            return;
+    while (renderFifo_.GetAvailableFrames() < frames) {
+        size_t read = captureFifo_.Read(blockInputPtrs_, processingBlock_);
+        if (read < processingBlock_) {
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                std::fill(blockInputPtrs_[ch] + read, blockInputPtrs_[ch] + processingBlock_, 0.0f);
+            }
         }
+        RunCallback(blockInputPtrs_, blockOutputPtrs_, channels, processingBlock_);
+        uint32_t rendered = renderResampler_.Process(blockOutputPtrs_, processingBlock_, resampledPtrs_);
+        renderFifo_.Write(resampledPtrs_, rendered);
     }
+    renderFifo_.Read(outputs, frames);
+}
+
+void AudioEngine::ProcessBlock(float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+    uint64_t callbackStart = MonotonicNanos();
     
-    if (inputClient_) {
-        hr = inputClient_->Start();
-        if (FAILED(hr)) {
-            std::cerr << "Warning: Failed to start input client: 0x" << std::hex << hr << std::endl;
-            // Continue without input
+    float** busInputs = inputs;
+    float** busOutputs = outputs;
+    uint32_t buses = channels;
+    if (mapping_) {
+        // Inputs are only read, so buses can share device channels
+        for (uint32_t bus = 0; bus < busCount_; ++bus) {
+            int32_t source = busInputMap_[bus];
+            busInputPtrs_[bus] = source >= 0 ? inputs[source] : silentRow_;
         }
+        busInputs = busInputPtrs_;
+        busOutputs = busOutputPtrs_;
+        buses = busCount_;
     }
     
-    auto startTime = std::chrono::high_resolution_clock::now();
+    if (adapting_) {
+        AdaptBlock(busInputs, busOutputs, buses, frames);
+    } else {
+        RunCallback(busInputs, busOutputs, buses, frames);
+    }
     
-    while (!shouldStop_.load()) {
-        // Handle different modes: event callback vs polling
-        if (outputEventCallbackMode_) {
-            // Event callback mode: wait for audio event
-            DWORD waitResult = WaitForSingleObject(audioEvent_, 1000); // 1 second timeout
-            
-            if (waitResult != WAIT_OBJECT_0) {
-                if (waitResult == WAIT_TIMEOUT) {
-                    continue;
-                } else {
-                    break; // Error occurred
-                }
-            }
-        } else {
-            // Polling mode: sleep for a short period and check buffers
-            Sleep(5); // 5ms sleep for polling mode
-        }
-        
-        if (shouldStop_.load()) {
-            break;
-        }
-        
-        // Process audio
-        if (renderClient_ && audioCallback_) {
-            static bool firstCallback = true;
-            if (firstCallback) {
-                std::cout << "Audio processing callbacks started" << std::endl;
-                firstCallback = false;
+    if (mapping_) {
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            int32_t bus = ch < deviceChannels_ ? busOutputMap_[ch] : -1;
+            if (bus >= 0) {
+                memcpy(outputs[ch], busOutputPtrs_[bus], frames * sizeof(float));
+            } else {
+                memset(outputs[ch], 0, frames * sizeof(float));
             }
-            
-            UINT32 bufferFrameCount;
-            if (SUCCEEDED(outputClient_->GetBufferSize(&bufferFrameCount))) {
-                UINT32 numFramesPadding;
-                if (SUCCEEDED(outputClient_->GetCurrentPadding(&numFramesPadding))) {
-                    UINT32 numFramesAvailable = bufferFrameCount - numFramesPadding;
-                    
-                    if (numFramesAvailable > 0) {
-                        BYTE* outputData;
-                        if (SUCCEEDED(renderClient_->GetBuffer(numFramesAvailable, &outputData))) {
-                            // Prepare buffers
-                            inputBuffer_.resize(numFramesAvailable * currentFormat_.channels);
-                            outputBuffer_.resize(numFramesAvailable * currentFormat_.channels);
-                            
-                            // Capture audio input from microphone if available
-                            bool capturedInput = false;
-                            if (captureClient_) {
-                                UINT32 packetLength = 0;
-                                HRESULT hr = captureClient_->GetNextPacketSize(&packetLength);
-                                
-                                // Check for available packets (polling mode)
-                                if (SUCCEEDED(hr) && packetLength > 0) {
-                                    BYTE* inputData;
-                                    UINT32 framesAvailable;
-                                    DWORD flags;
-                                    
-                                    HRESULT captureHr = captureClient_->GetBuffer(&inputData, &framesAvailable, &flags, nullptr, nullptr);
-                                    
-                                    if (SUCCEEDED(captureHr) && framesAvailable > 0) {
-                                        // Copy captured audio to input buffer
-                                        UINT32 framesToCopy = std::min(framesAvailable, numFramesAvailable);
-                                        
-                                        if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
-                                            // Silence - fill with zeros
-                                            std::fill(inputBuffer_.begin(), inputBuffer_.end(), 0.0f);
-                                        } else {
-                                            // Copy audio data (assuming 32-bit float format)
-                                            if (actualInputFormat_.bitsPerSample == 32) {
-                                                memcpy(inputBuffer_.data(), inputData, framesToCopy * actualInputFormat_.channels * sizeof(float));
-                                            } else {
-                                                // TODO: Implement conversion from other formats
-                                                std::fill(inputBuffer_.begin(), inputBuffer_.end(), 0.0f);
-                                            }
-                                            
-                                            // If captured frames < needed frames, zero the rest
-                                            if (framesToCopy < numFramesAvailable) {
-                                                std::fill(inputBuffer_.begin() + (framesToCopy * actualInputFormat_.channels),
-                                                         inputBuffer_.end(), 0.0f);
-                                            }
-                                        }
-                                        
-                                        captureClient_->ReleaseBuffer(framesAvailable);
-                                        capturedInput = true;
-                                        
-                                        // Log successful captures occasionally
-                                        static int successCount = 0;
-                                        successCount++;
-                                        if (successCount == 1) {
-                                            std::cout << "SUCCESS: Microphone input is working in polling mode" << std::endl;
-                                        }
-                                    }
-                                }
-                            }
-                            
-                            // If no input captured, use silence instead of test tone
-                            if (!capturedInput) {
-                                // Fill input buffer with silence
-                                std::fill(inputBuffer_.begin(), inputBuffer_.end(), 0.0f);
-                                
-                                // Log silence usage (reduced frequency)
-                                static int silenceCounter = 0;
-                                silenceCounter++;
-                                if (silenceCounter == 1) {
-                                    std::cout << "INFO: Using silence when microphone data not available" << std::endl;
-                                }
-                            }
-                            
-                            // Call user callback to process audio
-                            audioCallback_(inputBuffer_.data(), outputBuffer_.data(), numFramesAvailable, callbackUserData_);
-                            
-                            // Convert float to target format and copy to WASAPI buffer
-                            if (currentFormat_.bitsPerSample == 32) {
-                                // 32-bit float
-                                memcpy(outputData, outputBuffer_.data(), numFramesAvailable * currentFormat_.channels * sizeof(float));
-                            } else {
-                                // TODO: Implement 16-bit and 24-bit conversions
-                                memset(outputData, 0, numFramesAvailable * currentFormat_.channels * (currentFormat_.bitsPerSample / 8));
-                            }
-                            
-                            renderClient_->ReleaseBuffer(numFramesAvailable, 0);
-                        }
-                    }
-                }
-            }
-        }
-        
-        // Update CPU usage periodically
-        auto now = std::chrono::high_resolution_clock::now();
-        auto elapsed = std::chrono::duration<double>(now - startTime).count();
-        if (elapsed >= CPU_MEASUREMENT_INTERVAL) {
-            // Simple CPU usage calculation (this is a placeholder)
-            cpuUsage_.store(5.0); // TODO: Implement actual CPU measurement
-            startTime = now;
         }
     }
     
-    // Stop the audio clients
-    if (inputClient_) {
-        inputClient_->Stop();
-    }
+    uint64_t now = MonotonicNanos();
+    uint64_t callbackTime = now - callbackStart;
     
-    if (outputClient_) {
-        outputClient_->Stop();
+    callbackTiming_.Record(callbackTime);
+    busyNanos_ += callbackTime;
+    lastCallbackNanos_ = callbackTime;
+    double deadline = static_cast<double>(frames) * 1e9 / streamSampleRate_;
+    if (callbackTime > deadline) {
+        RecordGlitch(GlitchType::CallbackOverrun, frames, callbackTime);
     }
     
-    // Uninitialize COM for this thread
-    if (comInitialized) {
-        CoUninitialize();
+    // DSP load is callback time over wall time, averaged per interval
+    double elapsed = (now - intervalStart_) / 1e9;
+    if (elapsed >= CPU_MEASUREMENT_INTERVAL) {
+        cpuUsage_.store(busyNanos_ / 1e9 / elapsed * 100.0);
+        intervalStart_ = now;
+        busyNanos_ = 0;
     }
 }
 
+void AudioEngine::RecordGlitch(GlitchType type, uint32_t frames, uint64_t callbackNanos) {
+    GlitchEvent event;
+    event.timeNanos = MonotonicNanos();
+    event.type = type;
+    event.frames = frames;
+    event.callbackNanos = callbackNanos;
+    event.deadlineNanos = streamSampleRate_ ? static_cast<uint64_t>(frames) * 1000000000ull / streamSampleRate_ : 0;
+    if (glitchContextSource_) {
+        event.context = glitchContextSource_();
+    }
+    glitchLog_.Record(event);
+    dropoutCount_.fetch_add(1);
+}
+
 void AudioEngine::SetAudioCallback(AudioCallback callback, void* userData) {
     audioCallback_ = callback;
     callbackUserData_ = userData;
 }
 
+void AudioEngine::SetProcessCallback(AudioProcessCallback callback) {
+    processCallback_ = std::move(callback);
+}
+
 double AudioEngine::GetCpuUsage() const {
     return cpuUsage_.load();
 }
 
 double AudioEngine::GetLatency() const {
-    if (!outputClient_) {
+    if (!backend_ || !isRunning_.load()) {
         return 0.0;
     }
-    
-    REFERENCE_TIME latency;
-    if (SUCCEEDED(outputClient_->GetStreamLatency(&latency))) {
-        return latency / 10000.0; // Convert to milliseconds
+    double latency = backend_->GetLatency();
+    if (adapting_) {
+        // Both filters' delay and the block the callback can run ahead
+        latency += (captureResampler_.GetLatency() + processingBlock_) * 1000.0 / captureResampler_.GetOutputRate() +
+                   renderResampler_.GetLatency() * 1000.0 / renderResampler_.GetOutputRate();
     }
-    
-    return 0.0;
+    uint32_t processingRate = adapting_ ? captureResampler_.GetOutputRate() : streamSampleRate_;
+    if (processingLatencySource_ && processingRate > 0) {
+        latency += processingLatencySource_() * 1000.0 / processingRate;
+    }
+    return latency;
 }
 
 uint32_t AudioEngine::GetDropouts() const {
     return dropoutCount_.load();
 }
 
-bool AudioEngine::SetMasterVolume(float volume) {
-    if (!volumeControl_) {
-        return false;
+std::vector<GlitchEvent> AudioEngine::GetRecentGlitches(uint32_t count) const {
+    return glitchLog_.GetRecent(count);
+}
+
+std::string AudioEngine::DumpGlitches(uint32_t count) const {
+    return FormatGlitches(glitchLog_.GetRecent(count), streamStart_.load());
+}
+
+DriftStatus AudioEngine::GetDriftStatus() const {
+    if (!backend_ || !isRunning_.load()) {
+        return DriftStatus();
     }
-    
-    volume = std::max(0.0f, std::min(1.0f, volume));
-    return SUCCEEDED(volumeControl_->SetMasterVolume(volume, nullptr));
+    return backend_->GetDriftStatus();
+}
+
+void AudioEngine::ResetStats() {
+    cpuUsage_.store(0.0);
+    dropoutCount_.store(0);
+    callbackTiming_.Reset();
+    glitchLog_.Reset();
+}
+
+bool AudioEngine::SetMasterVolume(float volume) {
+    return backend_ ? backend_->SetMasterVolume(volume) : false;
 }
 
 float AudioEngine::GetMasterVolume() const {
-    if (!volumeControl_) {
-        return 1.0f;
-    }
-    
-    float volume = 1.0f;
-    volumeControl_->GetMasterVolume(&volume);
-    return volume;
+    return backend_ ? backend_->GetMasterVolume() : 1.0f;
 }
 
 bool AudioEngine::SetMuted(bool muted) {
-    if (!volumeControl_) {
-        return false;
-    }
-    
-    return SUCCEEDED(volumeControl_->SetMute(muted, nullptr));
+    return backend_ ? backend_->SetMuted(muted) : false;
 }
 
 bool AudioEngine::IsMuted() const {
-    if (!volumeControl_) {
-        return false;
-    }
-    
-    BOOL muted = FALSE;
-    volumeControl_->GetMute(&muted);
-    return muted != FALSE;
+    return backend_ ? backend_->IsMuted() : false;
+}
+
+void AudioEngine::SetOutputDither(bool enabled) {
+    outputDither_ = enabled;
 }
 
-} // namespace violet
\ No newline at end of file
+} // namespace violet
@@ -1,9 +1,12 @@
 #include "violet/audio_processing_chain.h"
-#include "violet/audio_engine.h"
+#include "violet/realtime_log.h"
+#include "violet/realtime_thread.h"
 #include "violet/utils.h"
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <cmath>
 
 namespace violet {
@@ -13,7 +16,24 @@ ProcessingNode::ProcessingNode(std::unique_ptr<PluginInstance> plugin, uint32_t
     : plugin_(std::move(plugin))
     , channels_(channels)
     , blockSize_(blockSize)
-    , bypassed_(false) {
+    , routingDirect_(false)
+    , inPlaceSafe_(false)
+    , bytesCopied_(0)
+    , subnormalSamples_(0)
+    , subnormalBlocks_(0)
+    , latency_(0)
+    , bypassed_(false)
+    , automation_(nullptr)
+    , automationHazard_(nullptr)
+    , automationVersion_(0)
+    , automationGranularity_(DEFAULT_AUTOMATION_GRANULARITY)
+    , samplePosition_(0)
+    , cursorVersion_(0)
+    , automationCursor_(0)
+    , transferRatio_(1.0)
+    , transferPending_(false) {
+    
+    timedChanges_.reserve(MAX_TIMED_CHANGES);
     
     if (plugin_) {
         const auto& info = plugin_->GetInfo();
@@ -28,7 +48,6 @@ ProcessingNode::ProcessingNode(std::unique_ptr<PluginInstance> plugin, uint32_t
         
         // Initialize control values - allocate for ALL control inputs
         controlValues_.resize(info.controlInputs, 0.0f);
-        parameterChanged_.resize(info.controlInputs, false);
         
         // Set default values from parameter info
         auto parameters = plugin_->GetParameters();
@@ -37,19 +56,39 @@ ProcessingNode::ProcessingNode(std::unique_ptr<PluginInstance> plugin, uint32_t
         }
     }
     
+    parameterShadow_.reset(new std::atomic<float>[controlValues_.size()]);
+    for (size_t i = 0; i < controlValues_.size(); ++i) {
+        parameterShadow_[i].store(controlValues_[i]);
+    }
+    
     AllocateBuffers();
     ConnectPorts();
+    UpdateConnectionMode();
     
     // Activate plugin immediately after connecting ports
     // This is required by LV2 spec: all ports must be connected before activation
     if (plugin_) {
         std::cout << "Activating plugin in ProcessingNode constructor: " << plugin_->GetInfo().name << std::endl;
         plugin_->Activate();
+        ProbeLatency();
     }
 }
 
 ProcessingNode::~ProcessingNode() {
     Deactivate();
+    delete automation_.load();
+}
+
+void ProcessingNode::RecordSubnormals(uint32_t samples) {
+    if (samples > 0) {
+        subnormalSamples_.fetch_add(samples, std::memory_order_relaxed);
+        subnormalBlocks_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ProcessingNode::ResetSubnormals() {
+    subnormalSamples_.store(0, std::memory_order_relaxed);
+    subnormalBlocks_.store(0, std::memory_order_relaxed);
 }
 
 void ProcessingNode::AllocateBuffers() {
@@ -82,9 +121,9 @@ void ProcessingNode::AllocateBuffers() {
         }
     }
     
-    // Allocate dummy buffers for control output ports (monitor ports)
-    controlOutputDummy_.resize(info.controlOutputs, 0.0f);
-    std::cout << "Allocated " << info.controlOutputs << " dummy control output ports" << std::endl;
+    // Control output ports: monitors and meters, and the latency report
+    controlOutputValues_.resize(info.controlOutputs, 0.0f);
+    std::cout << "Allocated " << info.controlOutputs << " control output ports" << std::endl;
 }
 
 void ProcessingNode::ConnectPorts() {
@@ -92,15 +131,10 @@ void ProcessingNode::ConnectPorts() {
     
     const auto& info = plugin_->GetInfo();
     
-    // Connect audio input ports
-    for (uint32_t i = 0; i < info.audioInputs && i < inputPtrs_.size(); ++i) {
-        plugin_->ConnectAudioInput(i, inputPtrs_[i]);
-    }
-    
-    // Connect audio output ports
-    for (uint32_t i = 0; i < info.audioOutputs && i < outputPtrs_.size(); ++i) {
-        plugin_->ConnectAudioOutput(i, outputPtrs_[i]);
-    }
+    // Connect audio ports to the private buffers until Process() decides otherwise
+    connectedInputs_.assign(info.audioInputs, nullptr);
+    connectedOutputs_.assign(info.audioOutputs, nullptr);
+    ConnectPrivateBuffers();
     
     // Connect ALL control input ports
     for (uint32_t i = 0; i < info.controlInputs; ++i) {
@@ -109,9 +143,133 @@ void ProcessingNode::ConnectPorts() {
         }
     }
     
-    // Connect control output ports (monitor/meter ports) to dummy buffers
-    for (uint32_t i = 0; i < info.controlOutputs && i < controlOutputDummy_.size(); ++i) {
-        plugin_->ConnectControlOutput(i, &controlOutputDummy_[i]);
+    // Connect control output ports (monitor/meter ports and latency)
+    for (uint32_t i = 0; i < info.controlOutputs && i < controlOutputValues_.size(); ++i) {
+        plugin_->ConnectControlOutput(i, &controlOutputValues_[i]);
+    }
+}
+
+void ProcessingNode::ReadLatency() {
+    int32_t output = plugin_->GetLatencyOutput();
+    if (output < 0 || static_cast<size_t>(output) >= controlOutputValues_.size()) {
+        return;
+    }
+    
+    // NaN and negative reports count as no latency
+    float frames = controlOutputValues_[output];
+    latency_.store(frames > 0.0f ? static_cast<uint32_t>(std::lround(std::min(frames, 1e9f))) : 0);
+}
+
+void ProcessingNode::ProbeLatency() {
+    // The latency port is only written by run(), so run one block of
+    // silence through the private buffers and restart the plugin to forget it
+    if (plugin_->GetLatencyOutput() < 0 || !plugin_->IsActive()) {
+        return;
+    }
+    
+    plugin_->Process(blockSize_);
+    ReadLatency();
+    plugin_->Deactivate();
+    plugin_->Activate();
+    for (auto& buffer : outputBuffers_) {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+    }
+    std::cout << "Plugin " << plugin_->GetInfo().name << " reports " << latency_.load() << " frames latency" << std::endl;
+}
+
+uint32_t ProcessingNode::GetLatency() const {
+    if (!plugin_ || bypassed_.load() || !IsActive()) {
+        return 0;
+    }
+    return latency_.load();
+}
+
+void ProcessingNode::UpdateConnectionMode() {
+    channelWritten_.assign(channels_, 0);
+    for (uint32_t ch : outputChannels_) {
+        if (ch < channels_) {
+            channelWritten_[ch] = 1;
+        }
+    }
+    
+    routingDirect_ = false;
+    inPlaceSafe_ = false;
+    if (!plugin_) return;
+    
+    const auto& info = plugin_->GetInfo();
+    
+    // Every audio port needs a chain channel, and no two outputs may share one
+    if (inputChannels_.size() < info.audioInputs || outputChannels_.size() < info.audioOutputs) {
+        return;
+    }
+    for (uint32_t i = 0; i < info.audioInputs; ++i) {
+        if (inputChannels_[i] >= channels_) return;
+    }
+    for (uint32_t i = 0; i < info.audioOutputs; ++i) {
+        if (outputChannels_[i] >= channels_) return;
+        for (uint32_t j = 0; j < i; ++j) {
+            if (outputChannels_[j] == outputChannels_[i]) return;
+        }
+    }
+    routingDirect_ = true;
+    
+    // Running in place is only safe when each output aliases at most its own
+    // input (no remapping) and the plugin doesn't declare lv2:inPlaceBroken
+    if (info.inPlaceBroken) return;
+    for (uint32_t o = 0; o < info.audioOutputs; ++o) {
+        for (uint32_t i = 0; i < info.audioInputs; ++i) {
+            if (i != o && inputChannels_[i] == outputChannels_[o]) return;
+        }
+    }
+    inPlaceSafe_ = true;
+}
+
+void ProcessingNode::ConnectAudioPorts(float** inputBuffers, float** outputBuffers, uint32_t offset) {
+    // Only call into the plugin when a port actually moves
+    for (uint32_t i = 0; i < connectedInputs_.size(); ++i) {
+        float* buffer = inputBuffers[inputChannels_[i]] + offset;
+        if (connectedInputs_[i] != buffer) {
+            plugin_->ConnectAudioInput(i, buffer);
+            connectedInputs_[i] = buffer;
+        }
+    }
+    
+    for (uint32_t i = 0; i < connectedOutputs_.size(); ++i) {
+        float* buffer = outputBuffers[outputChannels_[i]] + offset;
+        if (connectedOutputs_[i] != buffer) {
+            plugin_->ConnectAudioOutput(i, buffer);
+            connectedOutputs_[i] = buffer;
+        }
+    }
+}
+
+void ProcessingNode::ConnectPrivateBuffers() {
+    for (uint32_t i = 0; i < connectedInputs_.size() && i < inputPtrs_.size(); ++i) {
+        if (connectedInputs_[i] != inputPtrs_[i]) {
+            plugin_->ConnectAudioInput(i, inputPtrs_[i]);
+            connectedInputs_[i] = inputPtrs_[i];
+        }
+    }
+    
+    for (uint32_t i = 0; i < connectedOutputs_.size() && i < outputPtrs_.size(); ++i) {
+        if (connectedOutputs_[i] != outputPtrs_[i]) {
+            plugin_->ConnectAudioOutput(i, outputPtrs_[i]);
+            connectedOutputs_[i] = outputPtrs_[i];
+        }
+    }
+}
+
+void ProcessingNode::CopyUnroutedChannels(float** inputBuffers, float** outputBuffers, uint32_t frames) {
+    // Channels no output port writes to pass straight through
+    if (!inputBuffers || !outputBuffers || inputBuffers == outputBuffers) {
+        return;
+    }
+    
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+        if (!channelWritten_[ch] && inputBuffers[ch] && outputBuffers[ch] && inputBuffers[ch] != outputBuffers[ch]) {
+            memcpy(outputBuffers[ch], inputBuffers[ch], frames * sizeof(float));
+            bytesCopied_ += frames * sizeof(float);
+        }
     }
 }
 
@@ -133,67 +291,115 @@ void ProcessingNode::Deactivate() {
 }
 
 void ProcessingNode::Process(float** inputBuffers, float** outputBuffers, uint32_t frames) {
+    bytesCopied_ = 0;
+    
+    const AutomationTimeline* timeline = AcquireAutomation();
+    uint64_t position = samplePosition_.load();
+    
     if (!plugin_ || bypassed_.load() || !IsActive()) {
+        // Keep automation running so values are current when the node resumes
+        for (uint32_t framesDone = 0; framesDone < frames; ) {
+            framesDone += ApplyScheduledChanges(timeline, position + framesDone, frames - framesDone);
+        }
+        samplePosition_.store(position + frames);
+        ReleaseAutomation();
+        
         // Bypass: copy input to output
         for (uint32_t ch = 0; ch < std::min(inputChannels_.size(), outputChannels_.size()); ++ch) {
             if (inputChannels_[ch] < channels_ && outputChannels_[ch] < channels_) {
-                if (inputBuffers && outputBuffers && inputBuffers[inputChannels_[ch]] && outputBuffers[outputChannels_[ch]]) {
+                if (inputBuffers && outputBuffers && inputBuffers[inputChannels_[ch]] && outputBuffers[outputChannels_[ch]] &&
+                    inputBuffers[inputChannels_[ch]] != outputBuffers[outputChannels_[ch]]) {
                     memcpy(outputBuffers[outputChannels_[ch]], 
                            inputBuffers[inputChannels_[ch]], 
                            frames * sizeof(float));
+                    bytesCopied_ += frames * sizeof(float);
                 }
             }
         }
+        CopyUnroutedChannels(inputBuffers, outputBuffers, frames);
         return;
     }
     
     const auto& info = plugin_->GetInfo();
     
-    // Process in chunks if frames exceeds blockSize
+    // Connect ports straight to the chain's buffers when routing allows it.
+    // Separate input/output buffer sets never alias, so only in-place
+    // processing needs the plugin to be in-place safe.
+    bool direct = routingDirect_ && inputBuffers && outputBuffers &&
+                  (inPlaceSafe_ || inputBuffers != outputBuffers);
+    if (direct) {
+        CopyUnroutedChannels(inputBuffers, outputBuffers, frames);
+    } else {
+        ConnectPrivateBuffers();
+    }
+    
+    // Process in chunks of at most blockSize, split further at automation
+    // points and timed parameter changes
     uint32_t framesProcessed = 0;
     while (framesProcessed < frames) {
-        uint32_t framesToProcess = std::min(frames - framesProcessed, blockSize_);
-        
-        // Copy input data to plugin input buffers with validation
-        for (uint32_t i = 0; i < info.audioInputs && i < inputChannels_.size() && i < inputPtrs_.size(); ++i) {
-            if (!inputPtrs_[i]) {
-                std::cerr << "Error: inputPtrs_[" << i << "] is NULL!" << std::endl;
-                continue;
-            }
-            
-            uint32_t srcChannel = inputChannels_[i];
-            if (srcChannel < channels_ && inputBuffers && inputBuffers[srcChannel]) {
-                memcpy(inputPtrs_[i], inputBuffers[srcChannel] + framesProcessed, framesToProcess * sizeof(float));
-            } else {
-                // No input available, clear buffer
-                memset(inputPtrs_[i], 0, framesToProcess * sizeof(float));
+        uint32_t chunk = std::min(frames - framesProcessed, blockSize_);
+        uint32_t framesToProcess = chunk;
+        if (plugin_->HasFixedBlockLength()) {
+            // Splitting would break the plugin's fixed block length, so
+            // automation inside the block lands on its start instead
+            for (uint32_t framesDone = 0; framesDone < chunk; ) {
+                framesDone += ApplyScheduledChanges(timeline, position + framesProcessed + framesDone,
+                                                    chunk - framesDone);
             }
+        } else {
+            framesToProcess = ApplyScheduledChanges(timeline, position + framesProcessed, chunk);
         }
         
-        // Process parameter changes
-        ProcessParameterChanges();
-        
-        // Process automation
-        ProcessAutomation(framesProcessed, framesToProcess);
+        if (direct) {
+            ConnectAudioPorts(inputBuffers, outputBuffers, framesProcessed);
+        } else {
+            // Copy input data to plugin input buffers with validation
+            for (uint32_t i = 0; i < info.audioInputs && i < inputChannels_.size() && i < inputPtrs_.size(); ++i) {
+                if (!inputPtrs_[i]) {
+                    LogRealtime(LogLevel::Error, "Error: inputPtrs_[{}] is NULL!", i);
+                    continue;
+                }
+                
+                uint32_t srcChannel = inputChannels_[i];
+                if (srcChannel < channels_ && inputBuffers && inputBuffers[srcChannel]) {
+                    memcpy(inputPtrs_[i], inputBuffers[srcChannel] + framesProcessed, framesToProcess * sizeof(float));
+                    bytesCopied_ += framesToProcess * sizeof(float);
+                } else {
+                    // No input available, clear buffer
+                    memset(inputPtrs_[i], 0, framesToProcess * sizeof(float));
+                }
+            }
+        }
         
         // Run the plugin
         plugin_->Process(framesToProcess);
         
-        // Copy output data from plugin output buffers with validation
-        for (uint32_t i = 0; i < info.audioOutputs && i < outputChannels_.size() && i < outputPtrs_.size(); ++i) {
-            if (!outputPtrs_[i]) {
-                std::cerr << "Error: outputPtrs_[" << i << "] is NULL!" << std::endl;
-                continue;
-            }
-            
-            uint32_t dstChannel = outputChannels_[i];
-            if (dstChannel < channels_ && outputBuffers && outputBuffers[dstChannel]) {
-                memcpy(outputBuffers[dstChannel] + framesProcessed, outputPtrs_[i], framesToProcess * sizeof(float));
+        if (!direct) {
+            // Copy output data from plugin output buffers with validation
+            for (uint32_t i = 0; i < info.audioOutputs && i < outputChannels_.size() && i < outputPtrs_.size(); ++i) {
+                if (!outputPtrs_[i]) {
+                    LogRealtime(LogLevel::Error, "Error: outputPtrs_[{}] is NULL!", i);
+                    continue;
+                }
+                
+                uint32_t dstChannel = outputChannels_[i];
+                if (dstChannel < channels_ && outputBuffers && outputBuffers[dstChannel]) {
+                    memcpy(outputBuffers[dstChannel] + framesProcessed, outputPtrs_[i], framesToProcess * sizeof(float));
+                    bytesCopied_ += framesToProcess * sizeof(float);
+                }
             }
         }
         
         framesProcessed += framesToProcess;
     }
+    
+    if (!direct) {
+        CopyUnroutedChannels(inputBuffers, outputBuffers, frames);
+    }
+    ReadLatency();
+    
+    samplePosition_.store(position + frames);
+    ReleaseAutomation();
 }
 
 void ProcessingNode::ProcessMidi(MidiBuffer* midiBuffer, uint32_t frames) {
@@ -201,38 +407,7 @@ void ProcessingNode::ProcessMidi(MidiBuffer* midiBuffer, uint32_t frames) {
     // This would involve converting MidiBuffer to LV2 Atom format
 }
 
-void ProcessingNode::ProcessParameterChanges() {
-    for (size_t i = 0; i < parameterChanged_.size(); ++i) {
-        if (parameterChanged_[i]) {
-            plugin_->SetParameter(static_cast<uint32_t>(i), controlValues_[i]);
-            parameterChanged_[i] = false;
-        }
-    }
-}
-
-void ProcessingNode::ProcessAutomation(uint32_t currentSample, uint32_t frames) {
-    std::lock_guard<std::mutex> lock(automationMutex_);
-    
-    // Process automation points within the current frame range
-    for (const auto& point : automationPoints_) {
-        if (point.sampleTime >= currentSample && point.sampleTime < currentSample + frames) {
-            if (point.parameterIndex < controlValues_.size()) {
-                controlValues_[point.parameterIndex] = point.value;
-                parameterChanged_[point.parameterIndex] = true;
-            }
-        }
-    }
-    
-    // Remove processed automation points
-    automationPoints_.erase(
-        std::remove_if(automationPoints_.begin(), automationPoints_.end(),
-                      [currentSample, frames](const AutomationPoint& point) {
-                          return point.sampleTime < currentSample + frames;
-                      }),
-        automationPoints_.end());
-}
-
-void ProcessingNode::SetParameter(uint32_t parameterIndex, float value) {
+bool ProcessingNode::NormalizeParameter(uint32_t& parameterIndex, float& value) const {
     if (plugin_) {
         auto parameters = plugin_->GetParameters();
 
@@ -244,7 +419,7 @@ void ProcessingNode::SetParameter(uint32_t parameterIndex, float value) {
             if (fallback != parameters.end()) {
                 parameterIndex = fallback->index;
             } else {
-                return;
+                return false;
             }
         }
 
@@ -257,26 +432,45 @@ void ProcessingNode::SetParameter(uint32_t parameterIndex, float value) {
                 break;
             }
         }
-    } else if (parameterIndex >= controlValues_.size()) {
-        return;
     }
 
+    return parameterIndex < controlValues_.size();
+}
+
+void ProcessingNode::ApplyParameter(uint32_t parameterIndex, float value) {
+    // The control port reads controlValues_ directly, so this is all it takes
     if (parameterIndex < controlValues_.size()) {
         controlValues_[parameterIndex] = value;
-        parameterChanged_[parameterIndex] = true;
+        parameterShadow_[parameterIndex].store(value);
+    }
+}
+
+void ProcessingNode::ApplyParameterAt(uint32_t sampleOffset, uint32_t parameterIndex, float value) {
+    if (sampleOffset == 0 || timedChanges_.size() >= MAX_TIMED_CHANGES) {
+        ApplyParameter(parameterIndex, value);
+        return;
     }
+    
+    // Timed like automation, in frames processed by this node; changes for
+    // the same frame keep their queue order
+    AutomationPoint change = { samplePosition_.load() + sampleOffset, parameterIndex, value };
+    auto it = std::upper_bound(timedChanges_.begin(), timedChanges_.end(), change.sampleTime,
+                               [](uint64_t time, const AutomationPoint& p) {
+                                   return time < p.sampleTime;
+                               });
+    timedChanges_.insert(it, change);
 }
 
 float ProcessingNode::GetParameter(uint32_t parameterIndex) const {
     if (parameterIndex < controlValues_.size()) {
-        return controlValues_[parameterIndex];
+        return parameterShadow_[parameterIndex].load();
     }
     
     if (plugin_) {
         auto parameters = plugin_->GetParameters();
         for (const auto& param : parameters) {
             if (param.portIndex == parameterIndex && param.index < controlValues_.size()) {
-                return controlValues_[param.index];
+                return parameterShadow_[param.index].load();
             }
         }
     }
@@ -284,53 +478,334 @@ float ProcessingNode::GetParameter(uint32_t parameterIndex) const {
     return 0.0f;
 }
 
+void ProcessingNode::TransferFrom(std::shared_ptr<ProcessingNode> source, double rateRatio) {
+    ProcessingNode& previous = *source;
+    uint32_t parameterCount = std::min(GetParameterCount(), previous.GetParameterCount());
+    for (uint32_t i = 0; i < parameterCount; ++i) {
+        ApplyParameter(i, previous.GetParameter(i));
+    }
+    SetBypassed(previous.IsBypassed());
+    
+    // Default routing depends on the channel count, so only custom routing
+    // for the same width carries over
+    if (previous.channels_ == channels_) {
+        inputChannels_ = previous.inputChannels_;
+        outputChannels_ = previous.outputChannels_;
+        UpdateConnectionMode();
+    }
+    
+    std::lock_guard<std::mutex> lock(previous.automationMutex_);
+    automationGranularity_.store(previous.automationGranularity_.load());
+    samplePosition_.store(static_cast<uint64_t>(std::llround(previous.samplePosition_.load() * rateRatio)));
+    
+    const AutomationTimeline* current = previous.automation_.load();
+    if (current) {
+        auto timeline = std::make_unique<AutomationTimeline>();
+        timeline->points = current->points;
+        for (auto& point : timeline->points) {
+            point.sampleTime = static_cast<uint64_t>(std::llround(point.sampleTime * rateRatio));
+        }
+        std::lock_guard<std::mutex> ownLock(automationMutex_);
+        PublishAutomation(std::move(timeline));
+    }
+    
+    // The audio thread keeps running previous until it picks up the
+    // snapshot with this node; CompleteTransfer() catches up on that gap
+    transferSource_ = std::move(source);
+    transferRatio_ = rateRatio;
+    transferPending_.store(true);
+}
+
+void ProcessingNode::CompleteTransfer() {
+    if (!transferPending_.load()) {
+        return;
+    }
+    // previous may itself have been replaced before it ever ran
+    ProcessingNode& previous = *transferSource_;
+    previous.CompleteTransfer();
+    
+    // previous is no longer processed, so its values are final
+    uint32_t parameterCount = std::min(GetParameterCount(), previous.GetParameterCount());
+    for (uint32_t i = 0; i < parameterCount; ++i) {
+        ApplyParameter(i, previous.controlValues_[i]);
+    }
+    
+    uint64_t position = static_cast<uint64_t>(std::llround(previous.samplePosition_.load() * transferRatio_));
+    samplePosition_.store(position);
+    cursorVersion_ = 0;     // relocate in the automation timeline
+    
+    // Timed changes it hadn't reached yet, same distance ahead
+    timedChanges_.clear();
+    for (const AutomationPoint& change : previous.timedChanges_) {
+        uint64_t ahead = change.sampleTime - std::min(change.sampleTime, previous.samplePosition_.load());
+        timedChanges_.push_back({ position + static_cast<uint64_t>(std::llround(ahead * transferRatio_)),
+                                  change.parameterIndex, change.value });
+    }
+    
+    transferPending_.store(false);
+}
+
+void ProcessingNode::ReleaseTransferSource() {
+    if (transferSource_ && !transferPending_.load()) {
+        transferSource_.reset();
+    }
+}
+
 void ProcessingNode::AddAutomationPoint(const AutomationPoint& point) {
     std::lock_guard<std::mutex> lock(automationMutex_);
-    automationPoints_.push_back(point);
     
-    // Keep automation points sorted by time
-    std::sort(automationPoints_.begin(), automationPoints_.end(),
-             [](const AutomationPoint& a, const AutomationPoint& b) {
-                 return a.sampleTime < b.sampleTime;
-             });
+    auto timeline = std::make_unique<AutomationTimeline>();
+    const AutomationTimeline* current = automation_.load();
+    if (current) {
+        timeline->points.reserve(current->points.size() + 1);
+        timeline->points = current->points;
+    }
+    
+    // Insert after any points at the same time so they keep their order
+    auto it = std::upper_bound(timeline->points.begin(), timeline->points.end(), point.sampleTime,
+                               [](uint64_t time, const AutomationPoint& p) {
+                                   return time < p.sampleTime;
+                               });
+    timeline->points.insert(it, point);
+    
+    PublishAutomation(std::move(timeline));
+}
+
+void ProcessingNode::AddAutomationPoints(std::vector<AutomationPoint> points) {
+    std::lock_guard<std::mutex> lock(automationMutex_);
+    
+    // Sort only the new run, then merge it into the existing timeline
+    auto byTime = [](const AutomationPoint& a, const AutomationPoint& b) {
+        return a.sampleTime < b.sampleTime;
+    };
+    std::stable_sort(points.begin(), points.end(), byTime);
+    
+    auto timeline = std::make_unique<AutomationTimeline>();
+    const AutomationTimeline* current = automation_.load();
+    if (current) {
+        timeline->points.reserve(current->points.size() + points.size());
+        std::merge(current->points.begin(), current->points.end(), points.begin(), points.end(),
+                   std::back_inserter(timeline->points), byTime);
+    } else {
+        timeline->points = std::move(points);
+    }
+    
+    PublishAutomation(std::move(timeline));
+}
+
+void ProcessingNode::SetAutomation(uint32_t parameterIndex, std::vector<AutomationPoint> points) {
+    std::lock_guard<std::mutex> lock(automationMutex_);
+    
+    auto byTime = [](const AutomationPoint& a, const AutomationPoint& b) {
+        return a.sampleTime < b.sampleTime;
+    };
+    for (auto& point : points) {
+        point.parameterIndex = parameterIndex;
+    }
+    std::stable_sort(points.begin(), points.end(), byTime);
+    
+    // The other parameters' points, merged with the new lane
+    std::vector<AutomationPoint> others;
+    const AutomationTimeline* current = automation_.load();
+    if (current) {
+        others.reserve(current->points.size());
+        std::copy_if(current->points.begin(), current->points.end(), std::back_inserter(others),
+                     [parameterIndex](const AutomationPoint& p) { return p.parameterIndex != parameterIndex; });
+    }
+    if (others.empty() && points.empty()) {
+        PublishAutomation(nullptr);
+        return;
+    }
+    
+    auto timeline = std::make_unique<AutomationTimeline>();
+    timeline->points.reserve(others.size() + points.size());
+    std::merge(others.begin(), others.end(), points.begin(), points.end(),
+               std::back_inserter(timeline->points), byTime);
+    
+    PublishAutomation(std::move(timeline));
 }
 
 void ProcessingNode::ClearAutomation() {
     std::lock_guard<std::mutex> lock(automationMutex_);
-    automationPoints_.clear();
+    PublishAutomation(nullptr);
+}
+
+std::vector<ProcessingNode::AutomationPoint> ProcessingNode::GetAutomation() const {
+    std::lock_guard<std::mutex> lock(automationMutex_);
+    const AutomationTimeline* current = automation_.load();
+    return current ? current->points : std::vector<AutomationPoint>();
+}
+
+void ProcessingNode::PublishAutomation(std::unique_ptr<AutomationTimeline> timeline) {
+    if (timeline) {
+        timeline->version = ++automationVersion_;
+    }
+    
+    const AutomationTimeline* previous = automation_.exchange(timeline.release());
+    if (previous) {
+        retiredAutomation_.emplace_back(previous);
+    }
+    
+    // Anything but the timeline the audio thread announced can go now
+    const AutomationTimeline* hazard = automationHazard_.load();
+    retiredAutomation_.erase(
+        std::remove_if(retiredAutomation_.begin(), retiredAutomation_.end(),
+                      [hazard](const std::unique_ptr<const AutomationTimeline>& retired) {
+                          return retired.get() != hazard;
+                      }),
+        retiredAutomation_.end());
+}
+
+const ProcessingNode::AutomationTimeline* ProcessingNode::AcquireAutomation() {
+    // Announce the timeline, then make sure it is still the current one; an
+    // editor that swapped it out in between will see the hazard and keep it
+    const AutomationTimeline* timeline = automation_.load();
+    while (true) {
+        automationHazard_.store(timeline);
+        const AutomationTimeline* current = automation_.load();
+        if (current == timeline) {
+            return timeline;
+        }
+        timeline = current;
+    }
+}
+
+void ProcessingNode::ReleaseAutomation() {
+    automationHazard_.store(nullptr);
+}
+
+uint32_t ProcessingNode::ApplyAutomation(const AutomationTimeline* timeline, uint64_t position, uint32_t maxFrames) {
+    if (!timeline) {
+        cursorVersion_ = 0;
+        return maxFrames;
+    }
+    
+    const auto& points = timeline->points;
+    
+    // A new timeline resumes at the current position; earlier points are skipped
+    if (timeline->version != cursorVersion_) {
+        auto it = std::lower_bound(points.begin(), points.end(), position,
+                                   [](const AutomationPoint& p, uint64_t time) {
+                                       return p.sampleTime < time;
+                                   });
+        automationCursor_ = static_cast<size_t>(it - points.begin());
+        cursorVersion_ = timeline->version;
+    }
+    
+    // Points within the granularity are applied now rather than splitting
+    // off a tiny sub-block for each of them
+    uint64_t applyBefore = position + std::min(automationGranularity_.load(), maxFrames);
+    while (automationCursor_ < points.size() && points[automationCursor_].sampleTime < applyBefore) {
+        const AutomationPoint& point = points[automationCursor_++];
+        ApplyParameter(point.parameterIndex, point.value);
+    }
+    
+    if (automationCursor_ == points.size()) {
+        return maxFrames;
+    }
+    return static_cast<uint32_t>(std::min<uint64_t>(maxFrames, points[automationCursor_].sampleTime - position));
+}
+
+uint32_t ProcessingNode::ApplyTimedChanges(uint64_t position, uint32_t maxFrames) {
+    // Same granularity as automation points; capacity is reserved, so
+    // erasing from the front never allocates
+    uint64_t applyBefore = position + std::min(automationGranularity_.load(), maxFrames);
+    size_t applied = 0;
+    while (applied < timedChanges_.size() && timedChanges_[applied].sampleTime < applyBefore) {
+        ApplyParameter(timedChanges_[applied].parameterIndex, timedChanges_[applied].value);
+        ++applied;
+    }
+    timedChanges_.erase(timedChanges_.begin(), timedChanges_.begin() + applied);
+    
+    if (timedChanges_.empty()) {
+        return maxFrames;
+    }
+    return static_cast<uint32_t>(std::min<uint64_t>(maxFrames, timedChanges_.front().sampleTime - position));
+}
+
+uint32_t ProcessingNode::ApplyScheduledChanges(const AutomationTimeline* timeline, uint64_t position,
+                                               uint32_t maxFrames) {
+    return ApplyTimedChanges(position, ApplyAutomation(timeline, position, maxFrames));
 }
 
 void ProcessingNode::SetInputChannels(const std::vector<uint32_t>& channels) {
     inputChannels_ = channels;
+    UpdateConnectionMode();
 }
 
 void ProcessingNode::SetOutputChannels(const std::vector<uint32_t>& channels) {
     outputChannels_ = channels;
+    UpdateConnectionMode();
 }
 
 // AudioProcessingChain implementation
 AudioProcessingChain::AudioProcessingChain(AudioEngine* audioEngine)
     : audioEngine_(audioEngine)
     , pluginManager_(nullptr)
+    , linearGraph_(true)
+    , snapshot_(nullptr)
+    , globalEpoch_(0)
+    , readerEpoch_(READER_IDLE)
     , sampleRate_(44100)
     , channels_(2)
     , blockSize_(256)
+    , fixedBlockLength_(false)
+    , formatGeneration_(0)
+    , formatBusy_(false)
+    , formatStop_(false)
     , bypassed_(false)
     , enabled_(true)
     , cpuUsage_(0.0)
     , processedFrames_(0)
+    , bytesCopiedPerBlock_(0)
+    , blockCount_(0)
+    , xrunCount_(0)
+    , denormalCheck_(false)
+    , lastSnapshotId_(0)
+    , lastSlowestNodeId_(0)
+    , lastSlowestNodeNanos_(0)
+    , latency_(0)
     , nextNodeId_(1) {
     
     // TODO: Get plugin manager from audio engine or create one
     pluginManager_ = new PluginManager();
     if (pluginManager_) {
+        // The chain only instantiates plugins by URI, so lilv loads just the
+        // bundles a session uses
+        pluginManager_->SetLazyLoading(true);
         pluginManager_->Initialize();
     }
+    
+    // Nodes report errors from the audio thread through the realtime log
+    StartLogThread();
+    
+    // Spawn the workers up front so the audio thread never creates threads
+    threadPool_ = std::make_shared<ProcessingThreadPool>(ProcessingThreadPool::GetDefaultWorkerCount());
+    
+    // Publish an empty snapshot so the audio thread never sees a null chain
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    RebuildLinearGraph();
+    PublishSnapshot();
 }
 
 AudioProcessingChain::~AudioProcessingChain() {
+    // A rebuild in progress finishes its current instantiation, then bails out
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        formatStop_ = true;
+    }
+    if (formatThread_.joinable()) {
+        formatThread_.join();
+    }
+    
     ClearChain();
     
+    // The audio thread is stopped by now, so everything can go
+    delete snapshot_.exchange(nullptr);
+    pendingRetired_.clear();
+    retired_.clear();
+    threadPool_.reset();
+    
     if (pluginManager_) {
         pluginManager_->Shutdown();
         delete pluginManager_;
@@ -342,22 +817,67 @@ uint32_t AudioProcessingChain::AddPlugin(const std::string& pluginUri, uint32_t
         return 0;
     }
     
+    uint32_t sampleRate, channels, blockSize;
+    bool fixedBlockLength;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        sampleRate = sampleRate_;
+        channels = channels_;
+        blockSize = blockSize_;
+        fixedBlockLength = fixedBlockLength_;
+        generation = formatGeneration_;
+    }
+    
     // Create plugin instance
-    auto pluginInstance = pluginManager_->CreatePlugin(pluginUri, sampleRate_, blockSize_);
+    std::unique_ptr<PluginInstance> pluginInstance;
+    {
+        std::lock_guard<std::mutex> lock(instantiateMutex_);
+        pluginInstance = pluginManager_->CreatePlugin(pluginUri, sampleRate, blockSize, fixedBlockLength);
+    }
     if (!pluginInstance) {
         std::cerr << "Failed to create plugin: " << pluginUri << std::endl;
         return 0;
     }
     
     // Create processing node
-    auto node = std::make_unique<ProcessingNode>(std::move(pluginInstance), channels_, blockSize_);
+    auto node = std::make_unique<ProcessingNode>(std::move(pluginInstance), channels, blockSize);
     if (!node->Activate()) {
         std::cerr << "Failed to activate plugin: " << pluginUri << std::endl;
         return 0;
     }
     
+    return InsertNode(std::move(node), position, generation);
+}
+
+uint32_t AudioProcessingChain::AddSumNode(uint32_t position) {
+    uint32_t channels, blockSize;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        channels = channels_;
+        blockSize = blockSize_;
+        generation = formatGeneration_;
+    }
+    
+    // A node without a plugin passes its (summed) inputs straight through
+    return InsertNode(std::make_unique<ProcessingNode>(nullptr, channels, blockSize), position, generation);
+}
+
+uint32_t AudioProcessingChain::InsertNode(std::unique_ptr<ProcessingNode> node, uint32_t position,
+                                          uint64_t formatGeneration) {
     std::lock_guard<std::mutex> lock(nodesMutex_);
     
+    CollectRetiredLocked();
+    
+    // The format changed while the node was being created; have it rebuilt
+    {
+        std::lock_guard<std::mutex> formatLock(formatMutex_);
+        if (formatGeneration != formatGeneration_) {
+            UpdateAudioFormat();
+        }
+    }
+    
     uint32_t nodeId = GetNextNodeId();
     
     // Determine position
@@ -369,11 +889,19 @@ uint32_t AudioProcessingChain::AddPlugin(const std::string& pluginUri, uint32_t
     nodeInfo.nodeId = nodeId;
     nodeInfo.position = position;
     nodeInfo.node = std::move(node);
+    nodeInfo.formatGeneration = formatGeneration;
+    
+    if (!linearGraph_) {
+        // In a custom graph new nodes go in series in front of the chain output
+        nodeInfo.inputs = outputSources_;
+        outputSources_.assign(1, nodeId);
+    }
     
     nodes_.push_back(std::move(nodeInfo));
     
     // Reorder chain
     ReorderChain();
+    PublishSnapshot();
     
     return nodeId;
 }
@@ -387,8 +915,35 @@ bool AudioProcessingChain::RemovePlugin(uint32_t nodeId) {
                           });
     
     if (it != nodes_.end()) {
+        std::vector<uint32_t> removedInputs = it->inputs;
+        
+        // The audio thread may still be running this node, so hand it to the
+        // reclaimer instead of destroying it here
+        Retire(std::move(it->node));
         nodes_.erase(it);
+        
+        if (!linearGraph_) {
+            // Splice the node out: whatever it fed now reads its inputs
+            auto splice = [nodeId, &removedInputs](std::vector<uint32_t>& inputs) {
+                auto pos = std::find(inputs.begin(), inputs.end(), nodeId);
+                if (pos == inputs.end()) {
+                    return;
+                }
+                inputs.erase(pos);
+                for (uint32_t source : removedInputs) {
+                    if (std::find(inputs.begin(), inputs.end(), source) == inputs.end()) {
+                        inputs.push_back(source);
+                    }
+                }
+            };
+            for (auto& info : nodes_) {
+                splice(info.inputs);
+            }
+            splice(outputSources_);
+        }
+        
         ReorderChain();
+        PublishSnapshot();
         return true;
     }
     
@@ -406,6 +961,7 @@ bool AudioProcessingChain::MovePlugin(uint32_t nodeId, uint32_t newPosition) {
     if (it != nodes_.end()) {
         it->position = newPosition;
         ReorderChain();
+        PublishSnapshot();
         return true;
     }
     
@@ -414,105 +970,709 @@ bool AudioProcessingChain::MovePlugin(uint32_t nodeId, uint32_t newPosition) {
 
 void AudioProcessingChain::ClearChain() {
     std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    for (auto& info : nodes_) {
+        Retire(std::move(info.node));
+    }
     nodes_.clear();
+    
+    // An empty chain starts out linear again
+    linearGraph_ = true;
+    RebuildLinearGraph();
+    PublishSnapshot();
 }
 
-ProcessingNode* AudioProcessingChain::GetNode(uint32_t nodeId) {
+bool AudioProcessingChain::ConnectNodes(uint32_t sourceId, uint32_t destinationId) {
     std::lock_guard<std::mutex> lock(nodesMutex_);
     
-    auto it = std::find_if(nodes_.begin(), nodes_.end(),
-                          [nodeId](const NodeInfo& info) {
-                              return info.nodeId == nodeId;
-                          });
+    std::vector<uint32_t>* inputs = FindInputs(destinationId);
+    if (!inputs || (sourceId != GRAPH_IO && !FindInputs(sourceId))) {
+        return false;
+    }
     
-    return (it != nodes_.end()) ? it->node.get() : nullptr;
-}
-
-const ProcessingNode* AudioProcessingChain::GetNode(uint32_t nodeId) const {
-    std::lock_guard<std::mutex> lock(nodesMutex_);
+    // Reject edges that would close a cycle
+    if (sourceId != GRAPH_IO && destinationId != GRAPH_IO && IsReachable(destinationId, sourceId)) {
+        return false;
+    }
     
-    auto it = std::find_if(nodes_.begin(), nodes_.end(),
-                          [nodeId](const NodeInfo& info) {
-                              return info.nodeId == nodeId;
-                          });
+    if (std::find(inputs->begin(), inputs->end(), sourceId) == inputs->end()) {
+        inputs->push_back(sourceId);
+    }
     
-    return (it != nodes_.end()) ? it->node.get() : nullptr;
+    linearGraph_ = false;
+    PublishSnapshot();
+    return true;
 }
 
-std::vector<uint32_t> AudioProcessingChain::GetNodeIds() const {
+bool AudioProcessingChain::DisconnectNodes(uint32_t sourceId, uint32_t destinationId) {
     std::lock_guard<std::mutex> lock(nodesMutex_);
     
-    std::vector<uint32_t> ids;
-    for (const auto& info : nodes_) {
-        ids.push_back(info.nodeId);
+    std::vector<uint32_t>* inputs = FindInputs(destinationId);
+    if (!inputs) {
+        return false;
     }
     
-    return ids;
+    auto it = std::find(inputs->begin(), inputs->end(), sourceId);
+    if (it == inputs->end()) {
+        return false;
+    }
+    inputs->erase(it);
+    
+    linearGraph_ = false;
+    PublishSnapshot();
+    return true;
 }
 
-uint32_t AudioProcessingChain::GetNodeCount() const {
+bool AudioProcessingChain::SetNodeInputs(uint32_t nodeId, const std::vector<uint32_t>& sourceIds) {
     std::lock_guard<std::mutex> lock(nodesMutex_);
-    return static_cast<uint32_t>(nodes_.size());
-}
+    
+    std::vector<uint32_t>* inputs = FindInputs(nodeId);
+    if (!inputs) {
+        return false;
+    }
+    
+    std::vector<uint32_t> sources;
+    for (uint32_t sourceId : sourceIds) {
+        if (sourceId != GRAPH_IO) {
+            if (!FindInputs(sourceId) || (nodeId != GRAPH_IO && IsReachable(nodeId, sourceId))) {
+                return false;
+            }
+        }
+        if (std::find(sources.begin(), sources.end(), sourceId) == sources.end()) {
+            sources.push_back(sourceId);
+        }
+    }
+    
+    *inputs = std::move(sources);
+    linearGraph_ = false;
+    PublishSnapshot();
+    return true;
+}
 
-void AudioProcessingChain::Process(float** inputBuffers, float** outputBuffers, uint32_t channels, uint32_t frames) {
-    if (!enabled_.load() || bypassed_.load()) {
-        // Bypass: copy input to output
-        for (uint32_t ch = 0; ch < channels; ++ch) {
-            memcpy(outputBuffers[ch], inputBuffers[ch], frames * sizeof(float));
+std::vector<uint32_t> AudioProcessingChain::GetNodeInputs(uint32_t nodeId) const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    if (nodeId == GRAPH_IO) {
+        return outputSources_;
+    }
+    
+    for (const auto& info : nodes_) {
+        if (info.nodeId == nodeId) {
+            return info.inputs;
         }
-        return;
     }
     
-    auto startTime = std::chrono::high_resolution_clock::now();
+    return std::vector<uint32_t>();
+}
+
+bool AudioProcessingChain::IsLinear() const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    return linearGraph_;
+}
+
+AudioProcessingChain::ChainState AudioProcessingChain::SaveState() const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    ChainState state;
+    for (const auto& info : nodes_) {
+        if (!info.node) {
+            continue;
+        }
+        
+        ChainState::NodeState nodeState;
+        nodeState.nodeId = info.nodeId;
+        nodeState.position = info.position;
+        nodeState.bypassed = info.node->IsBypassed();
+        nodeState.inputChannels = info.node->GetInputChannels();
+        nodeState.outputChannels = info.node->GetOutputChannels();
+        nodeState.inputs = info.inputs;
+        
+        if (PluginInstance* plugin = info.node->GetPlugin()) {
+            nodeState.pluginUri = plugin->GetInfo().uri;
+            plugin->SaveState(nodeState.pluginState);
+            
+            // The node owns the applied values, not the plugin instance
+            for (const auto& param : plugin->GetParameters()) {
+                nodeState.pluginState[param.symbol] = std::to_string(info.node->GetParameter(param.index));
+            }
+        }
+        state.nodes.push_back(std::move(nodeState));
+    }
+    
+    state.linearGraph = linearGraph_;
+    state.outputs = outputSources_;
+    state.bypassed = bypassed_.load();
+    state.enabled = enabled_.load();
+    return state;
+}
+
+bool AudioProcessingChain::LoadState(const ChainState& state) {
+    ClearChain();
+    
+    std::vector<const ChainState::NodeState*> ordered;
+    for (const auto& nodeState : state.nodes) {
+        ordered.push_back(&nodeState);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const ChainState::NodeState* a, const ChainState::NodeState* b) {
+                         return a->position < b->position;
+                     });
     
+    // Create the nodes, remembering which saved id became which node
+    bool complete = true;
+    std::map<uint32_t, uint32_t> idMap;
+    idMap[GRAPH_IO] = GRAPH_IO;
+    for (const ChainState::NodeState* nodeState : ordered) {
+        uint32_t nodeId = nodeState->pluginUri.empty() ? AddSumNode() : AddPlugin(nodeState->pluginUri);
+        if (nodeId == 0 && !nodeState->pluginUri.empty()) {
+            complete = false;
+            nodeId = AddSumNode();  // pass its inputs through in its place
+            if (nodeId != 0) {
+                idMap[nodeState->nodeId] = nodeId;
+            }
+            continue;
+        }
+        if (nodeId == 0) {
+            complete = false;
+            continue;
+        }
+        idMap[nodeState->nodeId] = nodeId;
+        
+        ProcessingNode* node = GetNode(nodeId);
+        if (!node) {
+            continue;
+        }
+        node->SetBypassed(nodeState->bypassed);
+        if (!nodeState->inputChannels.empty()) {
+            node->SetInputChannels(nodeState->inputChannels);
+        }
+        if (!nodeState->outputChannels.empty()) {
+            node->SetOutputChannels(nodeState->outputChannels);
+        }
+        
+        if (PluginInstance* plugin = node->GetPlugin()) {
+            plugin->LoadState(nodeState->pluginState);
+            
+            // Values reach the node through the queue like any other change
+            for (const auto& param : plugin->GetParameters()) {
+                auto it = nodeState->pluginState.find(param.symbol);
+                if (it == nodeState->pluginState.end()) {
+                    continue;
+                }
+                try {
+                    SetParameter(nodeId, param.index, std::stof(it->second));
+                } catch (const std::exception&) {
+                    // Ignore invalid values
+                }
+            }
+        }
+    }
+    
+    if (!state.linearGraph) {
+        auto mapIds = [&idMap](const std::vector<uint32_t>& ids) {
+            std::vector<uint32_t> mapped;
+            for (uint32_t id : ids) {
+                auto it = idMap.find(id);
+                if (it != idMap.end()) {
+                    mapped.push_back(it->second);
+                }
+            }
+            return mapped;
+        };
+        
+        // Disconnect everything first so rewiring never sees a transient cycle
+        for (const ChainState::NodeState* nodeState : ordered) {
+            auto it = idMap.find(nodeState->nodeId);
+            if (it != idMap.end()) {
+                SetNodeInputs(it->second, std::vector<uint32_t>());
+            }
+        }
+        for (const ChainState::NodeState* nodeState : ordered) {
+            auto it = idMap.find(nodeState->nodeId);
+            if (it != idMap.end()) {
+                SetNodeInputs(it->second, mapIds(nodeState->inputs));
+            }
+        }
+        SetNodeInputs(GRAPH_IO, mapIds(state.outputs));
+    }
+    
+    SetBypassed(state.bypassed);
+    SetEnabled(state.enabled);
+    return complete;
+}
+
+void AudioProcessingChain::SetWorkerThreadCount(uint32_t count) {
+    // Spawn the new workers before taking the lock; the old pool is retired
+    // like a snapshot because the audio thread may be inside it right now
+    auto pool = std::make_shared<ProcessingThreadPool>(count);
+    
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    if (threadPool_) {
+        Retire(threadPool_);
+    }
+    threadPool_ = pool;
+    PublishSnapshot();
+}
+
+uint32_t AudioProcessingChain::GetWorkerThreadCount() const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    return threadPool_ ? threadPool_->GetWorkerCount() : 0;
+}
+
+ProcessingNode* AudioProcessingChain::GetNode(uint32_t nodeId) {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                          [nodeId](const NodeInfo& info) {
+                              return info.nodeId == nodeId;
+                          });
+    
+    return (it != nodes_.end()) ? it->node.get() : nullptr;
+}
+
+const ProcessingNode* AudioProcessingChain::GetNode(uint32_t nodeId) const {
     std::lock_guard<std::mutex> lock(nodesMutex_);
     
-    if (nodes_.empty()) {
-        // No plugins: copy input to output
+    auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                          [nodeId](const NodeInfo& info) {
+                              return info.nodeId == nodeId;
+                          });
+    
+    return (it != nodes_.end()) ? it->node.get() : nullptr;
+}
+
+std::vector<uint32_t> AudioProcessingChain::GetNodeIds() const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    std::vector<uint32_t> ids;
+    for (const auto& info : nodes_) {
+        ids.push_back(info.nodeId);
+    }
+    
+    return ids;
+}
+
+uint32_t AudioProcessingChain::GetNodeCount() const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    return static_cast<uint32_t>(nodes_.size());
+}
+
+void AudioProcessingChain::Process(float** inputBuffers, float** outputBuffers, uint32_t channels, uint32_t frames) {
+    uint64_t startTime = MonotonicNanos();
+    
+    ChainSnapshot* snapshot = AcquireSnapshot();
+    
+    // Apply queued parameter changes even while bypassed so the queue drains
+    bool running = enabled_.load() && !bypassed_.load() && snapshot && !snapshot->nodes.empty();
+    ApplyParameterChanges(snapshot, running ? frames : 0);
+    if (snapshot) {
+        snapshot->slowestNode.store(0, std::memory_order_relaxed);
+    }
+    
+    if (!running) {
+        // Bypassed or no plugins: copy input to output
         for (uint32_t ch = 0; ch < channels; ++ch) {
             memcpy(outputBuffers[ch], inputBuffers[ch], frames * sizeof(float));
         }
+        if (snapshot) {
+            snapshot->fadePosition = snapshot->fadeFrames;
+        }
+        latency_.store(0);
+    } else if (snapshot->fadeFrom && snapshot->fadePosition < snapshot->fadeFrames) {
+        // Fresh graph after a format change: render the replaced graph too
+        // and fade over to the new one. Output may alias input, so the old
+        // graph goes first into its own buffers. It gets the whole block,
+        // in its own slices, so fixed block lengths hold; slices past the
+        // fade only overwrite each other behind the part that is mixed.
+        ChainSnapshot* fadeFrom = snapshot->fadeFrom.get();
+        uint32_t fadeLength = std::min(frames, snapshot->fadeFrames - snapshot->fadePosition);
+        uint32_t fadeChannels = std::min(channels, static_cast<uint32_t>(snapshot->fadeBuffers.size()));
+        for (uint32_t offset = 0; offset < frames; offset += fadeFrom->maxFrames) {
+            uint32_t sliceFrames = std::min(frames - offset, fadeFrom->maxFrames);
+            for (uint32_t ch = 0; ch < fadeChannels; ++ch) {
+                snapshot->fadeInputs[ch] = inputBuffers[ch] + offset;
+                snapshot->fadeOutputs[ch] = snapshot->fadeBuffers[ch] + std::min(offset, fadeLength);
+            }
+            RenderSnapshot(fadeFrom, snapshot->fadeInputs.data(), snapshot->fadeOutputs.data(),
+                           fadeChannels, sliceFrames);
+        }
+        
+        uint64_t bytesCopied = RenderSnapshot(snapshot, inputBuffers, outputBuffers, channels, frames);
+        
+        float step = 1.0f / snapshot->fadeFrames;
+        for (uint32_t ch = 0; ch < fadeChannels; ++ch) {
+            const float* previous = snapshot->fadeBuffers[ch];
+            float* output = outputBuffers[ch];
+            for (uint32_t i = 0; i < fadeLength; ++i) {
+                float gain = (snapshot->fadePosition + i + 1) * step;
+                output[i] = previous[i] + (output[i] - previous[i]) * gain;
+            }
+        }
+        snapshot->fadePosition += fadeLength;
+        bytesCopiedPerBlock_.store(bytesCopied);
+        latency_.store(snapshot->latency);
+    } else {
+        bytesCopiedPerBlock_.store(RenderSnapshot(snapshot, inputBuffers, outputBuffers, channels, frames));
+        latency_.store(snapshot->latency);
+    }
+    
+    uint32_t sampleRate = 0;
+    if (snapshot) {
+        sampleRate = snapshot->sampleRate;
+        uint64_t slowest = snapshot->slowestNode.load(std::memory_order_relaxed);
+        uint32_t index = static_cast<uint32_t>(slowest & 0xffff);
+        lastSnapshotId_.store(snapshot->id, std::memory_order_relaxed);
+        lastSlowestNodeId_.store(slowest && index < snapshot->nodeIds.size() ? snapshot->nodeIds[index] : 0,
+                                 std::memory_order_relaxed);
+        lastSlowestNodeNanos_.store(slowest >> 16, std::memory_order_relaxed);
+    }
+    ReleaseSnapshot();
+    
+    processedFrames_.fetch_add(frames);
+    RecordBlockTime(MonotonicNanos() - startTime, frames, sampleRate);
+}
+
+uint64_t AudioProcessingChain::RenderSnapshot(ChainSnapshot* snapshot, float** inputBuffers, float** outputBuffers,
+                                              uint32_t channels, uint32_t frames) {
+    // Process through the graph in slices that fit the snapshot's buffers
+    uint64_t bytesCopied = 0;
+    uint32_t ioChannels = std::min(channels, static_cast<uint32_t>(snapshot->inputSlice.size()));
+    for (uint32_t offset = 0; offset < frames; offset += snapshot->maxFrames) {
+        uint32_t sliceFrames = std::min(frames - offset, snapshot->maxFrames);
+        
+        for (uint32_t ch = 0; ch < ioChannels; ++ch) {
+            snapshot->inputSlice[ch] = inputBuffers[ch] + offset;
+            snapshot->outputSlice[ch] = outputBuffers[ch] + offset;
+        }
+        
+        ProcessGraph(snapshot, snapshot->inputSlice.data(), snapshot->outputSlice.data(), ioChannels, sliceFrames);
+        bytesCopied += snapshot->mixBytesCopied.load();
+    }
+    for (uint32_t ch = ioChannels; ch < channels; ++ch) {
+        if (outputBuffers[ch] != inputBuffers[ch]) {
+            memcpy(outputBuffers[ch], inputBuffers[ch], frames * sizeof(float));
+            bytesCopied += frames * sizeof(float);
+        }
+    }
+    return bytesCopied;
+}
+
+GlitchContext AudioProcessingChain::GetBlockContext() const {
+    GlitchContext context;
+    context.snapshotId = lastSnapshotId_.load(std::memory_order_relaxed);
+    context.slowestNodeId = lastSlowestNodeId_.load(std::memory_order_relaxed);
+    context.slowestNodeNanos = lastSlowestNodeNanos_.load(std::memory_order_relaxed);
+    return context;
+}
+
+void AudioProcessingChain::RecordBlockTime(uint64_t nanos, uint32_t frames, uint32_t sampleRate) {
+    callbackTiming_.Record(nanos);
+    blockCount_.fetch_add(1);
+    
+    if (sampleRate == 0 || frames == 0) {
         return;
     }
     
-    // Allocate chain buffers if needed
-    if (chainBuffers_.size() != channels || chainBuffers_[0].size() != frames) {
-        chainBuffers_.resize(channels);
-        chainBufferPtrs_.resize(channels);
+    // The block has to be done before the device needs the next one
+    double deadline = static_cast<double>(frames) * 1e9 / sampleRate;
+    if (nanos > deadline) {
+        xrunCount_.fetch_add(1);
+    }
+    
+    double load = nanos / deadline * 100.0;
+    double cpu = cpuUsage_.load();
+    cpuUsage_.store(cpu + (load - cpu) * CPU_SMOOTHING);
+}
+
+namespace {
+
+void MixInto(float** destination, float** source, uint32_t channels, uint32_t frames, bool first) {
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        if (first) {
+            memcpy(destination[ch], source[ch], frames * sizeof(float));
+        } else {
+            for (uint32_t i = 0; i < frames; ++i) {
+                destination[ch][i] += source[ch][i];
+            }
+        }
+    }
+}
+
+// As MixInto(), but through a delay line that holds the source back by
+// `delay` frames
+void MixDelayed(float** destination, float** source, ChainSnapshot::DelayLine& line, uint32_t delay,
+                uint32_t channels, uint32_t frames, bool first) {
+    const uint32_t mask = line.mask;
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        float* ring = line.storage.data() + static_cast<size_t>(ch) * (mask + 1);
+        for (uint32_t i = 0; i < frames; ++i) {
+            uint32_t position = (line.writePosition + i) & mask;
+            ring[position] = source[ch][i];
+            float sample = ring[(position - delay) & mask];
+            destination[ch][i] = first ? sample : destination[ch][i] + sample;
+        }
+    }
+    line.writePosition = (line.writePosition + frames) & mask;
+}
+
+// Latency of the slowest of `sources` in the current block
+uint32_t LatestArrival(const ChainSnapshot* snapshot, const std::vector<uint32_t>& sources) {
+    uint32_t arrival = 0;
+    for (uint32_t source : sources) {
+        if (source != ChainSnapshot::GRAPH_INPUT) {
+            arrival = std::max(arrival, snapshot->arrival[source]);
+        }
+    }
+    return arrival;
+}
+
+// Sums `sources` into `destination`, each delayed to line up with the
+// slowest. Returns that source's latency.
+uint32_t MixSources(ChainSnapshot* snapshot, float** destination, float** input, const std::vector<uint32_t>& sources,
+                    uint32_t firstDelay, uint32_t channels, uint32_t frames) {
+    uint32_t arrival = LatestArrival(snapshot, sources);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        uint32_t source = sources[i];
+        float** sourceSet = source == ChainSnapshot::GRAPH_INPUT
+            ? input
+            : snapshot->bufferSets[snapshot->graph[source].buffer];
+        if (firstDelay == ChainSnapshot::NO_DELAY) {
+            MixInto(destination, sourceSet, channels, frames, i == 0);
+            continue;
+        }
+        uint32_t sourceArrival = source == ChainSnapshot::GRAPH_INPUT ? 0 : snapshot->arrival[source];
+        uint32_t delay = std::min(arrival - sourceArrival, snapshot->maxDelay);
+        MixDelayed(destination, sourceSet, snapshot->delayLines[firstDelay + i], delay, channels, frames, i == 0);
+    }
+    return arrival;
+}
+
+// Runs one graph node. A node that inherited its source's buffer set runs in
+// place on it, a node with a single source reads the source set directly and
+// anything else renders the sum of its sources, latency compensated, into
+// its own set first.
+void RunGraphNode(ChainSnapshot* snapshot, uint32_t index, uint32_t frames) {
+    uint64_t startTime = MonotonicNanos();
+    const ChainSnapshot::GraphNode& graphNode = snapshot->graph[index];
+    ProcessingNode* node = snapshot->nodes[index];
+    float** own = snapshot->bufferSets[graphNode.buffer];
+    uint32_t channels = snapshot->channels;
+    uint64_t bytesCopied = 0;
+    
+    auto sourceSet = [snapshot](uint32_t source) {
+        return source == ChainSnapshot::GRAPH_INPUT
+            ? snapshot->graphInput
+            : snapshot->bufferSets[snapshot->graph[source].buffer];
+    };
+    
+    uint32_t arrival = 0;
+    if (graphNode.inheritsBuffer) {
+        arrival = LatestArrival(snapshot, graphNode.sources);
+        node->Process(own, own, frames);
+    } else if (graphNode.sources.size() == 1) {
+        arrival = LatestArrival(snapshot, graphNode.sources);
+        node->Process(sourceSet(graphNode.sources[0]), own, frames);
+    } else {
+        if (graphNode.sources.empty()) {
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                memset(own[ch], 0, frames * sizeof(float));
+            }
+        }
+        arrival = MixSources(snapshot, own, snapshot->graphInput, graphNode.sources, graphNode.firstDelay,
+                             channels, frames);
+        bytesCopied += static_cast<uint64_t>(graphNode.sources.size()) * channels * frames * sizeof(float);
+        node->Process(own, own, frames);
+    }
+    // Consumers read this once the node counts as finished
+    snapshot->arrival[index] = arrival + node->GetLatency();
+    
+    bytesCopied += node->GetBytesCopied();
+    snapshot->mixBytesCopied.fetch_add(bytesCopied);
+    
+    uint64_t nodeNanos = MonotonicNanos() - startTime;
+    node->GetTiming().Record(nodeNanos);
+    
+    // Workers race on the block's maximum
+    uint64_t packed = (nodeNanos << 16) | (index & 0xffff);
+    uint64_t slowest = snapshot->slowestNode.load(std::memory_order_relaxed);
+    while (packed > slowest &&
+           !snapshot->slowestNode.compare_exchange_weak(slowest, packed, std::memory_order_relaxed)) {
+    }
+    
+    // Outside the node's timing: the scan is the diagnostic's cost, not the plugin's
+    if (snapshot->denormalCheck && snapshot->denormalCheck->load(std::memory_order_relaxed)) {
+        uint32_t subnormals = 0;
         for (uint32_t ch = 0; ch < channels; ++ch) {
-            chainBuffers_[ch].resize(frames);
-            chainBufferPtrs_[ch] = chainBuffers_[ch].data();
+            subnormals += CountSubnormals(own[ch], frames);
         }
+        node->RecordSubnormals(subnormals);
     }
+}
+
+// Shared by the audio thread and the workers: pop ready nodes until every
+// node in the snapshot has run. A node becomes ready when its last source
+// finishes, and whoever finished that source pushes it.
+class GraphTask : public ParallelTask {
+public:
+    GraphTask(ChainSnapshot* snapshot, uint32_t frames)
+        : snapshot_(snapshot), frames_(frames) {}
     
-    // Copy input to chain buffers
+    void Work() override {
+        const uint32_t nodeCount = static_cast<uint32_t>(snapshot_->nodes.size());
+        
+        while (snapshot_->completed.load() < nodeCount) {
+            uint32_t head = snapshot_->readyHead.load();
+            if (head >= snapshot_->readyTail.load() ||
+                !snapshot_->readyHead.compare_exchange_weak(head, head + 1)) {
+                CpuRelax();
+                continue;
+            }
+            
+            // The pusher bumps the tail before filling the slot
+            uint32_t slot;
+            while ((slot = snapshot_->readyQueue[head].load()) == 0) {
+                CpuRelax();
+            }
+            uint32_t index = slot - 1;
+            
+            RunGraphNode(snapshot_, index, frames_);
+            
+            for (uint32_t consumer : snapshot_->graph[index].consumers) {
+                if (snapshot_->pending[consumer].fetch_sub(1) == 1) {
+                    uint32_t tail = snapshot_->readyTail.fetch_add(1);
+                    snapshot_->readyQueue[tail].store(consumer + 1);
+                }
+            }
+            
+            snapshot_->completed.fetch_add(1);
+        }
+    }
+    
+private:
+    ChainSnapshot* snapshot_;
+    uint32_t frames_;
+};
+
+} // namespace
+
+void AudioProcessingChain::ProcessGraph(ChainSnapshot* snapshot, float** inputBuffers, float** outputBuffers,
+                                        uint32_t channels, uint32_t frames) {
+    const uint32_t graphChannels = snapshot->channels;
+    const uint32_t nodeCount = static_cast<uint32_t>(snapshot->nodes.size());
+    float** staging = snapshot->bufferSets.back();
+    
+    snapshot->mixBytesCopied.store(0);
+    
+    bool aliased = false;
     for (uint32_t ch = 0; ch < channels; ++ch) {
-        memcpy(chainBufferPtrs_[ch], inputBuffers[ch], frames * sizeof(float));
+        if (inputBuffers[ch] == outputBuffers[ch]) {
+            aliased = true;
+            break;
+        }
     }
     
-    // Process through chain
-    for (const auto& nodeInfo : nodes_) {
-        if (nodeInfo.node && nodeInfo.node->IsActive()) {
-            nodeInfo.node->Process(chainBufferPtrs_.data(), chainBufferPtrs_.data(), frames);
+    // Bind the output-bound set to the caller's output, falling back to the
+    // set's own storage for channels the caller doesn't have
+    bool outputBound = snapshot->outputBoundBuffer != ChainSnapshot::NO_BUFFER;
+    if (outputBound) {
+        float** bound = &snapshot->bufferPtrs[snapshot->outputBoundBuffer * graphChannels];
+        for (uint32_t ch = channels; ch < graphChannels; ++ch) {
+            outputBuffers[ch] = bound[ch];
         }
+        snapshot->bufferSets[snapshot->outputBoundBuffer] = outputBuffers;
     }
     
-    // Copy chain buffers to output
-    for (uint32_t ch = 0; ch < channels; ++ch) {
-        memcpy(outputBuffers[ch], chainBufferPtrs_[ch], frames * sizeof(float));
+    // Stage the input when nodes could read it after the output overwrote it,
+    // or when the caller has fewer channels than the graph
+    if ((aliased && !(outputBound && snapshot->inputAliasSafe)) || channels < graphChannels) {
+        uint64_t bytesStaged = 0;
+        for (uint32_t ch = 0; ch < graphChannels; ++ch) {
+            if (ch < channels) {
+                memcpy(staging[ch], inputBuffers[ch], frames * sizeof(float));
+                bytesStaged += frames * sizeof(float);
+            } else {
+                memset(staging[ch], 0, frames * sizeof(float));
+            }
+        }
+        snapshot->graphInput = staging;
+        snapshot->mixBytesCopied.fetch_add(bytesStaged);
+    } else {
+        snapshot->graphInput = inputBuffers;
     }
     
-    processedFrames_.fetch_add(frames);
+    if (snapshot->parallel) {
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            snapshot->pending[i].store(snapshot->graph[i].dependencyCount);
+            snapshot->readyQueue[i].store(0);
+        }
+        for (size_t i = 0; i < snapshot->roots.size(); ++i) {
+            snapshot->readyQueue[i].store(snapshot->roots[i] + 1);
+        }
+        snapshot->readyHead.store(0);
+        snapshot->readyTail.store(static_cast<uint32_t>(snapshot->roots.size()));
+        snapshot->completed.store(0);
+        
+        GraphTask task(snapshot, frames);
+        snapshot->threadPool->RunParallel(&task);
+    } else {
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            RunGraphNode(snapshot, i, frames);
+        }
+    }
+    
+    uint32_t mixChannels = std::min(channels, graphChannels);
+    if (outputBound) {
+        snapshot->bufferSets[snapshot->outputBoundBuffer] =
+            &snapshot->bufferPtrs[snapshot->outputBoundBuffer * graphChannels];
+        snapshot->latency = LatestArrival(snapshot, snapshot->outputSources);
+    } else {
+        // Sum the output sources into the caller's output
+        if (snapshot->outputSources.empty()) {
+            for (uint32_t ch = 0; ch < mixChannels; ++ch) {
+                memset(outputBuffers[ch], 0, frames * sizeof(float));
+            }
+        }
+        snapshot->latency = MixSources(snapshot, outputBuffers, snapshot->graphInput, snapshot->outputSources,
+                                       snapshot->outputFirstDelay, mixChannels, frames);
+        snapshot->mixBytesCopied.fetch_add(
+            static_cast<uint64_t>(snapshot->outputSources.size()) * mixChannels * frames * sizeof(float));
+    }
+    
+    // Channels beyond the graph's width pass through dry
+    for (uint32_t ch = graphChannels; ch < channels; ++ch) {
+        if (outputBuffers[ch] != inputBuffers[ch]) {
+            memcpy(outputBuffers[ch], inputBuffers[ch], frames * sizeof(float));
+            snapshot->mixBytesCopied.fetch_add(frames * sizeof(float));
+        }
+    }
+}
+
+void AudioProcessingChain::ApplyParameterChanges(ChainSnapshot* snapshot, uint32_t frames) {
+    // Cost is proportional to the number of changes, not parameters. Changes
+    // for nodes that are no longer in the snapshot are dropped. Those timed
+    // inside the block are left to the node to apply at their frame; frames
+    // is 0 when the nodes won't run, so everything lands now.
+    if (snapshot && snapshot->transferPending) {
+        // Nodes rebuilt for a new format catch up on their predecessors
+        // before this block's changes land on them
+        for (ProcessingNode* node : snapshot->nodes) {
+            node->CompleteTransfer();
+        }
+        snapshot->transferPending = false;
+    }
     
-    // Update CPU usage periodically
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration<double>(endTime - lastCpuMeasurement_).count();
-    if (elapsed >= CPU_MEASUREMENT_INTERVAL) {
-        auto processingTime = std::chrono::duration<double>(endTime - startTime).count();
-        double frameTime = static_cast<double>(frames) / sampleRate_;
-        cpuUsage_.store((processingTime / frameTime) * 100.0);
-        lastCpuMeasurement_ = endTime;
+    ParameterChange change;
+    while (parameterQueue_.Pop(change)) {
+        if (!snapshot) {
+            continue;
+        }
+        for (size_t i = 0; i < snapshot->nodeIds.size(); ++i) {
+            if (snapshot->nodeIds[i] == change.nodeId) {
+                uint32_t offset = change.sampleOffset < frames ? change.sampleOffset : 0;
+                snapshot->nodes[i]->ApplyParameterAt(offset, change.parameterIndex, change.value);
+                break;
+            }
+        }
     }
 }
 
@@ -521,23 +1681,34 @@ void AudioProcessingChain::ProcessMidi(MidiBuffer* midiBuffer, uint32_t frames)
         return;
     }
     
-    std::lock_guard<std::mutex> lock(nodesMutex_);
+    const ChainSnapshot* snapshot = AcquireSnapshot();
     
-    // Process MIDI through each node
-    for (const auto& nodeInfo : nodes_) {
-        if (nodeInfo.node && nodeInfo.node->IsActive()) {
-            nodeInfo.node->ProcessMidi(midiBuffer, frames);
+    // Process MIDI through each node in graph order
+    if (snapshot) {
+        for (ProcessingNode* node : snapshot->nodes) {
+            if (node->IsActive()) {
+                node->ProcessMidi(midiBuffer, frames);
+            }
         }
     }
+    
+    ReleaseSnapshot();
 }
 
-bool AudioProcessingChain::SetParameter(uint32_t nodeId, uint32_t parameterIndex, float value) {
-    ProcessingNode* node = GetNode(nodeId);
-    if (node) {
-        node->SetParameter(parameterIndex, value);
-        return true;
+bool AudioProcessingChain::SetParameter(uint32_t nodeId, uint32_t parameterIndex, float value, uint32_t sampleOffset) {
+    {
+        std::lock_guard<std::mutex> lock(nodesMutex_);
+        
+        auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                              [nodeId](const NodeInfo& info) {
+                                  return info.nodeId == nodeId;
+                              });
+        if (it == nodes_.end() || !it->node || !it->node->NormalizeParameter(parameterIndex, value)) {
+            return false;
+        }
     }
-    return false;
+    
+    return parameterQueue_.Push({nodeId, parameterIndex, value, sampleOffset});
 }
 
 float AudioProcessingChain::GetParameter(uint32_t nodeId, uint32_t parameterIndex) const {
@@ -548,6 +1719,43 @@ float AudioProcessingChain::GetParameter(uint32_t nodeId, uint32_t parameterInde
     return 0.0f;
 }
 
+bool AudioProcessingChain::SetAutomation(uint32_t nodeId, uint32_t parameterIndex,
+                                         std::vector<ProcessingNode::AutomationPoint> points) {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                          [nodeId](const NodeInfo& info) {
+                              return info.nodeId == nodeId;
+                          });
+    if (it == nodes_.end() || !it->node) {
+        return false;
+    }
+    
+    // Resolve the index once, then clamp every value the same way
+    float value = 0.0f;
+    uint32_t index = parameterIndex;
+    if (!it->node->NormalizeParameter(index, value)) {
+        return false;
+    }
+    for (auto& point : points) {
+        it->node->NormalizeParameter(index, point.value);
+    }
+    
+    it->node->SetAutomation(index, std::move(points));
+    return true;
+}
+
+std::vector<ProcessingNode::AutomationPoint> AudioProcessingChain::GetAutomation(uint32_t nodeId) const {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    
+    for (const auto& info : nodes_) {
+        if (info.nodeId == nodeId && info.node) {
+            return info.node->GetAutomation();
+        }
+    }
+    return std::vector<ProcessingNode::AutomationPoint>();
+}
+
 void AudioProcessingChain::SetMidiParameterMapper(std::shared_ptr<MidiParameterMapper> mapper) {
     midiMapper_ = mapper;
 }
@@ -573,20 +1781,33 @@ void AudioProcessingChain::ProcessMidiParameterControl(const MidiMessage& messag
 }
 
 bool AudioProcessingChain::SetFormat(uint32_t sampleRate, uint32_t channels, uint32_t blockSize) {
-    std::lock_guard<std::mutex> lock(formatMutex_);
-    
-    if (sampleRate_ == sampleRate && channels_ == channels && blockSize_ == blockSize) {
-        return true; // No change needed
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        
+        if (sampleRate_ == sampleRate && channels_ == channels && blockSize_ == blockSize) {
+            return true; // No change needed
+        }
+        
+        sampleRate_ = sampleRate;
+        channels_ = channels;
+        blockSize_ = blockSize;
+        
+        UpdateAudioFormat();
     }
     
-    sampleRate_ = sampleRate;
-    channels_ = channels;
-    blockSize_ = blockSize;
-    
-    UpdateAudioFormat();
+    // Buffer sets are sized from the format, so republish. formatMutex_ is
+    // released first because BuildSnapshot() takes it under nodesMutex_.
+    // The existing nodes keep running until their replacements are ready.
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    PublishSnapshot();
     return true;
 }
 
+void AudioProcessingChain::WaitForFormatChange() {
+    std::unique_lock<std::mutex> lock(formatMutex_);
+    formatIdle_.wait(lock, [this] { return !formatBusy_; });
+}
+
 void AudioProcessingChain::GetFormat(uint32_t& sampleRate, uint32_t& channels, uint32_t& blockSize) const {
     std::lock_guard<std::mutex> lock(formatMutex_);
     sampleRate = sampleRate_;
@@ -594,33 +1815,631 @@ void AudioProcessingChain::GetFormat(uint32_t& sampleRate, uint32_t& channels, u
     blockSize = blockSize_;
 }
 
+void AudioProcessingChain::SetFixedBlockLength(bool fixed) {
+    std::lock_guard<std::mutex> lock(formatMutex_);
+    if (fixedBlockLength_ == fixed) {
+        return;
+    }
+    
+    // Plugins only learn about it at instantiation
+    fixedBlockLength_ = fixed;
+    UpdateAudioFormat();
+}
+
+bool AudioProcessingChain::IsFixedBlockLength() const {
+    std::lock_guard<std::mutex> lock(formatMutex_);
+    return fixedBlockLength_;
+}
+
 void AudioProcessingChain::ReorderChain() {
     // Sort nodes by position
     std::sort(nodes_.begin(), nodes_.end(),
              [](const NodeInfo& a, const NodeInfo& b) {
                  return a.position < b.position;
              });
+    
+    // A linear chain's topology is defined by the positions
+    if (linearGraph_) {
+        RebuildLinearGraph();
+    }
 }
 
 void AudioProcessingChain::UpdateAudioFormat() {
-    // TODO: Recreate nodes with new format
-    // This would require stopping audio, recreating all plugin instances,
-    // and restarting audio
+    // Called with formatMutex_ held. A running rebuild picks up the new
+    // generation on its next pass, otherwise start one.
+    ++formatGeneration_;
+    if (formatBusy_ || formatStop_) {
+        return;
+    }
+    if (formatThread_.joinable()) {
+        formatThread_.join(); // finished, it only had to return
+    }
+    formatBusy_ = true;
+    formatThread_ = std::thread(&AudioProcessingChain::FormatThreadProc, this);
+}
+
+void AudioProcessingChain::FormatThreadProc() {
+    struct Rebuild {
+        uint32_t nodeId;
+        ProcessingNode* previous;
+        std::string uri;                // empty for sum nodes
+        std::string state;
+        uint32_t previousRate;
+        std::unique_ptr<ProcessingNode> node;
+    };
+    
+    for (;;) {
+        std::vector<Rebuild> rebuilds;
+        uint32_t sampleRate, channels, blockSize;
+        bool fixedBlockLength;
+        uint64_t generation;
+        
+        {
+            std::lock_guard<std::mutex> lock(nodesMutex_);
+            std::lock_guard<std::mutex> formatLock(formatMutex_);
+            
+            sampleRate = sampleRate_;
+            channels = channels_;
+            blockSize = blockSize_;
+            fixedBlockLength = fixedBlockLength_;
+            generation = formatGeneration_;
+            
+            if (!formatStop_) {
+                for (auto& info : nodes_) {
+                    if (!info.node || info.formatGeneration == generation) {
+                        continue;
+                    }
+                    Rebuild rebuild;
+                    rebuild.nodeId = info.nodeId;
+                    rebuild.previous = info.node.get();
+                    rebuild.previousRate = sampleRate;
+                    if (PluginInstance* plugin = info.node->GetPlugin()) {
+                        rebuild.previousRate = static_cast<uint32_t>(plugin->GetSampleRate());
+                        rebuild.uri = plugin->GetInfo().uri;
+                        plugin->SaveLv2State(rebuild.state);
+                    }
+                    rebuilds.push_back(std::move(rebuild));
+                }
+            }
+            
+            if (rebuilds.empty()) {
+                formatBusy_ = false;
+                formatIdle_.notify_all();
+                return;
+            }
+        }
+        
+        // Instantiate outside the locks; the audio thread keeps running the
+        // old nodes meanwhile
+        for (auto& rebuild : rebuilds) {
+            std::unique_ptr<PluginInstance> plugin;
+            if (!rebuild.uri.empty()) {
+                {
+                    std::lock_guard<std::mutex> lock(instantiateMutex_);
+                    plugin = pluginManager_->CreatePlugin(rebuild.uri, sampleRate, blockSize, fixedBlockLength);
+                }
+                if (!plugin) {
+                    std::cerr << "Failed to re-instantiate plugin: " << rebuild.uri << std::endl;
+                    continue;
+                }
+                if (!rebuild.state.empty()) {
+                    plugin->RestoreLv2State(rebuild.state);
+                }
+            }
+            
+            auto node = std::make_unique<ProcessingNode>(std::move(plugin), channels, blockSize);
+            if (!node->Activate()) {
+                std::cerr << "Failed to activate plugin: " << rebuild.uri << std::endl;
+                continue;
+            }
+            rebuild.node = std::move(node);
+        }
+        
+        std::lock_guard<std::mutex> lock(nodesMutex_);
+        {
+            std::lock_guard<std::mutex> formatLock(formatMutex_);
+            if (formatStop_ || generation != formatGeneration_) {
+                continue; // superseded, rebuild for the latest format
+            }
+        }
+        
+        std::vector<std::shared_ptr<void>> replaced;
+        uint32_t swapped = 0;
+        for (auto& rebuild : rebuilds) {
+            auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                                  [&rebuild](const NodeInfo& info) {
+                                      return info.nodeId == rebuild.nodeId;
+                                  });
+            if (it == nodes_.end() || it->node.get() != rebuild.previous) {
+                continue; // removed while we were instantiating
+            }
+            
+            // A failed rebuild keeps the old instance rather than retrying forever
+            it->formatGeneration = generation;
+            if (!rebuild.node) {
+                continue;
+            }
+            
+            double ratio = rebuild.previousRate ? static_cast<double>(sampleRate) / rebuild.previousRate : 1.0;
+            std::shared_ptr<ProcessingNode> previous(std::move(it->node));
+            rebuild.node->TransferFrom(previous, ratio);
+            replaced.push_back(std::move(previous));
+            it->node = std::move(rebuild.node);
+            ++swapped;
+        }
+        
+        // Crossfade only when the whole graph is new; the old snapshot would
+        // otherwise run surviving nodes twice per block
+        if (swapped == nodes_.size()) {
+            PublishSnapshot(std::move(replaced));
+        } else {
+            for (auto& node : replaced) {
+                Retire(std::move(node));
+            }
+            PublishSnapshot();
+        }
+    }
 }
 
 uint32_t AudioProcessingChain::GetNextNodeId() {
     return nextNodeId_.fetch_add(1);
 }
 
+// Graph editing
+
+void AudioProcessingChain::RebuildLinearGraph() {
+    uint32_t previous = GRAPH_IO;
+    for (auto& info : nodes_) {
+        info.inputs.assign(1, previous);
+        previous = info.nodeId;
+    }
+    outputSources_.assign(1, previous);
+}
+
+bool AudioProcessingChain::IsReachable(uint32_t fromId, uint32_t toId) const {
+    // Walk the inputs backwards from toId looking for fromId
+    std::vector<uint32_t> stack(1, toId);
+    std::vector<uint32_t> visited;
+    
+    while (!stack.empty()) {
+        uint32_t id = stack.back();
+        stack.pop_back();
+        
+        if (id == fromId) {
+            return true;
+        }
+        if (id == GRAPH_IO || std::find(visited.begin(), visited.end(), id) != visited.end()) {
+            continue;
+        }
+        visited.push_back(id);
+        
+        for (const auto& info : nodes_) {
+            if (info.nodeId == id) {
+                stack.insert(stack.end(), info.inputs.begin(), info.inputs.end());
+                break;
+            }
+        }
+    }
+    
+    return false;
+}
+
+std::vector<uint32_t>* AudioProcessingChain::FindInputs(uint32_t nodeId) {
+    if (nodeId == GRAPH_IO) {
+        return &outputSources_;
+    }
+    
+    for (auto& info : nodes_) {
+        if (info.nodeId == nodeId) {
+            return &info.inputs;
+        }
+    }
+    
+    return nullptr;
+}
+
+// Snapshot publication and reclamation
+//
+// The audio thread announces the epoch it started a block in (readerEpoch_)
+// before loading snapshot_, and resets it to READER_IDLE when done. Editors
+// swap in a new snapshot and then advance globalEpoch_, tagging whatever the
+// old snapshot referenced with the new epoch. An item tagged E is only freed
+// once the reader is idle or has announced an epoch >= E, at which point it
+// is guaranteed to have loaded the newer snapshot.
+
+std::unique_ptr<ChainSnapshot> AudioProcessingChain::BuildSnapshot() const {
+    auto snapshot = std::make_unique<ChainSnapshot>();
+    
+    // Distinct from GRAPH_INPUT, which is UINT32_MAX
+    constexpr uint32_t NOT_FOUND = UINT32_MAX - 1;
+    
+    // nodes_ is sorted by position, which breaks ties in the topological order
+    std::vector<const NodeInfo*> infos;
+    for (const auto& info : nodes_) {
+        if (info.node) {
+            infos.push_back(&info);
+        }
+    }
+    const uint32_t count = static_cast<uint32_t>(infos.size());
+    
+    auto indexOf = [&infos](uint32_t nodeId) {
+        for (uint32_t i = 0; i < infos.size(); ++i) {
+            if (infos[i]->nodeId == nodeId) {
+                return i;
+            }
+        }
+        return NOT_FOUND;
+    };
+    
+    // Resolve sources to position indices, dropping dangling ids
+    std::vector<std::vector<uint32_t>> sources(count);
+    std::vector<uint32_t> indegree(count, 0);
+    std::vector<std::vector<uint32_t>> consumers(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        for (uint32_t sourceId : infos[i]->inputs) {
+            uint32_t source = sourceId == GRAPH_IO ? ChainSnapshot::GRAPH_INPUT : indexOf(sourceId);
+            if (source == NOT_FOUND) {
+                continue;
+            }
+            sources[i].push_back(source);
+            if (source != ChainSnapshot::GRAPH_INPUT) {
+                consumers[source].push_back(i);
+                ++indegree[i];
+            }
+        }
+    }
+    
+    // Kahn's algorithm, always taking the ready node with the lowest position
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> level(count, 0);
+    std::vector<bool> done(count, false);
+    order.reserve(count);
+    while (order.size() < count) {
+        uint32_t next = NOT_FOUND;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!done[i] && indegree[i] == 0) {
+                next = i;
+                break;
+            }
+        }
+        if (next == NOT_FOUND) {
+            std::cerr << "Processing graph contains a cycle, dropping "
+                      << (count - order.size()) << " nodes" << std::endl;
+            break;
+        }
+        done[next] = true;
+        order.push_back(next);
+        for (uint32_t consumer : consumers[next]) {
+            --indegree[consumer];
+            level[consumer] = std::max(level[consumer], level[next] + 1);
+        }
+    }
+    
+    std::vector<uint32_t> topoIndex(count, NOT_FOUND);
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        topoIndex[order[i]] = i;
+    }
+    auto remap = [&topoIndex](uint32_t source) {
+        return source == ChainSnapshot::GRAPH_INPUT ? source : topoIndex[source];
+    };
+    
+    const uint32_t nodeCount = static_cast<uint32_t>(order.size());
+    snapshot->nodeIds.reserve(nodeCount);
+    snapshot->nodes.reserve(nodeCount);
+    snapshot->graph.resize(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const NodeInfo* info = infos[order[i]];
+        snapshot->nodeIds.push_back(info->nodeId);
+        snapshot->nodes.push_back(info->node.get());
+        snapshot->transferPending = snapshot->transferPending || info->node->IsTransferPending();
+        
+        ChainSnapshot::GraphNode& graphNode = snapshot->graph[i];
+        for (uint32_t source : sources[order[i]]) {
+            source = remap(source);
+            if (source == NOT_FOUND) {
+                continue;
+            }
+            graphNode.sources.push_back(source);
+            if (source != ChainSnapshot::GRAPH_INPUT) {
+                snapshot->graph[source].consumers.push_back(i);
+                ++graphNode.dependencyCount;
+            }
+        }
+        if (graphNode.dependencyCount == 0) {
+            snapshot->roots.push_back(i);
+        }
+    }
+    
+    std::vector<uint32_t> outputReaders(nodeCount, 0);
+    for (uint32_t sourceId : outputSources_) {
+        uint32_t source = sourceId == GRAPH_IO ? ChainSnapshot::GRAPH_INPUT : indexOf(sourceId);
+        if (source == NOT_FOUND) {
+            continue;
+        }
+        source = remap(source);
+        if (source == NOT_FOUND) {
+            continue;
+        }
+        snapshot->outputSources.push_back(source);
+        if (source != ChainSnapshot::GRAPH_INPUT) {
+            ++outputReaders[source];
+        }
+    }
+    
+    // Buffer assignment: a node whose only source is a node it alone reads
+    // continues in that node's buffer set, so plain series chains run in
+    // place. Everything else gets a set of its own.
+    uint32_t bufferCount = 0;
+    std::vector<uint32_t> bufferHead;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        ChainSnapshot::GraphNode& graphNode = snapshot->graph[i];
+        if (graphNode.sources.size() == 1 && graphNode.sources[0] != ChainSnapshot::GRAPH_INPUT) {
+            uint32_t source = graphNode.sources[0];
+            if (snapshot->graph[source].consumers.size() + outputReaders[source] == 1) {
+                graphNode.buffer = snapshot->graph[source].buffer;
+                graphNode.inheritsBuffer = true;
+                continue;
+            }
+        }
+        graphNode.buffer = bufferCount++;
+        bufferHead.push_back(i);
+    }
+    
+    // A single node feeding the output renders straight into it. The caller
+    // may hand in aliased input/output buffers, which is only harmless when
+    // the first node of that set is the sole reader of the input.
+    if (snapshot->outputSources.size() == 1 && snapshot->outputSources[0] != ChainSnapshot::GRAPH_INPUT) {
+        snapshot->outputBoundBuffer = snapshot->graph[snapshot->outputSources[0]].buffer;
+        
+        uint32_t inputReaders = 0;
+        for (const auto& graphNode : snapshot->graph) {
+            inputReaders += static_cast<uint32_t>(
+                std::count(graphNode.sources.begin(), graphNode.sources.end(), ChainSnapshot::GRAPH_INPUT));
+        }
+        const auto& head = snapshot->graph[bufferHead[snapshot->outputBoundBuffer]];
+        snapshot->inputAliasSafe = inputReaders == 1 && head.sources.size() == 1 &&
+                                   head.sources[0] == ChainSnapshot::GRAPH_INPUT;
+    }
+    
+    // Only go parallel when some level of the graph has independent nodes
+    snapshot->threadPool = threadPool_.get();
+    if (snapshot->threadPool && snapshot->threadPool->GetWorkerCount() > 0) {
+        std::vector<uint32_t> width;
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            uint32_t depth = level[order[i]];
+            if (depth >= width.size()) {
+                width.resize(depth + 1, 0);
+            }
+            if (++width[depth] > 1) {
+                snapshot->parallel = true;
+            }
+        }
+    }
+    
+    // Allocate everything the audio thread touches up front
+    uint32_t channels;
+    uint32_t blockSize;
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        channels = channels_;
+        blockSize = blockSize_;
+        snapshot->sampleRate = sampleRate_;
+    }
+    for (const ProcessingNode* node : snapshot->nodes) {
+        channels = std::max(channels, node->GetChannelCount());
+    }
+    snapshot->channels = channels;
+    snapshot->maxFrames = std::max(blockSize, MIN_GRAPH_BLOCK);
+    snapshot->denormalCheck = &denormalCheck_;
+    
+    uint32_t setCount = bufferCount + 1;
+    snapshot->bufferStorage.assign(static_cast<size_t>(setCount) * channels * snapshot->maxFrames, 0.0f);
+    snapshot->bufferPtrs.resize(static_cast<size_t>(setCount) * channels);
+    snapshot->bufferSets.resize(setCount);
+    for (uint32_t set = 0; set < setCount; ++set) {
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            size_t index = static_cast<size_t>(set) * channels + ch;
+            snapshot->bufferPtrs[index] = snapshot->bufferStorage.data() + index * snapshot->maxFrames;
+        }
+        snapshot->bufferSets[set] = &snapshot->bufferPtrs[static_cast<size_t>(set) * channels];
+    }
+    
+    size_t ioChannels = std::max<size_t>(channels, MAX_IO_CHANNELS);
+    snapshot->inputSlice.resize(ioChannels, nullptr);
+    snapshot->outputSlice.resize(ioChannels, nullptr);
+    
+    snapshot->pending.reset(new std::atomic<uint32_t>[std::max<uint32_t>(nodeCount, 1)]);
+    snapshot->readyQueue.reset(new std::atomic<uint32_t>[std::max<uint32_t>(nodeCount, 1)]);
+    
+    // Latencies as the nodes report them now, until the first block
+    uint64_t totalLatency = 0;
+    snapshot->arrival.assign(nodeCount, 0);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        totalLatency += snapshot->nodes[i]->GetReportedLatency();
+        snapshot->arrival[i] = LatestArrival(snapshot.get(), snapshot->graph[i].sources) +
+                               snapshot->nodes[i]->GetLatency();
+    }
+    snapshot->latency = LatestArrival(snapshot.get(), snapshot->outputSources);
+    
+    // A delay line per mixed source, with room for the latencies to double.
+    // Longer delays are clamped until the next snapshot.
+    uint32_t delayCount = 0;
+    for (auto& graphNode : snapshot->graph) {
+        if (graphNode.sources.size() > 1) {
+            graphNode.firstDelay = delayCount;
+            delayCount += static_cast<uint32_t>(graphNode.sources.size());
+        }
+    }
+    if (snapshot->outputSources.size() > 1) {
+        snapshot->outputFirstDelay = delayCount;
+        delayCount += static_cast<uint32_t>(snapshot->outputSources.size());
+    }
+    if (delayCount > 0) {
+        uint64_t needed = std::max<uint64_t>(MIN_COMPENSATION, 2 * totalLatency);
+        uint32_t size = 1;
+        while (size <= needed && size < (1u << 24)) {
+            size <<= 1;
+        }
+        snapshot->maxDelay = size - 1;
+        snapshot->delayLines.resize(delayCount);
+        for (auto& line : snapshot->delayLines) {
+            line.storage.assign(static_cast<size_t>(size) * channels, 0.0f);
+            line.mask = size - 1;
+        }
+    }
+    
+    return snapshot;
+}
+
+void AudioProcessingChain::PublishSnapshot(std::vector<std::shared_ptr<void>> fadeNodes) {
+    std::unique_ptr<ChainSnapshot> snapshot = BuildSnapshot();
+    snapshot->id = globalEpoch_.load() + 1;
+    latency_.store(snapshot->latency);
+    
+    // The replaced snapshot and its nodes are owned by the new one until it
+    // is retired in turn
+    bool fading = !fadeNodes.empty() && snapshot_.load();
+    if (fading) {
+        snapshot->fadeFrom.reset(snapshot_.load());
+        snapshot->fadeNodes = std::move(fadeNodes);
+        snapshot->fadeFrames = std::max<uint32_t>(1, snapshot->sampleRate * FORMAT_FADE_MS / 1000);
+        
+        // Room for the faded frames plus one more slice of the old graph
+        size_t fadeChannels = snapshot->inputSlice.size();
+        size_t fadeStride = snapshot->fadeFrames + snapshot->fadeFrom->maxFrames;
+        snapshot->fadeStorage.resize(fadeChannels * fadeStride, 0.0f);
+        snapshot->fadeBuffers.resize(fadeChannels);
+        snapshot->fadeInputs.resize(fadeChannels);
+        snapshot->fadeOutputs.resize(fadeChannels);
+        for (size_t ch = 0; ch < fadeChannels; ++ch) {
+            snapshot->fadeBuffers[ch] = snapshot->fadeStorage.data() + ch * fadeStride;
+        }
+    } else {
+        for (auto& node : fadeNodes) {
+            Retire(std::move(node));
+        }
+    }
+    
+    ChainSnapshot* previous = snapshot_.exchange(snapshot.release());
+    uint64_t epoch = globalEpoch_.fetch_add(1) + 1;
+    
+    if (previous && !fading) {
+        retired_.push_back({epoch, std::shared_ptr<ChainSnapshot>(previous)});
+    }
+    for (auto& object : pendingRetired_) {
+        retired_.push_back({epoch, std::move(object)});
+    }
+    pendingRetired_.clear();
+    
+    CollectRetiredLocked();
+}
+
+void AudioProcessingChain::Retire(std::shared_ptr<void> object) {
+    // Freed once the next published snapshot has been picked up
+    if (object) {
+        pendingRetired_.push_back(std::move(object));
+    }
+}
+
+void AudioProcessingChain::CollectRetired() {
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    CollectRetiredLocked();
+}
+
+void AudioProcessingChain::CollectRetiredLocked() {
+    for (auto& info : nodes_) {
+        if (info.node) {
+            info.node->ReleaseTransferSource();
+        }
+    }
+    
+    // READER_IDLE is UINT64_MAX, so an idle reader releases everything
+    uint64_t readerEpoch = readerEpoch_.load();
+    retired_.erase(
+        std::remove_if(retired_.begin(), retired_.end(),
+                      [readerEpoch](const RetiredItem& item) {
+                          return item.epoch <= readerEpoch;
+                      }),
+        retired_.end());
+}
+
+ChainSnapshot* AudioProcessingChain::AcquireSnapshot() {
+    readerEpoch_.store(globalEpoch_.load());
+    return snapshot_.load();
+}
+
+void AudioProcessingChain::ReleaseSnapshot() {
+    readerEpoch_.store(READER_IDLE);
+}
+
+AudioProcessingChain::ChainStats AudioProcessingChain::GetStats() const {
+    ChainStats stats;
+    stats.callback = callbackTiming_.GetStats();
+    stats.blocks = blockCount_.load();
+    stats.xruns = xrunCount_.load();
+    stats.cpuUsage = cpuUsage_.load();
+    stats.latency = latency_.load();
+    
+    // nodesMutex_ only keeps nodes alive here; the audio thread never takes it
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    for (const auto& info : nodes_) {
+        if (!info.node) {
+            continue;
+        }
+        
+        NodeStats nodeStats;
+        nodeStats.nodeId = info.nodeId;
+        nodeStats.name = info.node->GetPlugin() ? info.node->GetPlugin()->GetInfo().name : "Sum";
+        nodeStats.timing = info.node->GetTiming().GetStats();
+        nodeStats.subnormalSamples = info.node->GetSubnormalSamples();
+        nodeStats.subnormalBlocks = info.node->GetSubnormalBlocks();
+        nodeStats.latency = info.node->GetLatency();
+        stats.nodes.push_back(nodeStats);
+    }
+    
+    return stats;
+}
+
+std::string AudioProcessingChain::DumpStats() const {
+    ChainStats stats = GetStats();
+    
+    std::ostringstream out;
+    out << "Chain: " << stats.blocks << " blocks, " << stats.xruns << " xruns, DSP load "
+        << static_cast<int>(stats.cpuUsage + 0.5) << "%, latency " << stats.latency << " frames\n";
+    out << "  callback  " << FormatTimingStats(stats.callback) << "\n";
+    for (const auto& node : stats.nodes) {
+        out << "  [" << node.nodeId << "] " << node.name << "  " << FormatTimingStats(node.timing) << "\n";
+        if (node.latency > 0) {
+            out << "      latency " << node.latency << " frames\n";
+        }
+        if (node.subnormalSamples > 0) {
+            out << "      subnormal output in " << node.subnormalBlocks << " blocks ("
+                << node.subnormalSamples << " samples)\n";
+        }
+    }
+    
+    return out.str();
+}
+
 void AudioProcessingChain::ResetPerformanceCounters() {
     cpuUsage_.store(0.0);
     processedFrames_.store(0);
-    lastCpuMeasurement_ = std::chrono::high_resolution_clock::now();
+    callbackTiming_.Reset();
+    blockCount_.store(0);
+    xrunCount_.store(0);
+    
+    std::lock_guard<std::mutex> lock(nodesMutex_);
+    for (auto& info : nodes_) {
+        if (info.node) {
+            info.node->GetTiming().Reset();
+            info.node->ResetSubnormals();
+        }
+    }
 }
 
 // Simplified preset manager implementation
 ChainPresetManager::ChainPresetManager() {
-    presetsDirectory_ = utils::GetExecutableDirectory() + "\\presets";
+    presetsDirectory_ = utils::JoinPath(utils::GetExecutableDirectory(), "presets");
     CreatePresetsDirectory();
 }
 
@@ -649,7 +2468,7 @@ std::string ChainPresetManager::GetPresetsDirectory() const {
 }
 
 bool ChainPresetManager::CreatePresetsDirectory() const {
-    return CreateDirectoryA(presetsDirectory_.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+    return utils::MakeDirectory(presetsDirectory_);
 }
 
 } // namespace violet
\ No newline at end of file
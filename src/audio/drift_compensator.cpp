@@ -0,0 +1,201 @@
+#include "violet/drift_compensator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace violet {
+
+namespace {
+
+// Loop tuning, in seconds. The loop settles in a few tens of seconds, slow
+// enough that ratio changes are far below anything audible; the smoothing
+// takes out what's left of the packet timing in the delay measurement.
+constexpr double DELAY_SMOOTHING_SECONDS = 1.0;
+constexpr double LOOP_BANDWIDTH = 0.1;          // rad/s
+constexpr double LOOP_DAMPING = 0.8;
+constexpr double LOOP_KP = 2.0 * LOOP_DAMPING * LOOP_BANDWIDTH;
+constexpr double LOOP_KI = LOOP_BANDWIDTH * LOOP_BANDWIDTH;
+
+// No two real device clocks are further apart than this
+constexpr double MAX_CORRECTION = 0.005;
+
+// Catmull-Rom through x1..x2, exact at t == 0
+inline float Cubic(float x0, float x1, float x2, float x3, float t) {
+    float c1 = 0.5f * (x2 - x0);
+    float c2 = x0 - 2.5f * x1 + 2.0f * x2 - 0.5f * x3;
+    float c3 = 0.5f * (x3 - x0) + 1.5f * (x1 - x2);
+    return ((c3 * t + c2) * t + c1) * t + x1;
+}
+
+} // namespace
+
+DriftCompensator::DriftCompensator()
+    : channels_(0), maxPull_(0), targetFill_(0), sampleRate_(48000.0), fifo_(0, 0),
+      priming_(true), captureEnd_(-1.0), phase_(0.0), targetDelay_(0.0), filteredError_(0.0),
+      integral_(0.0), ratio_(1.0), statusRatio_(1.0), statusDelay_(0.0), resyncs_(0) {
+}
+
+void DriftCompensator::Configure(uint32_t channels, uint32_t maxPush, uint32_t maxPull,
+                                 uint32_t targetFill, double sampleRate) {
+    channels_ = channels;
+    maxPull_ = maxPull;
+    targetFill_ = std::max(targetFill, maxPull);
+    sampleRate_ = sampleRate > 0.0 ? sampleRate : 48000.0;
+
+    // Room for the target, a burst of packets and the loop's excursions
+    fifo_.Resize(channels, 2 * (targetFill_ + maxPush + maxPull));
+
+    // A pull reads up to ratio * frames + 3 input frames past the history
+    uint32_t maxInput = static_cast<uint32_t>(std::ceil(maxPull * (1.0 + MAX_CORRECTION))) + 4;
+    history_.assign(static_cast<size_t>(channels) * HISTORY, 0.0f);
+    work_.assign(HISTORY + maxInput, 0.0f);
+    indices_.assign(maxPull, 0);
+    fractions_.assign(maxPull, 0.0f);
+
+    Reset();
+}
+
+void DriftCompensator::Reset() {
+    fifo_.Clear();
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    priming_ = true;
+    captureEnd_ = -1.0;
+    phase_ = 0.0;
+    targetDelay_ = 0.0;
+    filteredError_ = 0.0;
+    integral_ = 0.0;
+    ratio_ = 1.0;
+    statusRatio_.store(1.0, std::memory_order_relaxed);
+    statusDelay_.store(0.0, std::memory_order_relaxed);
+    resyncs_.store(0, std::memory_order_relaxed);
+}
+
+void DriftCompensator::Push(const float* const* inputs, uint32_t frames, double captureTime) {
+    if (channels_ == 0 || frames == 0) {
+        return;
+    }
+
+    size_t written = fifo_.Write(inputs, frames);
+    if (written < frames) {
+        // The render side stalled; drop what's queued and prime again
+        Resync();
+        fifo_.Write(inputs, frames);
+    }
+    // A packet without a timestamp continues from the previous one
+    if (captureTime >= 0.0) {
+        captureEnd_ = captureTime + frames / sampleRate_;
+    } else if (captureEnd_ >= 0.0) {
+        captureEnd_ += frames / sampleRate_;
+    }
+}
+
+void DriftCompensator::Resync() {
+    fifo_.Clear();
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    priming_ = true;
+    phase_ = 0.0;
+    resyncs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+double DriftCompensator::MeasureDelay(double playTime) const {
+    // Frames queued, plus the frames the capture clock has recorded since
+    // the last packet that will have to be queued by play time
+    double delay = static_cast<double>(fifo_.GetAvailableFrames());
+    if (playTime >= 0.0 && captureEnd_ >= 0.0) {
+        delay += (playTime - captureEnd_) * sampleRate_;
+    }
+    return delay;
+}
+
+void DriftCompensator::UpdateLoop(uint32_t frames, double delay) {
+    double dt = frames / sampleRate_;
+    double alpha = 1.0 - std::exp(-dt / DELAY_SMOOTHING_SECONDS);
+    filteredError_ += alpha * ((delay - targetDelay_) - filteredError_);
+
+    // PI on the smoothed delay. While the correction is clamped the
+    // integral holds so it can't wind up past the clock offset.
+    double correction = (LOOP_KP * filteredError_ + LOOP_KI * (integral_ + filteredError_ * dt)) / sampleRate_;
+    if (std::fabs(correction) < MAX_CORRECTION) {
+        integral_ += filteredError_ * dt;
+    }
+    correction = std::max(-MAX_CORRECTION, std::min(MAX_CORRECTION, correction));
+    ratio_ = 1.0 + correction;
+
+    statusRatio_.store(ratio_, std::memory_order_relaxed);
+    statusDelay_.store(targetDelay_ + filteredError_, std::memory_order_relaxed);
+}
+
+void DriftCompensator::Pull(float* const* outputs, uint32_t frames, double playTime) {
+    frames = std::min(frames, maxPull_);
+    if (channels_ == 0 || frames == 0) {
+        return;
+    }
+
+    double delay = MeasureDelay(playTime);
+    if (priming_) {
+        if (fifo_.GetAvailableFrames() < targetFill_) {
+            for (uint32_t ch = 0; ch < channels_; ++ch) {
+                std::fill(outputs[ch], outputs[ch] + frames, 0.0f);
+            }
+            return;
+        }
+        // Hold the delay the stream starts with; the integral keeps the
+        // last clock estimate across restarts
+        priming_ = false;
+        targetDelay_ = delay;
+        filteredError_ = 0.0;
+    }
+
+    UpdateLoop(frames, delay);
+
+    // Read positions relative to the history: output j interpolates between
+    // work[indices[j]] and work[indices[j] + 1]
+    double position = phase_;
+    for (uint32_t j = 0; j < frames; ++j) {
+        double whole = std::floor(position);
+        indices_[j] = 1 + static_cast<uint32_t>(whole);
+        fractions_[j] = static_cast<float>(position - whole);
+        position += ratio_;
+    }
+    uint32_t advance = static_cast<uint32_t>(std::floor(position));
+    uint32_t needed = std::max(indices_[frames - 1], advance);
+
+    if (fifo_.GetAvailableFrames() < needed) {
+        // Capture fell behind; play silence until the target refills
+        Resync();
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            std::fill(outputs[ch], outputs[ch] + frames, 0.0f);
+        }
+        return;
+    }
+
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+        float* history = history_.data() + static_cast<size_t>(ch) * HISTORY;
+        float* work = work_.data();
+        std::copy(history, history + HISTORY, work);
+
+        CircularBuffer<float>* ring = fifo_.GetChannelBuffer(ch);
+        ring->Peek(work + HISTORY, needed);
+        ring->Skip(advance);
+
+        float* out = outputs[ch];
+        for (uint32_t j = 0; j < frames; ++j) {
+            const float* x = work + indices_[j] - 1;
+            out[j] = Cubic(x[0], x[1], x[2], x[3], fractions_[j]);
+        }
+
+        std::copy(work + advance, work + advance + HISTORY, history);
+    }
+    phase_ = position - advance;
+}
+
+DriftStatus DriftCompensator::GetStatus() const {
+    DriftStatus status;
+    status.active = channels_ > 0;
+    status.ratioPpm = (statusRatio_.load(std::memory_order_relaxed) - 1.0) * 1e6;
+    status.latencyFrames = statusDelay_.load(std::memory_order_relaxed);
+    status.targetFrames = targetFill_;
+    status.resyncs = resyncs_.load(std::memory_order_relaxed);
+    return status;
+}
+
+} // namespace violet
@@ -0,0 +1,106 @@
+#include "violet/glitch_log.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
+
+namespace violet {
+
+static_assert(std::is_trivially_copyable<GlitchEvent>::value, "GlitchEvent is copied word by word");
+
+const char* GetGlitchTypeName(GlitchType type) {
+    switch (type) {
+    case GlitchType::CallbackOverrun: return "callback overrun";
+    case GlitchType::RenderUnderrun:  return "render underrun";
+    case GlitchType::CaptureOverrun:  return "capture overrun";
+    case GlitchType::CaptureUnderrun: return "capture underrun";
+    }
+    return "unknown";
+}
+
+GlitchLog::GlitchLog()
+    : writeIndex_(0)
+    , resetIndex_(0) {
+    for (Slot& slot : slots_) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+        for (auto& word : slot.words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void GlitchLog::Record(const GlitchEvent& event) {
+    uint64_t words[EVENT_WORDS] = {};
+    memcpy(words, &event, sizeof(event));
+
+    uint64_t index = writeIndex_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index & (CAPACITY - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < EVENT_WORDS; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+std::vector<GlitchEvent> GlitchLog::GetRecent(uint32_t count) const {
+    uint64_t end = writeIndex_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(resetIndex_.load(std::memory_order_acquire),
+                              end - std::min<uint64_t>(end, std::min(count, CAPACITY)));
+
+    std::vector<GlitchEvent> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots_[index & (CAPACITY - 1)];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * (index + 1)) {
+            continue; // still being written, or already overwritten
+        }
+
+        uint64_t words[EVENT_WORDS];
+        for (size_t i = 0; i < EVENT_WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        GlitchEvent event;
+        memcpy(&event, words, sizeof(event));
+        events.push_back(event);
+    }
+    return events;
+}
+
+uint64_t GlitchLog::GetTotalCount() const {
+    return writeIndex_.load(std::memory_order_acquire) - resetIndex_.load(std::memory_order_acquire);
+}
+
+void GlitchLog::Reset() {
+    resetIndex_.store(writeIndex_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+std::string FormatGlitches(const std::vector<GlitchEvent>& events, uint64_t originNanos) {
+    std::ostringstream out;
+    out << std::fixed;
+    for (const auto& event : events) {
+        double seconds = event.timeNanos >= originNanos ? (event.timeNanos - originNanos) / 1e9 : 0.0;
+        out << "  " << std::setprecision(3) << std::setw(10) << seconds << " s  "
+            << GetGlitchTypeName(event.type) << ", " << event.frames << " frames, callback "
+            << std::setprecision(2) << event.callbackNanos / 1e6 << " of "
+            << event.deadlineNanos / 1e6 << " ms";
+        if (event.context.slowestNodeId != 0) {
+            out << ", slowest node [" << event.context.slowestNodeId << "] "
+                << event.context.slowestNodeNanos / 1e6 << " ms";
+        }
+        if (event.context.snapshotId != 0) {
+            out << ", graph " << event.context.snapshotId;
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+} // namespace violet
@@ -6,6 +6,7 @@
 
 namespace violet {
 
+#ifdef _WIN32
 MidiHandler::MidiHandler()
     : inputHandle_(nullptr)
     , outputHandle_(nullptr)
@@ -370,6 +371,7 @@ std::string MidiHandler::MessageToString(const MidiMessage& message) {
         << " D2:" << static_cast<int>(message.data2);
     return oss.str();
 }
+#endif // _WIN32
 
 // MidiParameterMapper implementation
 MidiParameterMapper::MidiParameterMapper()
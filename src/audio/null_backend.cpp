@@ -0,0 +1,208 @@
+#include "violet/null_backend.h"
+#include "violet/alloc_trap.h"
+#include "violet/realtime_thread.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace violet {
+
+namespace {
+
+bool IsFileDevice(const std::string& deviceId, std::string& path) {
+    static const std::string prefix = "file:";
+    if (deviceId.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    path = deviceId.substr(prefix.size());
+    return true;
+}
+
+} // namespace
+
+NullBackend::NullBackend()
+    : freewheel_(false)
+    , inputPosition_(0)
+    , shouldStop_(false)
+    , processedFrames_(0) {
+}
+
+NullBackend::~NullBackend() {
+    Close();
+}
+
+std::vector<AudioDevice> NullBackend::EnumerateDevices() {
+    // File devices take any path, so only the null device is listed
+    AudioDevice device;
+    device.id = "null";
+    device.name = "Null device";
+    device.isDefault = true;
+    device.isInput = true;
+    device.isOutput = true;
+    return { device };
+}
+
+bool NullBackend::Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+                       const AudioFormat& requested, AudioFormat& actual) {
+    Close();
+    
+    if (requested.sampleRate == 0 || requested.channels == 0 || requested.bufferSize == 0) {
+        std::cerr << "Null backend: invalid format" << std::endl;
+        return false;
+    }
+    format_ = requested;
+    format_.bitsPerSample = 32;
+    
+    std::string path;
+    std::string error;
+    if (IsFileDevice(inputDeviceId, path)) {
+        if (!WavFile::Read(path, inputFile_, error)) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        if (inputFile_.sampleRate != format_.sampleRate) {
+            std::cerr << "Warning: " << path << " is " << inputFile_.sampleRate << " Hz, playing it at "
+                      << format_.sampleRate << " Hz" << std::endl;
+        }
+    }
+    inputDeviceId_ = inputDeviceId.empty() ? "null" : inputDeviceId;
+    
+    if (IsFileDevice(outputDeviceId, outputPath_)) {
+        // Grows on the audio thread past this, so reserve a typical run
+        size_t reserve = static_cast<size_t>(OUTPUT_RESERVE_SECONDS * format_.sampleRate);
+        outputFile_.sampleRate = format_.sampleRate;
+        outputFile_.channels.assign(format_.channels, std::vector<float>());
+        for (auto& channel : outputFile_.channels) {
+            channel.reserve(reserve);
+        }
+    }
+    outputDeviceId_ = outputDeviceId.empty() ? "null" : outputDeviceId;
+    
+    size_t bufferSize = static_cast<size_t>(format_.bufferSize) * format_.channels;
+    inputBuffer_.assign(bufferSize, 0.0f);
+    outputBuffer_.assign(bufferSize, 0.0f);
+    inputPtrs_.resize(format_.channels);
+    outputPtrs_.resize(format_.channels);
+    for (uint32_t ch = 0; ch < format_.channels; ++ch) {
+        inputPtrs_[ch] = inputBuffer_.data() + static_cast<size_t>(ch) * format_.bufferSize;
+        outputPtrs_[ch] = outputBuffer_.data() + static_cast<size_t>(ch) * format_.bufferSize;
+    }
+    
+    inputPosition_ = 0;
+    processedFrames_.store(0);
+    actual = format_;
+    
+    std::cout << "Null backend opened: " << format_.sampleRate << " Hz, " << format_.channels << " ch, "
+              << format_.bufferSize << " frames" << (freewheel_ ? " (freewheel)" : "") << std::endl;
+    return true;
+}
+
+void NullBackend::Close() {
+    Stop();
+    
+    if (!outputPath_.empty()) {
+        std::string error;
+        if (WavFile::Write(outputPath_, outputFile_, WavFile::SampleFormat::Float32, error)) {
+            std::cout << "Wrote " << outputFile_.GetFrameCount() << " frames to " << outputPath_ << std::endl;
+        } else {
+            std::cerr << error << std::endl;
+        }
+    }
+    
+    outputPath_.clear();
+    outputFile_ = AudioFileData();
+    inputFile_ = AudioFileData();
+    inputDeviceId_.clear();
+    outputDeviceId_.clear();
+}
+
+bool NullBackend::Start(AudioProcessCallback callback) {
+    if (inputPtrs_.empty() || audioThread_.joinable()) {
+        return false;
+    }
+    
+    callback_ = std::move(callback);
+    shouldStop_.store(false);
+    audioThread_ = std::thread(&NullBackend::AudioThreadProc, this);
+    return true;
+}
+
+void NullBackend::Stop() {
+    if (!audioThread_.joinable()) {
+        return;
+    }
+    
+    shouldStop_.store(true);
+    audioThread_.join();
+}
+
+double NullBackend::GetLatency() const {
+    return format_.sampleRate ? format_.bufferSize * 1000.0 / format_.sampleRate : 0.0;
+}
+
+void NullBackend::AudioThreadProc() {
+    using Clock = std::chrono::steady_clock;
+    PrepareRealtimeThread();
+    
+    const uint32_t channels = format_.channels;
+    const uint32_t frames = format_.bufferSize;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(frames) / format_.sampleRate));
+    
+    uint64_t inputFrames = inputFile_.GetFrameCount();
+    uint32_t inputChannels = inputFile_.GetChannelCount();
+    Clock::time_point nextPeriod = Clock::now();
+    
+    while (!shouldStop_.load()) {
+        if (!freewheel_) {
+            nextPeriod += period;
+            Clock::time_point now = Clock::now();
+            if (nextPeriod > now) {
+                std::this_thread::sleep_until(nextPeriod);
+            } else if (now - nextPeriod > period) {
+                // Fell a whole period behind, where a device would have run
+                // dry; don't try to catch up
+                ReportXrun(GlitchType::RenderUnderrun, frames);
+                nextPeriod = now;
+            }
+        }
+        
+        // Mono files feed every channel, like the offline renderer
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            float* dest = inputPtrs_[ch];
+            uint32_t source = inputChannels == 1 ? 0 : ch;
+            if (source >= inputChannels || inputFrames == 0) {
+                std::fill(dest, dest + frames, 0.0f);
+                continue;
+            }
+            const float* samples = inputFile_.channels[source].data();
+            uint64_t position = inputPosition_;
+            for (uint32_t offset = 0; offset < frames;) {
+                uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(frames - offset, inputFrames - position));
+                memcpy(dest + offset, samples + position, count * sizeof(float));
+                offset += count;
+                position = (position + count) % inputFrames;
+            }
+        }
+        if (inputFrames > 0) {
+            inputPosition_ = (inputPosition_ + frames) % inputFrames;
+        }
+        
+        callback_(inputPtrs_.data(), outputPtrs_.data(), channels, frames);
+        
+        if (!outputPath_.empty()) {
+            // Recording grows without bound; the reserve in Open() covers
+            // the first minute
+            ScopedAllocationAllowed allowed;
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                auto& channel = outputFile_.channels[ch];
+                channel.insert(channel.end(), outputPtrs_[ch], outputPtrs_[ch] + frames);
+            }
+        }
+        
+        processedFrames_.fetch_add(frames);
+    }
+}
+
+} // namespace violet
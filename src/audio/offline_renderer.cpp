@@ -0,0 +1,198 @@
+#include "violet/offline_renderer.h"
+#include "violet/audio_processing_chain.h"
+#include "violet/performance_stats.h"
+#include "violet/realtime_thread.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace violet {
+
+namespace {
+
+// Converts a whole file, dropping the filter delay from the front and
+// flushing it out of the end so the result lines up with the source
+bool ResampleFile(const AudioFileData& source, uint32_t sampleRate, ResamplerQuality quality,
+                  AudioFileData& result, std::string& error) {
+    constexpr uint32_t CHUNK = 4096;
+    uint32_t channels = source.GetChannelCount();
+    Resampler resampler;
+    if (!resampler.Configure(channels, source.sampleRate, sampleRate, quality, CHUNK)) {
+        error = "Cannot resample " + std::to_string(source.sampleRate) + " Hz to " +
+                std::to_string(sampleRate) + " Hz";
+        return false;
+    }
+
+    uint64_t sourceFrames = source.GetFrameCount();
+    uint64_t frames = static_cast<uint64_t>(std::llround(static_cast<double>(sourceFrames) * sampleRate /
+                                                         source.sampleRate));
+    uint64_t skip = static_cast<uint64_t>(std::llround(resampler.GetLatency()));
+    result.sampleRate = sampleRate;
+    result.Resize(channels, frames);
+
+    std::vector<float> chunk(static_cast<size_t>(channels) * CHUNK, 0.0f);
+    uint32_t maxOutput = resampler.GetMaxOutputFrames(CHUNK);
+    std::vector<float> converted(static_cast<size_t>(channels) * maxOutput);
+    std::vector<const float*> inputPtrs(channels);
+    std::vector<float*> outputPtrs(channels);
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        inputPtrs[ch] = chunk.data() + static_cast<size_t>(ch) * CHUNK;
+        outputPtrs[ch] = converted.data() + static_cast<size_t>(ch) * maxOutput;
+    }
+
+    // Produced frames count from the start of the delayed stream; past the
+    // end of the source the filter is fed silence
+    uint64_t produced = 0;
+    for (uint64_t offset = 0; produced < skip + frames; offset += CHUNK) {
+        uint64_t available = offset < sourceFrames ? std::min<uint64_t>(CHUNK, sourceFrames - offset) : 0;
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            float* block = chunk.data() + static_cast<size_t>(ch) * CHUNK;
+            if (available > 0) {
+                memcpy(block, source.channels[ch].data() + offset, available * sizeof(float));
+            }
+            std::fill(block + available, block + CHUNK, 0.0f);
+        }
+
+        uint32_t count = resampler.Process(inputPtrs.data(), CHUNK, outputPtrs.data());
+        uint64_t first = std::max(produced, skip);
+        uint64_t last = std::min(produced + count, skip + frames);
+        for (uint64_t n = first; n < last; ++n) {
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                result.channels[ch][n - skip] = outputPtrs[ch][n - produced];
+            }
+        }
+        produced += count;
+    }
+    return true;
+}
+
+} // namespace
+
+OfflineRenderer::OfflineRenderer(AudioProcessingChain* chain)
+    : chain_(chain) {
+}
+
+bool OfflineRenderer::Prepare(const AudioFileData& input, const OfflineRenderOptions& options) {
+    if (!chain_) {
+        lastError_ = "No processing chain";
+        return false;
+    }
+    if (input.GetChannelCount() == 0 || input.sampleRate == 0) {
+        lastError_ = "Input has no audio";
+        return false;
+    }
+    if (options.blockSize == 0) {
+        lastError_ = "Block size must be at least one frame";
+        return false;
+    }
+
+    // Input at another rate is converted to the render rate in Render()
+    uint32_t sampleRate = options.sampleRate ? options.sampleRate : input.sampleRate;
+    if (sampleRate != input.sampleRate && !GetResamplerFilter(input.sampleRate, sampleRate, options.quality)) {
+        lastError_ = "Cannot resample " + std::to_string(input.sampleRate) + " Hz to " +
+                     std::to_string(sampleRate) + " Hz";
+        return false;
+    }
+    if (options.outputSampleRate && options.outputSampleRate != sampleRate &&
+        !GetResamplerFilter(sampleRate, options.outputSampleRate, options.quality)) {
+        lastError_ = "Cannot resample " + std::to_string(sampleRate) + " Hz to " +
+                     std::to_string(options.outputSampleRate) + " Hz";
+        return false;
+    }
+
+    uint32_t channels = options.channels ? options.channels : input.GetChannelCount();
+    if (!chain_->SetFormat(sampleRate, channels, options.blockSize)) {
+        return false;
+    }
+    
+    // Render() only runs whole blocks, so plugins can rely on that
+    chain_->SetFixedBlockLength(true);
+
+    // Plugins already in the chain are re-instantiated in the background;
+    // offline there is no reason to render any of it at the old format
+    chain_->WaitForFormatChange();
+    return true;
+}
+
+bool OfflineRenderer::Render(const AudioFileData& input, AudioFileData& output,
+                             const OfflineRenderOptions& options, OfflineRenderResult& result) {
+    if (!Prepare(input, options)) {
+        return false;
+    }
+
+    uint32_t sampleRate, channels, blockSize;
+    chain_->GetFormat(sampleRate, channels, blockSize);
+
+    result = OfflineRenderResult();
+    uint64_t startTime = MonotonicNanos();
+
+    AudioFileData converted;
+    if (input.sampleRate != sampleRate &&
+        !ResampleFile(input, sampleRate, options.quality, converted, lastError_)) {
+        return false;
+    }
+    const AudioFileData& chainInput = input.sampleRate != sampleRate ? converted : input;
+
+    uint64_t inputFrames = chainInput.GetFrameCount();
+    uint64_t tailFrames = static_cast<uint64_t>(std::max(0.0, options.tailSeconds) * sampleRate);
+    uint64_t totalFrames = inputFrames + tailFrames;
+
+    // Plugin latency is rendered past the end and dropped from the front.
+    // The last block is padded with silence and cut off again afterwards.
+    uint32_t latency = chain_->GetLatency();
+    uint64_t renderFrames = (totalFrames + latency + blockSize - 1) / blockSize * blockSize;
+    output.sampleRate = sampleRate;
+    output.Resize(channels, renderFrames);
+
+    // Mono input feeds every chain channel, otherwise extra channels get silence
+    uint32_t inputChannels = chainInput.GetChannelCount();
+    std::vector<std::vector<float>> inputBlock(channels, std::vector<float>(blockSize, 0.0f));
+    std::vector<float*> inputPtrs(channels);
+    std::vector<float*> outputPtrs(channels);
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        inputPtrs[ch] = inputBlock[ch].data();
+    }
+
+    // Same FPU mode as the live audio threads
+    ScopedDenormalFlush denormalFlush(IsDenormalFlushEnabled());
+    for (uint64_t offset = 0; offset < renderFrames; offset += blockSize) {
+        // Each block runs as it would on an audio thread, watched by the
+        // allocation trap (alloc_trap.h)
+        ScopedRealtimeTag realtimeTag;
+        uint32_t frames = blockSize;
+        uint64_t available = offset < inputFrames ? std::min<uint64_t>(frames, inputFrames - offset) : 0;
+
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            float* block = inputBlock[ch].data();
+            uint32_t source = inputChannels == 1 ? 0 : ch;
+            if (source < inputChannels && available > 0) {
+                memcpy(block, chainInput.channels[source].data() + offset, available * sizeof(float));
+            }
+            std::fill(block + available, block + frames, 0.0f);
+            outputPtrs[ch] = output.channels[ch].data() + offset;
+        }
+
+        chain_->Process(inputPtrs.data(), outputPtrs.data(), channels, frames);
+        ++result.blocks;
+    }
+    for (auto& channel : output.channels) {
+        channel.erase(channel.begin(), channel.begin() + latency);
+        channel.resize(totalFrames);
+    }
+
+    if (options.outputSampleRate && options.outputSampleRate != sampleRate) {
+        AudioFileData rendered = std::move(output);
+        if (!ResampleFile(rendered, options.outputSampleRate, options.quality, output, lastError_)) {
+            return false;
+        }
+    }
+
+    result.wallSeconds = (MonotonicNanos() - startTime) / 1e9;
+    result.frames = totalFrames;
+    result.latencyFrames = latency;
+    result.audioSeconds = static_cast<double>(totalFrames) / sampleRate;
+    result.realtimeFactor = result.wallSeconds > 0.0 ? result.audioSeconds / result.wallSeconds : 0.0;
+    return true;
+}
+
+} // namespace violet
@@ -0,0 +1,66 @@
+#include "violet/parameter_queue.h"
+
+namespace violet {
+
+ParameterQueue::ParameterQueue(uint32_t capacity)
+    : capacity_(1)
+    , mask_(0)
+    , enqueuePos_(0)
+    , dequeuePos_(0)
+    , dropped_(0) {
+    
+    while (capacity_ < capacity) {
+        capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    
+    slots_.reset(new Slot[capacity_]);
+    for (uint32_t i = 0; i < capacity_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+ParameterQueue::~ParameterQueue() = default;
+
+bool ParameterQueue::Push(const ParameterChange& change) {
+    uint64_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    
+    while (true) {
+        Slot& slot = slots_[pos & mask_];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        
+        if (diff == 0) {
+            // Slot is free for this lap; claim it
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.change = change;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // The consumer hasn't freed this slot yet: full
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ParameterQueue::Pop(ParameterChange& change) {
+    uint64_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[pos & mask_];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    
+    // A claimed slot isn't readable until its producer publishes it
+    if (sequence != pos + 1) {
+        return false;
+    }
+    
+    change = slot.change;
+    slot.sequence.store(pos + capacity_, std::memory_order_release);
+    dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace violet
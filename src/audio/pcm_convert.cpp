@@ -0,0 +1,983 @@
+#include "violet/pcm_convert.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VIOLET_PCM_SSE2 1
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define VIOLET_PCM_AVX2 1
+#endif
+#endif
+
+namespace violet {
+namespace pcm {
+
+namespace {
+
+const int FORMAT_COUNT = 5;
+
+// Interleaved samples converted per pass when the channel count has no
+// fused kernel
+const uint32_t TILE_SAMPLES = 1024;
+
+// Full-scale value, and the clamp range before rounding. 2^31 itself isn't
+// representable as int32 and the float below it is 2^31 - 128.
+const float INT16_SCALE = 32768.0f;
+const float INT16_CLIP = 32767.0f;
+const float INT24_SCALE = 8388608.0f;
+const float INT24_CLIP = 8388607.0f;
+const float INT32_SCALE = 2147483648.0f;
+const float INT32_CLIP = 2147483520.0f;
+
+inline int Index(PcmFormat format) {
+    return static_cast<int>(format);
+}
+
+// xorshift32; the dither only needs to be cheap and white
+inline uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+inline float RandomUnit(uint32_t& state) {
+    return static_cast<float>(NextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+inline float Tpdf(uint32_t& state) {
+    return RandomUnit(state) - RandomUnit(state);
+}
+
+// Scale, dither, clamp, round to nearest. Written so NaN clamps to the
+// minimum the same way the vector min/max instructions do.
+inline int32_t Quantize(float x, float scale, float maximum, uint32_t* dither) {
+    float s = x * scale;
+    if (dither) {
+        s += Tpdf(*dither);
+    }
+    s = s > -scale ? s : -scale;
+    s = s < maximum ? s : maximum;
+    return static_cast<int32_t>(std::lrint(s));
+}
+
+inline int32_t LoadInt32(const uint8_t* p) {
+    int32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void StoreInt32(uint8_t* p, int32_t value) {
+    memcpy(p, &value, sizeof(value));
+}
+
+inline int32_t LoadInt24(const uint8_t* p) {
+    uint32_t value = static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 |
+                     static_cast<uint32_t>(p[2]) << 24;
+    return static_cast<int32_t>(value) >> 8;
+}
+
+inline void StoreInt24(uint8_t* p, int32_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p[2] = static_cast<uint8_t>(value >> 16);
+}
+
+// Per-sample conversions. The vector kernels use these for their tails, so
+// every level produces identical results when dither is off.
+template <PcmFormat F> struct ScalarCodec;
+
+template <> struct ScalarCodec<PcmFormat::Float32> {
+    static const uint32_t BYTES = 4;
+    static float Load(const uint8_t* p) {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    static void Store(uint8_t* p, float x, uint32_t*) { memcpy(p, &x, sizeof(x)); }
+};
+
+template <> struct ScalarCodec<PcmFormat::Int16> {
+    static const uint32_t BYTES = 2;
+    static float Load(const uint8_t* p) {
+        int16_t value;
+        memcpy(&value, p, sizeof(value));
+        return value * (1.0f / INT16_SCALE);
+    }
+    static void Store(uint8_t* p, float x, uint32_t* dither) {
+        int16_t value = static_cast<int16_t>(Quantize(x, INT16_SCALE, INT16_CLIP, dither));
+        memcpy(p, &value, sizeof(value));
+    }
+};
+
+template <> struct ScalarCodec<PcmFormat::Int24> {
+    static const uint32_t BYTES = 3;
+    static float Load(const uint8_t* p) { return LoadInt24(p) * (1.0f / INT24_SCALE); }
+    static void Store(uint8_t* p, float x, uint32_t* dither) {
+        StoreInt24(p, Quantize(x, INT24_SCALE, INT24_CLIP, dither));
+    }
+};
+
+template <> struct ScalarCodec<PcmFormat::Int24In32> {
+    static const uint32_t BYTES = 4;
+    static float Load(const uint8_t* p) {
+        int32_t value = static_cast<int32_t>(static_cast<uint32_t>(LoadInt32(p)) << 8) >> 8;
+        return value * (1.0f / INT24_SCALE);
+    }
+    static void Store(uint8_t* p, float x, uint32_t* dither) {
+        StoreInt32(p, Quantize(x, INT24_SCALE, INT24_CLIP, dither));
+    }
+};
+
+template <> struct ScalarCodec<PcmFormat::Int32> {
+    static const uint32_t BYTES = 4;
+    static float Load(const uint8_t* p) { return static_cast<float>(LoadInt32(p)) * (1.0f / INT32_SCALE); }
+    static void Store(uint8_t* p, float x, uint32_t*) { StoreInt32(p, Quantize(x, INT32_SCALE, INT32_CLIP, nullptr)); }
+};
+
+// Only 16 and 24-bit output is dithered
+inline bool IsDithered(PcmFormat format) {
+    return format == PcmFormat::Int16 || format == PcmFormat::Int24 || format == PcmFormat::Int24In32;
+}
+
+// One instruction set's kernels. Decode/Encode convert contiguous samples,
+// the stereo variants fuse the (de)interleave of two channels.
+// Deinterleave/Interleave move float frames of any width between an
+// interleaved buffer and planar channels, starting `offset` frames into
+// the channels.
+struct Kernels {
+    void (*decode[FORMAT_COUNT])(const uint8_t* source, float* dest, size_t count);
+    void (*decodeStereo[FORMAT_COUNT])(const uint8_t* source, float* left, float* right, size_t frames);
+    void (*encode[FORMAT_COUNT])(const float* source, uint8_t* dest, size_t count, uint32_t* dither);
+    void (*encodeStereo[FORMAT_COUNT])(const float* left, const float* right, uint8_t* dest, size_t frames,
+                                       uint32_t* dither);
+    void (*deinterleave)(const float* source, uint32_t channels, float* const* dest, size_t offset, size_t frames);
+    void (*interleave)(const float* const* source, size_t offset, float* dest, uint32_t channels, size_t frames);
+};
+
+struct ScalarKernels {
+    template <PcmFormat F>
+    static void Decode(const uint8_t* source, float* dest, size_t count) {
+        using C = ScalarCodec<F>;
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = C::Load(source + i * C::BYTES);
+        }
+    }
+
+    template <PcmFormat F>
+    static void DecodeStereo(const uint8_t* source, float* left, float* right, size_t frames) {
+        using C = ScalarCodec<F>;
+        for (size_t i = 0; i < frames; ++i) {
+            left[i] = C::Load(source + (2 * i) * C::BYTES);
+            right[i] = C::Load(source + (2 * i + 1) * C::BYTES);
+        }
+    }
+
+    template <PcmFormat F>
+    static void Encode(const float* source, uint8_t* dest, size_t count, uint32_t* dither) {
+        using C = ScalarCodec<F>;
+        for (size_t i = 0; i < count; ++i) {
+            C::Store(dest + i * C::BYTES, source[i], dither);
+        }
+    }
+
+    template <PcmFormat F>
+    static void EncodeStereo(const float* left, const float* right, uint8_t* dest, size_t frames, uint32_t* dither) {
+        using C = ScalarCodec<F>;
+        for (size_t i = 0; i < frames; ++i) {
+            C::Store(dest + (2 * i) * C::BYTES, left[i], dither);
+            C::Store(dest + (2 * i + 1) * C::BYTES, right[i], dither);
+        }
+    }
+
+    // Channels [first, last) of `channels`-wide frames
+    static void DeinterleaveRange(const float* source, uint32_t channels, uint32_t first, uint32_t last,
+                                  float* const* dest, size_t offset, size_t frames) {
+        for (uint32_t ch = first; ch < last; ++ch) {
+            float* channel = dest[ch] + offset;
+            for (size_t i = 0; i < frames; ++i) {
+                channel[i] = source[i * channels + ch];
+            }
+        }
+    }
+
+    static void InterleaveRange(const float* const* source, size_t offset, float* dest, uint32_t channels,
+                                uint32_t first, uint32_t last, size_t frames) {
+        for (uint32_t ch = first; ch < last; ++ch) {
+            const float* channel = source[ch] + offset;
+            for (size_t i = 0; i < frames; ++i) {
+                dest[i * channels + ch] = channel[i];
+            }
+        }
+    }
+
+    static void Deinterleave(const float* source, uint32_t channels, float* const* dest, size_t offset, size_t frames) {
+        DeinterleaveRange(source, channels, 0, channels, dest, offset, frames);
+    }
+
+    static void Interleave(const float* const* source, size_t offset, float* dest, uint32_t channels, size_t frames) {
+        InterleaveRange(source, offset, dest, channels, 0, channels, frames);
+    }
+};
+
+template <class Level, PcmFormat F>
+void SetKernels(Kernels& kernels) {
+    kernels.decode[Index(F)] = &Level::template Decode<F>;
+    kernels.decodeStereo[Index(F)] = &Level::template DecodeStereo<F>;
+    kernels.encode[Index(F)] = &Level::template Encode<F>;
+    kernels.encodeStereo[Index(F)] = &Level::template EncodeStereo<F>;
+}
+
+template <class Level>
+Kernels MakeKernels() {
+    Kernels kernels;
+    SetKernels<Level, PcmFormat::Float32>(kernels);
+    SetKernels<Level, PcmFormat::Int16>(kernels);
+    SetKernels<Level, PcmFormat::Int24>(kernels);
+    SetKernels<Level, PcmFormat::Int24In32>(kernels);
+    SetKernels<Level, PcmFormat::Int32>(kernels);
+    kernels.deinterleave = &Level::Deinterleave;
+    kernels.interleave = &Level::Interleave;
+    return kernels;
+}
+
+#ifdef VIOLET_PCM_SSE2
+
+// SSE2, 4 samples per vector. Dither runs one generator per lane.
+inline __m128 Sse2Tpdf(__m128i& state) {
+    const __m128 unit = _mm_set1_ps(1.0f / 16777216.0f);
+    __m128 r[2];
+    for (int k = 0; k < 2; ++k) {
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+        state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+        r[k] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(state, 8)), unit);
+    }
+    return _mm_sub_ps(r[0], r[1]);
+}
+
+inline __m128i Sse2Quantize(__m128 x, float scale, float maximum, __m128i* dither) {
+    __m128 s = _mm_mul_ps(x, _mm_set1_ps(scale));
+    if (dither) {
+        s = _mm_add_ps(s, Sse2Tpdf(*dither));
+    }
+    s = _mm_min_ps(_mm_max_ps(s, _mm_set1_ps(-scale)), _mm_set1_ps(maximum));
+    return _mm_cvtps_epi32(s);
+}
+
+template <PcmFormat F> struct Sse2Codec;
+
+template <> struct Sse2Codec<PcmFormat::Float32> {
+    static __m128 Load(const uint8_t* p) { return _mm_loadu_ps(reinterpret_cast<const float*>(p)); }
+    static void Store(uint8_t* p, __m128 x, __m128i*) { _mm_storeu_ps(reinterpret_cast<float*>(p), x); }
+};
+
+template <> struct Sse2Codec<PcmFormat::Int16> {
+    static __m128 Load(const uint8_t* p) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / INT16_SCALE));
+    }
+    static void Store(uint8_t* p, __m128 x, __m128i* dither) {
+        __m128i v = Sse2Quantize(x, INT16_SCALE, INT16_CLIP, dither);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(v, v));
+    }
+};
+
+// No byte shuffle in SSE2, so packed 24-bit goes through the stack
+template <> struct Sse2Codec<PcmFormat::Int24> {
+    static __m128 Load(const uint8_t* p) {
+        __m128i v = _mm_setr_epi32(LoadInt24(p), LoadInt24(p + 3), LoadInt24(p + 6), LoadInt24(p + 9));
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / INT24_SCALE));
+    }
+    static void Store(uint8_t* p, __m128 x, __m128i* dither) {
+        alignas(16) int32_t values[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(values), Sse2Quantize(x, INT24_SCALE, INT24_CLIP, dither));
+        for (int k = 0; k < 4; ++k) {
+            StoreInt24(p + 3 * k, values[k]);
+        }
+    }
+};
+
+template <> struct Sse2Codec<PcmFormat::Int24In32> {
+    static __m128 Load(const uint8_t* p) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        v = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / INT24_SCALE));
+    }
+    static void Store(uint8_t* p, __m128 x, __m128i* dither) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), Sse2Quantize(x, INT24_SCALE, INT24_CLIP, dither));
+    }
+};
+
+template <> struct Sse2Codec<PcmFormat::Int32> {
+    static __m128 Load(const uint8_t* p) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / INT32_SCALE));
+    }
+    static void Store(uint8_t* p, __m128 x, __m128i*) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), Sse2Quantize(x, INT32_SCALE, INT32_CLIP, nullptr));
+    }
+};
+
+struct Sse2Kernels {
+    template <PcmFormat F>
+    static void Decode(const uint8_t* source, float* dest, size_t count) {
+        using C = Sse2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(dest + i, C::Load(source + i * bytes));
+        }
+        ScalarKernels::Decode<F>(source + i * bytes, dest + i, count - i);
+    }
+
+    template <PcmFormat F>
+    static void DecodeStereo(const uint8_t* source, float* left, float* right, size_t frames) {
+        using C = Sse2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = C::Load(source + (2 * i) * bytes);        // L0 R0 L1 R1
+            __m128 b = C::Load(source + (2 * i + 4) * bytes);    // L2 R2 L3 R3
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        ScalarKernels::DecodeStereo<F>(source + (2 * i) * bytes, left + i, right + i, frames - i);
+    }
+
+    template <PcmFormat F>
+    static void Encode(const float* source, uint8_t* dest, size_t count, uint32_t* dither) {
+        using C = Sse2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        __m128i state;
+        __m128i* lanes = dither ? &state : nullptr;
+        if (dither) {
+            state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither));
+        }
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            C::Store(dest + i * bytes, _mm_loadu_ps(source + i), lanes);
+        }
+        if (dither) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dither), state);
+        }
+        ScalarKernels::Encode<F>(source + i, dest + i * bytes, count - i, dither);
+    }
+
+    template <PcmFormat F>
+    static void EncodeStereo(const float* left, const float* right, uint8_t* dest, size_t frames, uint32_t* dither) {
+        using C = Sse2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        __m128i state;
+        __m128i* lanes = dither ? &state : nullptr;
+        if (dither) {
+            state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither));
+        }
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            C::Store(dest + (2 * i) * bytes, _mm_unpacklo_ps(l, r), lanes);
+            C::Store(dest + (2 * i + 4) * bytes, _mm_unpackhi_ps(l, r), lanes);
+        }
+        if (dither) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dither), state);
+        }
+        ScalarKernels::EncodeStereo<F>(left + i, right + i, dest + (2 * i) * bytes, frames - i, dither);
+    }
+
+    // Groups of four channels go through a 4x4 transpose per four frames,
+    // leftover channels and frames through the scalar loop
+    static void DeinterleaveRange(const float* source, uint32_t channels, uint32_t first, uint32_t last,
+                                  float* const* dest, size_t offset, size_t frames) {
+        uint32_t grouped = first + ((last - first) & ~3u);
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            const float* frame = source + i * channels;
+            for (uint32_t ch = first; ch < grouped; ch += 4) {
+                __m128 r0 = _mm_loadu_ps(frame + ch);
+                __m128 r1 = _mm_loadu_ps(frame + channels + ch);
+                __m128 r2 = _mm_loadu_ps(frame + 2 * channels + ch);
+                __m128 r3 = _mm_loadu_ps(frame + 3 * channels + ch);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(dest[ch] + offset + i, r0);
+                _mm_storeu_ps(dest[ch + 1] + offset + i, r1);
+                _mm_storeu_ps(dest[ch + 2] + offset + i, r2);
+                _mm_storeu_ps(dest[ch + 3] + offset + i, r3);
+            }
+        }
+        ScalarKernels::DeinterleaveRange(source + i * channels, channels, first, grouped, dest, offset + i, frames - i);
+        ScalarKernels::DeinterleaveRange(source, channels, grouped, last, dest, offset, frames);
+    }
+
+    static void InterleaveRange(const float* const* source, size_t offset, float* dest, uint32_t channels,
+                                uint32_t first, uint32_t last, size_t frames) {
+        uint32_t grouped = first + ((last - first) & ~3u);
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            float* frame = dest + i * channels;
+            for (uint32_t ch = first; ch < grouped; ch += 4) {
+                __m128 r0 = _mm_loadu_ps(source[ch] + offset + i);
+                __m128 r1 = _mm_loadu_ps(source[ch + 1] + offset + i);
+                __m128 r2 = _mm_loadu_ps(source[ch + 2] + offset + i);
+                __m128 r3 = _mm_loadu_ps(source[ch + 3] + offset + i);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(frame + ch, r0);
+                _mm_storeu_ps(frame + channels + ch, r1);
+                _mm_storeu_ps(frame + 2 * channels + ch, r2);
+                _mm_storeu_ps(frame + 3 * channels + ch, r3);
+            }
+        }
+        ScalarKernels::InterleaveRange(source, offset + i, dest + i * channels, channels, first, grouped, frames - i);
+        ScalarKernels::InterleaveRange(source, offset, dest, channels, grouped, last, frames);
+    }
+
+    static void Deinterleave(const float* source, uint32_t channels, float* const* dest, size_t offset, size_t frames) {
+        DeinterleaveRange(source, channels, 0, channels, dest, offset, frames);
+    }
+
+    static void Interleave(const float* const* source, size_t offset, float* dest, uint32_t channels, size_t frames) {
+        InterleaveRange(source, offset, dest, channels, 0, channels, frames);
+    }
+};
+
+#endif // VIOLET_PCM_SSE2
+
+#ifdef VIOLET_PCM_AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// AVX2, 8 samples per vector. Built for AVX2 regardless of the compiler
+// flags and only called when the CPU has it.
+inline __m256 Avx2Tpdf(__m256i& state) {
+    const __m256 unit = _mm256_set1_ps(1.0f / 16777216.0f);
+    __m256 r[2];
+    for (int k = 0; k < 2; ++k) {
+        state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+        state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+        state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+        r[k] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(state, 8)), unit);
+    }
+    return _mm256_sub_ps(r[0], r[1]);
+}
+
+inline __m256i Avx2Quantize(__m256 x, float scale, float maximum, __m256i* dither) {
+    __m256 s = _mm256_mul_ps(x, _mm256_set1_ps(scale));
+    if (dither) {
+        s = _mm256_add_ps(s, Avx2Tpdf(*dither));
+    }
+    s = _mm256_min_ps(_mm256_max_ps(s, _mm256_set1_ps(-scale)), _mm256_set1_ps(maximum));
+    return _mm256_cvtps_epi32(s);
+}
+
+template <PcmFormat F> struct Avx2Codec;
+
+template <> struct Avx2Codec<PcmFormat::Float32> {
+    static __m256 Load(const uint8_t* p) { return _mm256_loadu_ps(reinterpret_cast<const float*>(p)); }
+    static void Store(uint8_t* p, __m256 x, __m256i*) { _mm256_storeu_ps(reinterpret_cast<float*>(p), x); }
+};
+
+template <> struct Avx2Codec<PcmFormat::Int16> {
+    static __m256 Load(const uint8_t* p) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.0f / INT16_SCALE));
+    }
+    static void Store(uint8_t* p, __m256 x, __m256i* dither) {
+        __m256i v = Avx2Quantize(x, INT16_SCALE, INT16_CLIP, dither);
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), packed);
+    }
+};
+
+// Packed 24-bit: each 128-bit lane shuffles four 3-byte samples into the
+// top of four 32-bit words, then an arithmetic shift sign-extends them.
+// The loads cover exactly the 24 bytes of the 8 samples.
+template <> struct Avx2Codec<PcmFormat::Int24> {
+    static __m256 Load(const uint8_t* p) {
+        const __m256i spread = _mm256_setr_epi8(
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+            -1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15);
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        v = _mm256_srai_epi32(_mm256_shuffle_epi8(v, spread), 8);
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.0f / INT24_SCALE));
+    }
+    static void Store(uint8_t* p, __m256 x, __m256i* dither) {
+        const __m256i pack = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+        __m256i v = _mm256_shuffle_epi8(Avx2Quantize(x, INT24_SCALE, INT24_CLIP, dither), pack);
+        v = _mm256_permutevar8x32_epi32(v, gather);    // 24 bytes in the low 6 words
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(v));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p + 16), _mm256_extracti128_si256(v, 1));
+    }
+};
+
+template <> struct Avx2Codec<PcmFormat::Int24In32> {
+    static __m256 Load(const uint8_t* p) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        v = _mm256_srai_epi32(_mm256_slli_epi32(v, 8), 8);
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.0f / INT24_SCALE));
+    }
+    static void Store(uint8_t* p, __m256 x, __m256i* dither) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), Avx2Quantize(x, INT24_SCALE, INT24_CLIP, dither));
+    }
+};
+
+template <> struct Avx2Codec<PcmFormat::Int32> {
+    static __m256 Load(const uint8_t* p) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.0f / INT32_SCALE));
+    }
+    static void Store(uint8_t* p, __m256 x, __m256i*) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), Avx2Quantize(x, INT32_SCALE, INT32_CLIP, nullptr));
+    }
+};
+
+struct Avx2Kernels {
+    template <PcmFormat F>
+    static void Decode(const uint8_t* source, float* dest, size_t count) {
+        using C = Avx2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(dest + i, C::Load(source + i * bytes));
+        }
+        ScalarKernels::Decode<F>(source + i * bytes, dest + i, count - i);
+    }
+
+    template <PcmFormat F>
+    static void DecodeStereo(const uint8_t* source, float* left, float* right, size_t frames) {
+        using C = Avx2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        size_t i = 0;
+        for (; i + 8 <= frames; i += 8) {
+            __m256 a = C::Load(source + (2 * i) * bytes);        // frames 0-3
+            __m256 b = C::Load(source + (2 * i + 8) * bytes);    // frames 4-7
+            // Lane-wise even/odd split gives 0 1 4 5 | 2 3 6 7; fix the order
+            __m256d l = _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m256d r = _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            _mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(l, _MM_SHUFFLE(3, 1, 2, 0))));
+            _mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(r, _MM_SHUFFLE(3, 1, 2, 0))));
+        }
+        ScalarKernels::DecodeStereo<F>(source + (2 * i) * bytes, left + i, right + i, frames - i);
+    }
+
+    template <PcmFormat F>
+    static void Encode(const float* source, uint8_t* dest, size_t count, uint32_t* dither) {
+        using C = Avx2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        __m256i state;
+        __m256i* lanes = dither ? &state : nullptr;
+        if (dither) {
+            state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither));
+        }
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            C::Store(dest + i * bytes, _mm256_loadu_ps(source + i), lanes);
+        }
+        if (dither) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither), state);
+        }
+        ScalarKernels::Encode<F>(source + i, dest + i * bytes, count - i, dither);
+    }
+
+    template <PcmFormat F>
+    static void EncodeStereo(const float* left, const float* right, uint8_t* dest, size_t frames, uint32_t* dither) {
+        using C = Avx2Codec<F>;
+        const uint32_t bytes = ScalarCodec<F>::BYTES;
+        __m256i state;
+        __m256i* lanes = dither ? &state : nullptr;
+        if (dither) {
+            state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither));
+        }
+        size_t i = 0;
+        for (; i + 8 <= frames; i += 8) {
+            __m256 l = _mm256_loadu_ps(left + i);
+            __m256 r = _mm256_loadu_ps(right + i);
+            __m256 low = _mm256_unpacklo_ps(l, r);     // frames 0 1 | 4 5
+            __m256 high = _mm256_unpackhi_ps(l, r);    // frames 2 3 | 6 7
+            C::Store(dest + (2 * i) * bytes, _mm256_permute2f128_ps(low, high, 0x20), lanes);
+            C::Store(dest + (2 * i + 8) * bytes, _mm256_permute2f128_ps(low, high, 0x31), lanes);
+        }
+        if (dither) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither), state);
+        }
+        ScalarKernels::EncodeStereo<F>(left + i, right + i, dest + (2 * i) * bytes, frames - i, dither);
+    }
+
+    // 8x8 transpose of eight frames of eight channels, in place
+    static void Transpose8(__m256& r0, __m256& r1, __m256& r2, __m256& r3,
+                           __m256& r4, __m256& r5, __m256& r6, __m256& r7) {
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+        __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+        __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+        __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        r0 = _mm256_permute2f128_ps(s0, s4, 0x20);
+        r1 = _mm256_permute2f128_ps(s1, s5, 0x20);
+        r2 = _mm256_permute2f128_ps(s2, s6, 0x20);
+        r3 = _mm256_permute2f128_ps(s3, s7, 0x20);
+        r4 = _mm256_permute2f128_ps(s0, s4, 0x31);
+        r5 = _mm256_permute2f128_ps(s1, s5, 0x31);
+        r6 = _mm256_permute2f128_ps(s2, s6, 0x31);
+        r7 = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+
+    // Groups of eight channels here, the rest through the SSE2 kernels
+    static void DeinterleaveRange(const float* source, uint32_t channels, uint32_t first, uint32_t last,
+                                  float* const* dest, size_t offset, size_t frames) {
+        uint32_t grouped = first + ((last - first) & ~7u);
+        size_t i = 0;
+        for (; i + 8 <= frames; i += 8) {
+            const float* frame = source + i * channels;
+            for (uint32_t ch = first; ch < grouped; ch += 8) {
+                const float* in = frame + ch;
+                __m256 r0 = _mm256_loadu_ps(in);
+                __m256 r1 = _mm256_loadu_ps(in + channels);
+                __m256 r2 = _mm256_loadu_ps(in + 2 * channels);
+                __m256 r3 = _mm256_loadu_ps(in + 3 * channels);
+                __m256 r4 = _mm256_loadu_ps(in + 4 * channels);
+                __m256 r5 = _mm256_loadu_ps(in + 5 * channels);
+                __m256 r6 = _mm256_loadu_ps(in + 6 * channels);
+                __m256 r7 = _mm256_loadu_ps(in + 7 * channels);
+                Transpose8(r0, r1, r2, r3, r4, r5, r6, r7);
+                _mm256_storeu_ps(dest[ch] + offset + i, r0);
+                _mm256_storeu_ps(dest[ch + 1] + offset + i, r1);
+                _mm256_storeu_ps(dest[ch + 2] + offset + i, r2);
+                _mm256_storeu_ps(dest[ch + 3] + offset + i, r3);
+                _mm256_storeu_ps(dest[ch + 4] + offset + i, r4);
+                _mm256_storeu_ps(dest[ch + 5] + offset + i, r5);
+                _mm256_storeu_ps(dest[ch + 6] + offset + i, r6);
+                _mm256_storeu_ps(dest[ch + 7] + offset + i, r7);
+            }
+        }
+        ScalarKernels::DeinterleaveRange(source + i * channels, channels, first, grouped, dest, offset + i, frames - i);
+        Sse2Kernels::DeinterleaveRange(source, channels, grouped, last, dest, offset, frames);
+    }
+
+    static void InterleaveRange(const float* const* source, size_t offset, float* dest, uint32_t channels,
+                                uint32_t first, uint32_t last, size_t frames) {
+        uint32_t grouped = first + ((last - first) & ~7u);
+        size_t i = 0;
+        for (; i + 8 <= frames; i += 8) {
+            float* frame = dest + i * channels;
+            for (uint32_t ch = first; ch < grouped; ch += 8) {
+                __m256 r0 = _mm256_loadu_ps(source[ch] + offset + i);
+                __m256 r1 = _mm256_loadu_ps(source[ch + 1] + offset + i);
+                __m256 r2 = _mm256_loadu_ps(source[ch + 2] + offset + i);
+                __m256 r3 = _mm256_loadu_ps(source[ch + 3] + offset + i);
+                __m256 r4 = _mm256_loadu_ps(source[ch + 4] + offset + i);
+                __m256 r5 = _mm256_loadu_ps(source[ch + 5] + offset + i);
+                __m256 r6 = _mm256_loadu_ps(source[ch + 6] + offset + i);
+                __m256 r7 = _mm256_loadu_ps(source[ch + 7] + offset + i);
+                Transpose8(r0, r1, r2, r3, r4, r5, r6, r7);
+                float* out = frame + ch;
+                _mm256_storeu_ps(out, r0);
+                _mm256_storeu_ps(out + channels, r1);
+                _mm256_storeu_ps(out + 2 * channels, r2);
+                _mm256_storeu_ps(out + 3 * channels, r3);
+                _mm256_storeu_ps(out + 4 * channels, r4);
+                _mm256_storeu_ps(out + 5 * channels, r5);
+                _mm256_storeu_ps(out + 6 * channels, r6);
+                _mm256_storeu_ps(out + 7 * channels, r7);
+            }
+        }
+        ScalarKernels::InterleaveRange(source, offset + i, dest + i * channels, channels, first, grouped, frames - i);
+        Sse2Kernels::InterleaveRange(source, offset, dest, channels, grouped, last, frames);
+    }
+
+    static void Deinterleave(const float* source, uint32_t channels, float* const* dest, size_t offset, size_t frames) {
+        DeinterleaveRange(source, channels, 0, channels, dest, offset, frames);
+    }
+
+    static void Interleave(const float* const* source, size_t offset, float* dest, uint32_t channels, size_t frames) {
+        InterleaveRange(source, offset, dest, channels, 0, channels, frames);
+    }
+};
+
+#pragma GCC pop_options
+#endif // VIOLET_PCM_AVX2
+
+SimdLevel DetectSimdLevel() {
+#if defined(VIOLET_PCM_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::Avx2;
+    }
+#endif
+#if defined(VIOLET_PCM_SSE2)
+    return SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const Kernels* GetKernels(SimdLevel level) {
+    static const Kernels scalar = MakeKernels<ScalarKernels>();
+    switch (level) {
+#ifdef VIOLET_PCM_AVX2
+    case SimdLevel::Avx2: {
+        static const Kernels avx2 = MakeKernels<Avx2Kernels>();
+        return &avx2;
+    }
+#endif
+#ifdef VIOLET_PCM_SSE2
+    case SimdLevel::Sse2: {
+        static const Kernels sse2 = MakeKernels<Sse2Kernels>();
+        return &sse2;
+    }
+#endif
+    default:
+        return &scalar;
+    }
+}
+
+SimdLevel GetDefaultSimdLevel() {
+    SimdLevel level = DetectSimdLevel();
+    const char* env = std::getenv("VIOLET_SIMD");
+    SimdLevel requested;
+    if (env && ParseSimdLevel(env, requested) && requested < level) {
+        level = requested;
+    }
+    return level;
+}
+
+std::atomic<SimdLevel>& ActiveLevel() {
+    static std::atomic<SimdLevel> level(GetDefaultSimdLevel());
+    return level;
+}
+
+const Kernels& ActiveKernels() {
+    return *GetKernels(ActiveLevel().load(std::memory_order_relaxed));
+}
+
+} // namespace
+
+uint32_t GetSampleBytes(PcmFormat format) {
+    switch (format) {
+    case PcmFormat::Int16:
+        return 2;
+    case PcmFormat::Int24:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+const char* GetFormatName(PcmFormat format) {
+    switch (format) {
+    case PcmFormat::Float32:
+        return "f32";
+    case PcmFormat::Int16:
+        return "s16";
+    case PcmFormat::Int24:
+        return "s24";
+    case PcmFormat::Int24In32:
+        return "s24_32";
+    case PcmFormat::Int32:
+        return "s32";
+    }
+    return "unknown";
+}
+
+Dither::Dither(uint32_t seed)
+    : enabled_(false) {
+    // Distinct, non-zero start for every lane
+    uint32_t value = seed ? seed : 1;
+    for (uint32_t& lane : state_) {
+        NextRandom(value);
+        lane = value;
+    }
+}
+
+void Decode(const void* source, PcmFormat format, uint32_t sourceChannels,
+            float* const* dest, uint32_t destChannels, uint32_t frames) {
+    const Kernels& kernels = ActiveKernels();
+    const uint8_t* bytes = static_cast<const uint8_t*>(source);
+    int index = Index(format);
+
+    if (sourceChannels == destChannels && sourceChannels == 1) {
+        kernels.decode[index](bytes, dest[0], frames);
+        return;
+    }
+    if (sourceChannels == destChannels && sourceChannels == 2) {
+        kernels.decodeStereo[index](bytes, dest[0], dest[1], frames);
+        return;
+    }
+
+    // Matching float channels need no tile
+    if (sourceChannels == destChannels && format == PcmFormat::Float32) {
+        kernels.deinterleave(static_cast<const float*>(source), sourceChannels, dest, 0, frames);
+        return;
+    }
+
+    // Convert a tile of interleaved samples, then scatter it per channel
+    uint32_t shared = std::min(sourceChannels, destChannels);
+    if (shared > 0) {
+        alignas(32) float tile[TILE_SAMPLES];
+        size_t frameBytes = static_cast<size_t>(GetSampleBytes(format)) * sourceChannels;
+        uint32_t tileFrames = std::max(TILE_SAMPLES / sourceChannels, 1u);
+        for (uint32_t done = 0; done < frames;) {
+            uint32_t count = std::min(tileFrames, frames - done);
+            if (sourceChannels > TILE_SAMPLES) {
+                // Too wide for the tile; convert one channel at a time
+                for (uint32_t ch = 0; ch < shared; ++ch) {
+                    kernels.decode[index](bytes + done * frameBytes + ch * GetSampleBytes(format), tile, 1);
+                    dest[ch][done] = tile[0];
+                }
+            } else if (shared == sourceChannels) {
+                kernels.decode[index](bytes + done * frameBytes, tile, static_cast<size_t>(count) * sourceChannels);
+                kernels.deinterleave(tile, sourceChannels, dest, done, count);
+            } else {
+                kernels.decode[index](bytes + done * frameBytes, tile, static_cast<size_t>(count) * sourceChannels);
+                for (uint32_t ch = 0; ch < shared; ++ch) {
+                    float* channel = dest[ch] + done;
+                    for (uint32_t i = 0; i < count; ++i) {
+                        channel[i] = tile[i * sourceChannels + ch];
+                    }
+                }
+            }
+            done += count;
+        }
+    }
+
+    for (uint32_t ch = shared; ch < destChannels; ++ch) {
+        memset(dest[ch], 0, frames * sizeof(float));
+    }
+}
+
+void Encode(const float* const* source, uint32_t sourceChannels,
+            void* dest, PcmFormat format, uint32_t destChannels, uint32_t frames,
+            Dither* dither) {
+    const Kernels& kernels = ActiveKernels();
+    uint8_t* bytes = static_cast<uint8_t*>(dest);
+    int index = Index(format);
+    size_t frameBytes = static_cast<size_t>(GetSampleBytes(format)) * destChannels;
+
+    // Zero is silence in every format
+    if (!source || sourceChannels == 0) {
+        memset(bytes, 0, frames * frameBytes);
+        return;
+    }
+
+    uint32_t* state = dither && IsDithered(format) ? dither->GetState() : nullptr;
+    if (sourceChannels == destChannels && destChannels == 1) {
+        kernels.encode[index](source[0], bytes, frames, state);
+        return;
+    }
+    if (sourceChannels == destChannels && destChannels == 2) {
+        kernels.encodeStereo[index](source[0], source[1], bytes, frames, state);
+        return;
+    }
+
+    // Matching float channels need no tile
+    if (sourceChannels == destChannels && format == PcmFormat::Float32) {
+        kernels.interleave(source, 0, static_cast<float*>(dest), destChannels, frames);
+        return;
+    }
+
+    // Interleave a tile, missing channels as silence, then convert it
+    uint32_t shared = std::min(sourceChannels, destChannels);
+    alignas(32) float tile[TILE_SAMPLES];
+    if (destChannels > TILE_SAMPLES) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            for (uint32_t ch = 0; ch < destChannels; ++ch) {
+                tile[0] = ch < shared ? source[ch][i] : 0.0f;
+                kernels.encode[index](tile, bytes + i * frameBytes + ch * GetSampleBytes(format), 1, state);
+            }
+        }
+        return;
+    }
+
+    uint32_t tileFrames = std::max(TILE_SAMPLES / destChannels, 1u);
+    for (uint32_t done = 0; done < frames;) {
+        uint32_t count = std::min(tileFrames, frames - done);
+        if (shared == destChannels) {
+            kernels.interleave(source, done, tile, destChannels, count);
+        } else {
+            for (uint32_t ch = 0; ch < destChannels; ++ch) {
+                if (ch < shared) {
+                    const float* channel = source[ch] + done;
+                    for (uint32_t i = 0; i < count; ++i) {
+                        tile[i * destChannels + ch] = channel[i];
+                    }
+                } else {
+                    for (uint32_t i = 0; i < count; ++i) {
+                        tile[i * destChannels + ch] = 0.0f;
+                    }
+                }
+            }
+        }
+        kernels.encode[index](tile, bytes + done * frameBytes, static_cast<size_t>(count) * destChannels, state);
+        done += count;
+    }
+}
+
+void Deinterleave(const float* source, uint32_t channels, float* const* dest, uint32_t frames) {
+    Decode(source, PcmFormat::Float32, channels, dest, channels, frames);
+}
+
+void Interleave(const float* const* source, uint32_t channels, float* dest, uint32_t frames) {
+    Encode(source, channels, dest, PcmFormat::Float32, channels, frames);
+}
+
+SimdLevel GetSimdLevel() {
+    return ActiveLevel().load();
+}
+
+SimdLevel GetMaxSimdLevel() {
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+bool SetSimdLevel(SimdLevel level) {
+    if (level > GetMaxSimdLevel()) {
+        return false;
+    }
+    ActiveLevel().store(level);
+    return true;
+}
+
+const char* GetSimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::Sse2:
+        return "sse2";
+    case SimdLevel::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+bool ParseSimdLevel(const std::string& name, SimdLevel& level) {
+    for (SimdLevel candidate : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+        if (name == GetSimdLevelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace pcm
+} // namespace violet
@@ -0,0 +1,105 @@
+#include "violet/performance_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace violet {
+
+uint64_t MonotonicNanos() {
+    // steady_clock is QueryPerformanceCounter on Windows and
+    // clock_gettime(CLOCK_MONOTONIC) elsewhere
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+TimingHistogram::TimingHistogram()
+    : total_(0)
+    , max_(0) {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t TimingHistogram::BucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<uint32_t>(value);
+    }
+    
+    uint32_t msb = 63;
+    while (!(value & (uint64_t(1) << msb))) {
+        --msb;
+    }
+    uint32_t shift = msb - SUB_BUCKET_BITS;
+    uint32_t sub = static_cast<uint32_t>(value >> shift) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+}
+
+uint64_t TimingHistogram::BucketUpperBound(uint32_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    
+    uint32_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void TimingHistogram::Record(uint64_t nanos) {
+    buckets_[BucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(nanos, std::memory_order_relaxed);
+    
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (nanos > max && !max_.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+TimingStats TimingHistogram::GetStats() const {
+    TimingStats stats;
+    
+    // Take the count from the buckets so the quantiles are self-consistent
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+    if (count == 0) {
+        return stats;
+    }
+    
+    stats.count = count;
+    stats.mean = total_.load(std::memory_order_relaxed) / count;
+    stats.max = max_.load(std::memory_order_relaxed);
+    
+    const double quantiles[] = {0.5, 0.99, 0.999};
+    uint64_t* results[] = {&stats.p50, &stats.p99, &stats.p999};
+    uint64_t seen = 0;
+    size_t q = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT && q < 3; ++i) {
+        seen += counts[i];
+        while (q < 3 && seen >= static_cast<uint64_t>(quantiles[q] * count + 0.5)) {
+            *results[q] = std::min(BucketUpperBound(i), stats.max);
+            ++q;
+        }
+    }
+    
+    return stats;
+}
+
+void TimingHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+std::string FormatTimingStats(const TimingStats& stats) {
+    char text[128];
+    snprintf(text, sizeof(text), "p50 %.1f / p99 %.1f / p99.9 %.1f / max %.1f us (%llu)",
+             stats.p50 / 1000.0, stats.p99 / 1000.0, stats.p999 / 1000.0, stats.max / 1000.0,
+             static_cast<unsigned long long>(stats.count));
+    return text;
+}
+
+} // namespace violet
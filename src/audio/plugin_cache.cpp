@@ -0,0 +1,705 @@
+#include "violet/plugin_cache.h"
+#include "violet/utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace violet {
+
+namespace {
+
+const char CACHE_MAGIC[8] = { 'V', 'I', 'O', 'L', 'E', 'T', 'P', 'C' };
+const uint32_t CACHE_VERSION = 1;
+
+const uint32_t PLUGIN_HAS_UI = 1u << 0;
+const uint32_t PLUGIN_IN_PLACE_BROKEN = 1u << 1;
+
+const uint32_t PARAMETER_TOGGLE = 1u << 0;
+const uint32_t PARAMETER_INTEGER = 1u << 1;
+const uint32_t PARAMETER_ENUM = 1u << 2;
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+struct DirectoryEntry {
+    std::string name;
+    bool isDirectory = false;
+    uint64_t size = 0;
+    int64_t modified = 0;       // platform units, only compared
+};
+
+#ifdef _WIN32
+const char PATH_LIST_SEPARATOR = ';';
+
+bool ListDirectory(const std::string& path, std::vector<DirectoryEntry>& entries) {
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((path + "\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0) {
+            continue;
+        }
+        DirectoryEntry entry;
+        entry.name = data.cFileName;
+        entry.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        entry.modified = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                                              data.ftLastWriteTime.dwLowDateTime);
+        entries.push_back(std::move(entry));
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+    return true;
+}
+#else
+const char PATH_LIST_SEPARATOR = ':';
+
+bool ListDirectory(const std::string& path, std::vector<DirectoryEntry>& entries) {
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return false;
+    }
+    while (dirent* item = readdir(dir)) {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) {
+            continue;
+        }
+        // stat() rather than d_type: bundles are often symlinks
+        struct stat info;
+        if (stat((path + "/" + item->d_name).c_str(), &info) != 0) {
+            continue;
+        }
+        DirectoryEntry entry;
+        entry.name = item->d_name;
+        entry.isDirectory = S_ISDIR(info.st_mode);
+        entry.size = static_cast<uint64_t>(info.st_size);
+#ifdef __linux__
+        entry.modified = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+        entry.modified = static_cast<int64_t>(info.st_mtime);
+#endif
+        entries.push_back(std::move(entry));
+    }
+    closedir(dir);
+    return true;
+}
+#endif
+
+uint64_t HashEntries(std::vector<DirectoryEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const DirectoryEntry& a, const DirectoryEntry& b) {
+        return a.name < b.name;
+    });
+    uint64_t hash = FNV_OFFSET;
+    for (const DirectoryEntry& entry : entries) {
+        hash = HashBytes(hash, entry.name.c_str(), entry.name.size() + 1);
+        if (!entry.isDirectory) {
+            hash = HashBytes(hash, &entry.size, sizeof(entry.size));
+            hash = HashBytes(hash, &entry.modified, sizeof(entry.modified));
+        }
+    }
+    // 0 is kept for "can't be read"
+    return hash != 0 ? hash : 1;
+}
+
+// Builds the string table, each distinct string stored once. Offset 0 is "".
+class StringTable {
+public:
+    StringTable() : bytes_(1, '\0') {}
+
+    uint32_t Add(const std::string& value) {
+        if (value.empty()) {
+            return 0;
+        }
+        auto it = offsets_.find(value);
+        if (it != offsets_.end()) {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(bytes_.size());
+        bytes_.insert(bytes_.end(), value.begin(), value.end());
+        bytes_.push_back('\0');
+        offsets_.emplace(value, offset);
+        return offset;
+    }
+
+    const std::vector<char>& GetBytes() const { return bytes_; }
+
+private:
+    std::vector<char> bytes_;
+    std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+template<typename T>
+void Append(std::vector<uint8_t>& out, const T* items, size_t count) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+    out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+}
+
+// Two managers in one process may save at the same time
+std::mutex saveMutex;
+
+} // namespace
+
+struct PluginCache::FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bundleCount;
+    uint32_t pluginCount;
+    uint32_t parameterCount;
+    uint32_t enumCount;
+    uint32_t stringBytes;
+    uint64_t checksum;          // FNV-1a of everything after the header
+};
+
+// Bundles sorted by path, each owning a run of plugin records
+struct PluginCache::BundleRecord {
+    uint64_t fingerprint;
+    uint32_t path;
+    uint32_t firstPlugin;
+    uint32_t pluginCount;
+    uint32_t reserved;
+};
+
+struct PluginCache::PluginRecord {
+    uint32_t uri;
+    uint32_t name;
+    uint32_t author;
+    uint32_t category;
+    uint32_t description;
+    uint32_t flags;
+    uint32_t audioInputs;
+    uint32_t audioOutputs;
+    uint32_t controlInputs;
+    uint32_t controlOutputs;
+    uint32_t midiInputs;
+    uint32_t midiOutputs;
+    uint32_t bundle;
+    uint32_t firstParameter;
+    uint32_t parameterCount;
+    uint32_t reserved;
+};
+
+struct PluginCache::ParameterRecord {
+    uint32_t index;
+    uint32_t portIndex;
+    uint32_t symbol;
+    uint32_t name;
+    float defaultValue;
+    float minimum;
+    float maximum;
+    uint32_t flags;
+    uint32_t firstEnum;
+    uint32_t enumCount;
+};
+
+PluginCache::PluginCache()
+    : data_(nullptr)
+    , size_(0)
+    , header_(nullptr)
+    , bundles_(nullptr)
+    , plugins_(nullptr)
+    , uriIndex_(nullptr)
+    , parameters_(nullptr)
+    , enumValues_(nullptr)
+    , strings_(nullptr) {
+    // The file layout; no padding anywhere
+    static_assert(sizeof(FileHeader) == 40, "cache header layout");
+    static_assert(sizeof(BundleRecord) == 24, "cache bundle record layout");
+    static_assert(sizeof(PluginRecord) == 64, "cache plugin record layout");
+    static_assert(sizeof(ParameterRecord) == 40, "cache parameter record layout");
+}
+
+PluginCache::~PluginCache() {
+    Clear();
+}
+
+void PluginCache::Clear() {
+#ifdef _WIN32
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+#else
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    bundles_ = nullptr;
+    plugins_ = nullptr;
+    uriIndex_ = nullptr;
+    parameters_ = nullptr;
+    enumValues_ = nullptr;
+    strings_ = nullptr;
+}
+
+bool PluginCache::Load(const std::string& path) {
+    Clear();
+
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamoff length = file.tellg();
+    if (length < static_cast<std::streamoff>(sizeof(FileHeader))) {
+        return false;
+    }
+    buffer_.resize(static_cast<size_t>(length));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer_.data()), length)) {
+        buffer_.clear();
+        return false;
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapped);
+    size_ = static_cast<size_t>(info.st_size);
+#endif
+
+    // Sections follow the header in this order, each a whole number of records
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data_);
+    uint64_t expected = sizeof(FileHeader) +
+                        uint64_t(header->bundleCount) * sizeof(BundleRecord) +
+                        uint64_t(header->pluginCount) * (sizeof(PluginRecord) + sizeof(uint32_t)) +
+                        uint64_t(header->parameterCount) * sizeof(ParameterRecord) +
+                        uint64_t(header->enumCount) * sizeof(uint32_t) +
+                        header->stringBytes;
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header->version != CACHE_VERSION ||
+        expected != size_ || header->stringBytes == 0 ||
+        HashBytes(FNV_OFFSET, data_ + sizeof(FileHeader), size_ - sizeof(FileHeader)) != header->checksum) {
+        Clear();
+        return false;
+    }
+
+    const uint8_t* section = data_ + sizeof(FileHeader);
+    const BundleRecord* bundles = reinterpret_cast<const BundleRecord*>(section);
+    section += header->bundleCount * sizeof(BundleRecord);
+    const PluginRecord* plugins = reinterpret_cast<const PluginRecord*>(section);
+    section += header->pluginCount * sizeof(PluginRecord);
+    const uint32_t* uriIndex = reinterpret_cast<const uint32_t*>(section);
+    section += header->pluginCount * sizeof(uint32_t);
+    const ParameterRecord* parameters = reinterpret_cast<const ParameterRecord*>(section);
+    section += header->parameterCount * sizeof(ParameterRecord);
+    const uint32_t* enumValues = reinterpret_cast<const uint32_t*>(section);
+    section += header->enumCount * sizeof(uint32_t);
+    const char* strings = reinterpret_cast<const char*>(section);
+
+    // The checksum catches damage; this catches a writer that got it wrong,
+    // so no lookup can leave the file
+    uint32_t stringBytes = header->stringBytes;
+    bool valid = strings[stringBytes - 1] == '\0';
+    for (uint32_t i = 0; valid && i < header->bundleCount; ++i) {
+        const BundleRecord& bundle = bundles[i];
+        valid = bundle.path < stringBytes &&
+                uint64_t(bundle.firstPlugin) + bundle.pluginCount <= header->pluginCount;
+    }
+    for (uint32_t i = 0; valid && i < header->pluginCount; ++i) {
+        const PluginRecord& plugin = plugins[i];
+        valid = plugin.uri < stringBytes && plugin.name < stringBytes && plugin.author < stringBytes &&
+                plugin.category < stringBytes && plugin.description < stringBytes &&
+                plugin.bundle < header->bundleCount && uriIndex[i] < header->pluginCount &&
+                uint64_t(plugin.firstParameter) + plugin.parameterCount <= header->parameterCount;
+    }
+    for (uint32_t i = 0; valid && i < header->parameterCount; ++i) {
+        const ParameterRecord& parameter = parameters[i];
+        valid = parameter.symbol < stringBytes && parameter.name < stringBytes &&
+                uint64_t(parameter.firstEnum) + parameter.enumCount <= header->enumCount;
+    }
+    for (uint32_t i = 0; valid && i < header->enumCount; ++i) {
+        valid = enumValues[i] < stringBytes;
+    }
+    if (!valid) {
+        std::cerr << "Ignoring malformed plugin cache " << path << std::endl;
+        Clear();
+        return false;
+    }
+
+    header_ = header;
+    bundles_ = bundles;
+    plugins_ = plugins;
+    uriIndex_ = uriIndex;
+    parameters_ = parameters;
+    enumValues_ = enumValues;
+    strings_ = strings;
+    return true;
+}
+
+bool PluginCache::Save(const std::string& path, const std::vector<CachedBundle>& bundles) {
+    std::vector<const CachedBundle*> sorted;
+    sorted.reserve(bundles.size());
+    for (const CachedBundle& bundle : bundles) {
+        sorted.push_back(&bundle);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const CachedBundle* a, const CachedBundle* b) {
+        return a->path < b->path;
+    });
+
+    StringTable strings;
+    std::vector<BundleRecord> bundleRecords;
+    std::vector<PluginRecord> pluginRecords;
+    std::vector<ParameterRecord> parameterRecords;
+    std::vector<uint32_t> enumValues;
+    std::vector<const std::string*> uris;
+
+    for (const CachedBundle* bundle : sorted) {
+        BundleRecord bundleRecord = {};
+        bundleRecord.fingerprint = bundle->fingerprint;
+        bundleRecord.path = strings.Add(bundle->path);
+        bundleRecord.firstPlugin = static_cast<uint32_t>(pluginRecords.size());
+        bundleRecord.pluginCount = static_cast<uint32_t>(bundle->plugins.size());
+
+        for (const CachedPlugin& plugin : bundle->plugins) {
+            const PluginInfo& info = plugin.info;
+            PluginRecord record = {};
+            record.uri = strings.Add(info.uri);
+            record.name = strings.Add(info.name);
+            record.author = strings.Add(info.author);
+            record.category = strings.Add(info.category);
+            record.description = strings.Add(info.description);
+            record.flags = (info.hasUI ? PLUGIN_HAS_UI : 0) | (info.inPlaceBroken ? PLUGIN_IN_PLACE_BROKEN : 0);
+            record.audioInputs = info.audioInputs;
+            record.audioOutputs = info.audioOutputs;
+            record.controlInputs = info.controlInputs;
+            record.controlOutputs = info.controlOutputs;
+            record.midiInputs = info.midiInputs;
+            record.midiOutputs = info.midiOutputs;
+            record.bundle = static_cast<uint32_t>(bundleRecords.size());
+            record.firstParameter = static_cast<uint32_t>(parameterRecords.size());
+            record.parameterCount = static_cast<uint32_t>(plugin.parameters.size());
+            pluginRecords.push_back(record);
+            uris.push_back(&info.uri);
+
+            for (const ParameterInfo& parameter : plugin.parameters) {
+                ParameterRecord parameterRecord = {};
+                parameterRecord.index = parameter.index;
+                parameterRecord.portIndex = parameter.portIndex;
+                parameterRecord.symbol = strings.Add(parameter.symbol);
+                parameterRecord.name = strings.Add(parameter.name);
+                parameterRecord.defaultValue = parameter.defaultValue;
+                parameterRecord.minimum = parameter.minimum;
+                parameterRecord.maximum = parameter.maximum;
+                parameterRecord.flags = (parameter.isToggle ? PARAMETER_TOGGLE : 0) |
+                                        (parameter.isInteger ? PARAMETER_INTEGER : 0) |
+                                        (parameter.isEnum ? PARAMETER_ENUM : 0);
+                parameterRecord.firstEnum = static_cast<uint32_t>(enumValues.size());
+                parameterRecord.enumCount = static_cast<uint32_t>(parameter.enumValues.size());
+                for (const std::string& value : parameter.enumValues) {
+                    enumValues.push_back(strings.Add(value));
+                }
+                parameterRecords.push_back(parameterRecord);
+            }
+        }
+        bundleRecords.push_back(bundleRecord);
+    }
+
+    std::vector<uint32_t> uriIndex(pluginRecords.size());
+    for (uint32_t i = 0; i < uriIndex.size(); ++i) {
+        uriIndex[i] = i;
+    }
+    std::stable_sort(uriIndex.begin(), uriIndex.end(), [&uris](uint32_t a, uint32_t b) {
+        return *uris[a] < *uris[b];
+    });
+
+    std::vector<uint8_t> payload;
+    Append(payload, bundleRecords.data(), bundleRecords.size());
+    Append(payload, pluginRecords.data(), pluginRecords.size());
+    Append(payload, uriIndex.data(), uriIndex.size());
+    Append(payload, parameterRecords.data(), parameterRecords.size());
+    Append(payload, enumValues.data(), enumValues.size());
+    Append(payload, strings.GetBytes().data(), strings.GetBytes().size());
+
+    FileHeader header = {};
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.bundleCount = static_cast<uint32_t>(bundleRecords.size());
+    header.pluginCount = static_cast<uint32_t>(pluginRecords.size());
+    header.parameterCount = static_cast<uint32_t>(parameterRecords.size());
+    header.enumCount = static_cast<uint32_t>(enumValues.size());
+    header.stringBytes = static_cast<uint32_t>(strings.GetBytes().size());
+    header.checksum = HashBytes(FNV_OFFSET, payload.data(), payload.size());
+
+    std::lock_guard<std::mutex> lock(saveMutex);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    if (!MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+#endif
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+size_t PluginCache::GetBundleCount() const {
+    return header_ ? header_->bundleCount : 0;
+}
+
+size_t PluginCache::GetPluginCount() const {
+    return header_ ? header_->pluginCount : 0;
+}
+
+const char* PluginCache::GetString(uint32_t offset) const {
+    return strings_ + offset;
+}
+
+const PluginCache::BundleRecord* PluginCache::FindBundleRecord(const std::string& bundlePath) const {
+    if (!header_) {
+        return nullptr;
+    }
+    const BundleRecord* end = bundles_ + header_->bundleCount;
+    const BundleRecord* it = std::lower_bound(bundles_, end, bundlePath,
+        [this](const BundleRecord& record, const std::string& path) {
+            return path.compare(GetString(record.path)) > 0;
+        });
+    return it != end && bundlePath == GetString(it->path) ? it : nullptr;
+}
+
+const PluginCache::PluginRecord* PluginCache::FindPluginRecord(const std::string& uri) const {
+    if (!header_) {
+        return nullptr;
+    }
+    const uint32_t* end = uriIndex_ + header_->pluginCount;
+    const uint32_t* it = std::lower_bound(uriIndex_, end, uri, [this](uint32_t index, const std::string& key) {
+        return key.compare(GetString(plugins_[index].uri)) > 0;
+    });
+    return it != end && uri == GetString(plugins_[*it].uri) ? &plugins_[*it] : nullptr;
+}
+
+bool PluginCache::FindBundle(const std::string& bundlePath, uint64_t& fingerprint) const {
+    const BundleRecord* record = FindBundleRecord(bundlePath);
+    if (!record) {
+        return false;
+    }
+    fingerprint = record->fingerprint;
+    return true;
+}
+
+PluginInfo PluginCache::DecodePlugin(const PluginRecord& record) const {
+    PluginInfo info;
+    info.uri = GetString(record.uri);
+    info.name = GetString(record.name);
+    info.author = GetString(record.author);
+    info.category = GetString(record.category);
+    info.description = GetString(record.description);
+    info.hasUI = (record.flags & PLUGIN_HAS_UI) != 0;
+    info.inPlaceBroken = (record.flags & PLUGIN_IN_PLACE_BROKEN) != 0;
+    info.audioInputs = record.audioInputs;
+    info.audioOutputs = record.audioOutputs;
+    info.controlInputs = record.controlInputs;
+    info.controlOutputs = record.controlOutputs;
+    info.midiInputs = record.midiInputs;
+    info.midiOutputs = record.midiOutputs;
+    return info;
+}
+
+std::vector<ParameterInfo> PluginCache::DecodeParameters(const PluginRecord& record) const {
+    std::vector<ParameterInfo> parameters;
+    parameters.reserve(record.parameterCount);
+    for (uint32_t i = 0; i < record.parameterCount; ++i) {
+        const ParameterRecord& source = parameters_[record.firstParameter + i];
+        ParameterInfo parameter;
+        parameter.index = source.index;
+        parameter.portIndex = source.portIndex;
+        parameter.symbol = GetString(source.symbol);
+        parameter.name = GetString(source.name);
+        parameter.defaultValue = source.defaultValue;
+        parameter.minimum = source.minimum;
+        parameter.maximum = source.maximum;
+        parameter.isToggle = (source.flags & PARAMETER_TOGGLE) != 0;
+        parameter.isInteger = (source.flags & PARAMETER_INTEGER) != 0;
+        parameter.isEnum = (source.flags & PARAMETER_ENUM) != 0;
+        for (uint32_t e = 0; e < source.enumCount; ++e) {
+            parameter.enumValues.push_back(GetString(enumValues_[source.firstEnum + e]));
+        }
+        parameters.push_back(std::move(parameter));
+    }
+    return parameters;
+}
+
+std::vector<PluginInfo> PluginCache::GetBundlePlugins(const std::string& bundlePath) const {
+    std::vector<PluginInfo> plugins;
+    const BundleRecord* record = FindBundleRecord(bundlePath);
+    if (record) {
+        plugins.reserve(record->pluginCount);
+        for (uint32_t i = 0; i < record->pluginCount; ++i) {
+            plugins.push_back(DecodePlugin(plugins_[record->firstPlugin + i]));
+        }
+    }
+    return plugins;
+}
+
+bool PluginCache::ReadBundle(const std::string& bundlePath, CachedBundle& bundle) const {
+    const BundleRecord* record = FindBundleRecord(bundlePath);
+    if (!record) {
+        return false;
+    }
+    bundle.path = GetString(record->path);
+    bundle.fingerprint = record->fingerprint;
+    bundle.plugins.clear();
+    for (uint32_t i = 0; i < record->pluginCount; ++i) {
+        const PluginRecord& plugin = plugins_[record->firstPlugin + i];
+        CachedPlugin cached;
+        cached.info = DecodePlugin(plugin);
+        cached.parameters = DecodeParameters(plugin);
+        bundle.plugins.push_back(std::move(cached));
+    }
+    return true;
+}
+
+bool PluginCache::GetParameters(const std::string& uri, std::vector<ParameterInfo>& parameters) const {
+    const PluginRecord* record = FindPluginRecord(uri);
+    if (!record) {
+        return false;
+    }
+    parameters = DecodeParameters(*record);
+    return true;
+}
+
+std::string PluginCache::FindPluginBundle(const std::string& uri) const {
+    const PluginRecord* record = FindPluginRecord(uri);
+    return record ? GetString(bundles_[record->bundle].path) : "";
+}
+
+std::string NormalizeBundlePath(const std::string& path) {
+    std::string result = path;
+    std::replace(result.begin(), result.end(), '\\', '/');
+    while (result.size() > 1 && result.back() == '/') {
+        result.pop_back();
+    }
+    return result;
+}
+
+std::vector<BundleFingerprint> FindBundles(const std::string& searchPath) {
+    std::vector<BundleFingerprint> bundles;
+    std::unordered_set<std::string> seen;
+
+    for (std::string directory : utils::Split(searchPath, PATH_LIST_SEPARATOR)) {
+        if (directory.empty()) {
+            continue;
+        }
+        // lilv expands a leading ~ too
+        const char* home = getenv("HOME");
+        if (directory[0] == '~' && home) {
+            directory = home + directory.substr(1);
+        }
+
+        std::vector<DirectoryEntry> entries;
+        if (!ListDirectory(directory, entries)) {
+            continue;
+        }
+        for (const DirectoryEntry& entry : entries) {
+            if (!entry.isDirectory) {
+                continue;
+            }
+            std::string bundlePath = NormalizeBundlePath(directory + "/" + entry.name);
+            std::vector<DirectoryEntry> files;
+            if (seen.count(bundlePath) || !ListDirectory(bundlePath, files)) {
+                continue;
+            }
+            bool hasManifest = std::any_of(files.begin(), files.end(), [](const DirectoryEntry& file) {
+                return !file.isDirectory && file.name == "manifest.ttl";
+            });
+            if (hasManifest) {
+                seen.insert(bundlePath);
+                BundleFingerprint bundle;
+                bundle.path = bundlePath;
+                bundle.fingerprint = HashEntries(files);
+                bundles.push_back(std::move(bundle));
+            }
+        }
+    }
+    return bundles;
+}
+
+uint64_t FingerprintBundle(const std::string& bundlePath) {
+    std::vector<DirectoryEntry> entries;
+    if (!ListDirectory(bundlePath, entries)) {
+        return 0;
+    }
+    return HashEntries(entries);
+}
+
+std::string GetDefaultPluginCachePath() {
+    const char* configured = getenv("VIOLET_PLUGIN_CACHE");
+    if (configured) {
+        return strcmp(configured, "off") == 0 ? std::string() : std::string(configured);
+    }
+
+#ifdef _WIN32
+    const char* localAppData = getenv("LOCALAPPDATA");
+    if (!localAppData || !*localAppData) {
+        return "";
+    }
+    std::string base = localAppData;
+#else
+    std::string base;
+    const char* cacheHome = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (cacheHome && *cacheHome) {
+        base = cacheHome;
+    } else if (home) {
+        base = utils::JoinPath(home, ".cache");
+        utils::MakeDirectory(base);
+    } else {
+        return "";
+    }
+#endif
+    std::string violetDir = utils::JoinPath(base, "Violet");
+    utils::MakeDirectory(violetDir);
+    return utils::JoinPath(violetDir, "plugin-cache.bin");
+}
+
+} // namespace violet
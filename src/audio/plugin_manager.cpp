@@ -1,20 +1,93 @@
 #include "violet/plugin_manager.h"
+#include "violet/plugin_cache.h"
+#include "violet/realtime_log.h"
 #include "violet/utils.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
 #include <cmath>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <climits>
+#endif
 
 namespace violet {
 
+namespace {
+
+// Key of the serialized LV2 state in SaveState()/LoadState() maps
+const char* const LV2_STATE_KEY = "lv2:state";
+const char* const LV2_STATE_URI = "urn:violet:state";
+
+// A control input's name, symbol, range and properties from the plugin data;
+// the caller fills in the indices
+ParameterInfo ReadParameterInfo(LilvWorld* world, const LilvPlugin* plugin, const LilvPort* port) {
+    ParameterInfo paramInfo;
+    
+    const LilvNode* symbolNode = lilv_port_get_symbol(plugin, port);
+    paramInfo.symbol = symbolNode ? lilv_node_as_string(symbolNode) : "";
+    
+    LilvNode* nameNode = const_cast<LilvNode*>(lilv_port_get_name(plugin, port));
+    paramInfo.name = nameNode ? lilv_node_as_string(nameNode) : paramInfo.symbol;
+    if (nameNode) lilv_node_free(nameNode);
+    
+    // Get default, min, max values from TTL file
+    LilvNode* defaultNode = nullptr;
+    LilvNode* minNode = nullptr;
+    LilvNode* maxNode = nullptr;
+    
+    lilv_port_get_range(plugin, port, &defaultNode, &minNode, &maxNode);
+    
+    paramInfo.defaultValue = defaultNode ? lilv_node_as_float(defaultNode) : 0.0f;
+    paramInfo.minimum = minNode ? lilv_node_as_float(minNode) : 0.0f;
+    paramInfo.maximum = maxNode ? lilv_node_as_float(maxNode) : 1.0f;
+    
+    if (defaultNode) lilv_node_free(defaultNode);
+    if (minNode) lilv_node_free(minNode);
+    if (maxNode) lilv_node_free(maxNode);
+    
+    // Check for toggle or integer properties
+    LilvNode* toggledNode = lilv_new_uri(world, LV2_CORE__toggled);
+    LilvNode* integerNode = lilv_new_uri(world, LV2_CORE__integer);
+    paramInfo.isToggle = lilv_port_has_property(plugin, port, toggledNode);
+    paramInfo.isInteger = lilv_port_has_property(plugin, port, integerNode);
+    paramInfo.isEnum = false; // TODO: Implement enumeration detection
+    lilv_node_free(toggledNode);
+    lilv_node_free(integerNode);
+    
+    return paramInfo;
+}
+
+// Directory of the bundle a plugin came from, as FindBundles() names it
+std::string GetBundlePath(const LilvPlugin* plugin) {
+    const LilvNode* bundleNode = lilv_plugin_get_bundle_uri(plugin);
+    char* path = bundleNode ? lilv_file_uri_parse(lilv_node_as_uri(bundleNode), nullptr) : nullptr;
+    if (!path) {
+        return "";
+    }
+    std::string bundlePath = NormalizeBundlePath(path);
+    lilv_free(path);
+    return bundlePath;
+}
+
+} // namespace
+
 // PluginInstance implementation
-PluginInstance::PluginInstance(const LilvPlugin* plugin, LilvWorld* world, double sampleRate, uint32_t blockSize)
+PluginInstance::PluginInstance(const LilvPlugin* plugin, LilvWorld* world, std::mutex* worldMutex, double sampleRate,
+                               uint32_t blockSize, bool fixedBlockLength)
     : plugin_(plugin)
     , world_(world)
+    , worldMutex_(worldMutex)
     , instance_(nullptr)
     , sampleRate_(sampleRate)
     , blockSize_(blockSize)
+    , fixedBlockLength_(fixedBlockLength)
     , isActive_(false)
+    , latencyOutput_(-1)
     , nextUrid_(1) {
     
     // Extract plugin info
@@ -28,6 +101,10 @@ PluginInstance::PluginInstance(const LilvPlugin* plugin, LilvWorld* world, doubl
     info_.author = authorNode ? lilv_node_as_string(authorNode) : "Unknown";
     if (authorNode) lilv_node_free(authorNode);
     
+    LilvNode* inPlaceBrokenNode = lilv_new_uri(world_, LV2_CORE__inPlaceBroken);
+    info_.inPlaceBroken = lilv_plugin_has_feature(plugin_, inPlaceBrokenNode);
+    lilv_node_free(inPlaceBrokenNode);
+    
     // Initialize features and ports
     InitializeFeatures();
     InitializePorts();
@@ -60,11 +137,40 @@ void PluginInstance::InitializeFeatures() {
     // Create feature list
     features_.clear();
     
-    static LV2_Feature uridMapFeature = { LV2_URID__map, &uridMap_ };
-    static LV2_Feature uridUnmapFeature = { LV2_URID__unmap, &uridUnmap_ };
-    
-    features_.push_back(&uridMapFeature);
-    features_.push_back(&uridUnmapFeature);
+    // Per instance: each feature points at this instance's own map
+    uridMapFeature_ = { LV2_URID__map, &uridMap_ };
+    uridUnmapFeature_ = { LV2_URID__unmap, &uridUnmap_ };
+    
+    features_.push_back(&uridMapFeature_);
+    features_.push_back(&uridUnmapFeature_);
+    
+    // Block length options; mapping through our own map keeps the URIDs the
+    // plugin sees consistent with the ones it maps itself
+    LV2_URID intType = MapUrid(this, LV2_ATOM__Int);
+    maxBlockLength_ = static_cast<int32_t>(blockSize_);
+    nominalBlockLength_ = maxBlockLength_;
+    minBlockLength_ = fixedBlockLength_ ? maxBlockLength_ : 0;
+    blockOptions_[0] = { LV2_OPTIONS_INSTANCE, 0, MapUrid(this, LV2_BUF_SIZE__minBlockLength),
+                         sizeof(int32_t), intType, &minBlockLength_ };
+    blockOptions_[1] = { LV2_OPTIONS_INSTANCE, 0, MapUrid(this, LV2_BUF_SIZE__maxBlockLength),
+                         sizeof(int32_t), intType, &maxBlockLength_ };
+    blockOptions_[2] = { LV2_OPTIONS_INSTANCE, 0, MapUrid(this, LV2_BUF_SIZE__nominalBlockLength),
+                         sizeof(int32_t), intType, &nominalBlockLength_ };
+    blockOptions_[3] = { LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, nullptr }; // Terminator
+    optionsFeature_ = { LV2_OPTIONS__options, blockOptions_ };
+    boundedBlockFeature_ = { LV2_BUF_SIZE__boundedBlockLength, nullptr };
+    fixedBlockFeature_ = { LV2_BUF_SIZE__fixedBlockLength, nullptr };
+    powerOf2BlockFeature_ = { LV2_BUF_SIZE__powerOf2BlockLength, nullptr };
+    
+    // Chunking in ProcessingNode already bounds every run by blockSize_
+    features_.push_back(&optionsFeature_);
+    features_.push_back(&boundedBlockFeature_);
+    if (fixedBlockLength_) {
+        features_.push_back(&fixedBlockFeature_);
+        if (blockSize_ != 0 && (blockSize_ & (blockSize_ - 1)) == 0) {
+            features_.push_back(&powerOf2BlockFeature_);
+        }
+    }
     features_.push_back(nullptr); // Null terminator
 }
 
@@ -74,6 +180,7 @@ void PluginInstance::CleanupFeatures() {
 
 LV2_URID PluginInstance::MapUrid(LV2_URID_Map_Handle handle, const char* uri) {
     PluginInstance* instance = static_cast<PluginInstance*>(handle);
+    std::lock_guard<std::mutex> lock(instance->uridMutex_);
     
     auto it = instance->uridMappings_.find(uri);
     if (it != instance->uridMappings_.end()) {
@@ -89,6 +196,7 @@ LV2_URID PluginInstance::MapUrid(LV2_URID_Map_Handle handle, const char* uri) {
 
 const char* PluginInstance::UnmapUrid(LV2_URID_Unmap_Handle handle, LV2_URID urid) {
     PluginInstance* instance = static_cast<PluginInstance*>(handle);
+    std::lock_guard<std::mutex> lock(instance->uridMutex_);
     
     auto it = instance->uridReverseMappings_.find(urid);
     if (it != instance->uridReverseMappings_.end()) {
@@ -113,6 +221,9 @@ void PluginInstance::InitializePorts() {
     
     std::cout << "=== Enumerating ports for plugin: " << info_.name << " (total ports: " << numPorts << ") ===" << std::endl;
     
+    // The control output flagged lv2:reportsLatency (or designated lv2:latency)
+    uint32_t latencyPort = lilv_plugin_has_latency(plugin_) ? lilv_plugin_get_latency_port_index(plugin_) : UINT32_MAX;
+    
     for (uint32_t i = 0; i < numPorts; ++i) {
         const LilvPort* port = lilv_plugin_get_port_by_index(plugin_, i);
         
@@ -134,50 +245,23 @@ void PluginInstance::InitializePorts() {
                 info_.controlInputs++;
                 
                 // Extract parameter info
-                ParameterInfo paramInfo;
+                ParameterInfo paramInfo = ReadParameterInfo(world_, plugin_, port);
                 paramInfo.index = static_cast<uint32_t>(controlInputPorts_.size() - 1); // ordinal index
                 paramInfo.portIndex = i;
                 
-                const LilvNode* symbolNode = lilv_port_get_symbol(plugin_, port);
-                paramInfo.symbol = symbolNode ? lilv_node_as_string(symbolNode) : "";
-                
-                LilvNode* nameNode = const_cast<LilvNode*>(lilv_port_get_name(plugin_, port));
-                paramInfo.name = nameNode ? lilv_node_as_string(nameNode) : paramInfo.symbol;
-                if (nameNode) lilv_node_free(nameNode);
-                
                 std::cout << "    Name: " << paramInfo.name << ", Symbol: " << paramInfo.symbol << std::endl;
-                
-                // Get default, min, max values from TTL file
-                LilvNode* defaultNode = nullptr;
-                LilvNode* minNode = nullptr;
-                LilvNode* maxNode = nullptr;
-                
-                lilv_port_get_range(plugin_, port, &defaultNode, &minNode, &maxNode);
-                
-                paramInfo.defaultValue = defaultNode ? lilv_node_as_float(defaultNode) : 0.0f;
-                paramInfo.minimum = minNode ? lilv_node_as_float(minNode) : 0.0f;
-                paramInfo.maximum = maxNode ? lilv_node_as_float(maxNode) : 1.0f;
-                
                 std::cout << "    Range: min=" << paramInfo.minimum 
                           << ", max=" << paramInfo.maximum 
                           << ", default=" << paramInfo.defaultValue << std::endl;
                 
-                if (defaultNode) lilv_node_free(defaultNode);
-                if (minNode) lilv_node_free(minNode);
-                if (maxNode) lilv_node_free(maxNode);
-                
-                // Check for toggle or integer properties
-                paramInfo.isToggle = lilv_port_has_property(plugin_, port, 
-                    lilv_new_uri(world_, LV2_CORE__toggled));
-                paramInfo.isInteger = lilv_port_has_property(plugin_, port, 
-                    lilv_new_uri(world_, LV2_CORE__integer));
-                paramInfo.isEnum = false; // TODO: Implement enumeration detection
-                
                 parameterInfo_[i] = paramInfo;
                 controlValues_[i] = paramInfo.defaultValue;
                 
             } else if (lilv_port_is_a(plugin_, port, lilv_new_uri(world_, LV2_CORE__OutputPort))) {
-                std::cout << "  Port " << i << ": Control Output" << std::endl;
+                std::cout << "  Port " << i << ": Control Output" << (i == latencyPort ? " (latency)" : "") << std::endl;
+                if (i == latencyPort) {
+                    latencyOutput_ = static_cast<int32_t>(controlOutputPorts_.size());
+                }
                 controlOutputPorts_.push_back(i);
                 info_.controlOutputs++;
             }
@@ -215,43 +299,41 @@ void PluginInstance::Process(uint32_t frames) {
 
 void PluginInstance::ConnectAudioInput(uint32_t port, float* buffer) {
     if (!instance_) {
-        std::cerr << "Error: instance_ is NULL in ConnectAudioInput" << std::endl;
+        LogRealtime(LogLevel::Error, "Error: instance_ is NULL in ConnectAudioInput");
         return;
     }
     
     if (port >= audioInputPorts_.size()) {
-        std::cerr << "Error: audio input port " << port << " out of range (size=" << audioInputPorts_.size() << ")" << std::endl;
+        LogRealtime(LogLevel::Error, "Error: audio input port {} out of range (size={})", port, audioInputPorts_.size());
         return;
     }
     
     if (!buffer) {
-        std::cerr << "Error: NULL buffer passed to ConnectAudioInput port " << port << std::endl;
+        LogRealtime(LogLevel::Error, "Error: NULL buffer passed to ConnectAudioInput port {}", port);
         return;
     }
     
     uint32_t actualPortIndex = audioInputPorts_[port];
-    std::cout << "Connecting audio input port " << port << " (actual LV2 port " << actualPortIndex << ") to buffer " << (void*)buffer << std::endl;
     lilv_instance_connect_port(instance_, actualPortIndex, buffer);
 }
 
 void PluginInstance::ConnectAudioOutput(uint32_t port, float* buffer) {
     if (!instance_) {
-        std::cerr << "Error: instance_ is NULL in ConnectAudioOutput" << std::endl;
+        LogRealtime(LogLevel::Error, "Error: instance_ is NULL in ConnectAudioOutput");
         return;
     }
     
     if (port >= audioOutputPorts_.size()) {
-        std::cerr << "Error: audio output port " << port << " out of range (size=" << audioOutputPorts_.size() << ")" << std::endl;
+        LogRealtime(LogLevel::Error, "Error: audio output port {} out of range (size={})", port, audioOutputPorts_.size());
         return;
     }
     
     if (!buffer) {
-        std::cerr << "Error: NULL buffer passed to ConnectAudioOutput port " << port << std::endl;
+        LogRealtime(LogLevel::Error, "Error: NULL buffer passed to ConnectAudioOutput port {}", port);
         return;
     }
     
     uint32_t actualPortIndex = audioOutputPorts_[port];
-    std::cout << "Connecting audio output port " << port << " (actual LV2 port " << actualPortIndex << ") to buffer " << (void*)buffer << std::endl;
     lilv_instance_connect_port(instance_, actualPortIndex, buffer);
 }
 
@@ -293,7 +375,7 @@ void PluginInstance::ConnectControlOutput(uint32_t port, float* value) {
     }
     
     uint32_t actualPortIndex = controlOutputPorts_[port];
-    std::cout << "Connecting control output port " << port << " (actual LV2 port " << actualPortIndex << ") to dummy buffer " << (void*)value << std::endl;
+    std::cout << "Connecting control output port " << port << " (actual LV2 port " << actualPortIndex << ") to value " << (void*)value << std::endl;
     lilv_instance_connect_port(instance_, actualPortIndex, value);
 }
 
@@ -366,7 +448,11 @@ bool PluginInstance::SaveState(std::map<std::string, std::string>& state) {
         state[info.symbol] = std::to_string(controlValues_[index]);
     }
     
-    // TODO: Implement LV2 state extension support
+    // Port symbols are C identifiers, so this key can't clash with them
+    std::string lv2State;
+    if (SaveLv2State(lv2State)) {
+        state[LV2_STATE_KEY] = lv2State;
+    }
     return true;
 }
 
@@ -387,7 +473,60 @@ bool PluginInstance::LoadState(const std::map<std::string, std::string>& state)
         }
     }
     
-    // TODO: Implement LV2 state extension support
+    auto it = state.find(LV2_STATE_KEY);
+    if (it != state.end()) {
+        RestoreLv2State(it->second);
+    }
+    return true;
+}
+
+bool PluginInstance::SaveLv2State(std::string& state) {
+    if (!instance_ || !lilv_instance_get_extension_data(instance_, LV2_STATE__interface)) {
+        return false;
+    }
+    
+    // The manager may be loading bundles into the same world
+    std::lock_guard<std::mutex> lock(*worldMutex_);
+    
+    // Port values are carried separately, so only the plugin's own
+    // properties are captured. Without state directories only POD,
+    // portable properties can be stored, which is what a string needs.
+    LilvState* lilvState = lilv_state_new_from_instance(
+        plugin_, instance_, &uridMap_, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE, features_.data());
+    if (!lilvState) {
+        return false;
+    }
+    
+    char* text = lilv_state_to_string(world_, &uridMap_, &uridUnmap_, lilvState, LV2_STATE_URI, nullptr);
+    lilv_state_free(lilvState);
+    if (!text) {
+        return false;
+    }
+    
+    state = text;
+    lilv_free(text);
+    return true;
+}
+
+bool PluginInstance::RestoreLv2State(const std::string& state) {
+    if (!instance_ || state.empty() || !lilv_instance_get_extension_data(instance_, LV2_STATE__interface)) {
+        return false;
+    }
+    
+    // Parsing maps the URIs through this instance's own URID map
+    LilvState* lilvState = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(*worldMutex_);
+        lilvState = lilv_state_new_from_string(world_, &uridMap_, state.c_str());
+    }
+    if (!lilvState) {
+        std::cerr << "Failed to parse LV2 state for " << info_.name << std::endl;
+        return false;
+    }
+    
+    lilv_state_restore(lilvState, instance_, nullptr, nullptr, 0, features_.data());
+    lilv_state_free(lilvState);
     return true;
 }
 
@@ -395,6 +534,14 @@ bool PluginInstance::LoadState(const std::map<std::string, std::string>& state)
 PluginManager::PluginManager()
     : world_(nullptr)
     , plugins_(nullptr)
+    , lazyLoading_(false)
+    , allBundlesLoaded_(false)
+    , cache_(new PluginCache())
+    , cachePath_(GetDefaultPluginCachePath())
+    , scanStarted_(false)
+    , worldLoaded_(false)
+    , scanning_(false)
+    , stopScan_(false)
     , isInitialized_(false) {
 }
 
@@ -413,25 +560,86 @@ bool PluginManager::Initialize() {
         return false;
     }
     
-    ScanPlugins();
+    // The browser has the cached list now; lilv catches up on the scan thread
+    LoadCachedPlugins();
     isInitialized_ = true;
+    if (!lazyLoading_) {
+        StartBackgroundScan();
+    }
     
     return true;
 }
 
+void PluginManager::StartBackgroundScan() {
+    std::lock_guard<std::mutex> lock(scanMutex_);
+    if (!isInitialized_ || scanStarted_) {
+        return;
+    }
+    scanStarted_ = true;
+    worldLoaded_ = false;
+    scanning_ = true;
+    stopScan_ = false;
+    scanThread_ = std::thread(&PluginManager::ScanThreadProc, this);
+}
+
 void PluginManager::Shutdown() {
     if (!isInitialized_) {
         return;
     }
     
-    availablePlugins_.clear();
+    stopScan_ = true;
+    if (scanThread_.joinable()) {
+        scanThread_.join();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(pluginsMutex_);
+        availablePlugins_.clear();
+        categories_.clear();
+        scannedParameters_.clear();
+        cache_->Clear();
+    }
     pluginMap_.clear();
-    categories_.clear();
+    bundleFingerprints_.clear();
+    allBundlesLoaded_ = false;
+    scanStarted_ = false;
     
     ShutdownLilv();
     isInitialized_ = false;
 }
 
+void PluginManager::SetCachePath(const std::string& path) {
+    cachePath_ = path;
+}
+
+void PluginManager::SetLazyLoading(bool lazy) {
+    lazyLoading_ = lazy;
+}
+
+bool PluginManager::HasLoadedAllBundles() const {
+    std::lock_guard<std::mutex> lock(worldMutex_);
+    return allBundlesLoaded_;
+}
+
+void PluginManager::SetPluginsChangedCallback(std::function<void()> callback) {
+    pluginsChanged_ = std::move(callback);
+}
+
+bool PluginManager::IsScanning() const {
+    std::lock_guard<std::mutex> lock(scanMutex_);
+    return scanning_;
+}
+
+void PluginManager::WaitForScan() {
+    std::unique_lock<std::mutex> lock(scanMutex_);
+    scanCondition_.wait(lock, [this] { return !scanning_; });
+}
+
+void PluginManager::WaitForWorld() {
+    std::unique_lock<std::mutex> lock(scanMutex_);
+    scanCondition_.wait(lock, [this] { return worldLoaded_ || !scanning_; });
+}
+
 void PluginManager::InitializeLilv() {
     world_ = lilv_world_new();
     if (!world_) {
@@ -439,39 +647,39 @@ void PluginManager::InitializeLilv() {
         return;
     }
     
-    // Set LV2_PATH environment variable to current directory
+    // Set LV2_PATH environment variable to current directory. putenv keeps
+    // the pointer, so the string has to outlive this call.
+    static std::string lv2Path;
+#ifdef _WIN32
+    // Search ./lv2 first, then anything the user put in LV2_PATH
     char currentDir[MAX_PATH];
     if (GetCurrentDirectoryA(MAX_PATH, currentDir)) {
-        std::string lv2Path = "LV2_PATH=" + std::string(currentDir) + "/lv2";
+        const char* existing = getenv("LV2_PATH");
+        lv2Path = "LV2_PATH=" + std::string(currentDir) + "/lv2";
+        if (existing && *existing) {
+            lv2Path += ";" + std::string(existing);
+        }
         putenv(const_cast<char*>(lv2Path.c_str()));
-        std::cout << "LV2_PATH set to: " << currentDir << std::endl;
+        std::cout << "LV2_PATH set to: " << lv2Path.substr(9) << std::endl;
     } else {
         std::cerr << "Failed to get current directory" << std::endl;
     }
-
-    lilv_world_load_all(world_);
-    plugins_ = lilv_world_get_all_plugins(world_);
-    
-    // Print all found plugins
-    if (plugins_) {
-        unsigned int pluginCount = lilv_plugins_size(plugins_);
-        std::cout << "Found " << pluginCount << " LV2 plugins:" << std::endl;
-        
-        LILV_FOREACH(plugins, iter, plugins_) {
-            const LilvPlugin* plugin = lilv_plugins_get(plugins_, iter);
-            const LilvNode* nameNode = lilv_plugin_get_name(plugin);
-            const LilvNode* uriNode = lilv_plugin_get_uri(plugin);
-            
-            std::string name = nameNode ? lilv_node_as_string(nameNode) : "Unknown";
-            std::string uri = uriNode ? lilv_node_as_string(uriNode) : "Unknown";
-            
-            std::cout << "  - " << name << " (" << uri << ")" << std::endl;
-            
-            if (nameNode) lilv_node_free(const_cast<LilvNode*>(nameNode));
-        }
+#else
+    // Search ./lv2 first, then the user's LV2_PATH or the usual system locations
+    char currentDir[PATH_MAX];
+    if (getcwd(currentDir, sizeof(currentDir))) {
+        const char* existing = getenv("LV2_PATH");
+        const char* home = getenv("HOME");
+        std::string searchPath = existing ? existing
+            : (home ? std::string(home) + "/.lv2:" : std::string()) + "/usr/local/lib/lv2:/usr/lib/lv2";
+        lv2Path = "LV2_PATH=" + std::string(currentDir) + "/lv2:" + searchPath;
+        putenv(const_cast<char*>(lv2Path.c_str()));
+        std::cout << "LV2_PATH set to: " << lv2Path.substr(9) << std::endl;
     } else {
-        std::cout << "No LV2 plugins found" << std::endl;
+        std::cerr << "Failed to get current directory" << std::endl;
     }
+#endif
+    // lilv_world_load_all() runs on the scan thread, see LoadWorld()
 }
 
 void PluginManager::ShutdownLilv() {
@@ -482,29 +690,247 @@ void PluginManager::ShutdownLilv() {
     }
 }
 
-void PluginManager::ScanPlugins() {
-    if (!plugins_) {
+std::string PluginManager::GetSearchPath() const {
+    const char* lv2Path = getenv("LV2_PATH");
+    if (lv2Path && *lv2Path) {
+        return lv2Path;
+    }
+    
+    // Where lilv looks without LV2_PATH
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+    std::string searchPath;
+    for (const auto& path : GetDefaultScanPaths()) {
+        searchPath += (searchPath.empty() ? "" : std::string(1, separator)) + path;
+    }
+    return searchPath;
+}
+
+void PluginManager::LoadCachedPlugins() {
+    // Listing the bundle directories is all the disk access this takes
+    bundleFingerprints_.clear();
+    for (const auto& bundle : FindBundles(GetSearchPath())) {
+        bundleFingerprints_[bundle.path] = bundle.fingerprint;
+    }
+    
+    std::vector<PluginInfo> plugins;
+    {
+        std::lock_guard<std::mutex> lock(pluginsMutex_);
+        if (cachePath_.empty() || !cache_->Load(cachePath_)) {
+            return;
+        }
+        for (const auto& bundle : bundleFingerprints_) {
+            uint64_t fingerprint = 0;
+            if (bundle.second != 0 && cache_->FindBundle(bundle.first, fingerprint) && fingerprint == bundle.second) {
+                std::vector<PluginInfo> bundlePlugins = cache_->GetBundlePlugins(bundle.first);
+                plugins.insert(plugins.end(), bundlePlugins.begin(), bundlePlugins.end());
+            }
+        }
+    }
+    SetPlugins(plugins);
+    std::cout << "Loaded " << plugins.size() << " LV2 plugins from the plugin cache" << std::endl;
+}
+
+void PluginManager::ScanThreadProc() {
+    {
+        // A lazy manager may have loaded everything already
+        std::lock_guard<std::mutex> lock(worldMutex_);
+        if (!allBundlesLoaded_) {
+            LoadWorld();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(scanMutex_);
+        worldLoaded_ = true;
+    }
+    scanCondition_.notify_all();
+    
+    ScanBundles(true);
+    {
+        std::lock_guard<std::mutex> lock(scanMutex_);
+        scanning_ = false;
+    }
+    scanCondition_.notify_all();
+}
+
+void PluginManager::LoadWorld() {
+    // Reads the manifests only; lilv parses a plugin's data the first time
+    // it is asked about it
+    lilv_world_load_all(world_);
+    allBundlesLoaded_ = true;
+    MapPlugins();
+}
+
+void PluginManager::LoadBundle(const std::string& bundlePath) {
+    // lilv wants the bundle as a directory URI, trailing slash included
+    LilvNode* bundleUri = lilv_new_file_uri(world_, nullptr, (bundlePath + "/").c_str());
+    if (!bundleUri) {
         return;
     }
+    lilv_world_load_bundle(world_, bundleUri);
+    lilv_node_free(bundleUri);
+    MapPlugins();
+}
+
+void PluginManager::MapPlugins() {
+    plugins_ = lilv_world_get_all_plugins(world_);
     
-    availablePlugins_.clear();
     pluginMap_.clear();
-    categories_.clear();
+    if (plugins_) {
+        LILV_FOREACH(plugins, iter, plugins_) {
+            const LilvPlugin* plugin = lilv_plugins_get(plugins_, iter);
+            pluginMap_[lilv_node_as_string(lilv_plugin_get_uri(plugin))] = plugin;
+        }
+    }
+}
+
+const LilvPlugin* PluginManager::FindPlugin(const std::string& uri) {
+    auto it = pluginMap_.find(uri);
+    if (it != pluginMap_.end()) {
+        return it->second;
+    }
+    if (!world_ || allBundlesLoaded_) {
+        return nullptr;
+    }
+    
+    // Lazy: load the bundle the cache says the plugin is in
+    std::string bundlePath;
+    {
+        std::lock_guard<std::mutex> lock(pluginsMutex_);
+        bundlePath = cache_->FindPluginBundle(uri);
+    }
+    if (!bundlePath.empty()) {
+        LoadBundle(bundlePath);
+        it = pluginMap_.find(uri);
+        if (it != pluginMap_.end()) {
+            return it->second;
+        }
+    }
     
-    LILV_FOREACH(plugins, iter, plugins_) {
-        const LilvPlugin* plugin = lilv_plugins_get(plugins_, iter);
-        PluginInfo info = ExtractPluginInfo(plugin);
+    // Not cached, or moved since: load everything, and have the scan bring
+    // the cache up to date for next time
+    std::cout << "Plugin " << uri << " is not in the plugin cache, loading all bundles" << std::endl;
+    LoadWorld();
+    StartBackgroundScan();
+    it = pluginMap_.find(uri);
+    return it != pluginMap_.end() ? it->second : nullptr;
+}
+
+void PluginManager::ScanPlugins() {
+    WaitForScan();
+    {
+        // A lazy manager's world only has the bundles it was asked for
+        std::lock_guard<std::mutex> lock(worldMutex_);
+        if (world_ && !allBundlesLoaded_) {
+            LoadWorld();
+        }
+    }
+    bundleFingerprints_.clear();
+    for (const auto& bundle : FindBundles(GetSearchPath())) {
+        bundleFingerprints_[bundle.path] = bundle.fingerprint;
+    }
+    ScanBundles(false);
+}
+
+void PluginManager::ScanBundles(bool useCache) {
+    std::map<std::string, std::vector<const LilvPlugin*>> bundlePlugins;
+    {
+        std::lock_guard<std::mutex> lock(worldMutex_);
+        if (!plugins_) {
+            return;
+        }
+        LILV_FOREACH(plugins, iter, plugins_) {
+            const LilvPlugin* plugin = lilv_plugins_get(plugins_, iter);
+            bundlePlugins[GetBundlePath(plugin)].push_back(plugin);
+        }
+    }
+    
+    // Bundles that still match their cached fingerprint are taken from the
+    // cache; the rest are parsed, one plugin at a time so CreatePlugin()
+    // never waits long for the world
+    std::vector<CachedBundle> bundles;
+    std::map<std::string, std::vector<ParameterInfo>> parsedParameters;
+    uint32_t parsedBundles = 0;
+    for (const auto& entry : bundlePlugins) {
+        CachedBundle bundle;
+        bundle.path = entry.first;
+        auto found = bundleFingerprints_.find(entry.first);
+        bundle.fingerprint = found != bundleFingerprints_.end() ? found->second : FingerprintBundle(entry.first);
         
-        availablePlugins_.push_back(info);
-        pluginMap_[info.uri] = plugin;
+        uint64_t cachedFingerprint = 0;
+        if (useCache && bundle.fingerprint != 0 && cache_->FindBundle(bundle.path, cachedFingerprint) &&
+            cachedFingerprint == bundle.fingerprint && cache_->ReadBundle(bundle.path, bundle)) {
+            bundles.push_back(std::move(bundle));
+            continue;
+        }
         
+        for (const LilvPlugin* plugin : entry.second) {
+            if (stopScan_) {
+                return;
+            }
+            CachedPlugin cached;
+            {
+                std::lock_guard<std::mutex> lock(worldMutex_);
+                cached.info = ExtractPluginInfo(plugin, &cached.parameters);
+            }
+            parsedParameters[cached.info.uri] = cached.parameters;
+            bundle.plugins.push_back(std::move(cached));
+        }
+        ++parsedBundles;
+        bundles.push_back(std::move(bundle));
+    }
+    
+    std::vector<PluginInfo> plugins;
+    for (const auto& bundle : bundles) {
+        for (const auto& plugin : bundle.plugins) {
+            plugins.push_back(plugin.info);
+        }
+    }
+    
+    // Bundles that are gone change the list as much as new ones
+    bool changed = parsedBundles > 0 || bundles.size() != cache_->GetBundleCount();
+    bool saved = changed && !cachePath_.empty() && PluginCache::Save(cachePath_, bundles);
+    if (changed && !cachePath_.empty() && !saved) {
+        std::cerr << "Failed to write the plugin cache " << cachePath_ << std::endl;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pluginsMutex_);
+        if (saved) {
+            cache_->Load(cachePath_);
+        }
+        for (auto& entry : parsedParameters) {
+            scannedParameters_[entry.first] = std::move(entry.second);
+        }
+    }
+    SetPlugins(plugins);
+    
+    std::cout << "Found " << plugins.size() << " LV2 plugins, " << parsedBundles << " of "
+              << bundles.size() << " bundles parsed:" << std::endl;
+    for (const auto& plugin : plugins) {
+        std::cout << "  - " << plugin.name << " (" << plugin.uri << ")" << std::endl;
+    }
+    
+    if (changed && pluginsChanged_) {
+        pluginsChanged_();
+    }
+}
+
+void PluginManager::SetPlugins(const std::vector<PluginInfo>& plugins) {
+    std::vector<std::string> categories;
+    for (const auto& info : plugins) {
         // Add category if not already present
-        if (std::find(categories_.begin(), categories_.end(), info.category) == categories_.end()) {
-            categories_.push_back(info.category);
+        if (std::find(categories.begin(), categories.end(), info.category) == categories.end()) {
+            categories.push_back(info.category);
         }
     }
+    std::sort(categories.begin(), categories.end());
     
-    std::sort(categories_.begin(), categories_.end());
+    std::lock_guard<std::mutex> lock(pluginsMutex_);
+    availablePlugins_ = plugins;
+    categories_ = std::move(categories);
 }
 
 void PluginManager::ScanDirectory(const std::string& directory) {
@@ -512,14 +938,17 @@ void PluginManager::ScanDirectory(const std::string& directory) {
     AddScanPath(directory);
     
     // Reload world with new paths
+    WaitForScan();
     if (world_) {
-        lilv_world_load_all(world_);
-        plugins_ = lilv_world_get_all_plugins(world_);
+        {
+            std::lock_guard<std::mutex> lock(worldMutex_);
+            LoadWorld();
+        }
         ScanPlugins();
     }
 }
 
-PluginInfo PluginManager::ExtractPluginInfo(const LilvPlugin* plugin) {
+PluginInfo PluginManager::ExtractPluginInfo(const LilvPlugin* plugin, std::vector<ParameterInfo>* parameters) {
     PluginInfo info;
     
     info.uri = lilv_node_as_string(lilv_plugin_get_uri(plugin));
@@ -532,11 +961,14 @@ PluginInfo PluginManager::ExtractPluginInfo(const LilvPlugin* plugin) {
     info.author = authorNode ? lilv_node_as_string(authorNode) : "Unknown";
     if (authorNode) lilv_node_free(authorNode);
     
-    info.category = GetPluginCategory(plugin);
+    LilvNode* inPlaceBrokenNode = lilv_new_uri(world_, LV2_CORE__inPlaceBroken);
+    info.inPlaceBroken = lilv_plugin_has_feature(plugin, inPlaceBrokenNode);
+    lilv_node_free(inPlaceBrokenNode);
+    
     info.description = ""; // TODO: Extract description if available
     info.hasUI = false; // TODO: Check for UI extension
     
-    // Count ports
+    // Count ports, collecting the control inputs on the same walk
     info.audioInputs = 0;
     info.audioOutputs = 0;
     info.controlInputs = 0;
@@ -544,53 +976,54 @@ PluginInfo PluginManager::ExtractPluginInfo(const LilvPlugin* plugin) {
     info.midiInputs = 0;
     info.midiOutputs = 0;
     
+    LilvNode* audioNode = lilv_new_uri(world_, LV2_CORE__AudioPort);
+    LilvNode* controlNode = lilv_new_uri(world_, LV2_CORE__ControlPort);
+    LilvNode* inputNode = lilv_new_uri(world_, LV2_CORE__InputPort);
+    LilvNode* outputNode = lilv_new_uri(world_, LV2_CORE__OutputPort);
+    
     uint32_t numPorts = lilv_plugin_get_num_ports(plugin);
     for (uint32_t i = 0; i < numPorts; ++i) {
         const LilvPort* port = lilv_plugin_get_port_by_index(plugin, i);
         
-        if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__AudioPort))) {
-            if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__InputPort))) {
+        if (lilv_port_is_a(plugin, port, audioNode)) {
+            if (lilv_port_is_a(plugin, port, inputNode)) {
                 info.audioInputs++;
-            } else if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__OutputPort))) {
+            } else if (lilv_port_is_a(plugin, port, outputNode)) {
                 info.audioOutputs++;
             }
-        } else if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__ControlPort))) {
-            if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__InputPort))) {
+        } else if (lilv_port_is_a(plugin, port, controlNode)) {
+            if (lilv_port_is_a(plugin, port, inputNode)) {
+                if (parameters) {
+                    ParameterInfo paramInfo = ReadParameterInfo(world_, plugin, port);
+                    paramInfo.index = info.controlInputs;
+                    paramInfo.portIndex = i;
+                    parameters->push_back(std::move(paramInfo));
+                }
                 info.controlInputs++;
-            } else if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__OutputPort))) {
+            } else if (lilv_port_is_a(plugin, port, outputNode)) {
                 info.controlOutputs++;
             }
         }
         // TODO: Add MIDI port counting
     }
     
+    lilv_node_free(audioNode);
+    lilv_node_free(controlNode);
+    lilv_node_free(inputNode);
+    lilv_node_free(outputNode);
+    
+    info.category = GetPluginCategory(info);
     return info;
 }
 
-std::string PluginManager::GetPluginCategory(const LilvPlugin* plugin) {
+std::string PluginManager::GetPluginCategory(const PluginInfo& info) const {
     // TODO: Implement proper category detection based on LV2 classes
     // For now, return a generic category based on port configuration
-    
-    uint32_t numPorts = lilv_plugin_get_num_ports(plugin);
-    uint32_t audioInputs = 0, audioOutputs = 0;
-    
-    for (uint32_t i = 0; i < numPorts; ++i) {
-        const LilvPort* port = lilv_plugin_get_port_by_index(plugin, i);
-        
-        if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__AudioPort))) {
-            if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__InputPort))) {
-                audioInputs++;
-            } else if (lilv_port_is_a(plugin, port, lilv_new_uri(world_, LV2_CORE__OutputPort))) {
-                audioOutputs++;
-            }
-        }
-    }
-    
-    if (audioInputs == 0 && audioOutputs > 0) {
+    if (info.audioInputs == 0 && info.audioOutputs > 0) {
         return "Generator";
-    } else if (audioInputs > 0 && audioOutputs > 0) {
+    } else if (info.audioInputs > 0 && info.audioOutputs > 0) {
         return "Effect";
-    } else if (audioInputs > 0 && audioOutputs == 0) {
+    } else if (info.audioInputs > 0 && info.audioOutputs == 0) {
         return "Analyzer";
     }
     
@@ -598,12 +1031,14 @@ std::string PluginManager::GetPluginCategory(const LilvPlugin* plugin) {
 }
 
 std::vector<PluginInfo> PluginManager::GetAvailablePlugins() const {
+    std::lock_guard<std::mutex> lock(pluginsMutex_);
     return availablePlugins_;
 }
 
 std::vector<PluginInfo> PluginManager::GetPluginsByCategory(const std::string& category) const {
     std::vector<PluginInfo> result;
     
+    std::lock_guard<std::mutex> lock(pluginsMutex_);
     std::copy_if(availablePlugins_.begin(), availablePlugins_.end(),
                  std::back_inserter(result),
                  [&category](const PluginInfo& info) {
@@ -614,19 +1049,25 @@ std::vector<PluginInfo> PluginManager::GetPluginsByCategory(const std::string& c
 }
 
 std::vector<std::string> PluginManager::GetCategories() const {
+    std::lock_guard<std::mutex> lock(pluginsMutex_);
     return categories_;
 }
 
-std::unique_ptr<PluginInstance> PluginManager::CreatePlugin(const std::string& uri, double sampleRate, uint32_t blockSize) {
-    auto it = pluginMap_.find(uri);
-    if (it == pluginMap_.end()) {
+std::unique_ptr<PluginInstance> PluginManager::CreatePlugin(const std::string& uri, double sampleRate, uint32_t blockSize,
+                                                           bool fixedBlockLength) {
+    WaitForWorld();
+    
+    std::lock_guard<std::mutex> lock(worldMutex_);
+    const LilvPlugin* plugin = FindPlugin(uri);
+    if (!plugin) {
         return nullptr;
     }
     
-    return std::make_unique<PluginInstance>(it->second, world_, sampleRate, blockSize);
+    return std::make_unique<PluginInstance>(plugin, world_, &worldMutex_, sampleRate, blockSize, fixedBlockLength);
 }
 
 PluginInfo PluginManager::GetPluginInfo(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(pluginsMutex_);
     auto it = std::find_if(availablePlugins_.begin(), availablePlugins_.end(),
                           [&uri](const PluginInfo& info) {
                               return info.uri == uri;
@@ -640,12 +1081,40 @@ PluginInfo PluginManager::GetPluginInfo(const std::string& uri) const {
 }
 
 bool PluginManager::IsPluginAvailable(const std::string& uri) const {
-    return pluginMap_.find(uri) != pluginMap_.end();
+    std::lock_guard<std::mutex> lock(pluginsMutex_);
+    return std::any_of(availablePlugins_.begin(), availablePlugins_.end(),
+                       [&uri](const PluginInfo& info) {
+                           return info.uri == uri;
+                       });
+}
+
+std::vector<ParameterInfo> PluginManager::GetPluginParameters(const std::string& uri) {
+    std::vector<ParameterInfo> parameters;
+    {
+        std::lock_guard<std::mutex> lock(pluginsMutex_);
+        auto it = scannedParameters_.find(uri);
+        if (it != scannedParameters_.end()) {
+            return it->second;
+        }
+        if (cache_->GetParameters(uri, parameters)) {
+            return parameters;
+        }
+    }
+    
+    // Not cached yet: ask lilv
+    WaitForWorld();
+    std::lock_guard<std::mutex> lock(worldMutex_);
+    const LilvPlugin* plugin = FindPlugin(uri);
+    if (plugin) {
+        ExtractPluginInfo(plugin, &parameters);
+    }
+    return parameters;
 }
 
 std::vector<std::string> PluginManager::GetDefaultScanPaths() const {
     std::vector<std::string> paths;
     
+#ifdef _WIN32
     // Common LV2 plugin directories on Windows
     paths.push_back("C:\\Program Files\\LV2");
     paths.push_back("C:\\Program Files (x86)\\LV2");
@@ -655,6 +1124,15 @@ std::vector<std::string> PluginManager::GetDefaultScanPaths() const {
     if (appData) {
         paths.push_back(std::string(appData) + "\\LV2");
     }
+#else
+    paths.push_back("/usr/lib/lv2");
+    paths.push_back("/usr/local/lib/lv2");
+    
+    char* home = getenv("HOME");
+    if (home) {
+        paths.push_back(std::string(home) + "/.lv2");
+    }
+#endif
     
     return paths;
 }
@@ -0,0 +1,155 @@
+#include "violet/processing_thread_pool.h"
+#include "violet/realtime_thread.h"
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace violet {
+
+void CpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Semaphore implementation
+#ifdef _WIN32
+
+Semaphore::Semaphore() {
+    handle_ = CreateSemaphore(nullptr, 0, LONG_MAX, nullptr);
+}
+
+Semaphore::~Semaphore() {
+    if (handle_) {
+        CloseHandle(handle_);
+    }
+}
+
+void Semaphore::Post(uint32_t count) {
+    ReleaseSemaphore(handle_, static_cast<LONG>(count), nullptr);
+}
+
+void Semaphore::Wait() {
+    WaitForSingleObject(handle_, INFINITE);
+}
+
+#else
+
+Semaphore::Semaphore() {
+    sem_init(&semaphore_, 0, 0);
+}
+
+Semaphore::~Semaphore() {
+    sem_destroy(&semaphore_);
+}
+
+void Semaphore::Post(uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        sem_post(&semaphore_);
+    }
+}
+
+void Semaphore::Wait() {
+    while (sem_wait(&semaphore_) != 0 && errno == EINTR) {
+    }
+}
+
+#endif
+
+// ProcessingThreadPool implementation
+ProcessingThreadPool::ProcessingThreadPool(uint32_t workerCount)
+    : task_(nullptr)
+    , taskOpen_(false)
+    , activeWorkers_(0)
+    , shouldStop_(false) {
+
+    workerCount = std::min(workerCount, MAX_WORKERS);
+    workers_.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&ProcessingThreadPool::WorkerThreadProc, this);
+    }
+}
+
+ProcessingThreadPool::~ProcessingThreadPool() {
+    shouldStop_.store(true);
+    wakeSemaphore_.Post(static_cast<uint32_t>(workers_.size()));
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+uint32_t ProcessingThreadPool::GetDefaultWorkerCount() {
+    uint32_t cores = std::thread::hardware_concurrency();
+    return cores > 1 ? std::min(cores - 1, MAX_WORKERS) : 0;
+}
+
+void ProcessingThreadPool::RunParallel(ParallelTask* task) {
+    if (workers_.empty()) {
+        task->Work();
+        return;
+    }
+
+    task_.store(task);
+    taskOpen_.store(true);
+    wakeSemaphore_.Post(static_cast<uint32_t>(workers_.size()));
+
+    task->Work();
+
+    // Close the task, then wait for the workers that did join to leave it.
+    // A worker that registers after this point sees taskOpen_ == false and
+    // never touches the task.
+    taskOpen_.store(false);
+    while (activeWorkers_.load() != 0) {
+        CpuRelax();
+    }
+    task_.store(nullptr);
+}
+
+void ProcessingThreadPool::WorkerThreadProc() {
+    SetRealtimePriority();
+    PrepareRealtimeThread();
+
+    while (true) {
+        wakeSemaphore_.Wait();
+        if (shouldStop_.load()) {
+            break;
+        }
+
+        activeWorkers_.fetch_add(1);
+        if (taskOpen_.load()) {
+            ParallelTask* task = task_.load();
+            if (task) {
+                task->Work();
+            }
+        }
+        activeWorkers_.fetch_sub(1);
+    }
+}
+
+void ProcessingThreadPool::SetRealtimePriority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+    // Best effort: needs CAP_SYS_NICE or an rtprio limit, otherwise workers
+    // stay at normal priority
+    sched_param param = {};
+    param.sched_priority = std::max(sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO) - 10);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
+
+} // namespace violet
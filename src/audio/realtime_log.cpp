@@ -0,0 +1,335 @@
+#include "violet/realtime_log.h"
+#include "violet/performance_stats.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace violet {
+
+namespace {
+
+const uint32_t QUEUE_CAPACITY = 1024;      // power of two
+const auto DRAIN_INTERVAL = std::chrono::milliseconds(20);
+const uint64_t RATE_WINDOW_NANOS = 1000000000;
+
+// Same multi-producer, single-consumer slot sequencing as ParameterQueue,
+// with the consumer side serialized by the logger's drain mutex
+class LogQueue {
+public:
+    LogQueue()
+        : slots_(new Slot[QUEUE_CAPACITY])
+        , enqueuePos_(0)
+        , dequeuePos_(0) {
+        for (uint32_t i = 0; i < QUEUE_CAPACITY; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Fills the slot in place; only the arguments in use are copied
+    bool Push(LogLevel level, const char* format, const LogArg* args, uint32_t argCount) {
+        uint64_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & (QUEUE_CAPACITY - 1)];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    LogRecord& record = slot.record;
+                    record.format = format;
+                    record.level = level;
+                    record.argCount = argCount;
+                    for (uint32_t i = 0; i < argCount; ++i) {
+                        record.args[i] = args[i];
+                    }
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Pop(LogRecord& record) {
+        uint64_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & (QUEUE_CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        record = slot.record;
+        slot.sequence.store(pos + QUEUE_CAPACITY, std::memory_order_release);
+        dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<uint64_t> enqueuePos_;
+    alignas(64) std::atomic<uint64_t> dequeuePos_;
+};
+
+class Logger {
+public:
+    Logger()
+        : startNanos_(MonotonicNanos())
+        , stopping_(false)
+        , written_(0)
+        , suppressed_(0)
+        , dropped_(0)
+        , reportedDrops_(0) {
+    }
+
+    void Push(LogLevel level, const char* format, const LogArg* args, uint32_t argCount) {
+        if (!queue_.Push(level, format, args, argCount)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Start() {
+        thread_ = std::thread(&Logger::ThreadProc, this);
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        Drain();
+    }
+
+    void Drain();
+    void SetSink(LogSink sink);
+    bool SetFile(const std::string& path);
+
+    LogStats GetStats() const {
+        LogStats stats;
+        stats.written = written_.load();
+        stats.dropped = dropped_.load();
+        stats.suppressed = suppressed_.load();
+        return stats;
+    }
+
+private:
+    // Lines so far in the current window for one format string
+    struct RateState {
+        uint64_t windowStart = 0;
+        uint32_t lines = 0;
+        uint64_t suppressed = 0;
+    };
+
+    void ThreadProc();
+    void Write(LogLevel level, uint64_t timeNanos, const std::string& line);
+    void ReportSuppressed(const char* format, RateState& state, uint64_t timeNanos);
+
+    LogQueue queue_;
+    uint64_t startNanos_;
+
+    std::thread thread_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+
+    // Everything below belongs to whoever holds drainMutex_
+    std::mutex drainMutex_;
+    std::unordered_map<const char*, RateState> rates_;
+    LogSink sink_;
+    std::ofstream file_;
+
+    std::atomic<uint64_t> written_;
+    std::atomic<uint64_t> suppressed_;
+    std::atomic<uint64_t> dropped_;
+    uint64_t reportedDrops_;
+};
+
+// Never destroyed, so a realtime thread still logging while the process
+// exits doesn't touch freed memory; the queue is flushed by an atexit hook
+std::atomic<Logger*> activeLogger(nullptr);
+std::once_flag startOnce;
+
+void StopAtExit() {
+    activeLogger.load()->Stop();
+}
+
+void Logger::ThreadProc() {
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, DRAIN_INTERVAL);
+        lock.unlock();
+        Drain();
+        lock.lock();
+    }
+}
+
+void Logger::Drain() {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+
+    LogRecord record;
+    uint64_t now = MonotonicNanos();
+    while (queue_.Pop(record)) {
+        RateState& state = rates_[record.format];
+        if (now >= state.windowStart + RATE_WINDOW_NANOS) {
+            ReportSuppressed(record.format, state, now);
+            state.windowStart = now;
+            state.lines = 0;
+        }
+        if (state.lines >= LOG_RATE_LIMIT) {
+            ++state.suppressed;
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ++state.lines;
+        Write(record.level, now, FormatLogRecord(record));
+    }
+
+    // Quiet formats still owe a summary once their window is over
+    for (auto& entry : rates_) {
+        if (entry.second.suppressed > 0 && now >= entry.second.windowStart + RATE_WINDOW_NANOS) {
+            ReportSuppressed(entry.first, entry.second, now);
+        }
+    }
+
+    uint64_t dropped = dropped_.load();
+    if (dropped != reportedDrops_) {
+        Write(LogLevel::Warning, now,
+              std::to_string(dropped - reportedDrops_) + " log message(s) dropped, the log queue was full");
+        reportedDrops_ = dropped;
+    }
+}
+
+void Logger::ReportSuppressed(const char* format, RateState& state, uint64_t timeNanos) {
+    if (state.suppressed == 0) {
+        return;
+    }
+    Write(LogLevel::Warning, timeNanos, std::to_string(state.suppressed) + " more like \"" + format + "\" suppressed");
+    state.suppressed = 0;
+}
+
+void Logger::Write(LogLevel level, uint64_t timeNanos, const std::string& line) {
+    written_.fetch_add(1, std::memory_order_relaxed);
+
+    if (sink_) {
+        sink_(level, line);
+    } else if (level == LogLevel::Info) {
+        std::cout << line << std::endl;
+    } else {
+        std::cerr << line << std::endl;
+    }
+
+    if (file_.is_open()) {
+        double seconds = timeNanos > startNanos_ ? (timeNanos - startNanos_) / 1e9 : 0.0;
+        file_ << std::fixed << std::setprecision(6) << seconds << " " << line << "\n";
+        file_.flush();
+    }
+}
+
+void Logger::SetSink(LogSink sink) {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+    sink_ = std::move(sink);
+}
+
+bool Logger::SetFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(drainMutex_);
+    file_.close();
+    file_.clear();
+    if (path.empty()) {
+        return true;
+    }
+    file_.open(path, std::ios::app);
+    return file_.is_open();
+}
+
+Logger* GetLogger() {
+    StartLogThread();
+    return activeLogger.load();
+}
+
+} // namespace
+
+void PushLogRecord(LogLevel level, const char* format, const LogArg* args, uint32_t argCount) {
+    Logger* logger = activeLogger.load(std::memory_order_acquire);
+    if (logger) {
+        logger->Push(level, format, args, argCount < MAX_LOG_ARGS ? argCount : MAX_LOG_ARGS);
+    }
+}
+
+void StartLogThread() {
+    std::call_once(startOnce, [] {
+        Logger* logger = new Logger();
+        logger->Start();
+        activeLogger.store(logger, std::memory_order_release);
+        std::atexit(StopAtExit);
+    });
+}
+
+void FlushLog() {
+    GetLogger()->Drain();
+}
+
+void SetLogSink(LogSink sink) {
+    GetLogger()->SetSink(std::move(sink));
+}
+
+bool SetLogFile(const std::string& path) {
+    return GetLogger()->SetFile(path);
+}
+
+LogStats GetLogStats() {
+    Logger* logger = activeLogger.load();
+    return logger ? logger->GetStats() : LogStats();
+}
+
+std::string FormatLogRecord(const LogRecord& record) {
+    std::ostringstream line;
+    uint32_t next = 0;
+    for (const char* c = record.format; c && *c; ++c) {
+        if (c[0] != '{' || c[1] != '}' || next >= record.argCount) {
+            line << *c;
+            continue;
+        }
+
+        const LogArg& arg = record.args[next++];
+        switch (arg.type) {
+            case LogArg::Type::Signed:
+                line << arg.i;
+                break;
+            case LogArg::Type::Unsigned:
+                line << arg.u;
+                break;
+            case LogArg::Type::Hex:
+                line << "0x" << std::hex << arg.u << std::dec;
+                break;
+            case LogArg::Type::Float:
+                line << arg.d;
+                break;
+            case LogArg::Type::String:
+                line << (arg.s ? arg.s : "(null)");
+                break;
+            case LogArg::Type::None:
+                break;
+        }
+        ++c;
+    }
+    return line.str();
+}
+
+} // namespace violet
@@ -0,0 +1,146 @@
+#include "violet/realtime_thread.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VIOLET_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <alloca.h>
+#include <cerrno>
+#include <sys/mman.h>
+#endif
+
+namespace violet {
+
+namespace {
+
+std::atomic<bool> denormalFlush(true);
+
+// Constant-initialized, so reading it never allocates (the allocation trap
+// reads it from inside malloc)
+thread_local bool realtimeThread = false;
+
+#if defined(VIOLET_X86)
+constexpr uint32_t MXCSR_DAZ = 0x0040;
+constexpr uint32_t MXCSR_FTZ = 0x8000;
+#elif defined(__aarch64__)
+constexpr uint64_t FPCR_FZ = uint64_t(1) << 24;
+#endif
+
+uint64_t GetFpuMode() {
+#if defined(VIOLET_X86)
+    return _mm_getcsr();
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    return fpcr;
+#else
+    return 0;
+#endif
+}
+
+void SetFpuMode(uint64_t mode) {
+#if defined(VIOLET_X86)
+    _mm_setcsr(static_cast<unsigned int>(mode));
+#elif defined(__aarch64__)
+    asm volatile("msr fpcr, %0" : : "r"(mode));
+#else
+    (void)mode;
+#endif
+}
+
+} // namespace
+
+void SetDenormalFlushEnabled(bool enabled) {
+    denormalFlush.store(enabled);
+}
+
+bool IsDenormalFlushEnabled() {
+    return denormalFlush.load();
+}
+
+bool EnableDenormalFlush() {
+#if defined(VIOLET_X86)
+    SetFpuMode(GetFpuMode() | MXCSR_FTZ | MXCSR_DAZ);
+    return true;
+#elif defined(__aarch64__)
+    SetFpuMode(GetFpuMode() | FPCR_FZ);
+    return true;
+#else
+    return false;
+#endif
+}
+
+ScopedDenormalFlush::ScopedDenormalFlush(bool enabled)
+    : savedMode_(GetFpuMode()) {
+    if (enabled) {
+        EnableDenormalFlush();
+    }
+}
+
+ScopedDenormalFlush::~ScopedDenormalFlush() {
+    SetFpuMode(savedMode_);
+}
+
+void PrefaultStack(size_t bytes) {
+    // Writes, not reads, so the pages are actually backed. alloca keeps the
+    // size flexible; the compiler probes the pages in order where it must
+    // (Windows guard pages).
+    volatile char* stack = static_cast<volatile char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) {
+        stack[i] = 0;
+    }
+    stack[bytes - 1] = 0;
+}
+
+void PrepareRealtimeThread() {
+    if (IsDenormalFlushEnabled()) {
+        EnableDenormalFlush();
+    }
+    PrefaultStack();
+    realtimeThread = true;
+}
+
+bool IsRealtimeThread() {
+    return realtimeThread;
+}
+
+ScopedRealtimeTag::ScopedRealtimeTag()
+    : previous_(realtimeThread) {
+    realtimeThread = true;
+}
+
+ScopedRealtimeTag::~ScopedRealtimeTag() {
+    realtimeThread = previous_;
+}
+
+bool LockProcessMemory(std::string& error) {
+#ifdef _WIN32
+    error = "Locking memory is not supported on Windows";
+    return false;
+#else
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        error = std::string("mlockall failed: ") + strerror(errno);
+        return false;
+    }
+    return true;
+#endif
+}
+
+uint32_t CountSubnormals(const float* samples, uint32_t count) {
+    // Zero exponent with a non-zero mantissa
+    uint32_t subnormals = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t bits;
+        memcpy(&bits, &samples[i], sizeof(bits));
+        subnormals += (bits & 0x7f800000u) == 0 && (bits & 0x007fffffu) != 0;
+    }
+    return subnormals;
+}
+
+} // namespace violet
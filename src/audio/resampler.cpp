@@ -0,0 +1,322 @@
+#include "violet/resampler.h"
+#include "violet/pcm_convert.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VIOLET_RESAMPLER_SSE2 1
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define VIOLET_RESAMPLER_AVX2 1
+#endif
+#endif
+
+namespace violet {
+
+namespace {
+
+const uint32_t MAX_PHASES = 4096;
+const double PI = 3.14159265358979323846;
+
+struct QualityPreset {
+    const char* name;
+    uint32_t taps;
+    double beta;                // Kaiser window shape
+};
+
+const QualityPreset PRESETS[] = {
+    { "fast", 16, 5.0 },
+    { "balanced", 32, 7.5 },
+    { "high", 64, 9.5 },
+    { "best", 128, 12.0 },
+};
+
+const QualityPreset& GetPreset(ResamplerQuality quality) {
+    return PRESETS[static_cast<int>(quality)];
+}
+
+// Zeroth-order modified Bessel function of the first kind
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x / 2.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+std::shared_ptr<const ResamplerFilter> BuildFilter(uint32_t upFactor, uint32_t downFactor,
+                                                   const QualityPreset& preset) {
+    auto filter = std::make_shared<ResamplerFilter>();
+    filter->upFactor = upFactor;
+    filter->downFactor = downFactor;
+    filter->taps = preset.taps;
+
+    // Kaiser design at the upsampled rate: the attenuation the window
+    // reaches sets the transition width for this length, which ends at the
+    // lower rate's Nyquist frequency so nothing aliases back
+    size_t length = static_cast<size_t>(preset.taps) * upFactor;
+    double attenuation = preset.beta / 0.1102 + 8.7;
+    double transition = (attenuation - 8.0) / (2.285 * 2.0 * PI * (length - 1));
+    double stopband = 0.5 / std::max(upFactor, downFactor);
+    double cutoff = stopband - transition / 2.0;
+    filter->cutoff = cutoff * std::max(upFactor, downFactor);
+
+    double center = (length - 1) / 2.0;
+    double window = BesselI0(preset.beta);
+    std::vector<double> prototype(length);
+    for (size_t t = 0; t < length; ++t) {
+        double x = t - center;
+        double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * PI * cutoff * x) / (PI * x * 2.0 * cutoff);
+        double r = x / center;
+        double kaiser = BesselI0(preset.beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / window;
+        prototype[t] = sinc * kaiser;
+    }
+
+    // Split into phases, each scaled to unity DC gain and reversed so a
+    // phase dots straight against ascending input
+    filter->coefficients.resize(length);
+    for (uint32_t phase = 0; phase < upFactor; ++phase) {
+        double sum = 0.0;
+        for (uint32_t m = 0; m < preset.taps; ++m) {
+            sum += prototype[static_cast<size_t>(m) * upFactor + phase];
+        }
+        float* out = filter->coefficients.data() + static_cast<size_t>(phase) * preset.taps;
+        for (uint32_t m = 0; m < preset.taps; ++m) {
+            double value = prototype[static_cast<size_t>(m) * upFactor + phase] / sum;
+            out[preset.taps - 1 - m] = static_cast<float>(value);
+        }
+    }
+    return filter;
+}
+
+// Output i is work[starts[i]..] dotted with coefficients[offsets[i]..]
+using FilterKernel = void (*)(const float* work, const float* coefficients, uint32_t taps,
+                              const uint32_t* starts, const uint32_t* offsets, uint32_t count,
+                              float* out);
+
+void FilterScalar(const float* work, const float* coefficients, uint32_t taps,
+                  const uint32_t* starts, const uint32_t* offsets, uint32_t count, float* out) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const float* x = work + starts[i];
+        const float* c = coefficients + offsets[i];
+        float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+        for (uint32_t t = 0; t < taps; t += 4) {
+            sum0 += x[t] * c[t];
+            sum1 += x[t + 1] * c[t + 1];
+            sum2 += x[t + 2] * c[t + 2];
+            sum3 += x[t + 3] * c[t + 3];
+        }
+        out[i] = (sum0 + sum1) + (sum2 + sum3);
+    }
+}
+
+#ifdef VIOLET_RESAMPLER_SSE2
+void FilterSse2(const float* work, const float* coefficients, uint32_t taps,
+                const uint32_t* starts, const uint32_t* offsets, uint32_t count, float* out) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const float* x = work + starts[i];
+        const float* c = coefficients + offsets[i];
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for (uint32_t t = 0; t < taps; t += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x + t), _mm_loadu_ps(c + t)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x + t + 4), _mm_loadu_ps(c + t + 4)));
+        }
+        __m128 sum = _mm_add_ps(sum0, sum1);
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        out[i] = _mm_cvtss_f32(sum);
+    }
+}
+#endif // VIOLET_RESAMPLER_SSE2
+
+#ifdef VIOLET_RESAMPLER_AVX2
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+void FilterAvx2(const float* work, const float* coefficients, uint32_t taps,
+                const uint32_t* starts, const uint32_t* offsets, uint32_t count, float* out) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const float* x = work + starts[i];
+        const float* c = coefficients + offsets[i];
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        uint32_t t = 0;
+        for (; t + 16 <= taps; t += 16) {
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(x + t), _mm256_loadu_ps(c + t)));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(x + t + 8), _mm256_loadu_ps(c + t + 8)));
+        }
+        if (t < taps) {
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(x + t), _mm256_loadu_ps(c + t)));
+        }
+        __m256 sum8 = _mm256_add_ps(sum0, sum1);
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        out[i] = _mm_cvtss_f32(sum);
+    }
+}
+
+#pragma GCC pop_options
+#endif // VIOLET_RESAMPLER_AVX2
+
+FilterKernel GetFilterKernel() {
+    switch (pcm::GetSimdLevel()) {
+#ifdef VIOLET_RESAMPLER_AVX2
+    case SimdLevel::Avx2:
+        return FilterAvx2;
+#endif
+#ifdef VIOLET_RESAMPLER_SSE2
+    case SimdLevel::Sse2:
+        return FilterSse2;
+#endif
+    default:
+        return FilterScalar;
+    }
+}
+
+} // namespace
+
+const char* GetResamplerQualityName(ResamplerQuality quality) {
+    return GetPreset(quality).name;
+}
+
+bool ParseResamplerQuality(const std::string& name, ResamplerQuality& quality) {
+    for (ResamplerQuality candidate : { ResamplerQuality::Fast, ResamplerQuality::Balanced,
+                                        ResamplerQuality::High, ResamplerQuality::Best }) {
+        if (name == GetResamplerQualityName(candidate)) {
+            quality = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const ResamplerFilter> GetResamplerFilter(uint32_t inputRate, uint32_t outputRate,
+                                                          ResamplerQuality quality) {
+    if (inputRate == 0 || outputRate == 0) {
+        return nullptr;
+    }
+    uint32_t common = std::gcd(inputRate, outputRate);
+    uint32_t upFactor = outputRate / common;
+    uint32_t downFactor = inputRate / common;
+    if (upFactor > MAX_PHASES) {
+        return nullptr;
+    }
+
+    // Banks are small (at most a few MB at the best preset) and a session
+    // only ever meets a handful of ratios, so they are kept for good
+    using Key = std::tuple<uint32_t, uint32_t, ResamplerQuality>;
+    static std::mutex mutex;
+    static std::map<Key, std::shared_ptr<const ResamplerFilter>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Key key(upFactor, downFactor, quality);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    std::shared_ptr<const ResamplerFilter> filter = BuildFilter(upFactor, downFactor, GetPreset(quality));
+    cache.emplace(key, filter);
+    return filter;
+}
+
+Resampler::Resampler()
+    : channels_(0), inputRate_(0), outputRate_(0), maxInputFrames_(0), index_(0), phase_(0) {
+}
+
+bool Resampler::Configure(uint32_t channels, uint32_t inputRate, uint32_t outputRate,
+                          ResamplerQuality quality, uint32_t maxInputFrames) {
+    channels_ = channels;
+    inputRate_ = inputRate;
+    outputRate_ = outputRate;
+    maxInputFrames_ = maxInputFrames;
+    filter_.reset();
+
+    if (inputRate != outputRate) {
+        filter_ = GetResamplerFilter(inputRate, outputRate, quality);
+        if (!filter_) {
+            return false;
+        }
+        uint32_t taps = filter_->taps;
+        history_.assign(static_cast<size_t>(channels) * (taps - 1), 0.0f);
+        work_.assign(taps - 1 + maxInputFrames, 0.0f);
+        starts_.assign(GetMaxOutputFrames(maxInputFrames), 0);
+        phases_.assign(starts_.size(), 0);
+    }
+
+    Reset();
+    return true;
+}
+
+void Resampler::Reset() {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    index_ = 0;
+    phase_ = 0;
+}
+
+uint32_t Resampler::GetMaxOutputFrames(uint32_t frames) const {
+    if (!filter_) {
+        return frames;
+    }
+    uint64_t scaled = static_cast<uint64_t>(frames) * filter_->upFactor;
+    return static_cast<uint32_t>((scaled + filter_->downFactor - 1) / filter_->downFactor) + 1;
+}
+
+double Resampler::GetLatency() const {
+    if (!filter_) {
+        return 0.0;
+    }
+    double length = static_cast<double>(filter_->taps) * filter_->upFactor;
+    return (length - 1.0) / 2.0 / filter_->downFactor;
+}
+
+uint32_t Resampler::Process(const float* const* inputs, uint32_t frames, float* const* outputs) {
+    frames = std::min(frames, maxInputFrames_);
+    if (!filter_) {
+        for (uint32_t ch = 0; ch < channels_; ++ch) {
+            std::copy(inputs[ch], inputs[ch] + frames, outputs[ch]);
+        }
+        return frames;
+    }
+
+    // Where every output of this block sits, shared by all channels
+    uint32_t taps = filter_->taps;
+    uint32_t upFactor = filter_->upFactor;
+    uint32_t downFactor = filter_->downFactor;
+    uint32_t count = 0;
+    while (index_ < frames) {
+        starts_[count] = index_;
+        phases_[count] = phase_ * taps;
+        ++count;
+        phase_ += downFactor;
+        index_ += phase_ / upFactor;
+        phase_ %= upFactor;
+    }
+    index_ -= frames;
+
+    FilterKernel kernel = GetFilterKernel();
+    float* work = work_.data();
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+        float* history = history_.data() + static_cast<size_t>(ch) * (taps - 1);
+        std::copy(history, history + taps - 1, work);
+        std::copy(inputs[ch], inputs[ch] + frames, work + taps - 1);
+
+        kernel(work, filter_->coefficients.data(), taps, starts_.data(), phases_.data(), count, outputs[ch]);
+
+        std::copy(work + frames, work + frames + taps - 1, history);
+    }
+    return count;
+}
+
+} // namespace violet
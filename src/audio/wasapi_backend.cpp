@@ -0,0 +1,1138 @@
+#include <windows.h>
+#include <initguid.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <ks.h>
+#include <ksmedia.h>
+
+#include "violet/wasapi_backend.h"
+#include "violet/realtime_log.h"
+#include "violet/realtime_thread.h"
+#include "violet/utils.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+namespace violet {
+
+namespace {
+
+// Shared-mode streams run at the mix format, which is usually float but
+// can be integer PCM on some drivers. 24-in-32 containers are left-aligned,
+// so they convert as 32-bit.
+bool GetPcmFormat(const WAVEFORMATEX* format, PcmFormat& pcmFormat) {
+    bool isFloat = format->wFormatTag == WAVE_FORMAT_IEEE_FLOAT;
+    bool isInteger = format->wFormatTag == WAVE_FORMAT_PCM;
+    if (format->wFormatTag == WAVE_FORMAT_EXTENSIBLE && format->cbSize >= 22) {
+        const WAVEFORMATEXTENSIBLE* extensible = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(format);
+        isFloat = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+        isInteger = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_PCM);
+    }
+    
+    if (isFloat && format->wBitsPerSample == 32) {
+        pcmFormat = PcmFormat::Float32;
+        return true;
+    }
+    if (isInteger) {
+        switch (format->wBitsPerSample) {
+        case 16:
+            pcmFormat = PcmFormat::Int16;
+            return true;
+        case 24:
+            pcmFormat = PcmFormat::Int24;
+            return true;
+        case 32:
+            pcmFormat = PcmFormat::Int32;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+WasapiBackend::WasapiBackend()
+    : deviceEnumerator_(nullptr)
+    , inputDevice_(nullptr)
+    , outputDevice_(nullptr)
+    , inputClient_(nullptr)
+    , outputClient_(nullptr)
+    , renderClient_(nullptr)
+    , captureClient_(nullptr)
+    , volumeControl_(nullptr)
+    , shouldStop_(false)
+    , audioEvent_(nullptr)
+    , inputEventCallbackMode_(false)
+    , outputEventCallbackMode_(false)
+    , inputPcmFormat_(PcmFormat::Float32)
+    , outputPcmFormat_(PcmFormat::Float32)
+    , ditherEnabled_(false)
+    , maxFrames_(0)
+    , captureChannels_(0)
+    , captureFrames_(0)
+    , captureStarted_(false) {
+}
+
+WasapiBackend::~WasapiBackend() {
+    Stop();
+    ShutdownWASAPI();
+    
+    if (audioEvent_) {
+        CloseHandle(audioEvent_);
+        audioEvent_ = nullptr;
+    }
+}
+
+bool WasapiBackend::Initialize() {
+    std::cout << "Initializing WASAPI backend..." << std::endl;
+    
+    if (!InitializeWASAPI()) {
+        std::cerr << "Failed to initialize WASAPI" << std::endl;
+        return false;
+    }
+    
+    // Create audio processing event
+    audioEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!audioEvent_) {
+        std::cerr << "Failed to create audio event: " << GetLastError() << std::endl;
+        return false;
+    }
+    
+    std::cout << "WASAPI backend initialized successfully" << std::endl;
+    return true;
+}
+
+bool WasapiBackend::InitializeWASAPI() {
+    // Initialize COM for this thread if not already initialized
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    if (FAILED(hr) && hr != RPC_E_CHANGED_MODE) {
+        std::cerr << "Failed to initialize COM: 0x" << std::hex << hr << std::endl;
+        // Continue anyway as COM might already be initialized
+    }
+    
+    hr = CoCreateInstance(
+        __uuidof(MMDeviceEnumerator),
+        nullptr, CLSCTX_ALL,
+        __uuidof(IMMDeviceEnumerator),
+        (void**)&deviceEnumerator_
+    );
+    
+    if (FAILED(hr)) {
+        std::cerr << "Failed to create device enumerator: 0x" << std::hex << hr << std::endl;
+        if (hr == REGDB_E_CLASSNOTREG) {
+            std::cerr << "MMDeviceEnumerator class not registered (Wine may need winepulse)" << std::endl;
+        } else if (hr == CLASS_E_NOAGGREGATION) {
+            std::cerr << "Class cannot be aggregated" << std::endl;
+        } else if (hr == E_NOINTERFACE) {
+            std::cerr << "Interface not supported" << std::endl;
+        } else if (hr == CO_E_NOTINITIALIZED) {
+            std::cerr << "COM not initialized" << std::endl;
+        }
+        return false;
+    }
+    
+    std::cout << "WASAPI device enumerator created successfully" << std::endl;
+    return true;
+}
+
+void WasapiBackend::ShutdownWASAPI() {
+    ReleaseClients();
+    
+    if (deviceEnumerator_) {
+        deviceEnumerator_->Release();
+        deviceEnumerator_ = nullptr;
+    }
+}
+
+void WasapiBackend::ReleaseClients() {
+    if (renderClient_) {
+        renderClient_->Release();
+        renderClient_ = nullptr;
+    }
+    
+    if (captureClient_) {
+        captureClient_->Release();
+        captureClient_ = nullptr;
+    }
+    
+    if (volumeControl_) {
+        volumeControl_->Release();
+        volumeControl_ = nullptr;
+    }
+    
+    if (inputClient_) {
+        inputClient_->Release();
+        inputClient_ = nullptr;
+        inputEventCallbackMode_ = false;
+    }
+    
+    if (outputClient_) {
+        outputClient_->Release();
+        outputClient_ = nullptr;
+        outputEventCallbackMode_ = false;
+    }
+    
+    if (inputDevice_) {
+        inputDevice_->Release();
+        inputDevice_ = nullptr;
+    }
+    
+    if (outputDevice_) {
+        outputDevice_->Release();
+        outputDevice_ = nullptr;
+    }
+}
+
+std::vector<AudioDevice> WasapiBackend::EnumerateDevices() {
+    std::vector<AudioDevice> devices;
+    
+    if (!deviceEnumerator_) {
+        return devices;
+    }
+    
+    // Enumerate output devices
+    IMMDeviceCollection* outputCollection = nullptr;
+    HRESULT hr = deviceEnumerator_->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &outputCollection);
+    if (SUCCEEDED(hr)) {
+        UINT count = 0;
+        outputCollection->GetCount(&count);
+        
+        for (UINT i = 0; i < count; ++i) {
+            IMMDevice* device = nullptr;
+            if (SUCCEEDED(outputCollection->Item(i, &device))) {
+                AudioDevice audioDevice;
+                audioDevice.id = GetDeviceId(device);
+                audioDevice.name = GetDeviceName(device);
+                audioDevice.isInput = false;
+                audioDevice.isOutput = true;
+                audioDevice.isDefault = false; // Will be set later
+                
+                devices.push_back(audioDevice);
+                device->Release();
+            }
+        }
+        outputCollection->Release();
+    }
+    
+    // Enumerate input devices
+    IMMDeviceCollection* inputCollection = nullptr;
+    hr = deviceEnumerator_->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, &inputCollection);
+    if (SUCCEEDED(hr)) {
+        UINT count = 0;
+        inputCollection->GetCount(&count);
+        
+        for (UINT i = 0; i < count; ++i) {
+            IMMDevice* device = nullptr;
+            if (SUCCEEDED(inputCollection->Item(i, &device))) {
+                AudioDevice audioDevice;
+                audioDevice.id = GetDeviceId(device);
+                audioDevice.name = GetDeviceName(device);
+                audioDevice.isInput = true;
+                audioDevice.isOutput = false;
+                audioDevice.isDefault = false; // Will be set later
+                
+                devices.push_back(audioDevice);
+                device->Release();
+            }
+        }
+        inputCollection->Release();
+    }
+    
+    // Mark default devices
+    IMMDevice* defaultOutput = nullptr;
+    if (SUCCEEDED(deviceEnumerator_->GetDefaultAudioEndpoint(eRender, eConsole, &defaultOutput))) {
+        std::string defaultOutputId = GetDeviceId(defaultOutput);
+        for (auto& device : devices) {
+            if (device.id == defaultOutputId && device.isOutput) {
+                device.isDefault = true;
+                break;
+            }
+        }
+        defaultOutput->Release();
+    }
+    
+    IMMDevice* defaultInput = nullptr;
+    if (SUCCEEDED(deviceEnumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &defaultInput))) {
+        std::string defaultInputId = GetDeviceId(defaultInput);
+        for (auto& device : devices) {
+            if (device.id == defaultInputId && device.isInput) {
+                device.isDefault = true;
+                break;
+            }
+        }
+        defaultInput->Release();
+    }
+    
+    return devices;
+}
+
+std::string WasapiBackend::GetDeviceId(IMMDevice* device) {
+    LPWSTR deviceId = nullptr;
+    if (SUCCEEDED(device->GetId(&deviceId))) {
+        std::string result = utils::WStringToString(deviceId);
+        CoTaskMemFree(deviceId);
+        return result;
+    }
+    return "";
+}
+
+std::string WasapiBackend::GetDeviceName(IMMDevice* device) {
+    IPropertyStore* props = nullptr;
+    if (SUCCEEDED(device->OpenPropertyStore(STGM_READ, &props))) {
+        PROPVARIANT varName;
+        PropVariantInit(&varName);
+        
+        if (SUCCEEDED(props->GetValue(PKEY_Device_FriendlyName, &varName))) {
+            std::string result = utils::WStringToString(varName.pwszVal);
+            PropVariantClear(&varName);
+            props->Release();
+            return result;
+        }
+        
+        PropVariantClear(&varName);
+        props->Release();
+    }
+    return "Unknown Device";
+}
+
+bool WasapiBackend::SelectDevice(const std::string& deviceId, bool isInput) {
+    if (!deviceEnumerator_) {
+        std::cerr << "Device enumerator not initialized" << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    
+    IMMDevice** targetDevice = isInput ? &inputDevice_ : &outputDevice_;
+    std::string* targetDeviceId = isInput ? &currentInputDeviceId_ : &currentOutputDeviceId_;
+    
+    // Release current device
+    if (*targetDevice) {
+        (*targetDevice)->Release();
+        *targetDevice = nullptr;
+    }
+    
+    // Get new device
+    if (deviceId.empty()) {
+        // Use default device
+        EDataFlow flow = isInput ? eCapture : eRender;
+        HRESULT hr = deviceEnumerator_->GetDefaultAudioEndpoint(flow, eConsole, targetDevice);
+        if (FAILED(hr)) {
+            std::cerr << "Failed to get default " << (isInput ? "input" : "output") 
+                      << " device: 0x" << std::hex << hr << std::endl;
+            if (hr == E_NOTFOUND) {
+                std::cerr << "No " << (isInput ? "input" : "output") << " devices found" << std::endl;
+            } else if (hr == E_OUTOFMEMORY) {
+                std::cerr << "Out of memory" << std::endl;
+            }
+            return false;
+        }
+        *targetDeviceId = GetDeviceId(*targetDevice);
+        std::cout << "Selected default " << (isInput ? "input" : "output") 
+                  << " device: " << *targetDeviceId << std::endl;
+    } else {
+        // Use specific device
+        std::wstring wDeviceId = utils::StringToWString(deviceId);
+        HRESULT hr = deviceEnumerator_->GetDevice(wDeviceId.c_str(), targetDevice);
+        if (FAILED(hr)) {
+            std::cerr << "Failed to get device '" << deviceId << "': 0x" << std::hex << hr << std::endl;
+            if (hr == E_NOTFOUND) {
+                std::cerr << "Device not found" << std::endl;
+            } else if (hr == E_INVALIDARG) {
+                std::cerr << "Invalid device ID" << std::endl;
+            }
+            return false;
+        }
+        *targetDeviceId = deviceId;
+        std::cout << "Selected " << (isInput ? "input" : "output") 
+                  << " device: " << deviceId << std::endl;
+    }
+    
+    return true;
+}
+
+std::string WasapiBackend::GetOpenInputDevice() const {
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    return inputClient_ ? currentInputDeviceId_ : std::string();
+}
+
+std::string WasapiBackend::GetOpenOutputDevice() const {
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    return outputClient_ ? currentOutputDeviceId_ : std::string();
+}
+
+bool WasapiBackend::Open(const std::string& inputDeviceId, const std::string& outputDeviceId,
+                         const AudioFormat& requested, AudioFormat& actual) {
+    Close();
+    requestedFormat_ = requested;
+    
+    if (!SelectDevice(outputDeviceId, false)) {
+        std::cerr << "Failed to select output device" << std::endl;
+        return false;
+    }
+    
+    // Select input device for microphone capture
+    if (!SelectDevice(inputDeviceId, true)) {
+        std::cerr << "Warning: Failed to select input device, audio input will be silent" << std::endl;
+        // Don't fail - we can still output audio even without input
+    }
+    
+    // Create input client first to get its native format
+    if (inputDevice_) {
+        std::cout << "Creating audio client for input device: " << currentInputDeviceId_ << std::endl;
+        if (CreateAudioClient(true, &actualInputFormat_)) { // Input
+            std::cout << "Input initialized: " << actualInputFormat_.sampleRate << " Hz, "
+                      << actualInputFormat_.channels << " channels, "
+                      << actualInputFormat_.bitsPerSample << " bits" << std::endl;
+        } else {
+            std::cerr << "Warning: Failed to create input audio client, continuing without audio input" << std::endl;
+            actualInputFormat_.sampleRate = 0;
+        }
+    }
+    
+    // Create audio client for output device, matching the input's rate if it can
+    std::cout << "Creating audio client for output device: " << currentOutputDeviceId_ << std::endl;
+    if (!CreateAudioClient(false, &actualOutputFormat_)) { // Output
+        std::cerr << "Failed to create audio client. Cannot start audio." << std::endl;
+        Close();
+        return false;
+    }
+    
+    std::cout << "Output initialized: " << actualOutputFormat_.sampleRate << " Hz, "
+              << actualOutputFormat_.channels << " channels, "
+              << actualOutputFormat_.bitsPerSample << " bits" << std::endl;
+    
+    // The render side drives processing, so its format is the stream format
+    if (inputClient_ && actualInputFormat_.sampleRate != actualOutputFormat_.sampleRate) {
+        std::cout << "Sample rate mismatch detected. Using output format ("
+                  << actualOutputFormat_.sampleRate << " Hz) for processing" << std::endl;
+    }
+    actual = actualOutputFormat_;
+    
+    // The callback is as wide as the wider device, so an interface with
+    // more inputs than outputs doesn't lose its extra inputs
+    if (inputClient_ && actualInputFormat_.channels > actual.channels) {
+        actual.channels = actualInputFormat_.channels;
+    }
+    
+    // One render period can never exceed the endpoint buffer
+    UINT32 bufferFrameCount = 0;
+    if (FAILED(outputClient_->GetBufferSize(&bufferFrameCount)) || bufferFrameCount == 0) {
+        std::cerr << "Failed to get output buffer size" << std::endl;
+        Close();
+        return false;
+    }
+    maxFrames_ = bufferFrameCount;
+    
+    outputDither_ = pcm::Dither();
+    outputDither_.SetEnabled(ditherEnabled_);
+    if (outputPcmFormat_ != PcmFormat::Float32) {
+        std::cout << "Output converts to " << pcm::GetFormatName(outputPcmFormat_)
+                  << (ditherEnabled_ ? " with dither" : "") << " ("
+                  << pcm::GetSimdLevelName(pcm::GetSimdLevel()) << ")" << std::endl;
+    }
+    
+    uint32_t channels = actual.channels;
+    inputBuffer_.assign(static_cast<size_t>(maxFrames_) * channels, 0.0f);
+    outputBuffer_.assign(static_cast<size_t>(maxFrames_) * channels, 0.0f);
+    inputPtrs_.resize(channels);
+    outputPtrs_.resize(channels);
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        inputPtrs_[ch] = inputBuffer_.data() + static_cast<size_t>(ch) * maxFrames_;
+        outputPtrs_[ch] = outputBuffer_.data() + static_cast<size_t>(ch) * maxFrames_;
+    }
+    
+    // The two devices run off their own clocks; capture goes through a FIFO
+    // that resamples it onto the render clock. An input at another nominal
+    // rate is first converted to the output rate.
+    captureFrames_ = 0;
+    if (inputClient_ && !captureResampler_.Configure(std::min(actualInputFormat_.channels, channels),
+                                                     actualInputFormat_.sampleRate, actual.sampleRate,
+                                                     ResamplerQuality::High, 0)) {
+        std::cerr << "Warning: cannot resample input from " << actualInputFormat_.sampleRate
+                  << " Hz, audio input will be silent" << std::endl;
+    } else if (inputClient_) {
+        UINT32 captureBufferFrames = 0;
+        REFERENCE_TIME inputPeriod = 0;
+        REFERENCE_TIME outputPeriod = 0;
+        if (SUCCEEDED(inputClient_->GetBufferSize(&captureBufferFrames)) && captureBufferFrames > 0) {
+            inputClient_->GetDevicePeriod(&inputPeriod, nullptr);
+            outputClient_->GetDevicePeriod(&outputPeriod, nullptr);
+            uint32_t inputPeriodFrames = static_cast<uint32_t>(inputPeriod * actual.sampleRate / 10000000);
+            uint32_t outputPeriodFrames = static_cast<uint32_t>(outputPeriod * actual.sampleRate / 10000000);
+            
+            // Two capture packets and a render period keep both sides fed
+            // through a late wake-up
+            captureChannels_ = std::min(actualInputFormat_.channels, channels);
+            captureFrames_ = captureBufferFrames;
+            captureResampler_.Configure(captureChannels_, actualInputFormat_.sampleRate, actual.sampleRate,
+                                        ResamplerQuality::High, captureFrames_);
+            uint32_t resampledFrames = captureResampler_.GetMaxOutputFrames(captureFrames_);
+            captureBuffer_.assign(static_cast<size_t>(captureFrames_ + resampledFrames) * captureChannels_, 0.0f);
+            capturePtrs_.resize(captureChannels_);
+            resampledPtrs_.resize(captureChannels_);
+            for (uint32_t ch = 0; ch < captureChannels_; ++ch) {
+                capturePtrs_[ch] = captureBuffer_.data() + static_cast<size_t>(ch) * captureFrames_;
+                resampledPtrs_[ch] = captureBuffer_.data() + static_cast<size_t>(captureChannels_) * captureFrames_ +
+                                     static_cast<size_t>(ch) * resampledFrames;
+            }
+            driftCompensator_.Configure(captureChannels_, resampledFrames, maxFrames_,
+                                        2 * inputPeriodFrames + outputPeriodFrames, actual.sampleRate);
+            if (!captureResampler_.IsPassthrough()) {
+                std::cout << "Resampling input from " << actualInputFormat_.sampleRate << " Hz" << std::endl;
+            }
+            std::cout << "Input drift compensation on, " << driftCompensator_.GetStatus().targetFrames
+                      << " frames buffered" << std::endl;
+        }
+    }
+    
+    return true;
+}
+
+void WasapiBackend::Close() {
+    Stop();
+    
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    ReleaseClients();
+    actualInputFormat_.sampleRate = 0;
+    maxFrames_ = 0;
+    captureFrames_ = 0;
+}
+
+bool WasapiBackend::Start(AudioProcessCallback callback) {
+    if (!outputClient_ || audioThread_.joinable()) {
+        return false;
+    }
+    
+    callback_ = std::move(callback);
+    shouldStop_.store(false);
+    audioThread_ = std::thread(&WasapiBackend::AudioThreadProc, this);
+    return true;
+}
+
+void WasapiBackend::Stop() {
+    if (!audioThread_.joinable()) {
+        return;
+    }
+    
+    shouldStop_.store(true);
+    
+    // Signal audio thread to stop
+    if (audioEvent_) {
+        SetEvent(audioEvent_);
+    }
+    
+    // Wait for audio thread to finish
+    audioThread_.join();
+}
+
+bool WasapiBackend::CreateAudioClient(bool isInput, AudioFormat* actualFormat) {
+    IMMDevice* device = isInput ? inputDevice_ : outputDevice_;
+    IAudioClient** client = isInput ? &inputClient_ : &outputClient_;
+    
+    if (!device) {
+        std::cerr << "No " << (isInput ? "input" : "output") << " device selected" << std::endl;
+        return false;
+    }
+    
+    // Release existing client
+    if (*client) {
+        (*client)->Release();
+        *client = nullptr;
+    }
+    
+    // Create new audio client
+    HRESULT hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)client);
+    if (FAILED(hr)) {
+        std::cerr << "Failed to activate audio client for " << (isInput ? "input" : "output") 
+                  << ": 0x" << std::hex << hr << std::endl;
+        return false;
+    }
+    
+    // Get the device's native mix format (for both input and output)
+    WAVEFORMATEX* mixFormat = nullptr;
+    hr = (*client)->GetMixFormat(&mixFormat);
+    if (FAILED(hr)) {
+        std::cerr << "Failed to get mix format for " << (isInput ? "input" : "output") << " device: 0x" << std::hex << hr << std::endl;
+        (*client)->Release();
+        *client = nullptr;
+        return false;
+    }
+    
+    std::cout << (isInput ? "Input" : "Output") << " device native format: "
+              << mixFormat->nSamplesPerSec << " Hz, "
+              << mixFormat->nChannels << " channels, "
+              << mixFormat->wBitsPerSample << " bits" << std::endl;
+    
+    // For output: if input format is already set, try to use matching format
+    // Otherwise use device's native format
+    if (!isInput && inputClient_ && actualInputFormat_.sampleRate > 0) {
+        std::cout << "Attempting to match output format to input: "
+                  << actualInputFormat_.sampleRate << " Hz" << std::endl;
+        
+        // Create format matching input
+        WAVEFORMATEXTENSIBLE* desiredFormat = (WAVEFORMATEXTENSIBLE*)CoTaskMemAlloc(sizeof(WAVEFORMATEXTENSIBLE));
+        memcpy(desiredFormat, mixFormat, sizeof(WAVEFORMATEXTENSIBLE));
+        desiredFormat->Format.nSamplesPerSec = actualInputFormat_.sampleRate;
+        desiredFormat->Format.nAvgBytesPerSec = actualInputFormat_.sampleRate * desiredFormat->Format.nBlockAlign;
+        
+        // Check if this format is supported
+        WAVEFORMATEX* closestMatch = nullptr;
+        hr = (*client)->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, (WAVEFORMATEX*)desiredFormat, &closestMatch);
+        
+        if (hr == S_OK) {
+            // Exact match supported - use it
+            CoTaskMemFree(mixFormat);
+            mixFormat = (WAVEFORMATEX*)desiredFormat;
+            std::cout << "Output device supports input sample rate" << std::endl;
+        } else if (hr == S_FALSE && closestMatch) {
+            // Close match available
+            std::cout << "Using closest match: " << closestMatch->nSamplesPerSec << " Hz" << std::endl;
+            CoTaskMemFree(mixFormat);
+            CoTaskMemFree(desiredFormat);
+            mixFormat = closestMatch;
+        } else {
+            // Not supported, use device default
+            std::cout << "Output device doesn't support input sample rate, using native format" << std::endl;
+            CoTaskMemFree(desiredFormat);
+        }
+    }
+    
+    // Store the actual format being used
+    if (actualFormat) {
+        actualFormat->sampleRate = mixFormat->nSamplesPerSec;
+        actualFormat->channels = mixFormat->nChannels;
+        actualFormat->bitsPerSample = mixFormat->wBitsPerSample;
+        actualFormat->bufferSize = requestedFormat_.bufferSize; // Keep requested buffer size
+    }
+    
+    // Calculate buffer duration - use 10ms for low latency
+    REFERENCE_TIME bufferDuration = 100000;  // 10ms
+    
+    // Try event callback mode first (for Windows), fall back to polling if it fails
+    hr = (*client)->Initialize(
+        AUDCLNT_SHAREMODE_SHARED,
+        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+        bufferDuration,
+        0,
+        mixFormat,
+        nullptr
+    );
+    
+    bool useEventCallback = SUCCEEDED(hr);
+    
+    if (FAILED(hr)) {
+        std::cout << "Event callback mode failed for " << (isInput ? "input" : "output") << ", trying polling mode" << std::endl;
+        // Release and recreate client
+        (*client)->Release();
+        hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)client);
+        if (FAILED(hr)) {
+            std::cerr << "Failed to reactivate audio client: 0x" << std::hex << hr << std::endl;
+            CoTaskMemFree(mixFormat);
+            *client = nullptr;
+            return false;
+        }
+        
+        // Get mix format again
+        WAVEFORMATEX* mixFormat2 = nullptr;
+        hr = (*client)->GetMixFormat(&mixFormat2);
+        if (SUCCEEDED(hr)) {
+            CoTaskMemFree(mixFormat);
+            mixFormat = mixFormat2;
+        }
+        
+        // Try without event callback (polling mode)
+        hr = (*client)->Initialize(
+            AUDCLNT_SHAREMODE_SHARED,
+            0,  // No event callback
+            bufferDuration,
+            0,
+            mixFormat,
+            nullptr
+        );
+    }
+    
+    PcmFormat pcmFormat = PcmFormat::Float32;
+    bool formatSupported = GetPcmFormat(mixFormat, pcmFormat);
+    WORD formatBits = mixFormat->wBitsPerSample;
+    CoTaskMemFree(mixFormat);
+    
+    if (SUCCEEDED(hr) && !formatSupported) {
+        std::cerr << "Unsupported " << (isInput ? "input" : "output") << " sample format ("
+                  << formatBits << " bits)" << std::endl;
+        (*client)->Release();
+        *client = nullptr;
+        return false;
+    }
+    (isInput ? inputPcmFormat_ : outputPcmFormat_) = pcmFormat;
+    
+    if (FAILED(hr)) {
+        std::cerr << "Failed to initialize " << (isInput ? "input" : "output") << " audio client: 0x" << std::hex << hr << std::endl;
+        if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
+            std::cerr << "  Format not supported" << std::endl;
+        } else if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+            std::cerr << "  Buffer size not aligned" << std::endl;
+        } else if (hr == AUDCLNT_E_DEVICE_IN_USE) {
+            std::cerr << "  Device already in use" << std::endl;
+        }
+        (*client)->Release();
+        *client = nullptr;
+        return false;
+    }
+    
+    if (isInput) {
+        // Get the device's preferred format
+        WAVEFORMATEX* mixFormat = nullptr;
+        hr = (*client)->GetMixFormat(&mixFormat);
+        if (FAILED(hr)) {
+            std::cerr << "Failed to get mix format for input device: 0x" << std::hex << hr << std::endl;
+            (*client)->Release();
+            *client = nullptr;
+            return false;
+        }
+        
+        std::cout << "Input device native format: "
+                  << mixFormat->nSamplesPerSec << " Hz, "
+                  << mixFormat->nChannels << " channels, "
+                  << mixFormat->wBitsPerSample << " bits" << std::endl;
+        
+        // Calculate buffer duration - use same duration as output for better sync
+        // Default to 10ms (100000 hundred-nanosecond units)
+        REFERENCE_TIME bufferDuration = 100000;  // 10ms
+        
+        // Try event callback mode first (for Windows), fall back to polling if it fails
+        hr = (*client)->Initialize(
+            AUDCLNT_SHAREMODE_SHARED,
+            AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+            bufferDuration,
+            0,
+            mixFormat,
+            nullptr
+        );
+        
+        bool useEventCallback = SUCCEEDED(hr);
+        
+        if (FAILED(hr)) {
+            std::cout << "Event callback mode failed, trying polling mode for input" << std::endl;
+            // Release and recreate client
+            (*client)->Release();
+            hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)client);
+            if (FAILED(hr)) {
+                std::cerr << "Failed to reactivate audio client for input: 0x" << std::hex << hr << std::endl;
+                CoTaskMemFree(mixFormat);
+                *client = nullptr;
+                return false;
+            }
+            
+            // Get mix format again
+            WAVEFORMATEX* mixFormat2 = nullptr;
+            hr = (*client)->GetMixFormat(&mixFormat2);
+            if (SUCCEEDED(hr)) {
+                CoTaskMemFree(mixFormat);
+                mixFormat = mixFormat2;
+            }
+            
+            // Try without event callback (polling mode)
+            hr = (*client)->Initialize(
+                AUDCLNT_SHAREMODE_SHARED,
+                0,  // No event callback
+                bufferDuration,
+                0,
+                mixFormat,
+                nullptr
+            );
+        }
+        
+        CoTaskMemFree(mixFormat);
+        
+        if (FAILED(hr)) {
+            std::cerr << "Failed to initialize input audio client: 0x" << std::hex << hr << std::endl;
+            if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
+                std::cerr << "  Format not supported" << std::endl;
+            } else if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+                std::cerr << "  Buffer size not aligned" << std::endl;
+            } else if (hr == AUDCLNT_E_DEVICE_IN_USE) {
+                std::cerr << "  Device already in use" << std::endl;
+            }
+            (*client)->Release();
+            *client = nullptr;
+            return false;
+        }
+        
+        // Get capture client
+        hr = (*client)->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
+        if (FAILED(hr)) {
+            std::cerr << "Failed to get capture client: 0x" << std::hex << hr << std::endl;
+            (*client)->Release();
+            *client = nullptr;
+            return false;
+        }
+        
+        // Set event handle if using event callback mode
+        if (useEventCallback) {
+            hr = (*client)->SetEventHandle(audioEvent_);
+            if (FAILED(hr)) {
+                std::cerr << "Failed to set event handle for input: 0x" << std::hex << hr << std::endl;
+                (*client)->Release();
+                *client = nullptr;
+                return false;
+            }
+            inputEventCallbackMode_ = true;
+            std::cout << "Input audio client initialized (event callback mode)" << std::endl;
+        } else {
+            inputEventCallbackMode_ = false;
+            std::cout << "Input audio client initialized (polling mode)" << std::endl;
+        }
+    } else {
+        // Output device
+        hr = (*client)->GetService(__uuidof(IAudioRenderClient), (void**)&renderClient_);
+        if (FAILED(hr)) {
+            std::cerr << "Failed to get render client: 0x" << std::hex << hr << std::endl;
+            (*client)->Release();
+            *client = nullptr;
+            return false;
+        }
+        
+        // Get volume control (optional)
+        hr = (*client)->GetService(__uuidof(ISimpleAudioVolume), (void**)&volumeControl_);
+        // Volume control is optional, don't fail if not available
+        
+        // Set event handle if using event callback mode
+        if (useEventCallback) {
+            hr = (*client)->SetEventHandle(audioEvent_);
+            if (FAILED(hr)) {
+                std::cerr << "Failed to set event handle for output: 0x" << std::hex << hr << std::endl;
+                (*client)->Release();
+                *client = nullptr;
+                return false;
+            }
+            outputEventCallbackMode_ = true;
+            std::cout << "Output audio client initialized (event callback mode)" << std::endl;
+        } else {
+            outputEventCallbackMode_ = false;
+            std::cout << "Output audio client initialized (polling mode)" << std::endl;
+        }
+    }
+    
+    return true;
+}
+
+bool WasapiBackend::SetupFormat(IAudioClient* client, const AudioFormat& format) {
+    WAVEFORMATEX* waveFormat = CreateWaveFormat(format);
+    if (!waveFormat) {
+        std::cerr << "Failed to create wave format" << std::endl;
+        return false;
+    }
+    
+    // Calculate buffer duration in 100-nanosecond units
+    REFERENCE_TIME bufferDuration = (REFERENCE_TIME)((double)format.bufferSize / format.sampleRate * 10000000.0);
+    
+    HRESULT hr = client->Initialize(
+        AUDCLNT_SHAREMODE_SHARED,
+        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+        bufferDuration,
+        0,
+        waveFormat,
+        nullptr
+    );
+    
+    CoTaskMemFree(waveFormat);
+    
+    if (FAILED(hr)) {
+        std::cerr << "Failed to initialize audio client: 0x" << std::hex << hr << std::endl;
+        if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
+            std::cerr << "Format not supported by device" << std::endl;
+        } else if (hr == AUDCLNT_E_DEVICE_IN_USE) {
+            std::cerr << "Device is already in use" << std::endl;
+        } else if (hr == E_INVALIDARG) {
+            std::cerr << "Invalid argument in Initialize" << std::endl;
+        }
+        return false;
+    }
+    
+    // Set event handle
+    hr = client->SetEventHandle(audioEvent_);
+    if (FAILED(hr)) {
+        std::cerr << "Failed to set event handle: 0x" << std::hex << hr << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+WAVEFORMATEX* WasapiBackend::CreateWaveFormat(const AudioFormat& format) {
+    // Use WAVEFORMATEXTENSIBLE for proper float format support
+    WAVEFORMATEXTENSIBLE* waveFormatEx = (WAVEFORMATEXTENSIBLE*)CoTaskMemAlloc(sizeof(WAVEFORMATEXTENSIBLE));
+    if (!waveFormatEx) {
+        return nullptr;
+    }
+    
+    memset(waveFormatEx, 0, sizeof(WAVEFORMATEXTENSIBLE));
+    
+    waveFormatEx->Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    waveFormatEx->Format.nChannels = format.channels;
+    waveFormatEx->Format.nSamplesPerSec = format.sampleRate;
+    waveFormatEx->Format.wBitsPerSample = format.bitsPerSample;
+    waveFormatEx->Format.nBlockAlign = (format.channels * format.bitsPerSample) / 8;
+    waveFormatEx->Format.nAvgBytesPerSec = format.sampleRate * waveFormatEx->Format.nBlockAlign;
+    waveFormatEx->Format.cbSize = 22; // Size of the extension
+    
+    waveFormatEx->Samples.wValidBitsPerSample = format.bitsPerSample;
+    
+    // Set channel mask for stereo (front left + front right)
+    waveFormatEx->dwChannelMask = (format.channels == 2) ? (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT) : 0;
+    
+    // Use IEEE float format for 32-bit, PCM for others
+    if (format.bitsPerSample == 32) {
+        waveFormatEx->SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    } else {
+        waveFormatEx->SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
+    }
+    
+    return (WAVEFORMATEX*)waveFormatEx;
+}
+
+double WasapiBackend::GetQpcSeconds() {
+    static const double ticksPerSecond = []() {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(frequency.QuadPart);
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart / ticksPerSecond;
+}
+
+void WasapiBackend::DrainCapture() {
+    UINT32 packetLength = 0;
+    while (SUCCEEDED(captureClient_->GetNextPacketSize(&packetLength)) && packetLength > 0) {
+        BYTE* inputData;
+        UINT32 framesAvailable;
+        DWORD flags;
+        UINT64 qpcPosition = 0;
+        if (FAILED(captureClient_->GetBuffer(&inputData, &framesAvailable, &flags, nullptr, &qpcPosition))) {
+            return;
+        }
+        
+        // The first packet after Start() is flagged as well
+        if ((flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) && captureStarted_) {
+            ReportXrun(GlitchType::CaptureOverrun, framesAvailable);
+        }
+        captureStarted_ = true;
+        
+        // Packets should fit the endpoint buffer, but a larger one is taken
+        // in pieces rather than cut short. The QPC position is in 100 ns
+        // units; a converted packet comes out later by the filter delay.
+        double packetTime = (flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR) ? -1.0 : qpcPosition * 1e-7;
+        size_t frameBytes = static_cast<size_t>(pcm::GetSampleBytes(inputPcmFormat_)) * actualInputFormat_.channels;
+        for (uint32_t offset = 0; offset < framesAvailable; offset += captureFrames_) {
+            uint32_t frames = std::min(framesAvailable - offset, captureFrames_);
+            if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+                for (uint32_t ch = 0; ch < captureChannels_; ++ch) {
+                    std::fill(capturePtrs_[ch], capturePtrs_[ch] + frames, 0.0f);
+                }
+            } else {
+                pcm::Decode(inputData + offset * frameBytes, inputPcmFormat_, actualInputFormat_.channels,
+                            capturePtrs_.data(), captureChannels_, frames);
+            }
+            
+            double captureTime = packetTime < 0.0 ? -1.0
+                : packetTime + static_cast<double>(offset) / actualInputFormat_.sampleRate;
+            if (captureResampler_.IsPassthrough()) {
+                driftCompensator_.Push(capturePtrs_.data(), frames, captureTime);
+            } else {
+                uint32_t resampled = captureResampler_.Process(capturePtrs_.data(), frames, resampledPtrs_.data());
+                if (captureTime >= 0.0) {
+                    captureTime += captureResampler_.GetLatency() / captureResampler_.GetOutputRate();
+                }
+                driftCompensator_.Push(resampledPtrs_.data(), resampled, captureTime);
+            }
+        }
+        
+        captureClient_->ReleaseBuffer(framesAvailable);
+        
+        static bool firstCapture = true;
+        if (firstCapture) {
+            LogRealtime(LogLevel::Info, "Microphone input is working");
+            firstCapture = false;
+        }
+    }
+}
+
+void WasapiBackend::AudioThreadProc() {
+    PrepareRealtimeThread();
+    
+    // Initialize COM for this thread (required for WASAPI)
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool comInitialized = SUCCEEDED(hr);
+    
+    // Start the audio clients
+    if (outputClient_) {
+        hr = outputClient_->Start();
+        if (FAILED(hr)) {
+            LogRealtime(LogLevel::Error, "Failed to start output client: {}", LogHex(static_cast<uint32_t>(hr)));
+            if (comInitialized) CoUninitialize();
+            return;
+        }
+    }
+    
+    if (inputClient_) {
+        hr = inputClient_->Start();
+        if (FAILED(hr)) {
+            LogRealtime(LogLevel::Warning, "Warning: Failed to start input client: {}", LogHex(static_cast<uint32_t>(hr)));
+            // Continue without input
+        }
+    }
+    
+    uint32_t channels = static_cast<uint32_t>(outputPtrs_.size());
+    driftCompensator_.Reset();
+    captureResampler_.Reset();
+    captureStarted_ = false;
+    bool rendered = false;
+    
+    while (!shouldStop_.load()) {
+        // Handle different modes: event callback vs polling
+        if (outputEventCallbackMode_) {
+            // Event callback mode: wait for audio event
+            DWORD waitResult = WaitForSingleObject(audioEvent_, 1000); // 1 second timeout
+            
+            if (waitResult != WAIT_OBJECT_0) {
+                if (waitResult == WAIT_TIMEOUT) {
+                    continue;
+                } else {
+                    break; // Error occurred
+                }
+            }
+        } else {
+            // Polling mode: sleep for a short period and check buffers
+            Sleep(5); // 5ms sleep for polling mode
+        }
+        
+        if (shouldStop_.load()) {
+            break;
+        }
+        
+        // Drain every capture packet into the drift FIFO on each wake-up,
+        // even when the render buffer has no room this time, so the
+        // endpoint buffer never overflows and no packet waits a cycle
+        bool capturing = captureClient_ && captureFrames_ > 0;
+        if (capturing) {
+            DrainCapture();
+        }
+        
+        // Process audio
+        if (renderClient_ && callback_) {
+            static bool firstCallback = true;
+            if (firstCallback) {
+                LogRealtime(LogLevel::Info, "Audio processing callbacks started");
+                firstCallback = false;
+            }
+            
+            UINT32 numFramesPadding;
+            if (SUCCEEDED(outputClient_->GetCurrentPadding(&numFramesPadding))) {
+                UINT32 numFramesAvailable = maxFrames_ - std::min(numFramesPadding, maxFrames_);
+                
+                // An empty device buffer once we've started filling it means
+                // it already played silence
+                if (numFramesPadding == 0 && rendered) {
+                    ReportXrun(GlitchType::RenderUnderrun, numFramesAvailable);
+                }
+                
+                if (numFramesAvailable > 0) {
+                    BYTE* outputData;
+                    if (SUCCEEDED(renderClient_->GetBuffer(numFramesAvailable, &outputData))) {
+                        // Pull exactly the frames this period renders
+                        if (capturing) {
+                            double playTime = GetQpcSeconds() +
+                                              static_cast<double>(numFramesPadding) / actualOutputFormat_.sampleRate;
+                            driftCompensator_.Pull(inputPtrs_.data(), numFramesAvailable, playTime);
+                        }
+                        
+                        // Channels the capture stream doesn't have are silent
+                        uint32_t silentFrom = capturing ? captureChannels_ : 0;
+                        for (uint32_t ch = silentFrom; ch < channels; ++ch) {
+                            std::fill(inputPtrs_[ch], inputPtrs_[ch] + numFramesAvailable, 0.0f);
+                        }
+                        
+                        // Call user callback to process audio
+                        callback_(inputPtrs_.data(), outputPtrs_.data(), channels, numFramesAvailable);
+                        
+                        // Interleave into the WASAPI buffer in the device's format
+                        pcm::Encode(outputPtrs_.data(), channels, outputData, outputPcmFormat_, actualOutputFormat_.channels,
+                                    numFramesAvailable, &outputDither_);
+                        
+                        renderClient_->ReleaseBuffer(numFramesAvailable, 0);
+                        rendered = true;
+                    }
+                }
+            }
+        }
+    }
+    
+    // Stop the audio clients
+    if (inputClient_) {
+        inputClient_->Stop();
+    }
+    
+    if (outputClient_) {
+        outputClient_->Stop();
+    }
+    
+    // Uninitialize COM for this thread
+    if (comInitialized) {
+        CoUninitialize();
+    }
+}
+
+double WasapiBackend::GetLatency() const {
+    if (!outputClient_) {
+        return 0.0;
+    }
+    
+    REFERENCE_TIME latency;
+    if (SUCCEEDED(outputClient_->GetStreamLatency(&latency))) {
+        return latency / 10000.0; // Convert to milliseconds
+    }
+    
+    return 0.0;
+}
+
+bool WasapiBackend::SetMasterVolume(float volume) {
+    if (!volumeControl_) {
+        return false;
+    }
+    
+    volume = std::max(0.0f, std::min(1.0f, volume));
+    return SUCCEEDED(volumeControl_->SetMasterVolume(volume, nullptr));
+}
+
+float WasapiBackend::GetMasterVolume() const {
+    if (!volumeControl_) {
+        return 1.0f;
+    }
+    
+    float volume = 1.0f;
+    volumeControl_->GetMasterVolume(&volume);
+    return volume;
+}
+
+bool WasapiBackend::SetMuted(bool muted) {
+    if (!volumeControl_) {
+        return false;
+    }
+    
+    return SUCCEEDED(volumeControl_->SetMute(muted, nullptr));
+}
+
+bool WasapiBackend::IsMuted() const {
+    if (!volumeControl_) {
+        return false;
+    }
+    
+    BOOL muted = FALSE;
+    volumeControl_->GetMute(&muted);
+    return muted != FALSE;
+}
+
+} // namespace violet
\ No newline at end of file
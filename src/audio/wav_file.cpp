@@ -0,0 +1,249 @@
+#include "violet/wav_file.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+namespace violet {
+
+namespace {
+
+const uint16_t WAVE_FORMAT_PCM = 0x0001;
+const uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+uint16_t ReadLE16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t ReadLE32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) |
+           (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void WriteLE16(std::ostream& stream, uint16_t value) {
+    char bytes[2] = { static_cast<char>(value & 0xFF), static_cast<char>(value >> 8) };
+    stream.write(bytes, 2);
+}
+
+void WriteLE32(std::ostream& stream, uint32_t value) {
+    char bytes[4] = {
+        static_cast<char>(value & 0xFF),
+        static_cast<char>((value >> 8) & 0xFF),
+        static_cast<char>((value >> 16) & 0xFF),
+        static_cast<char>((value >> 24) & 0xFF)
+    };
+    stream.write(bytes, 4);
+}
+
+float DecodeSample(const uint8_t* data, uint16_t formatTag, uint16_t bitsPerSample) {
+    if (formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+        if (bitsPerSample == 32) {
+            uint32_t bits = ReadLE32(data);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        uint64_t bits = ReadLE32(data) | (static_cast<uint64_t>(ReadLE32(data + 4)) << 32);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return static_cast<float>(value);
+    }
+
+    switch (bitsPerSample) {
+        case 8:
+            return (static_cast<int>(data[0]) - 128) / 128.0f;
+        case 16:
+            return static_cast<int16_t>(ReadLE16(data)) / 32768.0f;
+        case 24: {
+            int32_t value = static_cast<int32_t>((data[0] << 8) | (data[1] << 16) | (static_cast<uint32_t>(data[2]) << 24)) >> 8;
+            return value / 8388608.0f;
+        }
+        default:
+            return static_cast<int32_t>(ReadLE32(data)) / 2147483648.0f;
+    }
+}
+
+int32_t QuantizeSample(float sample, int32_t maxValue) {
+    float scaled = std::round(sample * static_cast<float>(maxValue));
+    scaled = std::max(-static_cast<float>(maxValue) - 1.0f, std::min(static_cast<float>(maxValue), scaled));
+    return static_cast<int32_t>(scaled);
+}
+
+} // namespace
+
+void AudioFileData::Resize(uint32_t channelCount, uint64_t frames) {
+    channels.resize(channelCount);
+    for (auto& channel : channels) {
+        channel.assign(frames, 0.0f);
+    }
+}
+
+bool WavFile::Read(const std::string& filePath, AudioFileData& data, std::string& error) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot open " + filePath;
+        return false;
+    }
+
+    uint8_t header[12];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) {
+        error = filePath + " is not a RIFF/WAVE file";
+        return false;
+    }
+
+    uint16_t formatTag = 0;
+    uint16_t channelCount = 0;
+    uint32_t sampleRate = 0;
+    uint16_t blockAlign = 0;
+    uint16_t bitsPerSample = 0;
+    bool haveFormat = false;
+
+    // Walk the chunks until the data chunk, picking up the format on the way
+    uint8_t chunkHeader[8];
+    while (file.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader))) {
+        uint32_t chunkSize = ReadLE32(chunkHeader + 4);
+
+        if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+            std::vector<uint8_t> format(chunkSize);
+            if (chunkSize < 16 || !file.read(reinterpret_cast<char*>(format.data()), chunkSize)) {
+                error = "Truncated format chunk in " + filePath;
+                return false;
+            }
+            formatTag = ReadLE16(&format[0]);
+            channelCount = ReadLE16(&format[2]);
+            sampleRate = ReadLE32(&format[4]);
+            blockAlign = ReadLE16(&format[12]);
+            bitsPerSample = ReadLE16(&format[14]);
+
+            // The sub-format GUID starts with the plain format tag
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26) {
+                formatTag = ReadLE16(&format[24]);
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+            if (!haveFormat) {
+                error = "Data chunk before format chunk in " + filePath;
+                return false;
+            }
+
+            bool supported = channelCount > 0 && blockAlign >= channelCount * ((bitsPerSample + 7) / 8) &&
+                ((formatTag == WAVE_FORMAT_PCM && (bitsPerSample == 8 || bitsPerSample == 16 ||
+                                                  bitsPerSample == 24 || bitsPerSample == 32)) ||
+                 (formatTag == WAVE_FORMAT_IEEE_FLOAT && (bitsPerSample == 32 || bitsPerSample == 64)));
+            if (!supported) {
+                error = "Unsupported WAV format in " + filePath;
+                return false;
+            }
+
+            std::vector<uint8_t> samples(chunkSize);
+            file.read(reinterpret_cast<char*>(samples.data()), chunkSize);
+            uint64_t frames = static_cast<uint64_t>(file.gcount()) / blockAlign;  // tolerate a short last chunk
+
+            uint32_t bytesPerSample = bitsPerSample / 8;
+            data.sampleRate = sampleRate;
+            data.Resize(channelCount, frames);
+            for (uint64_t frame = 0; frame < frames; ++frame) {
+                const uint8_t* frameData = samples.data() + frame * blockAlign;
+                for (uint16_t ch = 0; ch < channelCount; ++ch) {
+                    data.channels[ch][frame] = DecodeSample(frameData + ch * bytesPerSample, formatTag, bitsPerSample);
+                }
+            }
+            return true;
+        } else {
+            // Chunks are padded to an even size
+            file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+        }
+    }
+
+    error = "No data chunk in " + filePath;
+    return false;
+}
+
+bool WavFile::Write(const std::string& filePath, const AudioFileData& data,
+                    SampleFormat format, std::string& error) {
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot create " + filePath;
+        return false;
+    }
+
+    uint16_t channelCount = static_cast<uint16_t>(data.GetChannelCount());
+    uint64_t frames = data.GetFrameCount();
+    uint16_t bitsPerSample = format == SampleFormat::Int16 ? 16 : format == SampleFormat::Int24 ? 24 : 32;
+    uint16_t blockAlign = static_cast<uint16_t>(channelCount * bitsPerSample / 8);
+    uint64_t dataSize = frames * blockAlign;
+    if (dataSize + 36 > UINT32_MAX) {
+        error = "Output exceeds the 4 GB WAV limit";
+        return false;
+    }
+
+    file.write("RIFF", 4);
+    WriteLE32(file, static_cast<uint32_t>(36 + dataSize + (dataSize & 1)));
+    file.write("WAVE", 4);
+
+    file.write("fmt ", 4);
+    WriteLE32(file, 16);
+    WriteLE16(file, format == SampleFormat::Float32 ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+    WriteLE16(file, channelCount);
+    WriteLE32(file, data.sampleRate);
+    WriteLE32(file, data.sampleRate * blockAlign);
+    WriteLE16(file, blockAlign);
+    WriteLE16(file, bitsPerSample);
+
+    file.write("data", 4);
+    WriteLE32(file, static_cast<uint32_t>(dataSize));
+
+    // Interleave a block of frames at a time
+    const uint64_t FRAMES_PER_WRITE = 4096;
+    std::vector<char> buffer(FRAMES_PER_WRITE * blockAlign);
+    for (uint64_t start = 0; start < frames; start += FRAMES_PER_WRITE) {
+        uint64_t count = std::min(FRAMES_PER_WRITE, frames - start);
+        char* out = buffer.data();
+        for (uint64_t frame = start; frame < start + count; ++frame) {
+            for (uint16_t ch = 0; ch < channelCount; ++ch) {
+                float sample = data.channels[ch][frame];
+                switch (format) {
+                    case SampleFormat::Int16: {
+                        uint16_t value = static_cast<uint16_t>(QuantizeSample(sample, 32767));
+                        *out++ = static_cast<char>(value & 0xFF);
+                        *out++ = static_cast<char>(value >> 8);
+                        break;
+                    }
+                    case SampleFormat::Int24: {
+                        uint32_t value = static_cast<uint32_t>(QuantizeSample(sample, 8388607));
+                        *out++ = static_cast<char>(value & 0xFF);
+                        *out++ = static_cast<char>((value >> 8) & 0xFF);
+                        *out++ = static_cast<char>((value >> 16) & 0xFF);
+                        break;
+                    }
+                    case SampleFormat::Float32: {
+                        uint32_t bits;
+                        std::memcpy(&bits, &sample, sizeof(bits));
+                        *out++ = static_cast<char>(bits & 0xFF);
+                        *out++ = static_cast<char>((bits >> 8) & 0xFF);
+                        *out++ = static_cast<char>((bits >> 16) & 0xFF);
+                        *out++ = static_cast<char>((bits >> 24) & 0xFF);
+                        break;
+                    }
+                }
+            }
+        }
+        file.write(buffer.data(), out - buffer.data());
+    }
+
+    if (dataSize & 1) {
+        file.put(0);
+    }
+
+    if (!file.good()) {
+        error = "Failed writing " + filePath;
+        return false;
+    }
+    return true;
+}
+
+} // namespace violet
@@ -2,8 +2,12 @@
 #include "violet/utils.h"
 #include <fstream>
 #include <sstream>
+#include <cstdlib>
+
+#ifdef _WIN32
 #include <windows.h>
 #include <shlobj.h>
+#endif
 
 namespace violet {
 
@@ -65,10 +69,10 @@ bool ConfigManager::Initialize() {
     }
     
     // Create Violet directory if it doesn't exist
-    std::string violetDir = appDataPath + "\\Violet";
-    CreateDirectoryA(violetDir.c_str(), nullptr);
+    std::string violetDir = utils::JoinPath(appDataPath, "Violet");
+    utils::MakeDirectory(violetDir);
     
-    config_path_ = violetDir + "\\config.ini";
+    config_path_ = utils::JoinPath(violetDir, "config.ini");
     
     // Try to load existing configuration
     Load();
@@ -204,6 +208,8 @@ void ConfigManager::SetDefaults() {
     SetInt("audio.buffer_size", 256);
     SetInt("audio.bit_depth", 32);
     SetBool("audio.auto_start", false);
+    SetString("audio.input_map", "");     // see ChannelMap; empty = one bus per device channel
+    SetString("audio.output_map", "");
     
     // UI settings
     SetInt("ui.window_width", 1000);
@@ -226,11 +232,25 @@ void ConfigManager::SetDefaults() {
 }
 
 std::string ConfigManager::GetAppDataPath() const {
+#ifdef _WIN32
     char path[MAX_PATH];
     if (SUCCEEDED(SHGetFolderPathA(nullptr, CSIDL_APPDATA, nullptr, 0, path))) {
         return std::string(path);
     }
     return "";
+#else
+    const char* configHome = getenv("XDG_CONFIG_HOME");
+    if (configHome && *configHome) {
+        return std::string(configHome);
+    }
+    const char* home = getenv("HOME");
+    if (!home) {
+        return "";
+    }
+    std::string path = utils::JoinPath(home, ".config");
+    utils::MakeDirectory(path);
+    return path;
+#endif
 }
 
 } // namespace violet
\ No newline at end of file
@@ -5,10 +5,47 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cmath>
 
 namespace violet {
 
-const char* SessionManager::SESSION_VERSION = "1.0";
+namespace {
+
+std::string JoinIds(const std::vector<uint32_t>& ids) {
+    std::string result;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) result += ",";
+        result += std::to_string(ids[i]);
+    }
+    return result;
+}
+
+std::vector<uint32_t> SplitIds(const std::string& value) {
+    std::vector<uint32_t> ids;
+    std::stringstream ss(value);
+    std::string id;
+    while (std::getline(ss, id, ',')) {
+        if (!id.empty()) {
+            ids.push_back(std::stoul(id));
+        }
+    }
+    return ids;
+}
+
+void RescaleAutomation(SessionData::PluginNode& node, double rateRatio) {
+    if (rateRatio == 1.0) {
+        return;
+    }
+    for (auto& lane : node.automation) {
+        for (auto& point : lane.second) {
+            point.first = static_cast<uint64_t>(std::llround(point.first * rateRatio));
+        }
+    }
+}
+
+} // namespace
+
+const char* SessionManager::SESSION_VERSION = "1.1";
 const char* SessionManager::SESSION_EXTENSION = ".violet";
 
 SessionManager::SessionManager()
@@ -22,6 +59,7 @@ SessionManager::~SessionManager() {
 
 bool SessionManager::NewSession() {
     currentSessionPath_.clear();
+    missingPlugins_.clear();
     hasUnsavedChanges_ = false;
     return true;
 }
@@ -100,42 +138,89 @@ SessionData SessionManager::CreateSessionFromChain(AudioProcessingChain* chain)
     auto nodeIds = chain->GetNodeIds();
     for (uint32_t nodeId : nodeIds) {
         auto node = chain->GetNode(nodeId);
-        if (node && node->GetPlugin()) {
-            SessionData::PluginNode pluginNode;
-            pluginNode.nodeId = nodeId;
+        if (!node) {
+            continue;
+        }
+        
+        SessionData::PluginNode pluginNode;
+        pluginNode.nodeId = nodeId;
+        pluginNode.position = static_cast<uint32_t>(data.plugins.size());
+        pluginNode.bypassed = node->IsBypassed();
+        pluginNode.inputs = chain->GetNodeInputs(nodeId);
+        
+        auto missing = missingPlugins_.find(nodeId);
+        if (missing != missingPlugins_.end()) {
+            // Stand-in for a plugin that didn't load; keep what the session had
+            pluginNode.uri = missing->second.uri;
+            pluginNode.name = missing->second.name;
+            pluginNode.bypassed = missing->second.bypassed;
+            pluginNode.parameters = missing->second.parameters;
+            pluginNode.automation = missing->second.automation;
+        } else if (node->GetPlugin()) {
             pluginNode.uri = node->GetPlugin()->GetInfo().uri;
             pluginNode.name = node->GetPlugin()->GetInfo().name;
-            pluginNode.position = static_cast<uint32_t>(data.plugins.size());
-            pluginNode.bypassed = node->IsBypassed();
             
             // Get parameter values
             auto params = node->GetPlugin()->GetParameters();
             for (size_t i = 0; i < params.size(); ++i) {
-                float value = node->GetPlugin()->GetParameter(params[i].index);
+                float value = chain->GetParameter(nodeId, params[i].index);
                 pluginNode.parameters[params[i].index] = value;
             }
             
-            data.plugins.push_back(pluginNode);
+            for (const auto& point : chain->GetAutomation(nodeId)) {
+                pluginNode.automation[point.parameterIndex].emplace_back(point.sampleTime, point.value);
+            }
+        } else {
+            pluginNode.name = "Sum";
         }
+        
+        data.plugins.push_back(pluginNode);
     }
     
+    data.linearGraph = chain->IsLinear();
+    data.outputs = chain->GetNodeInputs(AudioProcessingChain::GRAPH_IO);
+    
     return data;
 }
 
 bool SessionManager::ApplySessionToChain(const SessionData& data, AudioProcessingChain* chain, PluginManager* pluginManager) {
     // Clear existing chain
     chain->ClearChain();
+    missingPlugins_.clear();
     
     // Set audio format
     chain->SetFormat(data.audioSettings.sampleRate,
                      data.audioSettings.channels,
                      data.audioSettings.bufferSize);
     
-    // Load plugins in order
-    for (const auto& pluginNode : data.plugins) {
-        uint32_t nodeId = chain->AddPlugin(pluginNode.uri);
+    double rateRatio = 1.0;
+    if (data.automationSampleRate != 0) {
+        rateRatio = static_cast<double>(data.audioSettings.sampleRate) / data.automationSampleRate;
+    }
+    
+    // Load plugins in order, remembering which saved id became which node
+    std::map<uint32_t, uint32_t> idMap;
+    idMap[AudioProcessingChain::GRAPH_IO] = AudioProcessingChain::GRAPH_IO;
+    
+    for (const auto& savedNode : data.plugins) {
+        SessionData::PluginNode pluginNode = savedNode;
+        RescaleAutomation(pluginNode, rateRatio);
+        
+        uint32_t nodeId = pluginNode.uri.empty() ? chain->AddSumNode() : chain->AddPlugin(pluginNode.uri);
+        if (nodeId == 0 && !pluginNode.uri.empty()) {
+            // Failed to load plugin; pass its inputs through in its place
+            nodeId = chain->AddSumNode();
+            if (nodeId != 0) {
+                missingPlugins_[nodeId] = pluginNode;
+            }
+        }
         if (nodeId == 0) {
-            continue;  // Failed to load plugin, skip
+            continue;
+        }
+        idMap[pluginNode.nodeId] = nodeId;
+        
+        if (missingPlugins_.count(nodeId)) {
+            continue;  // nothing to set on the stand-in
         }
         
         auto node = chain->GetNode(nodeId);
@@ -150,11 +235,57 @@ bool SessionManager::ApplySessionToChain(const SessionData& data, AudioProcessin
         for (const auto& param : pluginNode.parameters) {
             chain->SetParameter(nodeId, param.first, param.second);
         }
+        
+        // One timeline update per lane; the new node starts at frame 0
+        for (const auto& lane : pluginNode.automation) {
+            std::vector<ProcessingNode::AutomationPoint> points;
+            points.reserve(lane.second.size());
+            for (const auto& point : lane.second) {
+                points.push_back({ point.first, lane.first, point.second });
+            }
+            chain->SetAutomation(nodeId, lane.first, std::move(points));
+        }
+    }
+    
+    if (!data.linearGraph) {
+        auto mapIds = [&idMap](const std::vector<uint32_t>& ids) {
+            std::vector<uint32_t> mapped;
+            for (uint32_t id : ids) {
+                auto it = idMap.find(id);
+                if (it != idMap.end()) {
+                    mapped.push_back(it->second);
+                }
+            }
+            return mapped;
+        };
+        
+        // Disconnect everything first so rewiring never sees a transient cycle
+        for (const auto& pluginNode : data.plugins) {
+            auto it = idMap.find(pluginNode.nodeId);
+            if (it != idMap.end()) {
+                chain->SetNodeInputs(it->second, std::vector<uint32_t>());
+            }
+        }
+        for (const auto& pluginNode : data.plugins) {
+            auto it = idMap.find(pluginNode.nodeId);
+            if (it != idMap.end()) {
+                chain->SetNodeInputs(it->second, mapIds(pluginNode.inputs));
+            }
+        }
+        chain->SetNodeInputs(AudioProcessingChain::GRAPH_IO, mapIds(data.outputs));
     }
     
     return true;
 }
 
+std::vector<std::string> SessionManager::GetMissingPlugins() const {
+    std::vector<std::string> uris;
+    for (const auto& entry : missingPlugins_) {
+        uris.push_back(entry.second.uri);
+    }
+    return uris;
+}
+
 bool SessionManager::SerializeSession(const SessionData& data, const std::string& filePath) {
     std::ofstream file(filePath);
     if (!file.is_open()) {
@@ -174,6 +305,14 @@ bool SessionManager::SerializeSession(const SessionData& data, const std::string
     file << "Channels=" << data.audioSettings.channels << "\n";
     file << "\n";
     
+    // Write graph topology
+    file << "[GRAPH]\n";
+    file << "Linear=" << (data.linearGraph ? "1" : "0") << "\n";
+    if (!data.linearGraph) {
+        file << "Outputs=" << JoinIds(data.outputs) << "\n";
+    }
+    file << "\n";
+    
     // Write plugins
     file << "[PLUGINS]\n";
     file << "Count=" << data.plugins.size() << "\n";
@@ -187,6 +326,9 @@ bool SessionManager::SerializeSession(const SessionData& data, const std::string
         file << "Name=" << plugin.name << "\n";
         file << "Position=" << plugin.position << "\n";
         file << "Bypassed=" << (plugin.bypassed ? "1" : "0") << "\n";
+        if (!data.linearGraph) {
+            file << "Inputs=" << JoinIds(plugin.inputs) << "\n";
+        }
         
         // Write parameters
         if (!plugin.parameters.empty()) {
@@ -199,6 +341,16 @@ bool SessionManager::SerializeSession(const SessionData& data, const std::string
             }
             file << "\n";
         }
+        
+        // Write automation: "frame:value,frame:value,..." per parameter
+        for (const auto& lane : plugin.automation) {
+            file << "Automation." << lane.first << "=";
+            for (size_t p = 0; p < lane.second.size(); ++p) {
+                if (p > 0) file << ",";
+                file << lane.second[p].first << ":" << lane.second[p].second;
+            }
+            file << "\n";
+        }
         file << "\n";
     }
     
@@ -254,6 +406,10 @@ bool SessionManager::DeserializeSession(const std::string& filePath, SessionData
             else if (key == "BufferSize") data.audioSettings.bufferSize = std::stoi(value);
             else if (key == "Channels") data.audioSettings.channels = std::stoi(value);
         }
+        else if (currentSection == "GRAPH") {
+            if (key == "Linear") data.linearGraph = (value == "1");
+            else if (key == "Outputs") data.outputs = SplitIds(value);
+        }
         else if (key == "VERSION") {
             data.version = value;
         }
@@ -268,6 +424,7 @@ bool SessionManager::DeserializeSession(const std::string& filePath, SessionData
             else if (key == "Name") plugin.name = value;
             else if (key == "Position") plugin.position = std::stoul(value);
             else if (key == "Bypassed") plugin.bypassed = (value == "1");
+            else if (key == "Inputs") plugin.inputs = SplitIds(value);
             else if (key == "Parameters") {
                 // Parse parameters: "index:value,index:value,..."
                 std::stringstream ss(value);
@@ -281,9 +438,21 @@ bool SessionManager::DeserializeSession(const std::string& filePath, SessionData
                     }
                 }
             }
+            else if (key.find("Automation.") == 0) {
+                auto& lane = plugin.automation[std::stoul(key.substr(11))];
+                std::stringstream ss(value);
+                std::string point;
+                while (std::getline(ss, point, ',')) {
+                    size_t colonPos = point.find(':');
+                    if (colonPos != std::string::npos) {
+                        lane.emplace_back(std::stoull(point.substr(0, colonPos)), std::stof(point.substr(colonPos + 1)));
+                    }
+                }
+            }
         }
     }
     
+    data.automationSampleRate = data.audioSettings.sampleRate;
     return true;
 }
 
@@ -3,7 +3,17 @@
 #include <cctype>
 #include <sstream>
 #include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#endif
 
 namespace violet {
 namespace utils {
@@ -51,9 +61,18 @@ bool EndsWith(const std::string& str, const std::string& suffix) {
 }
 
 std::string GetExecutablePath() {
+#ifdef _WIN32
     char path[MAX_PATH];
     GetModuleFileNameA(nullptr, path, MAX_PATH);
     return std::string(path);
+#else
+    char path[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) {
+        return "";
+    }
+    return std::string(path, static_cast<size_t>(length));
+#endif
 }
 
 std::string GetExecutableDirectory() {
@@ -71,7 +90,11 @@ std::string JoinPath(const std::string& path1, const std::string& path2) {
     
     std::string result = path1;
     if (result.back() != '\\' && result.back() != '/') {
+#ifdef _WIN32
         result += "\\";
+#else
+        result += "/";
+#endif
     }
     
     std::string p2 = path2;
@@ -82,6 +105,7 @@ std::string JoinPath(const std::string& path1, const std::string& path2) {
     return result + p2;
 }
 
+#ifdef _WIN32
 bool FileExists(const std::string& path) {
     DWORD attributes = GetFileAttributesA(path.c_str());
     return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
@@ -92,22 +116,54 @@ bool DirectoryExists(const std::string& path) {
     return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+bool MakeDirectory(const std::string& path) {
+    return CreateDirectoryA(path.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+#else
+bool FileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && !S_ISDIR(info.st_mode);
+}
+
+bool DirectoryExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool MakeDirectory(const std::string& path) {
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+#endif
+
 std::wstring StringToWString(const std::string& str) {
     if (str.empty()) return std::wstring();
     
+#ifndef _WIN32
+    // Only the Windows UI needs wide strings; elsewhere widen byte by byte
+    return std::wstring(str.begin(), str.end());
+#else
     int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), nullptr, 0);
     std::wstring wstrTo(size_needed, 0);
     MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
     return wstrTo;
+#endif
 }
 
 std::string WStringToString(const std::wstring& wstr) {
     if (wstr.empty()) return std::string();
     
+#ifndef _WIN32
+    std::string result;
+    for (wchar_t c : wstr) {
+        result += static_cast<char>(c);
+    }
+    return result;
+#else
     int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), nullptr, 0, nullptr, nullptr);
     std::string strTo(size_needed, 0);
     WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, nullptr, nullptr);
     return strTo;
+#endif
 }
 
 double SamplesToMs(int samples, int sampleRate) {
@@ -118,6 +174,7 @@ int MsToSamples(double ms, int sampleRate) {
     return static_cast<int>((ms / 1000.0) * sampleRate);
 }
 
+#ifdef _WIN32
 std::string GetLastErrorString() {
     DWORD error = GetLastError();
     if (error == 0) return "";
@@ -145,6 +202,24 @@ void ShowWarningMessage(const std::string& message, const std::string& title) {
 void ShowInfoMessage(const std::string& message, const std::string& title) {
     MessageBoxA(nullptr, message.c_str(), title.c_str(), MB_OK | MB_ICONINFORMATION);
 }
+#else
+std::string GetLastErrorString() {
+    return errno != 0 ? std::string(strerror(errno)) : std::string();
+}
+
+// Headless builds have no message boxes; report on the console instead
+void ShowErrorMessage(const std::string& message, const std::string& title) {
+    std::cerr << title << ": " << message << std::endl;
+}
+
+void ShowWarningMessage(const std::string& message, const std::string& title) {
+    std::cerr << title << ": " << message << std::endl;
+}
+
+void ShowInfoMessage(const std::string& message, const std::string& title) {
+    std::cout << title << ": " << message << std::endl;
+}
+#endif
 
 } // namespace utils
 } // namespace violet
\ No newline at end of file
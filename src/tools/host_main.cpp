@@ -0,0 +1,308 @@
+// violet-host: headless live host, runs a chain on an audio backend
+//
+//   violet-host [options]
+//
+//   --backend <name>          audio backend (default: $VIOLET_AUDIO_BACKEND or
+//                             the platform's native one)
+//   --input <device>          input device id ("file:<path>" on the null backend)
+//   --output <device>         output device id ("file:<path>" on the null backend)
+//   --session <file.violet>   load the chain from a saved session
+//   --plugin <uri>            append a plugin to the chain (repeatable)
+//   --rate <hz>               sample rate (default 48000)
+//   --internal-rate <hz>      run the chain at this rate and resample to and
+//                             from the devices (default: the device rate)
+//   --quality <preset>        resampler quality: fast, balanced, high, best (default high)
+//   --block <frames>          buffer size (default 256)
+//   --fixed-block             always run the chain on full --block sized blocks,
+//                             buffering device periods if the backend varies them
+//   --channels <n>            channel count (default 2)
+//   --input-map <list>        device input channel for each chain bus, e.g.
+//                             "2,3" (-1 = silent; default: one bus per channel)
+//   --output-map <list>       chain bus for each device output channel, e.g.
+//                             "0,1,0,1" (-1 = silent; default: the same channel)
+//   --seconds <s>             stop after this long (default: run until interrupted)
+//   --freewheel               null backend only: run as fast as possible;
+//                             --seconds then counts audio, not wall time
+//   --lock-memory             lock the process in RAM (mlockall; Linux)
+//   --check-denormals         leave denormals unflushed and report the plugins
+//                             whose output contains them
+//   --list-devices            print the backend's devices and exit
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "violet/alloc_trap.h"
+#include "violet/audio_engine.h"
+#include "violet/audio_processing_chain.h"
+#include "violet/null_backend.h"
+#include "violet/realtime_thread.h"
+#include "violet/session_manager.h"
+
+namespace {
+
+std::atomic<bool> interrupted(false);
+
+void HandleInterrupt(int) {
+    interrupted.store(true);
+}
+
+void PrintUsage() {
+    std::cerr << "Usage: violet-host [--backend name] [--input device] [--output device]\n"
+                 "                   [--session file.violet] [--plugin uri]... [--rate hz]\n"
+                 "                   [--internal-rate hz] [--quality preset]\n"
+                 "                   [--block frames] [--fixed-block] [--channels n]\n"
+                 "                   [--input-map list] [--output-map list] [--seconds s]\n"
+                 "                   [--freewheel] [--lock-memory] [--check-denormals]\n"
+                 "                   [--list-devices]" << std::endl;
+    std::cerr << "Backends:";
+    for (const auto& name : violet::GetAudioBackendNames()) {
+        std::cerr << " " << name;
+    }
+    std::cerr << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string backendName;
+    std::string inputDevice;
+    std::string outputDevice;
+    std::string sessionPath;
+    std::vector<std::string> pluginUris;
+    violet::AudioFormat format;
+    format.sampleRate = 48000;
+    uint32_t internalRate = 0;
+    violet::ResamplerQuality quality = violet::ResamplerQuality::High;
+    violet::ChannelMap channelMap;
+    double seconds = 0.0;
+    bool fixedBlock = false;
+    bool freewheel = false;
+    bool lockMemory = false;
+    bool checkDenormals = false;
+    bool listDevices = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--backend" && hasValue) {
+            backendName = argv[++i];
+        } else if (arg == "--input" && hasValue) {
+            inputDevice = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            outputDevice = argv[++i];
+        } else if (arg == "--session" && hasValue) {
+            sessionPath = argv[++i];
+        } else if (arg == "--plugin" && hasValue) {
+            pluginUris.push_back(argv[++i]);
+        } else if (arg == "--rate" && hasValue) {
+            format.sampleRate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--internal-rate" && hasValue) {
+            internalRate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--quality" && hasValue) {
+            if (!violet::ParseResamplerQuality(argv[++i], quality)) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (arg == "--block" && hasValue) {
+            format.bufferSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--fixed-block") {
+            fixedBlock = true;
+        } else if (arg == "--channels" && hasValue) {
+            format.channels = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--input-map" && hasValue) {
+            if (!violet::ParseChannelList(argv[++i], channelMap.inputs)) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (arg == "--output-map" && hasValue) {
+            if (!violet::ParseChannelList(argv[++i], channelMap.outputs)) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (arg == "--seconds" && hasValue) {
+            seconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--freewheel") {
+            freewheel = true;
+        } else if (arg == "--lock-memory") {
+            lockMemory = true;
+        } else if (arg == "--check-denormals") {
+            checkDenormals = true;
+        } else if (arg == "--list-devices") {
+            listDevices = true;
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (freewheel && seconds <= 0.0) {
+        std::cerr << "--freewheel needs --seconds" << std::endl;
+        return 1;
+    }
+
+    // Freewheeling is a null backend feature, so build that one here
+    std::unique_ptr<violet::AudioBackend> backend;
+    violet::NullBackend* nullBackend = nullptr;
+    if (freewheel) {
+        if (!backendName.empty() && backendName != "null") {
+            std::cerr << "--freewheel only works with the null backend" << std::endl;
+            return 1;
+        }
+        auto freewheelBackend = std::make_unique<violet::NullBackend>();
+        freewheelBackend->SetFreewheel(true);
+        nullBackend = freewheelBackend.get();
+        backend = std::move(freewheelBackend);
+    } else {
+        backend = violet::CreateAudioBackend(backendName);
+        if (!backend) {
+            std::cerr << "Unknown audio backend: " << backendName << std::endl;
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    violet::AudioEngine engine;
+    if (!engine.Initialize(std::move(backend))) {
+        return 1;
+    }
+
+    if (listDevices) {
+        for (const auto& device : engine.EnumerateDevices()) {
+            std::cout << (device.isDefault ? "* " : "  ") << device.id << "  " << device.name << " ("
+                      << (device.isInput ? "in" : "") << (device.isInput && device.isOutput ? "/" : "")
+                      << (device.isOutput ? "out" : "") << ")" << std::endl;
+        }
+        return 0;
+    }
+
+    if (!engine.SetFormat(format)) {
+        std::cerr << "Unsupported format: " << format.sampleRate << " Hz, " << format.channels
+                  << " ch, " << format.bufferSize << " frames" << std::endl;
+        return 1;
+    }
+    if (!engine.SetProcessingSampleRate(internalRate)) {
+        std::cerr << "Unsupported internal rate: " << internalRate << " Hz" << std::endl;
+        return 1;
+    }
+    engine.SetResamplerQuality(quality);
+    if (!engine.SetChannelMap(channelMap)) {
+        std::cerr << "Too many buses in --input-map" << std::endl;
+        return 1;
+    }
+    engine.SetFixedBlockSize(fixedBlock);
+    engine.SetInputDevice(inputDevice);
+    engine.SetOutputDevice(outputDevice);
+
+    std::string error;
+    if (lockMemory && !violet::LockProcessMemory(error)) {
+        std::cerr << "Warning: " << error << ", running with unlocked memory" << std::endl;
+    }
+
+    // Denormals have to reach the chain to be traced back to a plugin
+    violet::SetDenormalFlushEnabled(!checkDenormals);
+
+    violet::AudioProcessingChain chain(&engine);
+    chain.SetDenormalCheck(checkDenormals);
+    violet::AudioFormat processing = engine.GetProcessingFormat();
+    chain.SetFormat(processing.sampleRate, processing.channels, processing.bufferSize);
+    engine.SetProcessCallback([&chain](float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+        chain.Process(inputs, outputs, channels, frames);
+    });
+    engine.SetGlitchContextSource([&chain] { return chain.GetBlockContext(); });
+    engine.SetProcessingLatencySource([&chain] { return chain.GetLatency(); });
+
+    if (!engine.Start()) {
+        return 1;
+    }
+
+    // The devices may have settled on another format; plugins are
+    // instantiated once the chain has followed
+    violet::AudioFormat actual = engine.GetProcessingFormat();
+    chain.SetFormat(actual.sampleRate, actual.channels, actual.bufferSize);
+    chain.SetFixedBlockLength(engine.HasFixedBlockSize());
+    chain.WaitForFormatChange();
+
+    if (!sessionPath.empty()) {
+        auto loadStart = std::chrono::steady_clock::now();
+        violet::SessionManager sessionManager;
+        violet::SessionData session;
+        if (!sessionManager.DeserializeSession(sessionPath, session)) {
+            std::cerr << "Failed to read session: " << sessionPath << std::endl;
+            return 1;
+        }
+
+        // The devices decide the format, not the session
+        session.audioSettings.sampleRate = actual.sampleRate;
+        session.audioSettings.channels = actual.channels;
+        session.audioSettings.bufferSize = actual.bufferSize;
+        if (!sessionManager.ApplySessionToChain(session, &chain, chain.GetPluginManager())) {
+            std::cerr << "Failed to load session: " << sessionPath << std::endl;
+            return 1;
+        }
+        for (const auto& uri : sessionManager.GetMissingPlugins()) {
+            std::cerr << "Plugin not found, passing audio through in its place: " << uri << std::endl;
+        }
+        std::cout << "Session loaded in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+                  << " ms" << std::endl;
+    }
+
+    for (const auto& uri : pluginUris) {
+        if (chain.AddPlugin(uri) == 0) {
+            return 1;
+        }
+    }
+
+    std::cout << "Running " << chain.GetNodeCount() << " node(s) on " << engine.GetBackendName()
+              << " at " << actual.sampleRate << " Hz, " << actual.channels << " channel(s), "
+              << actual.bufferSize << " frames, " << engine.GetLatency() << " ms output latency"
+              << (seconds > 0.0 ? "" : "; Ctrl-C to stop") << std::endl;
+
+    std::signal(SIGINT, HandleInterrupt);
+    std::signal(SIGTERM, HandleInterrupt);
+
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t targetFrames = static_cast<uint64_t>(seconds * engine.GetFormat().sampleRate);
+    while (!interrupted.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(nullBackend ? 1 : 100));
+        if (nullBackend) {
+            if (nullBackend->GetProcessedFrames() >= targetFrames) {
+                break;
+            }
+        } else if (seconds > 0.0 &&
+                   std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() >= seconds) {
+            break;
+        }
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    double cpuUsage = engine.GetCpuUsage();
+    uint32_t dropouts = engine.GetDropouts();
+    violet::DriftStatus drift = engine.GetDriftStatus();
+    engine.Stop();
+
+    std::cout << "Ran for " << wallSeconds << " s: " << cpuUsage << "% DSP load, "
+              << dropouts << " dropout(s)" << std::endl;
+    if (dropouts > 0) {
+        std::cout << "Latest dropouts:\n" << engine.DumpGlitches(16);
+    }
+    if (drift.active) {
+        std::cout << "Input clock " << drift.ratioPpm << " ppm off, " << drift.latencyFrames
+                  << " frames input delay, " << drift.resyncs << " resync(s)" << std::endl;
+    }
+    std::cout << chain.DumpStats();
+    if (violet::IsAllocTrapBuiltIn()) {
+        std::cout << violet::GetRealtimeAllocationCount() << " allocation(s) on audio threads" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+// violet-render: headless offline rendering of a chain or session
+//
+//   violet-render [options] input.wav output.wav
+//
+//   --session <file.violet>   load the chain from a saved session
+//   --plugin <uri>            append a plugin to the chain (repeatable)
+//   --block <frames>          processing block size (default 256)
+//   --rate <hz>               render sample rate (default: the input's; other
+//                             rates resample the input)
+//   --output-rate <hz>        output file sample rate (default: the render rate)
+//   --quality <preset>        resampler quality: fast, balanced, high, best (default best)
+//   --channels <n>            chain channel count (default: the input's)
+//   --tail <seconds>          silence rendered after the input
+//   --format <f32|s24|s16>    output sample format (default f32)
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include "violet/audio_processing_chain.h"
+#include "violet/offline_renderer.h"
+#include "violet/session_manager.h"
+#include "violet/wav_file.h"
+
+namespace {
+
+void PrintUsage() {
+    std::cerr << "Usage: violet-render [--session file.violet] [--plugin uri]... [--block frames]\n"
+                 "                     [--rate hz] [--output-rate hz] [--quality preset]\n"
+                 "                     [--channels n] [--tail seconds]\n"
+                 "                     [--format f32|s24|s16] input.wav output.wav" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string sessionPath;
+    std::vector<std::string> pluginUris;
+    std::vector<std::string> files;
+    violet::OfflineRenderOptions options;
+    violet::WavFile::SampleFormat outputFormat = violet::WavFile::SampleFormat::Float32;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--session" && hasValue) {
+            sessionPath = argv[++i];
+        } else if (arg == "--plugin" && hasValue) {
+            pluginUris.push_back(argv[++i]);
+        } else if (arg == "--block" && hasValue) {
+            options.blockSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--rate" && hasValue) {
+            options.sampleRate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--output-rate" && hasValue) {
+            options.outputSampleRate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--quality" && hasValue) {
+            if (!violet::ParseResamplerQuality(argv[++i], options.quality)) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (arg == "--channels" && hasValue) {
+            options.channels = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--tail" && hasValue) {
+            options.tailSeconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--format" && hasValue) {
+            std::string format = argv[++i];
+            if (format == "s16") {
+                outputFormat = violet::WavFile::SampleFormat::Int16;
+            } else if (format == "s24") {
+                outputFormat = violet::WavFile::SampleFormat::Int24;
+            } else if (format != "f32") {
+                PrintUsage();
+                return 1;
+            }
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (files.size() != 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::string error;
+    violet::AudioFileData input;
+    if (!violet::WavFile::Read(files[0], input, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    violet::AudioProcessingChain chain(nullptr);
+    violet::OfflineRenderer renderer(&chain);
+
+    // Set the render format before any plugin is instantiated
+    if (!renderer.Prepare(input, options)) {
+        std::cerr << renderer.GetLastError() << std::endl;
+        return 1;
+    }
+
+    uint32_t sampleRate, channels, blockSize;
+    chain.GetFormat(sampleRate, channels, blockSize);
+
+    if (!sessionPath.empty()) {
+        violet::SessionManager sessionManager;
+        violet::SessionData session;
+        if (!sessionManager.DeserializeSession(sessionPath, session)) {
+            std::cerr << "Failed to read session: " << sessionPath << std::endl;
+            return 1;
+        }
+
+        // The session's device settings don't apply offline
+        session.audioSettings.sampleRate = sampleRate;
+        session.audioSettings.channels = channels;
+        session.audioSettings.bufferSize = blockSize;
+        if (!sessionManager.ApplySessionToChain(session, &chain, chain.GetPluginManager())) {
+            std::cerr << "Failed to load session: " << sessionPath << std::endl;
+            return 1;
+        }
+        for (const auto& uri : sessionManager.GetMissingPlugins()) {
+            std::cerr << "Plugin not found, passing audio through in its place: " << uri << std::endl;
+        }
+    }
+
+    for (const auto& uri : pluginUris) {
+        if (chain.AddPlugin(uri) == 0) {
+            return 1;
+        }
+    }
+
+    std::cout << "Rendering " << files[0] << " through " << chain.GetNodeCount() << " node(s) at "
+              << sampleRate << " Hz, " << channels << " channel(s), " << blockSize << " frame blocks" << std::endl;
+
+    violet::AudioFileData output;
+    violet::OfflineRenderResult result;
+    if (!renderer.Render(input, output, options, result)) {
+        std::cerr << renderer.GetLastError() << std::endl;
+        return 1;
+    }
+
+    if (!violet::WavFile::Write(files[1], output, outputFormat, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Rendered " << result.audioSeconds << " s of audio in " << result.wallSeconds
+              << " s (" << result.realtimeFactor << "x realtime, " << result.blocks << " blocks)" << std::endl;
+    std::cout << chain.DumpStats();
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include "violet/plugin_manager.h"
 #include "violet/audio_engine.h"
 #include "violet/audio_processing_chain.h"
+#include "violet/config_manager.h"
 #include "violet/theme_manager.h"
 #include "violet/session_manager.h"
 #include "violet/audio_settings_dialog.h"
@@ -14,6 +15,7 @@
 #include <commctrl.h>
 #include <windowsx.h>
 #include <iostream>
+#include <algorithm>
 
 namespace violet {
 
@@ -211,6 +213,18 @@ LRESULT MainWindow::HandleMessage(UINT uMsg, WPARAM wParam, LPARAM lParam) {
         return 0;
     }
     
+    case WM_USER + 102: {
+        // Custom message: the background plugin scan changed the list
+        if (pluginBrowser_) {
+            pluginBrowser_->RefreshPluginList();
+        }
+        if (hStatusBar_ && pluginManager_) {
+            std::wstring pluginCount = L"Plugins: " + std::to_wstring(pluginManager_->GetAvailablePlugins().size());
+            SendMessage(hStatusBar_, SB_SETTEXT, 0, (LPARAM)pluginCount.c_str());
+        }
+        return 0;
+    }
+    
     case WM_USER + 200: {
         // Custom message: drag-drop plugin URI from browser
         if (lParam != 0 && activePluginsPanel_) {
@@ -223,10 +237,18 @@ LRESULT MainWindow::HandleMessage(UINT uMsg, WPARAM wParam, LPARAM lParam) {
     case WM_TIMER:
         // Update status bar with audio stats
         if (wParam == 1 && audioEngine_ && processingChain_) {
+            // Free chain snapshots and removed plugins the audio thread is done with
+            processingChain_->CollectRetired();
+
             if (hStatusBar_) {
-                // Update CPU usage
+                // Update DSP load and xruns
                 double cpu = processingChain_->GetCpuUsage();
                 std::wstring cpuText = L"CPU: " + std::to_wstring(static_cast<int>(cpu)) + L"%";
+                // The chain runs inside the engine callback, so its overruns are a subset
+                uint64_t xruns = std::max<uint64_t>(processingChain_->GetXrunCount(), audioEngine_->GetDropouts());
+                if (xruns > 0) {
+                    cpuText += L"  Xruns: " + std::to_wstring(xruns);
+                }
                 SendMessage(hStatusBar_, SB_SETTEXT, 2, (LPARAM)cpuText.c_str());
                 
                 // Update audio status
@@ -280,6 +302,13 @@ void MainWindow::OnCreate() {
     // Initialize backend components
     pluginManager_ = std::make_unique<PluginManager>();
     if (pluginManager_) {
+        // The list starts out from the plugin cache; the scan thread, started
+        // by the plugin browser, reports changed bundles once it has parsed them
+        HWND hwnd = hwnd_;
+        pluginManager_->SetPluginsChangedCallback([hwnd] {
+            PostMessage(hwnd, WM_USER + 102, 0, 0);
+        });
+        pluginManager_->SetLazyLoading(true);
         pluginManager_->Initialize();
     }
     
@@ -299,75 +328,16 @@ void MainWindow::OnCreate() {
     
     // Set up audio callback to process through chain
     if (audioEngine_ && processingChain_) {
-        // Pre-allocate audio buffers to avoid reallocation during processing
-        audioBufferLeft_.resize(1024);  // Max expected buffer size
-        audioBufferRight_.resize(1024);
-        audioBufferLeftOut_.resize(1024);
-        audioBufferRightOut_.resize(1024);
-        
-        audioEngine_->SetAudioCallback(
-            [](float* input, float* output, uint32_t frames, void* userData) {
-                auto* mainWindow = static_cast<MainWindow*>(userData);
-                if (!mainWindow || !mainWindow->processingChain_) {
-                    // Bypass: copy input to output
-                    if (input && output) {
-                        memcpy(output, input, frames * 2 * sizeof(float));
-                    }
-                    return;
-                }
-                
-                auto* chain = mainWindow->processingChain_.get();
-                
-                // De-interleave input: WASAPI provides interleaved stereo (L,R,L,R,...)
-                // Chain expects planar buffers (LLLL..., RRRR...)
-                std::vector<float>& leftIn = mainWindow->audioBufferLeft_;
-                std::vector<float>& rightIn = mainWindow->audioBufferRight_;
-                std::vector<float>& leftOut = mainWindow->audioBufferLeftOut_;
-                std::vector<float>& rightOut = mainWindow->audioBufferRightOut_;
-                
-                // Ensure buffers are large enough (but don't shrink to avoid reallocation)
-                if (leftIn.size() < frames) {
-                    leftIn.resize(frames);
-                    rightIn.resize(frames);
-                    leftOut.resize(frames);
-                    rightOut.resize(frames);
-                }
-                
-                // Validate input/output pointers
-                if (!input || !output) {
-                    std::cerr << "Error: NULL audio buffer in callback" << std::endl;
-                    return;
-                }
-                
-                // De-interleave input
-                for (uint32_t i = 0; i < frames; ++i) {
-                    leftIn[i] = input[i * 2];
-                    rightIn[i] = input[i * 2 + 1];
-                }
-                
-                // Create planar buffer pointers
-                float* inputBuffers[2] = { leftIn.data(), rightIn.data() };
-                float* outputBuffers[2] = { leftOut.data(), rightOut.data() };
-                
-                // Validate buffer pointers
-                if (!inputBuffers[0] || !inputBuffers[1] || !outputBuffers[0] || !outputBuffers[1]) {
-                    std::cerr << "Error: NULL buffer pointer after data()" << std::endl;
-                    memcpy(output, input, frames * 2 * sizeof(float));
-                    return;
-                }
-                
-                // Process through the plugin chain
-                // Note: Process all frames at once - the chain will handle chunking internally
-                chain->Process(inputBuffers, outputBuffers, 2, frames);
-                
-                // Interleave output back to WASAPI format
-                for (uint32_t i = 0; i < frames; ++i) {
-                    output[i * 2] = leftOut[i];
-                    output[i * 2 + 1] = rightOut[i];
-                }
-            },
-            this  // Pass MainWindow as user data
+        // The chain processes the backend's planar buffers in place of an
+        // interleaved round trip
+        AudioProcessingChain* chain = processingChain_.get();
+        audioEngine_->SetProcessCallback(
+            [chain](float** inputs, float** outputs, uint32_t channels, uint32_t frames) {
+                chain->Process(inputs, outputs, channels, frames);
+            }
         );
+        audioEngine_->SetGlitchContextSource([chain] { return chain->GetBlockContext(); });
+        audioEngine_->SetProcessingLatencySource([chain] { return chain->GetLatency(); });
         
         // Set audio format in engine to match chain
         AudioFormat format;
@@ -377,11 +347,30 @@ void MainWindow::OnCreate() {
         format.bitsPerSample = 32;
         audioEngine_->SetFormat(format);
         
+        // WASAPI periods vary in length; plugins get constant blocks
+        audioEngine_->SetFixedBlockSize(true);
+        
+        // Multichannel interfaces can pick which channels reach the chain
+        ConfigManager config;
+        if (config.Load()) {
+            ChannelMap channelMap;
+            if (ParseChannelList(config.GetString("audio.input_map"), channelMap.inputs) &&
+                ParseChannelList(config.GetString("audio.output_map"), channelMap.outputs) &&
+                audioEngine_->SetChannelMap(channelMap)) {
+                if (!channelMap.IsIdentity()) {
+                    std::cout << "Using the channel map from the config" << std::endl;
+                }
+            } else {
+                std::cerr << "Ignoring invalid audio.input_map/audio.output_map" << std::endl;
+            }
+        }
+        
         // Start audio engine automatically
         if (audioEngine_->Start()) {
             // Update processing chain with actual audio format
-            AudioFormat actualFormat = audioEngine_->GetFormat();
+            AudioFormat actualFormat = audioEngine_->GetProcessingFormat();
             processingChain_->SetFormat(actualFormat.sampleRate, actualFormat.channels, actualFormat.bufferSize);
+            processingChain_->SetFixedBlockLength(audioEngine_->HasFixedBlockSize());
             std::cout << "Updated processing chain to use " << actualFormat.sampleRate << " Hz" << std::endl;
             
             if (hStatusBar_) {
@@ -420,6 +409,11 @@ void MainWindow::OnDestroy() {
         audioEngine_->Stop();
     }
     
+    // Leave the session's timing stats in the console log
+    if (processingChain_) {
+        std::cout << processingChain_->DumpStats();
+    }
+    
     PostQuitMessage(0);
 }
 
@@ -781,6 +775,15 @@ void MainWindow::OnOpenSession() {
                 std::wstring msg = L"Loaded: " + utils::StringToWString(filePath);
                 SendMessage(hStatusBar_, SB_SETTEXT, 0, (LPARAM)msg.c_str());
             }
+            
+            auto missing = sessionManager_->GetMissingPlugins();
+            if (!missing.empty()) {
+                std::wstring msg = L"These plugins could not be loaded and are bypassed:\n";
+                for (const auto& uri : missing) {
+                    msg += L"\n" + utils::StringToWString(uri);
+                }
+                MessageBox(hwnd_, msg.c_str(), L"Missing Plugins", MB_OK | MB_ICONWARNING);
+            }
         } else {
             MessageBox(hwnd_, L"Failed to load session file", L"Error", MB_OK | MB_ICONERROR);
         }
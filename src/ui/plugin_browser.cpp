@@ -67,6 +67,10 @@ bool PluginBrowser::Create(HWND parent, HINSTANCE hInstance, int x, int y, int w
 
 void PluginBrowser::SetPluginManager(PluginManager* manager) {
     pluginManager_ = manager;
+    if (pluginManager_) {
+        // Show the cached list now, the rest once lilv has seen every bundle
+        pluginManager_->StartBackgroundScan();
+    }
     if (hwnd_ && pluginManager_) {
         RefreshPluginList();
     }